@@ -0,0 +1,310 @@
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/ipc_admission.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/ipc_server.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// IPC 过载保护检查：直接用 BatchDispatcher 处理构造好的请求批（请求处理为 RequestHandler，并记录调用顺序），检查：
+//   - 停止插队：批内最后一条 stopAll 最先执行，它前面的运动指令不执行、回复 "<action> superseded by stopAll"，
+//     前面的 stopAll 与它合并，它后面的指令照常执行；响应按请求顺序写回
+//   - 合并：连续的相同运动指令（action 与 ttl_ms 都相同）只执行最后一条，每条请求都收到相同的成功响应
+//   - 限速：突发额度用完后运动指令回复 RATE_LIMITED 且不执行，stopAll 不受限速
+//   - ttl 越界：ttl_ms 为 0 或超过 MAX_LEASE_TTL_MS 的请求不合并、不插队，逐条回复 INVALID_TTL，期望状态不变
+//   - 慢读者（进程内 IpcServer，两个后端各一次）：一个连接只发送不读取响应直到发送阻塞，期间另一个连接的往返时间
+//     不超过 100ms；之后慢读者开始读取，每条请求的响应都按顺序收到（连接没有被断开）
+// 任一检查失败时以退出码 1 结束
+// 用法: fpvcar-admission-check
+
+using namespace fpvcar::device_control;
+using CheckClock = std::chrono::steady_clock;
+
+namespace {
+    /**
+     * @brief 丢弃所有输出的流缓冲区（限速告警）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    /**
+     * @brief 被测的 BatchDispatcher：请求交给 RequestHandler，按调用顺序记录请求
+     */
+    struct Harness {
+        DesiredStateManager manager;
+        RequestHandler handler{manager, std::string()};
+        std::vector<std::string> calls;
+        ipc::BatchDispatcher dispatcher{[this](std::string_view request, std::string& response) {
+            calls.emplace_back(request);
+            return handler.handle_request(request, response) == RequestOutcome::SUBSCRIBE;
+        }};
+        ipc::TokenBucket bucket;
+
+        /**
+         * @brief 处理一批请求，返回按顺序解析出的响应（帧格式错误时为空）
+         */
+        std::vector<nlohmann::json> run(const std::vector<std::string>& requests) {
+            const std::vector<std::string_view> frames(requests.begin(), requests.end());
+            std::string out;
+            std::string handoff_response;
+            calls.clear();
+            dispatcher.dispatch(bucket, frames, out, handoff_response);
+
+            std::vector<std::string_view> reply_frames;
+            size_t offset = 0;
+            std::vector<nlohmann::json> replies;
+            if (!ipc::split_frames(out, offset, reply_frames) || offset != out.size()) return replies;
+            for (std::string_view frame : reply_frames) replies.push_back(nlohmann::json::parse(frame, nullptr, false));
+            return replies;
+        }
+    };
+
+    std::string command(const char* action, int64_t ttl_ms = -1) {
+        std::string request = std::string("{\"action\":\"") + action + "\"";
+        if (ttl_ms >= 0) request += ",\"ttl_ms\":" + std::to_string(ttl_ms);
+        return request + "}";
+    }
+
+    bool message_is(const nlohmann::json& reply, const std::string& message) {
+        return reply.is_object() && reply.value("status", "") == "ok" && reply.value("message", "") == message;
+    }
+
+    bool error_is(const nlohmann::json& reply, const char* code) {
+        return reply.is_object() && reply.value("status", "") == "error" && reply.value("error_code", "") == code;
+    }
+
+    struct Result {
+        std::string name;
+        bool ok;
+        std::string detail;
+    };
+
+    Result check_priority_stop() {
+        Harness h;
+        const auto replies = h.run({command("moveForward"), command("turnLeft", 500), command("stopAll"),
+                                    command("moveBackward"), command("stopAll"), command("turnRight")});
+        const bool order = h.calls.size() == 2 && h.calls[0] == command("stopAll") && h.calls[1] == command("turnRight");
+        const bool responses = replies.size() == 6 && message_is(replies[0], "moveForward superseded by stopAll") &&
+                               message_is(replies[1], "turnLeft superseded by stopAll") &&
+                               message_is(replies[2], "stopAll executed") &&
+                               message_is(replies[3], "moveBackward superseded by stopAll") &&
+                               message_is(replies[4], "stopAll executed") && message_is(replies[5], "turnRight executed");
+        const bool state = h.manager.get_desired_state() == DesiredState::TURNING_RIGHT;
+        const ipc::AdmissionStats stats = h.dispatcher.stats();
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "calls=%zu order=%d responses=%d state=%d superseded=%llu priority_stops=%llu",
+                      h.calls.size(), order, responses, state, static_cast<unsigned long long>(stats.superseded),
+                      static_cast<unsigned long long>(stats.priority_stops));
+        return {"priority_stop", order && responses && state && stats.superseded == 3 && stats.priority_stops == 1, detail};
+    }
+
+    Result check_coalescing() {
+        Harness h;
+        std::vector<std::string> requests(5, command("moveForward", 500));
+        requests.push_back(command("turnLeft"));
+        requests.push_back(command("turnLeft", 300));
+        requests.push_back(command("turnLeft", 300));
+        const auto replies = h.run(requests);
+        const bool calls = h.calls.size() == 3 && h.calls[0] == command("moveForward", 500) &&
+                           h.calls[1] == command("turnLeft") && h.calls[2] == command("turnLeft", 300);
+        bool responses = replies.size() == requests.size();
+        for (size_t i = 0; responses && i < replies.size(); ++i) {
+            responses = message_is(replies[i], i < 5 ? "moveForward executed" : "turnLeft executed");
+        }
+        const bool state = h.manager.get_desired_state() == DesiredState::TURNING_LEFT;
+        const ipc::AdmissionStats stats = h.dispatcher.stats();
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "requests=%zu calls=%zu responses=%d state=%d coalesced=%llu",
+                      requests.size(), h.calls.size(), responses, state, static_cast<unsigned long long>(stats.coalesced));
+        return {"coalescing", calls && responses && state && stats.coalesced == 5, detail};
+    }
+
+    Result check_rate_limit() {
+        Harness h;
+        h.dispatcher.set_rate_limit({1.0, 3.0});
+        // 交替的指令不会被合并，每条消耗一个令牌
+        const auto replies = h.run({command("moveForward"), command("turnLeft"), command("moveForward"),
+                                    command("turnLeft"), command("moveBackward")});
+        const size_t executed = h.calls.size();
+        bool responses = replies.size() == 5;
+        for (size_t i = 0; responses && i < replies.size(); ++i) {
+            responses = i < 3 ? replies[i].value("status", "") == "ok" : error_is(replies[i], "RATE_LIMITED");
+        }
+        const bool state = h.manager.get_desired_state() == DesiredState::MOVING_FORWARD;
+        // 令牌已用完，stopAll 仍然执行；之后的运动指令仍被限速
+        const auto stop_replies = h.run({command("stopAll"), command("turnRight")});
+        const bool stopped = stop_replies.size() == 2 && message_is(stop_replies[0], "stopAll executed") &&
+                             error_is(stop_replies[1], "RATE_LIMITED") && h.calls.size() == 1 &&
+                             h.manager.get_desired_state() == DesiredState::STOPPING;
+        const ipc::AdmissionStats stats = h.dispatcher.stats();
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "executed=%zu/5 responses=%d state=%d stop_accepted=%d rate_limited=%llu",
+                      executed, responses, state, stopped, static_cast<unsigned long long>(stats.rate_limited));
+        return {"rate_limit", executed == 3 && responses && state && stopped && stats.rate_limited == 3, detail};
+    }
+
+    Result check_ttl_out_of_range() {
+        Harness h;
+        const std::string too_long = command("moveForward", MAX_LEASE_TTL_MS + 1);
+        const auto replies = h.run({too_long, too_long, command("turnLeft", 0)});
+        bool responses = replies.size() == 3;
+        for (size_t i = 0; responses && i < replies.size(); ++i) responses = error_is(replies[i], "INVALID_TTL");
+        const bool unchanged = h.calls.size() == 3 && h.manager.get_desired_state() == DesiredState::STOPPING;
+        // 上限本身是合法的
+        const auto limit_replies = h.run({command("moveForward", MAX_LEASE_TTL_MS)});
+        const bool limit_ok = limit_replies.size() == 1 && message_is(limit_replies[0], "moveForward executed");
+        const ipc::AdmissionStats stats = h.dispatcher.stats();
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "responses=%d unchanged=%d limit_accepted=%d coalesced=%llu", responses,
+                      unchanged, limit_ok, static_cast<unsigned long long>(stats.coalesced));
+        return {"ttl_out_of_range", responses && unchanged && limit_ok && stats.coalesced == 0, detail};
+    }
+
+
+    int connect_to(const std::string& path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        timeval tv{5, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        return fd;
+    }
+
+    /**
+     * @brief 慢读者只发送不读取：非阻塞地写入请求帧，直到发送持续 100ms 没有进展（服务端已停止读取该连接）
+     * @return 写入的字节数（最后一帧可能只写了一部分）
+     */
+    size_t flood_until_blocked(int fd, const std::string& frames) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        size_t sent = 0;
+        auto progress = CheckClock::now();
+        while (sent < frames.size() && CheckClock::now() - progress < std::chrono::milliseconds(100)) {
+            const ssize_t n = ::send(fd, frames.data() + sent, frames.size() - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += static_cast<size_t>(n);
+                progress = CheckClock::now();
+            } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                break;
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        return sent;
+    }
+
+    Result check_slow_reader(IpcBackend backend, const char* name) {
+        const std::string path = "/tmp/fpvcar-admission-check." + std::to_string(::getpid()) + ".sock";
+        DesiredStateManager manager;
+        RequestHandler handler(manager, std::string());
+        IpcServer server(path, [&handler](std::string_view request, std::string& response) {
+            handler.handle_request(request, response);
+            return IpcDisposition::KEEP;
+        }, backend);
+        auto prepared = server.prepare();
+        if (!prepared) return {name, false, prepared.error()};
+        std::thread server_thread([&server]() { server.run(); });
+
+        const int slow = connect_to(path);
+        const int probe = connect_to(path);
+        std::string request_frame;
+        ipc::append_frame(request_frame, command("moveForward"));
+        std::string frames;
+        for (int i = 0; i < 100000; ++i) frames += request_frame;
+
+        // 探测连接不停往返，直到慢读者被阻塞后再往返 200 次
+        std::atomic<bool> flooded{false};
+        std::atomic<uint64_t> round_trips{0};
+        std::atomic<int64_t> max_round_trip_us{0};
+        std::atomic<bool> probe_failed{probe < 0};
+        std::thread probe_thread([&]() {
+            std::string frame;
+            ipc::append_frame(frame, command("turnLeft"));
+            std::string response;
+            for (uint64_t after = 0; !probe_failed.load() && after < 200;) {
+                const auto start = CheckClock::now();
+                if (ipc::write_exact(probe, frame.data(), frame.size()) != static_cast<ssize_t>(frame.size()) ||
+                    !ipc::read_message(probe, response)) {
+                    probe_failed.store(true);
+                    break;
+                }
+                const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(CheckClock::now() - start).count();
+                max_round_trip_us.store(std::max(max_round_trip_us.load(), us));
+                round_trips.fetch_add(1);
+                if (flooded.load()) ++after;
+            }
+        });
+        const size_t sent = slow >= 0 ? flood_until_blocked(slow, frames) : 0;
+        flooded.store(true);
+        probe_thread.join();
+
+        // 慢读者读取全部完整请求的响应，再补完最后半帧（服务端发完响应之前不会再读取该连接）
+        size_t requests = sent / request_frame.size();
+        const size_t partial = sent % request_frame.size();
+        size_t replies = 0;
+        std::string response;
+        auto read_replies = [&]() {
+            while (slow >= 0 && replies < requests && ipc::read_message(slow, response) &&
+                   response.find("moveForward executed") != std::string::npos) {
+                ++replies;
+            }
+        };
+        read_replies();
+        if (partial != 0 && replies == requests &&
+            ipc::write_exact(slow, request_frame.data() + partial, request_frame.size() - partial) > 0) {
+            ++requests;
+            read_replies();
+        }
+
+        server.stop();
+        server_thread.join();
+        if (slow >= 0) ::close(slow);
+        if (probe >= 0) ::close(probe);
+        const double max_ms = static_cast<double>(max_round_trip_us.load()) / 1000.0;
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "flooded=%zu replies=%zu probe_round_trips=%llu probe_failed=%d max_rtt=%.1fms",
+                      requests, replies, static_cast<unsigned long long>(round_trips.load()), probe_failed.load(), max_ms);
+        return {name, requests > 0 && sent < frames.size() && replies == requests && !probe_failed.load() && max_ms <= 100.0,
+                detail};
+    }
+}
+
+int main() {
+    NullBuffer null_buffer;
+    std::streambuf* const cout_buffer = std::cout.rdbuf(&null_buffer);
+    std::streambuf* const cerr_buffer = std::cerr.rdbuf(&null_buffer);
+    const Result results[] = {check_priority_stop(), check_coalescing(), check_rate_limit(), check_ttl_out_of_range(),
+                              check_slow_reader(IpcBackend::BLOCKING, "slow_reader"),
+                              check_slow_reader(IpcBackend::IO_URING, "slow_reader_uring")};
+    std::cout.rdbuf(cout_buffer);
+    std::cerr.rdbuf(cerr_buffer);
+
+    bool pass = true;
+    std::printf("%-24s %-6s %s\n", "check", "result", "detail");
+    for (const Result& result : results) {
+        pass = pass && result.ok;
+        std::printf("%-24s %-6s %s\n", result.name.c_str(), result.ok ? "PASS" : "FAIL", result.detail.c_str());
+    }
+    return pass ? 0 : 1;
+}
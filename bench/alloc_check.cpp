@@ -0,0 +1,240 @@
+#include "fpvcar_device_control/ipc_server.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
+#include "fpvcar-motor/config.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// 稳态堆分配检查：替换全局 operator new（glibc 下同时替换 malloc/calloc/realloc）为计数钩子，
+// 在进程内启动 IpcServer + RequestHandler + ControlLoop，预热后发送 N 条运动指令，
+// 统计从读取套接字到控制循环执行期间所有线程的堆分配次数；出现任何分配则以退出码 1 失败
+//
+// 用法: fpvcar-alloc-check [稳态指令数，默认 100000]
+
+namespace {
+    std::atomic<bool> g_counting{false};
+    std::atomic<uint64_t> g_new_count{0};
+    std::atomic<uint64_t> g_malloc_count{0};
+
+    void count(std::atomic<uint64_t>& counter) {
+        if (g_counting.load(std::memory_order_relaxed)) counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* counted_new(std::size_t size) {
+        count(g_new_count);
+        void* p = std::malloc(size ? size : 1);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    void* counted_new_aligned(std::size_t size, std::align_val_t align) {
+        count(g_new_count);
+        const std::size_t alignment = static_cast<std::size_t>(align);
+        void* p = nullptr;
+        if (::posix_memalign(&p, std::max(alignment, sizeof(void*)), size ? size : 1) != 0) throw std::bad_alloc();
+        return p;
+    }
+}
+
+// --- 全局 operator new/delete 替换 ---
+void* operator new(std::size_t size) { return counted_new(size); }
+void* operator new[](std::size_t size) { return counted_new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return counted_new(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return counted_new(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t align) { return counted_new_aligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return counted_new_aligned(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// --- glibc 下替换 C 分配函数，覆盖不经过 operator new 的分配 ---
+#if defined(__GLIBC__)
+extern "C" {
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t n, std::size_t size);
+    void* __libc_realloc(void* p, std::size_t size);
+
+    void* malloc(std::size_t size) {
+        count(g_malloc_count);
+        return __libc_malloc(size);
+    }
+    void* calloc(std::size_t n, std::size_t size) {
+        count(g_malloc_count);
+        return __libc_calloc(n, size);
+    }
+    void* realloc(void* p, std::size_t size) {
+        count(g_malloc_count);
+        return __libc_realloc(p, size);
+    }
+}
+#endif
+
+using namespace fpvcar::device_control;
+
+namespace {
+    /**
+     * @brief 丢弃所有输出的流缓冲区（不分配内存，替代 ostringstream）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    std::string make_frame(const std::string& request) {
+        std::string frame;
+        uint32_t length_net = htonl(static_cast<uint32_t>(request.size()));
+        frame.append(reinterpret_cast<const char*>(&length_net), sizeof(length_net));
+        frame.append(request);
+        return frame;
+    }
+
+    int connect_to(const std::string& path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            std::perror("connect");
+            std::exit(1);
+        }
+        return fd;
+    }
+
+    /**
+     * @brief 发送 commands 条指令并校验每条响应都是成功响应
+     * @note 只使用预先构建的帧和栈上缓冲区，客户端自身不分配内存
+     */
+    bool send_commands(int fd, const std::vector<std::string>& frames, uint64_t commands) {
+        char buffer[4096];
+        for (uint64_t i = 0; i < commands; ++i) {
+            const std::string& frame = frames[i % frames.size()];
+            if (ipc::write_exact(fd, frame.data(), frame.size()) != static_cast<ssize_t>(frame.size())) return false;
+            uint32_t length_net;
+            if (ipc::read_exact(fd, &length_net, sizeof(length_net)) != sizeof(length_net)) return false;
+            const uint32_t length = ntohl(length_net);
+            if (length == 0 || length > sizeof(buffer)) return false;
+            if (ipc::read_exact(fd, buffer, length) != static_cast<ssize_t>(length)) return false;
+            if (std::string_view(buffer, length).find("\"status\":\"ok\"") == std::string_view::npos) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 对一个后端执行检查
+     * @return 稳态期间没有任何堆分配时返回 true
+     */
+    bool check_backend(IpcBackend backend, uint64_t commands) {
+        const std::string path = "/tmp/fpvcar_alloc_check_" + std::to_string(::getpid()) + ".sock";
+        const std::vector<std::string> frames = {
+            make_frame("{\"action\":\"moveForward\"}"),
+            make_frame("{\"action\":\"turnLeft\",\"ttl_ms\":1000}"),
+            make_frame("{ \"action\" : \"moveBackwardAndTurnRight\" , \"ttl_ms\" : 500 }"),
+            make_frame("{\"action\":\"stopAll\"}"),
+        };
+
+        // 没有硬件时跳过控制循环，只检查 IPC 与请求处理路径
+        DesiredStateManager manager;
+        std::unique_ptr<FpvCarMotorBackend> car;
+        std::unique_ptr<ControlLoop> loop;
+        try {
+            car = std::make_unique<FpvCarMotorBackend>(
+                fpvcar::motorconfig::I2C_DEVICE_PATH, fpvcar::motorconfig::DEFAULT_CHANNELS,
+                fpvcar::motorconfig::DEFAULT_PWM_FREQUENCY, fpvcar::motorconfig::PCA9685_I2C_ADDRESS);
+            loop = std::make_unique<ControlLoop>(manager, *car);
+            loop->start();
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "controller unavailable (%s), checking IPC path only\n", e.what());
+        }
+
+        RequestHandler handler(manager);
+        ControlLoop* loop_ptr = loop.get();
+        IpcServer server(path, [&handler, loop_ptr](std::string_view request, std::string& response) {
+            handler.handle_request(request, response);
+            if (loop_ptr) loop_ptr->feed_watchdog();
+            return IpcDisposition::KEEP;
+        }, backend);
+        auto prep = server.prepare();
+        if (!prep) {
+            std::fprintf(stderr, "prepare failed: %s\n", prep.error().c_str());
+            std::exit(1);
+        }
+        std::thread server_thread([&server]() { server.run(); });
+
+        int fd = connect_to(path);
+        // 预热：缓冲区增长到稳态容量，控制循环至少执行过每种状态
+        const uint64_t warmup = 10000;
+        bool ok = send_commands(fd, frames, warmup);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        g_new_count.store(0);
+        g_malloc_count.store(0);
+        g_counting.store(true);
+        ok = ok && send_commands(fd, frames, commands);
+        g_counting.store(false);
+        const uint64_t new_count = g_new_count.load();
+        const uint64_t malloc_count = g_malloc_count.load();
+
+        ::close(fd);
+        server.stop();
+        server_thread.join();
+        if (loop) loop->stop();
+
+        const bool pass = ok && new_count == 0 && malloc_count == 0;
+        std::printf("%-9s %10llu %12llu %14llu  %s\n",
+            backend == IpcBackend::IO_URING ? "io_uring" : "blocking",
+            static_cast<unsigned long long>(commands),
+            static_cast<unsigned long long>(new_count),
+            static_cast<unsigned long long>(malloc_count),
+            !ok ? "FAIL (bad response)" : (pass ? "PASS" : "FAIL"));
+        std::fflush(stdout);
+        return pass;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t commands = 100000;
+    if (argc > 1) commands = std::max<uint64_t>(1, std::strtoull(argv[1], nullptr, 10));
+
+    // 服务日志（状态切换、租约到期等）写入空缓冲区
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf(&null_buffer);
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    std::printf("%-9s %10s %12s %14s  %s\n", "backend", "commands", "operator_new", "malloc_calls", "result");
+    bool pass = true;
+    for (IpcBackend backend : {IpcBackend::BLOCKING, IpcBackend::IO_URING}) {
+        pass = check_backend(backend, commands) && pass;
+    }
+
+    std::cout.rdbuf(saved_cout);
+    std::cerr.rdbuf(saved_cerr);
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,309 @@
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/pca9685.hpp"
+#include "fpvcar_device_control/static_pca9685.hpp"
+#ifdef FPVCAR_STATIC_CHANNEL_LAYOUT
+#include "fpvcar_device_control/static_channel_layout.hpp"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// 编译期通道布局基准：运行时配置的 Pca9685MotorBackend（COALESCED）与 StaticPca9685Backend 比较，分三部分：
+//   - equivalence：同一个随机序列（状态指令、按车轮设置占空比、重新初始化、读回寄存器）分别驱动两个后端和各自的 PCA9685 仿真器，
+//     每一步后比较 LED 寄存器与事务数、字节数
+//   - time：挂在只计数的传输层上（不限速、不加锁统计），测量每条状态指令与每个闭环周期（一次 set_wheel_duty）的 CPU 耗时，
+//     即总线之外的开销；每项跑多轮取最快的一轮
+//   - size：从本进程可执行文件的符号表（nm）累加两个后端的代码与只读数据大小（不含两者共用的 configure_chip 等）
+// 使用的布局：打开 FPVCAR_STATIC_CHANNEL_LAYOUT 时为构建时配置的布局，否则为 DefaultChannelLayout
+// 比较失败时以退出码 1 结束；耗时与体积在 -Os（Yocto 交叉编译）构建下比较才有意义
+// 用法: fpvcar-channel-bench [每轮指令数] [轮数]
+
+using namespace fpvcar::device_control;
+
+namespace {
+#ifdef FPVCAR_STATIC_CHANNEL_LAYOUT
+    using Layout = ConfiguredChannelLayout;
+    constexpr const char* LAYOUT_NAME = "configured (FPVCAR_STATIC_CHANNEL_LAYOUT)";
+#else
+    using Layout = DefaultChannelLayout;
+    constexpr const char* LAYOUT_NAME = "DefaultChannelLayout";
+#endif
+    using StaticBackend = StaticPca9685Backend<Layout>;
+
+    /**
+     * @brief 丢弃所有输出的流缓冲区（后端的频率告警）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    /**
+     * @brief 只计数的传输层：不访问总线，只累加事务数、字节数与数据校验和（防止写入被优化掉）
+     */
+    class CountingTransport : public I2cTransport {
+    public:
+        CountingTransport() : I2cTransport(400000) {}
+
+        void write(uint8_t, const uint8_t* data, size_t size) override {
+            ++transactions;
+            bytes += size;
+            for (size_t i = 0; i < size; ++i) checksum = checksum * 31 + data[i];
+        }
+
+        void write_read(uint8_t address, const uint8_t* out, size_t out_size, uint8_t*, size_t) override {
+            write(address, out, out_size);
+        }
+
+        uint64_t transactions = 0;
+        uint64_t bytes = 0;
+        uint64_t checksum = 0;
+    };
+
+    std::unique_ptr<MotorBackend> make_runtime(I2cTransport& transport) {
+        auto backend = std::make_unique<Pca9685MotorBackend>(transport, Layout::channels, static_cast<float>(Layout::pwm_frequency), Layout::address);
+        backend->initialize();
+        return backend;
+    }
+
+    void call_state(MotorBackend& backend, DesiredState state) {
+        switch (state) {
+            case DesiredState::MOVING_FORWARD: backend.moveForward(); break;
+            case DesiredState::MOVING_BACKWARD: backend.moveBackward(); break;
+            case DesiredState::TURNING_LEFT: backend.turnLeft(); break;
+            case DesiredState::TURNING_RIGHT: backend.turnRight(); break;
+            case DesiredState::MOVING_FORWARD_AND_TURN_LEFT: backend.moveForwardAndTurnLeft(); break;
+            case DesiredState::MOVING_FORWARD_AND_TURN_RIGHT: backend.moveForwardAndTurnRight(); break;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_LEFT: backend.moveBackwardAndTurnLeft(); break;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT: backend.moveBackwardAndTurnRight(); break;
+            case DesiredState::STOPPING: backend.stopAll(); break;
+        }
+    }
+
+    /**
+     * @brief 与上一条不同的随机状态序列（控制循环只在状态变化时调用电机）
+     */
+    std::vector<DesiredState> random_states(uint64_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> pick(0, static_cast<int>(DesiredState::STOPPING));
+        std::vector<DesiredState> states;
+        states.reserve(count);
+        DesiredState previous = DesiredState::STOPPING;
+        for (uint64_t i = 0; i < count; ++i) {
+            DesiredState state;
+            do {
+                state = static_cast<DesiredState>(pick(rng));
+            } while (state == previous);
+            states.push_back(state);
+            previous = state;
+        }
+        return states;
+    }
+
+    /**
+     * @brief 闭环的占空比序列：目标在几个状态之间切换，每个周期在目标附近小幅变化（PI 输出的典型形态）
+     */
+    std::vector<WheelDuty> closed_loop_duties(uint64_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> noise(-400, 400);
+        const std::vector<DesiredState> targets = random_states(count / 200 + 1, seed + 1);
+        std::vector<WheelDuty> duties;
+        duties.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            const WheelDuty target = wheel_setpoints(targets[i / 200], pca9685::TURN_INNER_DUTY);
+            WheelDuty duty{};
+            for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+                duty[w] = target[w] == 0 ? 0 : std::clamp(target[w] + noise(rng), -DUTY_FULL, DUTY_FULL);
+            }
+            duties.push_back(duty);
+        }
+        return duties;
+    }
+
+    /**
+     * @brief 比较两个仿真器的 LED 寄存器与传输统计
+     */
+    bool emulators_match(const Pca9685Emulator& a, const Pca9685Emulator& b) {
+        for (uint8_t reg = pca9685::MODE1; reg <= pca9685::LED15_OFF_H; ++reg) {
+            if (a.register_value(reg) != b.register_value(reg)) return false;
+        }
+        if (a.register_value(pca9685::PRESCALE) != b.register_value(pca9685::PRESCALE)) return false;
+        const I2cStats sa = a.stats();
+        const I2cStats sb = b.stats();
+        return sa.transactions == sb.transactions && sa.write_bytes == sb.write_bytes;
+    }
+
+    /**
+     * @brief 同一随机序列驱动两个后端，每一步后比较；返回是否全部一致
+     */
+    bool run_equivalence(uint64_t steps) {
+        Pca9685Emulator runtime_emulator(Layout::address, 400000, false);
+        Pca9685Emulator static_emulator(Layout::address, 400000, false);
+        const auto runtime = make_runtime(runtime_emulator);
+        StaticBackend fixed(static_emulator);
+        fixed.initialize();
+        bool pass = emulators_match(runtime_emulator, static_emulator);
+
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> action(0, 99);
+        std::uniform_int_distribution<int> pick(0, static_cast<int>(DesiredState::STOPPING));
+        std::uniform_int_distribution<int32_t> duty(-DUTY_FULL, DUTY_FULL);
+        uint64_t mismatches = 0;
+        for (uint64_t i = 0; i < steps; ++i) {
+            const int a = action(rng);
+            if (a < 70) {
+                // 包括与上一条相同的状态（写入表的对角线为空）
+                const DesiredState state = static_cast<DesiredState>(pick(rng));
+                call_state(*runtime, state);
+                call_state(fixed, state);
+            } else if (a < 98) {
+                WheelDuty d{};
+                for (int32_t& v : d) v = a < 90 ? duty(rng) : 0;
+                runtime->set_wheel_duty(d);
+                fixed.set_wheel_duty(d);
+            } else if (a < 99) {
+                runtime->reinitialize();
+                fixed.reinitialize();
+            } else {
+                // 读回寄存器（接管）之后两者仍然写入相同的事务
+                runtime->adopt_outputs();
+                fixed.adopt_outputs();
+            }
+            if (!emulators_match(runtime_emulator, static_emulator)) ++mismatches;
+        }
+        pass = pass && mismatches == 0;
+        const I2cStats stats = static_emulator.stats();
+        std::printf("equivalence: %llu steps, %llu transactions, %llu mismatches  %s\n",
+            static_cast<unsigned long long>(steps), static_cast<unsigned long long>(stats.transactions),
+            static_cast<unsigned long long>(mismatches), pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    /**
+     * @brief 多轮中最快一轮的每次调用耗时（ns）
+     */
+    template <typename F>
+    double best_ns_per_call(uint64_t calls, int rounds, F&& round) {
+        double best = 0.0;
+        for (int r = 0; r < rounds; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            round();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / static_cast<double>(calls);
+            best = r == 0 ? ns : std::min(best, ns);
+        }
+        return best;
+    }
+
+    void run_time(const char* name, MotorBackend& backend, const CountingTransport& transport,
+                  const std::vector<DesiredState>& states, const std::vector<WheelDuty>& duties, int rounds) {
+        const uint64_t before = transport.transactions;
+        const double per_command = best_ns_per_call(states.size(), rounds, [&]() {
+            for (DesiredState state : states) call_state(backend, state);
+        });
+        const uint64_t command_txn = transport.transactions - before;
+        const double per_tick = best_ns_per_call(duties.size(), rounds, [&]() {
+            for (const WheelDuty& duty : duties) backend.set_wheel_duty(duty);
+        });
+        std::printf("%-8s %12.1f %12.2f %12.1f\n", name, per_command,
+            static_cast<double>(command_txn) / static_cast<double>(rounds * states.size()), per_tick);
+    }
+
+    struct SymbolSize {
+        uint64_t text = 0;
+        uint64_t data = 0;
+        size_t symbols = 0;
+    };
+
+    /**
+     * @brief 用 nm 累加名字包含 pattern 的符号大小；nm 不可用时返回 false
+     */
+    bool symbol_size(const char* pattern, SymbolSize& out) {
+        // /proc/self 在 nm 进程里指向 nm 自己，这里用本进程的 pid
+        const std::string command = "nm -C -S /proc/" + std::to_string(::getpid()) + "/exe 2>/dev/null";
+        FILE* pipe = ::popen(command.c_str(), "r");
+        if (!pipe) return false;
+        char line[4096];
+        bool any = false;
+        while (std::fgets(line, sizeof(line), pipe)) {
+            any = true;
+            // 格式：地址 大小 类型 名字
+            char* rest = line;
+            const unsigned long long address = std::strtoull(rest, &rest, 16);
+            (void)address;
+            char* size_end = nullptr;
+            const unsigned long long size = std::strtoull(rest, &size_end, 16);
+            if (size_end == rest || *size_end != ' ') continue;
+            const char type = size_end[1];
+            const char* name = size_end + 3;
+            if (!std::strstr(name, pattern)) continue;
+            ++out.symbols;
+            if (type == 't' || type == 'T' || type == 'W' || type == 'w') {
+                out.text += size;
+            } else {
+                out.data += size;
+            }
+        }
+        ::pclose(pipe);
+        return any;
+    }
+
+    void run_size() {
+        SymbolSize runtime;
+        SymbolSize fixed;
+        if (!symbol_size("Pca9685MotorBackend::", runtime) || !symbol_size("StaticPca9685Backend<", fixed)) {
+            std::printf("size: nm not available\n");
+            return;
+        }
+        std::printf("%-8s %10s %10s %10s\n", "backend", "text_B", "rodata_B", "symbols");
+        std::printf("%-8s %10llu %10llu %10zu\n", "runtime", static_cast<unsigned long long>(runtime.text),
+            static_cast<unsigned long long>(runtime.data), runtime.symbols);
+        std::printf("%-8s %10llu %10llu %10zu\n", "static", static_cast<unsigned long long>(fixed.text),
+            static_cast<unsigned long long>(fixed.data), fixed.symbols);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t commands = 200000;
+    int rounds = 5;
+    if (argc > 1) commands = std::max<uint64_t>(1, std::strtoull(argv[1], nullptr, 10));
+    if (argc > 2) rounds = std::max(1, std::atoi(argv[2]));
+
+    NullBuffer null_buffer;
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    std::printf("layout: %s, %.0f Hz (prescale %u), address 0x%02x\n", LAYOUT_NAME, StaticBackend::pwm_frequency(),
+        static_cast<unsigned>(StaticBackend::PRESCALE), static_cast<unsigned>(Layout::address));
+    const bool pass = run_equivalence(std::min<uint64_t>(commands, 50000));
+
+    const std::vector<DesiredState> states = random_states(commands, 42);
+    const std::vector<WheelDuty> duties = closed_loop_duties(commands, 43);
+    std::printf("\ntime: %llu calls per round, best of %d rounds, counting transport (no bus time)\n",
+        static_cast<unsigned long long>(commands), rounds);
+    std::printf("%-8s %12s %12s %12s\n", "backend", "ns/command", "txn/command", "ns/tick");
+    CountingTransport runtime_transport;
+    const auto runtime = make_runtime(runtime_transport);
+    run_time("runtime", *runtime, runtime_transport, states, duties, rounds);
+    CountingTransport static_transport;
+    StaticBackend fixed(static_transport);
+    fixed.initialize();
+    run_time("static", fixed, static_transport, states, duties, rounds);
+    if (runtime_transport.checksum != static_transport.checksum) {
+        std::printf("time: register writes differ between backends  FAIL\n");
+    }
+
+    std::printf("\nsize: symbols in this executable (shared pca9685:: helpers excluded)\n");
+    run_size();
+
+    std::cerr.rdbuf(saved_cerr);
+    return pass && runtime_transport.checksum == static_transport.checksum ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+#include "fpvcar_device_control/client.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/ipc_server.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 客户端库基准：在进程内启动 IpcServer，分别用三种方式发送同样数量的 moveForward，报告吞吐与每条指令的延迟：
+//   - reconnect：每条指令新建连接、发送、等待响应、关闭（部分 gateway 目前的做法）
+//   - persistent_sync：DeviceControlClient 持久连接，request().get() 逐条等待响应
+//   - async_pipelined：DeviceControlClient 持久连接，command() 不等待响应，结果由回调统计（默认用法）
+// 最后检查自动重连：停止服务端后请求以失败交付，服务端在同一路径重新启动后客户端自动重连，请求恢复成功
+// 任何指令失败或重连检查失败时以退出码 1 结束
+// 用法: fpvcar-client-bench [每种方式的指令数]
+
+using namespace fpvcar::device_control;
+using BenchClock = std::chrono::steady_clock;
+
+namespace {
+    /**
+     * @brief 丢弃所有输出的流缓冲区（服务端的连接日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    /**
+     * @brief 一种方式的测量结果
+     */
+    struct Row {
+        const char* name;
+        uint64_t commands = 0;
+        uint64_t failed = 0;
+        double seconds = 0.0;
+        int64_t p50_ns = 0;
+        int64_t p99_ns = 0;
+        int64_t max_ns = 0;
+    };
+
+    /**
+     * @brief 进程内服务端：IpcServer + RequestHandler（不带控制循环）
+     */
+    class BenchServer {
+    public:
+        explicit BenchServer(const std::string& path)
+            : m_handler(m_manager),
+              m_server(path, [this](std::string_view request, std::string& response) {
+                  m_handler.handle_request(request, response);
+                  return IpcDisposition::KEEP;
+              }) {}
+
+        ~BenchServer() { stop(); }
+
+        bool start() {
+            if (!m_server.prepare()) return false;
+            m_thread = std::thread([this]() { m_server.run(); });
+            return true;
+        }
+
+        void stop() {
+            m_server.stop();
+            if (m_thread.joinable()) m_thread.join();
+        }
+
+    private:
+        DesiredStateManager m_manager;
+        RequestHandler m_handler;
+        IpcServer m_server;
+        std::thread m_thread;
+    };
+
+    int64_t percentile(std::vector<int64_t>& samples, double p) {
+        if (samples.empty()) return 0;
+        std::sort(samples.begin(), samples.end());
+        const size_t index = std::min(samples.size() - 1, static_cast<size_t>(p / 100.0 * static_cast<double>(samples.size())));
+        return samples[index];
+    }
+
+    Row run_reconnect(const std::string& path, uint64_t commands) {
+        Row row{"reconnect"};
+        std::vector<int64_t> latency;
+        latency.reserve(commands);
+        std::string response;
+        const auto begin = BenchClock::now();
+        for (uint64_t i = 0; i < commands; ++i) {
+            const auto t0 = BenchClock::now();
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+            const bool ok = fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                            ipc::write_message(fd, "{\"action\":\"moveForward\"}") && ipc::read_message(fd, response);
+            if (fd >= 0) ::close(fd);
+            if (!ok) {
+                ++row.failed;
+                continue;
+            }
+            latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - t0).count());
+        }
+        row.seconds = std::chrono::duration<double>(BenchClock::now() - begin).count();
+        row.commands = commands;
+        row.p50_ns = percentile(latency, 50.0);
+        row.p99_ns = percentile(latency, 99.0);
+        row.max_ns = percentile(latency, 100.0);
+        return row;
+    }
+
+    Row from_client(const char* name, uint64_t commands, double seconds, const ClientStats& stats) {
+        Row row{name};
+        row.commands = commands;
+        row.failed = stats.failed;
+        row.seconds = seconds;
+        row.p50_ns = stats.p50_latency_ns;
+        row.p99_ns = stats.p99_latency_ns;
+        row.max_ns = stats.max_latency_ns;
+        return row;
+    }
+
+    Row run_persistent_sync(const std::string& path, uint64_t commands) {
+        ClientOptions options;
+        options.socket_path = path;
+        DeviceControlClient client(options);
+        client.start();
+        client.wait_connected(std::chrono::seconds(1));
+        const auto begin = BenchClock::now();
+        for (uint64_t i = 0; i < commands; ++i) {
+            client.request("{\"action\":\"moveForward\"}").get();
+        }
+        const double seconds = std::chrono::duration<double>(BenchClock::now() - begin).count();
+        client.stop();
+        return from_client("persistent_sync", commands, seconds, client.stats());
+    }
+
+    Row run_async_pipelined(const std::string& path, uint64_t commands) {
+        ClientOptions options;
+        options.socket_path = path;
+        DeviceControlClient client(options);
+        client.start();
+        client.wait_connected(std::chrono::seconds(1));
+        std::atomic<uint64_t> done{0};
+        const auto begin = BenchClock::now();
+        for (uint64_t i = 0; i < commands;) {
+            // 未完成请求达到 max_pending 时 command() 立即返回 false，稍后重试
+            if (client.command("moveForward", 0, [&done](const ClientResult&) { done.fetch_add(1); })) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        while (done.load() < commands) std::this_thread::yield();
+        const double seconds = std::chrono::duration<double>(BenchClock::now() - begin).count();
+        client.stop();
+        return from_client("async_pipelined", commands, seconds, client.stats());
+    }
+
+    /**
+     * @brief 自动重连检查
+     * @return 服务端停止期间请求失败、重启后自动重连并恢复成功时返回 true
+     */
+    bool check_reconnect(const std::string& path, std::unique_ptr<BenchServer>& server) {
+        ClientOptions options;
+        options.socket_path = path;
+        DeviceControlClient client(options);
+        client.start();
+        const bool before = client.wait_connected(std::chrono::seconds(1)) &&
+                            client.request("{\"action\":\"stopAll\"}").get().status == ClientStatus::OK;
+
+        // 服务端停止并删除套接字：请求以失败交付（DISCONNECTED 或 NOT_CONNECTED）
+        server.reset();
+        ClientResult down = client.request("{\"action\":\"stopAll\"}").get();
+        for (int i = 0; i < 100 && down.status == ClientStatus::OK; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            down = client.request("{\"action\":\"stopAll\"}").get();
+        }
+
+        // 在同一路径重新启动服务端
+        server = std::make_unique<BenchServer>(path);
+        if (!server->start()) return false;
+        const auto restart = BenchClock::now();
+        const bool reconnected = client.wait_connected(std::chrono::seconds(3));
+        const double reconnect_ms = std::chrono::duration<double, std::milli>(BenchClock::now() - restart).count();
+        const ClientResult after = client.request("{\"action\":\"stopAll\"}").get();
+        const ClientStats stats = client.stats();
+        client.stop();
+
+        const bool pass = before && down.status != ClientStatus::OK && reconnected && after.status == ClientStatus::OK && stats.reconnects >= 1;
+        std::printf("reconnect: while_down=%s reconnected_after=%.1fms reconnects=%llu after=%s  %s\n",
+            client_status_to_string(down.status), reconnect_ms, static_cast<unsigned long long>(stats.reconnects),
+            client_status_to_string(after.status), pass ? "PASS" : "FAIL");
+        return pass;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t commands = 20000;
+    if (argc > 1) commands = std::max<uint64_t>(1, std::strtoull(argv[1], nullptr, 10));
+    const std::string path = "/tmp/fpvcar-client-bench." + std::to_string(::getpid()) + ".sock";
+
+    // 服务端的连接日志写入空缓冲区
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf(&null_buffer);
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    auto server = std::make_unique<BenchServer>(path);
+    if (!server->start()) {
+        std::cout.rdbuf(saved_cout);
+        std::cerr.rdbuf(saved_cerr);
+        std::fprintf(stderr, "failed to start server on %s\n", path.c_str());
+        return 1;
+    }
+
+    std::vector<Row> rows;
+    rows.push_back(run_reconnect(path, commands));
+    rows.push_back(run_persistent_sync(path, commands));
+    rows.push_back(run_async_pipelined(path, commands));
+
+    std::printf("fpvcar-client-bench: %llu commands per mode\n", static_cast<unsigned long long>(commands));
+    std::printf("%-16s %10s %8s %12s %10s %10s %10s\n", "mode", "commands", "failed", "cmd/s", "p50_us", "p99_us", "max_us");
+    bool pass = true;
+    for (const Row& row : rows) {
+        pass = pass && row.failed == 0;
+        std::printf("%-16s %10llu %8llu %12.0f %10.1f %10.1f %10.1f\n", row.name,
+            static_cast<unsigned long long>(row.commands), static_cast<unsigned long long>(row.failed),
+            static_cast<double>(row.commands) / row.seconds, static_cast<double>(row.p50_ns) / 1e3,
+            static_cast<double>(row.p99_ns) / 1e3, static_cast<double>(row.max_ns) / 1e3);
+    }
+    pass = check_reconnect(path, server) && pass;
+
+    server.reset();
+    std::cout.rdbuf(saved_cout);
+    std::cerr.rdbuf(saved_cerr);
+    return pass ? 0 : 1;
+}
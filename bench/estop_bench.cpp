@@ -0,0 +1,264 @@
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/estop.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/ipc_server.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/simulated_motor_backend.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 紧急停车延迟基准：在进程内运行 IpcServer → RequestHandler → ControlLoop（仿真电机，真实时钟），
+// 若干条负载连接不停地发送请求占满普通指令套接字，同时分别测量三种停车方式从发出到电机收到停车调用的延迟：
+//   - ipc_stopAll：普通 IPC 连接发送 {"action":"stopAll"}（排在负载请求之后，再等控制周期）
+//   - estop_socket：紧急停车套接字发送一个字节
+//   - estop_sigusr1：向本进程发送 SIGUSR1
+// 分两个阶段：
+//   - neutral：负载请求为 traceStop（完整的解析与处理路径，但不改变运动状态）
+//   - competing：负载请求为 moveForward，停车之后车辆立刻又被切回前进，普通 stopAll 可能在控制周期执行之前
+//     就被覆盖，永远到不了电机（计为 lost）
+// 紧急停车延迟的 p99 超过 --bound-us 或有任何丢失时以退出码 1 结束
+// 用法: fpvcar-estop-bench [--trials N] [--load N] [--bound-us US]
+
+using namespace fpvcar::device_control;
+
+namespace {
+    struct Options {
+        int trials = 200;      // 每种方式的测量次数
+        int load = 4;          // 负载连接数
+        int64_t bound_us = 2000; // 紧急停车 p99 上限
+    };
+
+    constexpr auto STOP_TIMEOUT = std::chrono::milliseconds(100); // 超过即计为丢失
+    constexpr const char* NEUTRAL_LOAD = "{\"action\":\"traceStop\"}";
+    constexpr const char* COMPETING_LOAD = "{\"action\":\"moveForward\"}";
+
+    /**
+     * @brief 丢弃所有输出的流缓冲区（控制循环的状态日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int connect_socket(const std::string& path, int type) {
+        int fd = ::socket(AF_UNIX, type, 0);
+        if (fd < 0) return -1;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    /**
+     * @brief 一种停车方式的测量结果
+     */
+    struct Result {
+        const char* name;
+        std::vector<int64_t> latency_ns;
+        int lost = 0;
+
+        int64_t percentile(double p) const {
+            if (latency_ns.empty()) return 0;
+            std::vector<int64_t> sorted = latency_ns;
+            std::sort(sorted.begin(), sorted.end());
+            const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size())));
+            return sorted[index];
+        }
+    };
+
+    void usage(const char* prog) {
+        std::fprintf(stderr, "Usage: %s [--trials N] [--load N] [--bound-us US]\n", prog);
+    }
+
+    bool parse_args(int argc, char** argv, Options& opt) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                return false;
+            }
+            const char* value = argv[++i];
+            if (arg == "--trials") opt.trials = std::max(1, std::atoi(value));
+            else if (arg == "--load") opt.load = std::max(0, std::atoi(value));
+            else if (arg == "--bound-us") opt.bound_us = std::max<int64_t>(1, std::atoll(value));
+            else {
+                usage(argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 1;
+
+    const std::string ipc_path = "/tmp/fpvcar-estop-bench." + std::to_string(::getpid()) + ".sock";
+    const std::string estop_path = "/tmp/fpvcar-estop-bench." + std::to_string(::getpid()) + ".estop.sock";
+
+    // 控制循环的状态日志写入空缓冲区
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf(&null_buffer);
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    SteadyClock& clock = SteadyClock::instance();
+    DesiredStateManager manager(clock);
+    SimulatedMotorBackend motor(clock);
+    ControlLoop loop(manager, motor, DesiredState::STOPPING, MotorFaultPolicy(), clock);
+    RequestHandler handler(manager);
+
+    // 记录测量开始之后电机收到的第一个停车调用
+    std::atomic<int64_t> armed_at{0};
+    std::atomic<int64_t> stopped_at{0};
+    motor.set_observer([&armed_at, &stopped_at](Clock::time_point, DesiredState state) {
+        if (state != DesiredState::STOPPING || armed_at.load() == 0) return;
+        int64_t expected = 0;
+        stopped_at.compare_exchange_strong(expected, now_ns());
+    });
+
+    IpcServer server(ipc_path, [&handler, &loop](std::string_view request, std::string& response) {
+        handler.handle_request(request, response);
+        loop.feed_watchdog();
+        return IpcDisposition::KEEP;
+    });
+    EmergencyStop estop(estop_path, [&loop]() { return loop.emergency_stop(); });
+
+    loop.start();
+    auto prepared = server.prepare();
+    auto estop_started = prepared ? estop.start() : prepared;
+    if (!prepared || !estop_started) {
+        std::cout.rdbuf(saved_cout);
+        std::cerr.rdbuf(saved_cerr);
+        std::fprintf(stderr, "setup failed: %s\n", (!prepared ? prepared.error() : estop_started.error()).c_str());
+        return 1;
+    }
+    std::thread server_thread([&server]() { server.run(); });
+
+    // 负载连接：不停地发送当前阶段的负载请求并等待响应
+    std::atomic<bool> loading{true};
+    std::atomic<const char*> load_request{NEUTRAL_LOAD};
+    std::atomic<uint64_t> load_requests{0};
+    std::vector<std::thread> loaders;
+    for (int i = 0; i < opt.load; ++i) {
+        loaders.emplace_back([&]() {
+            int fd = connect_socket(ipc_path, SOCK_STREAM);
+            if (fd < 0) return;
+            std::string response;
+            while (loading.load(std::memory_order_relaxed)) {
+                if (!ipc::write_message(fd, load_request.load(std::memory_order_relaxed)) || !ipc::read_message(fd, response)) break;
+                load_requests.fetch_add(1, std::memory_order_relaxed);
+            }
+            ::close(fd);
+        });
+    }
+
+    const int ipc_fd = connect_socket(ipc_path, SOCK_STREAM);
+    const int estop_fd = connect_socket(estop_path, SOCK_SEQPACKET);
+    std::mt19937 rng(1);
+    // 间隔超过一个控制周期（保证控制循环已切换到运动状态），且与控制周期不同步
+    std::uniform_int_distribution<int> spacing_us(12000, 22000);
+    std::string response;
+
+    // 一个阶段：每种停车方式轮流测量 trials 次
+    auto run_phase = [&](bool competing, Result (&results)[3]) {
+        load_request.store(competing ? COMPETING_LOAD : NEUTRAL_LOAD);
+        for (int trial = 0; trial < opt.trials; ++trial) {
+            for (Result& result : results) {
+                // 先让车辆处于运动状态（负载连接只在 competing 阶段发送运动指令）
+                if (!competing || opt.load == 0) manager.set_desired_state(DesiredState::MOVING_FORWARD);
+                std::this_thread::sleep_for(std::chrono::microseconds(spacing_us(rng)));
+
+                stopped_at.store(0);
+                const int64_t t0 = now_ns();
+                armed_at.store(t0);
+                if (&result == &results[0]) {
+                    ipc::write_message(ipc_fd, "{\"action\":\"stopAll\"}");
+                    ipc::read_message(ipc_fd, response);
+                } else if (&result == &results[1]) {
+                    char frame = ESTOP_FRAME;
+                    char ack = 0;
+                    ::send(estop_fd, &frame, 1, 0);
+                    ::recv(estop_fd, &ack, 1, 0);
+                } else {
+                    ::kill(::getpid(), SIGUSR1);
+                }
+                const int64_t deadline = t0 + std::chrono::duration_cast<std::chrono::nanoseconds>(STOP_TIMEOUT).count();
+                while (stopped_at.load() == 0 && now_ns() < deadline) std::this_thread::sleep_for(std::chrono::microseconds(50));
+                armed_at.store(0);
+                const int64_t stopped = stopped_at.load();
+                if (stopped == 0) {
+                    ++result.lost;
+                } else {
+                    result.latency_ns.push_back(stopped - t0);
+                }
+            }
+        }
+    };
+
+    Result neutral[] = {{"ipc_stopAll", {}, 0}, {"estop_socket", {}, 0}, {"estop_sigusr1", {}, 0}};
+    Result competing[] = {{"ipc_stopAll", {}, 0}, {"estop_socket", {}, 0}, {"estop_sigusr1", {}, 0}};
+    const auto begin = std::chrono::steady_clock::now();
+    run_phase(false, neutral);
+    run_phase(true, competing);
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    loading.store(false);
+    estop.stop();
+    server.stop();
+    if (server_thread.joinable()) server_thread.join();
+    for (auto& t : loaders) t.join();
+    ::close(ipc_fd);
+    ::close(estop_fd);
+    loop.stop();
+    const EstopStats stats = estop.stats();
+
+    std::cout.rdbuf(saved_cout);
+    std::cerr.rdbuf(saved_cerr);
+
+    std::printf("fpvcar-estop-bench: trials=%d load_connections=%d load_rate=%.0f req/s\n", opt.trials, opt.load,
+        static_cast<double>(load_requests.load()) / elapsed_s);
+    std::printf("%-10s %-14s %8s %6s %10s %10s %10s %10s\n", "load", "path", "samples", "lost", "p50_us", "p99_us", "max_us", "result");
+    bool pass = true;
+    for (const auto* phase : {&neutral, &competing}) {
+        for (const Result& result : *phase) {
+            const bool estop_path = &result != &(*phase)[0];
+            const bool ok = !estop_path || (result.lost == 0 && result.percentile(99.0) <= opt.bound_us * 1000);
+            pass = pass && ok;
+            std::printf("%-10s %-14s %8zu %6d %10.1f %10.1f %10.1f %10s\n", phase == &neutral ? "neutral" : "competing",
+                result.name, result.latency_ns.size(), result.lost,
+                static_cast<double>(result.percentile(50.0)) / 1e3, static_cast<double>(result.percentile(99.0)) / 1e3,
+                static_cast<double>(result.percentile(100.0)) / 1e3, estop_path ? (ok ? "PASS" : "FAIL") : "-");
+        }
+    }
+    std::printf("estop thread: triggers=%llu (socket %llu, SIGUSR1 %llu) failures=%llu mean_us=%.1f max_us=%.1f (receive -> stopAll returned)\n",
+        static_cast<unsigned long long>(stats.triggers), static_cast<unsigned long long>(stats.socket_triggers),
+        static_cast<unsigned long long>(stats.signal_triggers), static_cast<unsigned long long>(stats.failures),
+        stats.triggers > 0 ? static_cast<double>(stats.total_latency_ns) / static_cast<double>(stats.triggers) / 1e3 : 0.0,
+        static_cast<double>(stats.max_latency_ns) / 1e3);
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/motor_fault.hpp"
+#include "fpvcar_device_control/simulated_motor_backend.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// 电机故障处理检查：VirtualClock 下驱动 MotorFaultGuard 与 ControlLoop（无需硬件，结果可复现），检查：
+//   - 重试：注入 2 次故障后第 3 次调用成功，两次重试之间的间隔不短于退避时间（10ms、20ms）
+//   - 重新初始化与降级：每连续失败 3 次重新初始化一次后端，连续失败 6 次进入降级，之后一次成功的调用退出降级
+//   - CPU 份额：每次调用阻塞 30ms 后失败的总线上，失败调用占用的时间不超过 max_cpu_share
+//   - 控制循环：降级时期望状态被强制为停止，总线恢复后停车成功、退出降级，新的运动指令照常执行
+//     （分别从运动中和已停车开始：已停车时降级后的停车状态与上次执行的状态相同，仍须按退避间隔尝试停车才能退出降级）
+// 任一检查失败时以退出码 1 结束
+// 用法: fpvcar-fault-check
+
+using namespace fpvcar::device_control;
+using namespace std::chrono_literals;
+
+namespace {
+    /**
+     * @brief 丢弃所有输出的流缓冲区（故障处理与控制循环的日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    /**
+     * @brief 每次调用先占用 call_time（推进虚拟时钟）再抛出异常，模拟卡住后超时失败的 I2C 总线
+     */
+    class HangingBackend : public MotorBackend {
+    public:
+        HangingBackend(VirtualClock& clock, Clock::duration call_time) : m_clock(clock), m_call_time(call_time) {}
+
+        void moveForward() override { hang(); }
+        void moveBackward() override { hang(); }
+        void turnLeft() override { hang(); }
+        void turnRight() override { hang(); }
+        void moveForwardAndTurnLeft() override { hang(); }
+        void moveForwardAndTurnRight() override { hang(); }
+        void moveBackwardAndTurnLeft() override { hang(); }
+        void moveBackwardAndTurnRight() override { hang(); }
+        void stopAll() override { hang(); }
+        void reinitialize() override { hang(); }
+
+        Clock::duration busy() const { return m_busy; }
+
+    private:
+        void hang() {
+            m_clock.advance(m_call_time);
+            m_busy += m_call_time;
+            throw std::runtime_error("simulated I2C timeout");
+        }
+
+        VirtualClock& m_clock;
+        const Clock::duration m_call_time;
+        Clock::duration m_busy{0};
+    };
+
+    struct Result {
+        std::string name;
+        bool ok;
+        std::string detail;
+    };
+
+    double to_ms(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    Result check_retry() {
+        VirtualClock clock;
+        SimulatedMotorBackend motor(clock);
+        MotorFaultGuard guard(motor, clock);
+        motor.inject_faults(2);
+        std::vector<Clock::time_point> attempts;
+        bool stopped = false;
+        for (int step = 0; step < 1000 && !stopped; ++step) {
+            const uint64_t calls = guard.stats().calls;
+            const auto now = clock.now();
+            stopped = guard.run([&motor]() { motor.stopAll(); });
+            if (guard.stats().calls != calls) attempts.push_back(now);
+            clock.advance(1ms);
+        }
+        const MotorFaultStats stats = guard.stats();
+        const bool spaced = attempts.size() == 3 && attempts[1] - attempts[0] >= 10ms && attempts[2] - attempts[1] >= 20ms;
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "calls=%llu failures=%llu gaps=%.0f,%.0fms",
+                      static_cast<unsigned long long>(stats.calls), static_cast<unsigned long long>(stats.failures),
+                      attempts.size() > 1 ? to_ms(attempts[1] - attempts[0]) : 0.0,
+                      attempts.size() > 2 ? to_ms(attempts[2] - attempts[1]) : 0.0);
+        return {"retry_with_backoff", stopped && stats.calls == 3 && stats.failures == 2 && spaced && !stats.degraded, detail};
+    }
+
+    Result check_reinit_and_degrade() {
+        VirtualClock clock;
+        SimulatedMotorBackend motor(clock);
+        MotorFaultGuard guard(motor, clock);
+        motor.inject_faults(6);
+        bool degraded_before_success = false;
+        bool stopped = false;
+        for (int step = 0; step < 5000 && !stopped; ++step) {
+            const bool degraded = guard.degraded();
+            stopped = guard.run([&motor]() { motor.stopAll(); });
+            if (stopped) degraded_before_success = degraded;
+            clock.advance(1ms);
+        }
+        const MotorFaultStats stats = guard.stats();
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "failures=%llu reinits=%llu degraded_entries=%llu",
+                      static_cast<unsigned long long>(stats.failures), static_cast<unsigned long long>(stats.reinits),
+                      static_cast<unsigned long long>(stats.degraded_entries));
+        const bool ok = stopped && stats.failures == 6 && stats.reinits == 2 && motor.state().reinits == 2 &&
+                        stats.degraded_entries == 1 && degraded_before_success && !stats.degraded;
+        return {"reinit_and_degraded", ok, detail};
+    }
+
+    Result check_cpu_share() {
+        VirtualClock clock;
+        HangingBackend motor(clock, 30ms);
+        MotorFaultPolicy policy;
+        MotorFaultGuard guard(motor, clock, policy);
+        const auto start = clock.now();
+        while (clock.now() - start < 60s) {
+            guard.run([&motor]() { motor.stopAll(); });
+            clock.advance(1ms);
+        }
+        const double share = to_ms(motor.busy()) / to_ms(clock.now() - start);
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "busy=%.1f%% (limit %.0f%%) calls=%llu failures=%llu", share * 100.0,
+                      policy.max_cpu_share * 100.0, static_cast<unsigned long long>(guard.stats().calls),
+                      static_cast<unsigned long long>(guard.stats().failures));
+        return {"bounded_cpu_share", share <= policy.max_cpu_share && guard.degraded(), detail};
+    }
+
+    Result check_control_loop() {
+        VirtualClock clock;
+        DesiredStateManager manager(clock);
+        SimulatedMotorBackend motor(clock);
+        ControlLoop loop(manager, motor, DesiredState::STOPPING, MotorFaultPolicy(), clock);
+        // 电机最后一次成功执行的指令
+        std::atomic<DesiredState> applied{DesiredState::STOPPING};
+        motor.set_observer([&applied](Clock::time_point, DesiredState state) { applied.store(state); });
+        loop.start();
+        auto run_for = [&clock, &loop](Clock::duration d) {
+            for (auto end = clock.now() + d; clock.now() < end;) {
+                loop.feed_watchdog();
+                clock.advance(1ms);
+            }
+        };
+
+        manager.set_desired_state(DesiredState::MOVING_FORWARD);
+        run_for(50ms);
+        const bool moving = applied.load() == DesiredState::MOVING_FORWARD;
+
+        // 总线持续故障：运动指令反复失败，进入降级后期望状态被强制为停止
+        motor.inject_faults(1000);
+        manager.set_desired_state(DesiredState::TURNING_LEFT);
+        run_for(2s);
+        const bool degraded = loop.motor_faults().degraded;
+        const bool forced_stop = manager.get_desired_state() == DesiredState::STOPPING;
+
+        // 总线恢复：停车调用成功后退出降级，新的运动指令照常执行
+        motor.inject_faults(0);
+        run_for(1s);
+        const bool recovered = !loop.motor_faults().degraded && applied.load() == DesiredState::STOPPING;
+        manager.set_desired_state(DesiredState::MOVING_BACKWARD);
+        run_for(50ms);
+        const bool resumed = applied.load() == DesiredState::MOVING_BACKWARD;
+        loop.stop();
+
+        const MotorFaultStats stats = loop.motor_faults();
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "moving=%d degraded=%d forced_stop=%d recovered=%d resumed=%d reinits=%llu",
+                      moving, degraded, forced_stop, recovered, resumed, static_cast<unsigned long long>(stats.reinits));
+        return {"control_loop_degraded", moving && degraded && forced_stop && recovered && resumed, detail};
+    }
+
+    Result check_control_loop_from_stop() {
+        VirtualClock clock;
+        DesiredStateManager manager(clock);
+        SimulatedMotorBackend motor(clock);
+        ControlLoop loop(manager, motor, DesiredState::STOPPING, MotorFaultPolicy(), clock);
+        std::atomic<DesiredState> applied{DesiredState::STOPPING};
+        motor.set_observer([&applied](Clock::time_point, DesiredState state) { applied.store(state); });
+        loop.start();
+        auto run_for = [&clock, &loop](Clock::duration d) {
+            for (auto end = clock.now() + d; clock.now() < end;) {
+                loop.feed_watchdog();
+                clock.advance(1ms);
+            }
+        };
+
+        // 停车状态下总线故障：第一条运动指令反复失败，进入降级，上次成功执行的状态仍是停车
+        run_for(50ms);
+        motor.inject_faults(1000);
+        manager.set_desired_state(DesiredState::MOVING_FORWARD);
+        run_for(2s);
+        const bool degraded = loop.motor_faults().degraded;
+
+        // 总线恢复：降级期间的停车尝试成功后退出降级，新的运动指令照常执行
+        motor.inject_faults(0);
+        run_for(1s);
+        const bool recovered = !loop.motor_faults().degraded;
+        manager.set_desired_state(DesiredState::MOVING_BACKWARD);
+        run_for(50ms);
+        const bool resumed = applied.load() == DesiredState::MOVING_BACKWARD;
+        loop.stop();
+
+        const MotorFaultStats stats = loop.motor_faults();
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "degraded=%d recovered=%d resumed=%d calls=%llu failures=%llu", degraded,
+                      recovered, resumed, static_cast<unsigned long long>(stats.calls),
+                      static_cast<unsigned long long>(stats.failures));
+        return {"control_loop_from_stop", degraded && recovered && resumed, detail};
+    }
+}
+
+int main() {
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf(&null_buffer);
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    const Result results[] = {check_retry(), check_reinit_and_degrade(), check_cpu_share(), check_control_loop(),
+                               check_control_loop_from_stop()};
+
+    std::cout.rdbuf(saved_cout);
+    std::cerr.rdbuf(saved_cerr);
+
+    bool pass = true;
+    std::printf("%-24s %-6s %s\n", "check", "result", "detail");
+    for (const Result& result : results) {
+        pass = pass && result.ok;
+        std::printf("%-24s %-6s %s\n", result.name.c_str(), result.ok ? "PASS" : "FAIL", result.detail.c_str());
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/pca9685.hpp"
+#include "fpvcar_device_control/wheel_speed.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <thread>
+
+// I2C 总线开销基准：Pca9685MotorBackend 驱动 PCA9685 仿真器（无需硬件），分两部分：
+//   - per_command：随机的状态变更序列直接调用后端，统计每条指令的事务数、字节数、总线占用时间和冗余寄存器写入，
+//     并在每条指令后检查仿真器的通道输出与指令一致
+//   - per_tick：真实时钟下运行 ControlLoop 的 1kHz 闭环（编码器由仿真器的通道输出积分得到），仿真器按总线速率限速，
+//     统计每个控制周期的总线占用时间、占周期的比例和掉帧次数
+// 两部分都比较两种写入策略（逐通道写入 / 只写变化并合并事务）与两种总线速率（100kHz / 400kHz）
+// 另外检查接管时后端读回芯片寄存器而不复位（takeover）
+// 通道输出检查失败时以退出码 1 结束
+// 用法: fpvcar-i2c-bench [指令数] [每种配置的闭环秒数]
+
+using namespace fpvcar::device_control;
+
+namespace {
+    constexpr double FULL_SPEED_EPS = 2800.0; // 满占空比时的编码器边沿/秒
+
+    /**
+     * @brief 丢弃所有输出的流缓冲区（控制循环的状态日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    const char* policy_name(Pca9685WritePolicy policy) {
+        return policy == Pca9685WritePolicy::PER_CHANNEL ? "per_channel" : "coalesced";
+    }
+
+    /**
+     * @brief 统计每次电机调用的总线开销（在后端外包一层，调用前后取传输层统计的差值）
+     */
+    class MeasuredBackend : public MotorBackend {
+    public:
+        MeasuredBackend(MotorBackend& inner, I2cTransport& transport) : m_inner(inner), m_transport(transport) {}
+
+        void moveForward() override { measure([this]() { m_inner.moveForward(); }); }
+        void moveBackward() override { measure([this]() { m_inner.moveBackward(); }); }
+        void turnLeft() override { measure([this]() { m_inner.turnLeft(); }); }
+        void turnRight() override { measure([this]() { m_inner.turnRight(); }); }
+        void moveForwardAndTurnLeft() override { measure([this]() { m_inner.moveForwardAndTurnLeft(); }); }
+        void moveForwardAndTurnRight() override { measure([this]() { m_inner.moveForwardAndTurnRight(); }); }
+        void moveBackwardAndTurnLeft() override { measure([this]() { m_inner.moveBackwardAndTurnLeft(); }); }
+        void moveBackwardAndTurnRight() override { measure([this]() { m_inner.moveBackwardAndTurnRight(); }); }
+        void stopAll() override { measure([this]() { m_inner.stopAll(); }); }
+        bool supports_wheel_duty() const override { return true; }
+        void set_wheel_duty(const WheelDuty& duty) override { measure([this, &duty]() { m_inner.set_wheel_duty(duty); }); }
+
+        uint64_t calls = 0;
+        uint64_t transactions = 0;
+        uint64_t bytes = 0;
+        int64_t bus_time_ns = 0;
+        int64_t max_bus_time_ns = 0;
+        int64_t max_duration_ns = 0;
+
+    private:
+        template <typename F>
+        void measure(F&& call) {
+            const I2cStats before = m_transport.stats();
+            call();
+            const I2cStats after = m_transport.stats();
+            ++calls;
+            transactions += after.transactions - before.transactions;
+            bytes += after.write_bytes - before.write_bytes;
+            const int64_t bus = after.bus_time_ns - before.bus_time_ns;
+            bus_time_ns += bus;
+            max_bus_time_ns = std::max(max_bus_time_ns, bus);
+            max_duration_ns = std::max(max_duration_ns, after.duration_ns - before.duration_ns);
+        }
+
+        MotorBackend& m_inner;
+        I2cTransport& m_transport;
+    };
+
+    /**
+     * @brief 由仿真器调速通道的输出积分得到编码器边沿（轮速与占空比成正比）
+     */
+    class EmulatorEncoder : public WheelFeedback {
+    public:
+        EmulatorEncoder(const Pca9685Emulator& emulator, const std::array<pca9685::WheelChannels, WHEEL_COUNT>& channels)
+            : m_emulator(emulator), m_channels(channels), m_last(SteadyClock::instance().now()) {}
+
+        bool sample(EncoderSample& out) override {
+            const auto now = SteadyClock::instance().now();
+            const double dt = std::chrono::duration<double>(now - m_last).count();
+            m_last = now;
+            for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+                const double duty = static_cast<double>(m_emulator.channel_counts(m_channels[w].speed)) / pca9685::PWM_COUNTS;
+                m_travel[w] += duty * FULL_SPEED_EPS * dt;
+                out.edges[w] = static_cast<uint64_t>(m_travel[w]);
+            }
+            out.time = now;
+            return true;
+        }
+
+    private:
+        const Pca9685Emulator& m_emulator;
+        const std::array<pca9685::WheelChannels, WHEEL_COUNT> m_channels;
+        Clock::time_point m_last;
+        std::array<double, WHEEL_COUNT> m_travel{};
+    };
+
+    /**
+     * @brief 检查仿真器的通道输出与期望状态一致
+     */
+    bool outputs_match(const Pca9685Emulator& emulator, const std::array<pca9685::WheelChannels, WHEEL_COUNT>& channels, DesiredState state) {
+        const std::array<int32_t, WHEEL_COUNT> duty = wheel_setpoints(state, DUTY_FULL / 2);
+        for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+            if (emulator.channel_counts(channels[w].speed) != pca9685::duty_counts(duty[w])) return false;
+            if (emulator.channel_counts(channels[w].in1) != (duty[w] > 0 ? pca9685::PWM_COUNTS : 0)) return false;
+            if (emulator.channel_counts(channels[w].in2) != (duty[w] < 0 ? pca9685::PWM_COUNTS : 0)) return false;
+        }
+        return true;
+    }
+
+    void call_state(MotorBackend& backend, DesiredState state) {
+        switch (state) {
+            case DesiredState::MOVING_FORWARD: backend.moveForward(); break;
+            case DesiredState::MOVING_BACKWARD: backend.moveBackward(); break;
+            case DesiredState::TURNING_LEFT: backend.turnLeft(); break;
+            case DesiredState::TURNING_RIGHT: backend.turnRight(); break;
+            case DesiredState::MOVING_FORWARD_AND_TURN_LEFT: backend.moveForwardAndTurnLeft(); break;
+            case DesiredState::MOVING_FORWARD_AND_TURN_RIGHT: backend.moveForwardAndTurnRight(); break;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_LEFT: backend.moveBackwardAndTurnLeft(); break;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT: backend.moveBackwardAndTurnRight(); break;
+            case DesiredState::STOPPING: backend.stopAll(); break;
+        }
+    }
+
+    /**
+     * @brief 每条指令的总线开销；返回通道输出检查是否全部通过
+     */
+    bool run_per_command(Pca9685WritePolicy policy, uint32_t bus_speed_hz, uint64_t commands) {
+        const auto channels = fpvcar::motorconfig::DEFAULT_CHANNELS;
+        // 只统计不限速，几万条指令在一秒内完成
+        Pca9685Emulator emulator(fpvcar::motorconfig::PCA9685_I2C_ADDRESS, bus_speed_hz, false);
+        Pca9685MotorBackend backend(emulator, channels, 1000.0f, fpvcar::motorconfig::PCA9685_I2C_ADDRESS, policy);
+        backend.initialize();
+        MeasuredBackend measured(backend, emulator);
+        const auto wheel_channels = pca9685::wheel_channels(channels);
+        const Pca9685EmulatorStats init = emulator.device_stats();
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> pick(0, static_cast<int>(DesiredState::STOPPING));
+        DesiredState previous = DesiredState::STOPPING;
+        bool pass = true;
+        for (uint64_t i = 0; i < commands; ++i) {
+            // 控制循环只在状态变化时调用电机，这里同样只生成与上一条不同的状态
+            DesiredState state;
+            do {
+                state = static_cast<DesiredState>(pick(rng));
+            } while (state == previous);
+            call_state(measured, state);
+            pass = pass && outputs_match(emulator, wheel_channels, state);
+            previous = state;
+        }
+
+        const Pca9685EmulatorStats pca = emulator.device_stats();
+        const double n = static_cast<double>(measured.calls);
+        std::printf("%-12s %5u %10.1f %10.1f %12.1f %12.1f %12.1f  %s\n", policy_name(policy), bus_speed_hz / 1000,
+            static_cast<double>(measured.transactions) / n, static_cast<double>(measured.bytes) / n,
+            static_cast<double>(measured.bus_time_ns) / n / 1e3, static_cast<double>(measured.max_bus_time_ns) / 1e3,
+            static_cast<double>(pca.redundant_writes - init.redundant_writes) / n, pass ? "PASS" : "FAIL");
+        return pass;
+    }
+
+    /**
+     * @brief 1kHz 闭环下每个控制周期的总线开销
+     */
+    void run_per_tick(Pca9685WritePolicy policy, uint32_t bus_speed_hz, double seconds) {
+        const auto channels = fpvcar::motorconfig::DEFAULT_CHANNELS;
+        Clock& clock = SteadyClock::instance();
+        Pca9685Emulator emulator(fpvcar::motorconfig::PCA9685_I2C_ADDRESS, bus_speed_hz, true);
+        Pca9685MotorBackend backend(emulator, channels, 1000.0f, fpvcar::motorconfig::PCA9685_I2C_ADDRESS, policy);
+        backend.initialize();
+        MeasuredBackend measured(backend, emulator);
+        EmulatorEncoder encoder(emulator, pca9685::wheel_channels(channels));
+
+        DesiredStateManager manager(clock);
+        ControlLoop loop(manager, measured, DesiredState::STOPPING, MotorFaultPolicy(), clock);
+        WheelSpeedConfig speed;
+        speed.enabled = true;
+        speed.max_speed_eps = 0.7 * FULL_SPEED_EPS;
+        speed.feedforward = 0.7;
+        loop.set_wheel_speed_control(encoder, speed);
+
+        loop.start();
+        const DesiredState script[] = {
+            DesiredState::MOVING_FORWARD, DesiredState::MOVING_FORWARD_AND_TURN_LEFT, DesiredState::MOVING_FORWARD,
+            DesiredState::MOVING_FORWARD_AND_TURN_RIGHT, DesiredState::TURNING_LEFT, DesiredState::MOVING_BACKWARD,
+        };
+        const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        for (size_t i = 0; std::chrono::steady_clock::now() < end; ++i) {
+            manager.set_desired_state(script[i % (sizeof(script) / sizeof(script[0]))]);
+            loop.feed_watchdog();
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        const TickTimingStats timing = loop.tick_timing();
+        loop.stop();
+
+        const double calls = static_cast<double>(std::max<uint64_t>(1, measured.calls));
+        const double bus_us = static_cast<double>(measured.bus_time_ns) / calls / 1e3;
+        const double period_us = static_cast<double>(timing.target_interval_ns) / 1e3;
+        std::printf("%-12s %5u %10llu %10.1f %10.1f %10.1f %10.1f %9.0f%% %10llu %12.1f\n", policy_name(policy), bus_speed_hz / 1000,
+            static_cast<unsigned long long>(measured.calls), static_cast<double>(measured.transactions) / calls,
+            static_cast<double>(measured.bytes) / calls, bus_us, static_cast<double>(measured.max_duration_ns) / 1e3,
+            100.0 * bus_us / period_us, static_cast<unsigned long long>(timing.overruns),
+            static_cast<double>(timing.jitter_p99_ns) / 1e3);
+    }
+
+    /**
+     * @brief 接管：新实例的后端构造时不访问芯片，adopt_outputs 只读回寄存器、不改变输出；之后两个后端的指令都按芯片的实际寄存器写入
+     * @return 检查是否全部通过
+     */
+    bool run_takeover() {
+        const auto channels = fpvcar::motorconfig::DEFAULT_CHANNELS;
+        const uint8_t address = fpvcar::motorconfig::PCA9685_I2C_ADDRESS;
+        const auto wheel_channels = pca9685::wheel_channels(channels);
+        Pca9685Emulator emulator(address, 400000, false);
+        Pca9685MotorBackend old_backend(emulator, channels, 1000.0f, address);
+        old_backend.initialize();
+        old_backend.moveForward();
+
+        // 新实例：构造与读回都不写寄存器，电机保持旧实例的输出
+        const uint64_t writes = emulator.device_stats().register_writes;
+        Pca9685MotorBackend new_backend(emulator, channels, 1000.0f, address);
+        new_backend.adopt_outputs();
+        bool pass = emulator.device_stats().register_writes == writes && outputs_match(emulator, wheel_channels, DesiredState::MOVING_FORWARD);
+        new_backend.turnLeft();
+        pass = pass && outputs_match(emulator, wheel_channels, DesiredState::TURNING_LEFT);
+
+        // 移交失败、旧实例恢复：旧的寄存器副本（前进）已过时，读回后再前进必须重新写入
+        old_backend.adopt_outputs();
+        old_backend.moveForward();
+        pass = pass && outputs_match(emulator, wheel_channels, DesiredState::MOVING_FORWARD);
+
+        // 芯片未配置（上电状态）时 adopt_outputs 重新配置，输出全关
+        Pca9685Emulator fresh(address, 400000, false);
+        Pca9685MotorBackend fresh_backend(fresh, channels, 1000.0f, address);
+        fresh_backend.adopt_outputs();
+        pass = pass && !(fresh.register_value(pca9685::MODE1) & pca9685::MODE1_SLEEP) &&
+               outputs_match(fresh, wheel_channels, DesiredState::STOPPING);
+        fresh_backend.moveBackward();
+        pass = pass && outputs_match(fresh, wheel_channels, DesiredState::MOVING_BACKWARD);
+
+        std::printf("takeover: adopt running chip without writes, resume after failed handover, adopt unconfigured chip  %s\n",
+            pass ? "PASS" : "FAIL");
+        return pass;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t commands = 20000;
+    double seconds = 2.0;
+    if (argc > 1) commands = std::max<uint64_t>(1, std::strtoull(argv[1], nullptr, 10));
+    if (argc > 2) seconds = std::max(0.2, std::atof(argv[2]));
+
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf(&null_buffer);
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    const Pca9685WritePolicy policies[] = {Pca9685WritePolicy::PER_CHANNEL, Pca9685WritePolicy::COALESCED};
+    const uint32_t speeds[] = {100000, 400000};
+
+    std::printf("per_command: %llu random state changes (default channel layout, 12 channels)\n",
+        static_cast<unsigned long long>(commands));
+    std::printf("%-12s %5s %10s %10s %12s %12s %12s\n", "policy", "kHz", "txn/cmd", "bytes/cmd", "bus_us/cmd", "max_bus_us", "redundant/cmd");
+    bool pass = true;
+    for (Pca9685WritePolicy policy : policies) {
+        for (uint32_t speed : speeds) pass = run_per_command(policy, speed, commands) && pass;
+    }
+    std::printf("\n");
+    pass = run_takeover() && pass;
+
+    std::printf("\nper_tick: closed loop at 1 kHz for %.1f s per row, bus timing enforced\n", seconds);
+    std::printf("%-12s %5s %10s %10s %10s %10s %10s %10s %10s %12s\n", "policy", "kHz", "ticks", "txn/tick", "bytes/tick",
+        "bus_us", "max_us", "bus/period", "overruns", "jitter_p99us");
+    for (Pca9685WritePolicy policy : policies) {
+        for (uint32_t speed : speeds) run_per_tick(policy, speed, seconds);
+    }
+
+    std::cout.rdbuf(saved_cout);
+    std::cerr.rdbuf(saved_cerr);
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include "fpvcar_device_control/ipc_server.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// IPC 后端对比基准：在进程内启动 IpcServer，用若干客户端连接发送指令，
+// 对比阻塞后端（read_exact/write_exact 循环）与 io_uring 后端的
+// 每条指令系统调用次数、每万条指令的服务器线程 CPU 时间和吞吐
+//
+// 用法: fpvcar-ipc-bench [每个场景的指令总数]
+
+using namespace fpvcar::device_control;
+using BenchClock = std::chrono::steady_clock;
+
+namespace {
+    struct Scenario {
+        int connections;  // 客户端连接数
+        int depth;        // 流水线深度：每次连续发送的请求数，收齐响应后再发下一批
+    };
+
+    int connect_to(const std::string& path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            std::perror("connect");
+            std::exit(1);
+        }
+        return fd;
+    }
+
+    void run_client(const std::string& path, uint64_t commands, int depth) {
+        int fd = connect_to(path);
+        const std::string request = "{\"action\":\"moveForward\"}";
+        std::string frame;
+        uint32_t length_net = htonl(static_cast<uint32_t>(request.size()));
+        frame.append(reinterpret_cast<const char*>(&length_net), sizeof(length_net));
+        frame.append(request);
+
+        std::string batch;
+        for (uint64_t sent = 0; sent < commands;) {
+            const uint64_t n = std::min<uint64_t>(static_cast<uint64_t>(depth), commands - sent);
+            batch.clear();
+            for (uint64_t i = 0; i < n; ++i) batch.append(frame);
+            if (ipc::write_exact(fd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) {
+                std::perror("write");
+                std::exit(1);
+            }
+            for (uint64_t i = 0; i < n; ++i) {
+                if (ipc::read_message(fd).empty()) {
+                    std::fprintf(stderr, "server closed connection\n");
+                    std::exit(1);
+                }
+            }
+            sent += n;
+        }
+        ::close(fd);
+    }
+
+    void run_scenario(IpcBackend backend, const Scenario& scenario, uint64_t total_commands) {
+        const std::string path = "/tmp/fpvcar_ipc_bench_" + std::to_string(::getpid()) + ".sock";
+        DesiredStateManager manager;
+        RequestHandler handler(manager);
+        IpcServer server(path, [&handler](std::string_view req, std::string& response) {
+            handler.handle_request(req, response);
+            return IpcDisposition::KEEP;
+        }, backend);
+        auto prep = server.prepare();
+        if (!prep) {
+            std::fprintf(stderr, "prepare failed: %s\n", prep.error().c_str());
+            std::exit(1);
+        }
+        std::thread server_thread([&server]() { server.run(); });
+
+        const uint64_t per_connection = total_commands / static_cast<uint64_t>(scenario.connections);
+        auto start = BenchClock::now();
+        std::vector<std::thread> clients;
+        for (int c = 0; c < scenario.connections; ++c) {
+            clients.emplace_back(run_client, path, per_connection, scenario.depth);
+        }
+        for (auto& t : clients) t.join();
+        const double elapsed_s = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+        server.stop();
+        server_thread.join();
+        const IpcServerStats stats = server.stats();
+
+        const double commands = static_cast<double>(stats.commands);
+        std::printf("%-9s %5d %6d %10llu %12.3f %14.1f %12.0f\n",
+            backend == IpcBackend::IO_URING ? "io_uring" : "blocking",
+            scenario.connections, scenario.depth,
+            static_cast<unsigned long long>(stats.commands),
+            commands > 0 ? static_cast<double>(stats.syscalls) / commands : 0.0,
+            commands > 0 ? static_cast<double>(stats.cpu_ns) / commands * 10000.0 / 1000.0 : 0.0,
+            commands / elapsed_s);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t total_commands = 100000;
+    if (argc > 1) total_commands = std::max<uint64_t>(1, std::strtoull(argv[1], nullptr, 10));
+
+    // 服务器日志（io_uring 回退提示等）不计入结果
+    std::ostringstream discarded;
+    std::streambuf* saved_cout = std::cout.rdbuf(discarded.rdbuf());
+
+    const std::vector<Scenario> scenarios = {{1, 1}, {1, 16}, {4, 1}, {4, 16}};
+    std::printf("%-9s %5s %6s %10s %12s %14s %12s\n",
+        "backend", "conns", "depth", "commands", "syscalls/cmd", "cpu_us/10kcmd", "cmd/s");
+    for (const auto& scenario : scenarios) {
+        for (IpcBackend backend : {IpcBackend::BLOCKING, IpcBackend::IO_URING}) {
+            run_scenario(backend, scenario, total_commands);
+        }
+    }
+    std::cout.rdbuf(saved_cout);
+    return 0;
+}
@@ -0,0 +1,375 @@
+#include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/config.hpp"
+#include "fpvcar_device_control/fast_request_parser.hpp"
+#include "fpvcar_device_control/flight_recorder.hpp"
+#include <nlohmann/json.hpp>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// fpvcar-microbench：请求与状态热路径的微基准
+// 每个基准以固定迭代次数运行若干个样本，统计每次操作耗时（ns/op）的均值、中位数、标准差、最小/最大值和 p99，
+// 并把结果写成 JSON，便于对这些路径的每次改动给出前后对比数据
+//
+// 用法: fpvcar-microbench [--out PATH] [--filter SUBSTR] [--samples N] [--scale FACTOR]
+
+using nlohmann::json;
+using namespace fpvcar::device_control;
+using BenchClock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        std::string out_path = "microbench_results.json";
+        std::string filter;
+        int samples = 15;
+        double scale = 1.0; // 迭代次数缩放系数
+    };
+
+    /**
+     * @brief 一个基准的统计结果（单位：ns/op）
+     */
+    struct Result {
+        std::string name;
+        uint64_t iterations = 0; // 每个样本的迭代次数
+        int samples = 0;
+        double mean = 0, median = 0, stddev = 0, min = 0, max = 0, p99 = 0;
+    };
+
+    /**
+     * @brief 一个基准：body(iterations) 执行指定次数的操作并返回实际耗时
+     * @note 返回耗时而不是由框架计时，方便多线程基准排除线程创建开销
+     */
+    struct Benchmark {
+        std::string name;
+        uint64_t iterations;
+        std::function<BenchClock::duration(uint64_t)> body;
+    };
+
+    volatile uint64_t g_sink = 0; // 防止编译器把被测代码优化掉
+
+    /**
+     * @brief 把一个单线程操作包装为计时的基准体
+     */
+    template <typename F>
+    std::function<BenchClock::duration(uint64_t)> timed(F op) {
+        return [op](uint64_t iterations) mutable {
+            auto start = BenchClock::now();
+            for (uint64_t i = 0; i < iterations; ++i) op(i);
+            return BenchClock::now() - start;
+        };
+    }
+
+    Result summarize(const std::string& name, uint64_t iterations, std::vector<double> ns_per_op) {
+        Result r;
+        r.name = name;
+        r.iterations = iterations;
+        r.samples = static_cast<int>(ns_per_op.size());
+        std::sort(ns_per_op.begin(), ns_per_op.end());
+        const size_t n = ns_per_op.size();
+        double sum = 0;
+        for (double v : ns_per_op) sum += v;
+        r.mean = sum / static_cast<double>(n);
+        r.median = (n % 2) ? ns_per_op[n / 2] : (ns_per_op[n / 2 - 1] + ns_per_op[n / 2]) / 2.0;
+        double var = 0;
+        for (double v : ns_per_op) var += (v - r.mean) * (v - r.mean);
+        r.stddev = n > 1 ? std::sqrt(var / static_cast<double>(n - 1)) : 0.0;
+        r.min = ns_per_op.front();
+        r.max = ns_per_op.back();
+        r.p99 = ns_per_op[std::min(n - 1, static_cast<size_t>(std::ceil(0.99 * static_cast<double>(n))) - 1)];
+        return r;
+    }
+
+    Result run(const Benchmark& bench, const Options& opt) {
+        const uint64_t iterations = std::max<uint64_t>(1, static_cast<uint64_t>(static_cast<double>(bench.iterations) * opt.scale));
+        bench.body(std::max<uint64_t>(1, iterations / 10)); // 预热，结果丢弃
+        std::vector<double> ns_per_op;
+        for (int s = 0; s < opt.samples; ++s) {
+            auto elapsed = bench.body(iterations);
+            ns_per_op.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations));
+        }
+        return summarize(bench.name, iterations, std::move(ns_per_op));
+    }
+
+    /**
+     * @brief 在 threads 个线程上同时执行 op，每个线程执行 iterations 次
+     * @return 从所有线程同时开始到全部结束的耗时（不含线程创建）
+     */
+    template <typename F>
+    BenchClock::duration run_parallel(int threads, uint64_t iterations, F op) {
+        std::atomic<bool> go{false};
+        std::atomic<int> ready{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {}
+                for (uint64_t i = 0; i < iterations; ++i) op(t, i);
+            });
+        }
+        while (ready.load() < threads) {}
+        auto start = BenchClock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& w : workers) w.join();
+        return BenchClock::now() - start;
+    }
+
+    const std::vector<std::string> ACTIONS = {
+        "moveForward", "moveBackward", "turnLeft", "turnRight",
+        "moveForwardAndTurnLeft", "moveForwardAndTurnRight",
+        "moveBackwardAndTurnLeft", "moveBackwardAndTurnRight", "stopAll",
+    };
+
+    // 错误路径：名称 -> 请求内容
+    const std::vector<std::pair<std::string, std::string>> ERROR_CASES = {
+        {"invalid_json", "{\"action\": \"moveForward\""},
+        {"missing_action", "{\"speed\": 1}"},
+        {"empty_action", "{\"action\": \"\"}"},
+        {"unknown_action", "{\"action\": \"flyToTheMoon\"}"},
+    };
+
+    std::vector<Benchmark> make_benchmarks(DesiredStateManager& manager, RequestHandler& handler, const std::string& config_path) {
+        std::vector<Benchmark> benches;
+
+        // --- RequestHandler::handle_request ---
+        for (const auto& action : ACTIONS) {
+            std::string request = "{\"action\":\"" + action + "\"}";
+            benches.push_back({"handle_request/" + action, 100000, timed([&handler, request](uint64_t) {
+                g_sink = g_sink + handler.handle_request(request).size();
+            })});
+        }
+        // 复用响应缓冲区：IpcServer 实际使用的调用方式（快速解析路径，无堆分配）
+        for (const std::string request : {"{\"action\":\"moveForward\"}", "{\"action\":\"moveForward\",\"ttl_ms\":150}"}) {
+            const std::string name = request.find("ttl_ms") != std::string::npos ? "moveForward+ttl" : "moveForward";
+            benches.push_back({"handle_request/reuse/" + name, 200000, timed([&handler, request, response = std::string()](uint64_t) mutable {
+                handler.handle_request(std::string_view(request), response);
+                g_sink = g_sink + response.size();
+            })});
+        }
+        for (const auto& [name, request] : ERROR_CASES) {
+            benches.push_back({"handle_request/error/" + name, 100000, timed([&handler, request = request](uint64_t) {
+                g_sink = g_sink + handler.handle_request(request).size();
+            })});
+        }
+
+        // --- 请求解析：快速路径（SIMD / 标量扫描）vs nlohmann DOM ---
+        const std::vector<std::pair<std::string, std::string>> parse_cases = {
+            {"moveForward", "{\"action\":\"moveForward\"}"},
+            {"moveForward+ttl", "{\"action\":\"moveForward\",\"ttl_ms\":150}"},
+            {"long+spaces", "{ \"action\" : \"moveBackwardAndTurnRight\" , \"ttl_ms\" : 500 }"},
+        };
+        for (const auto& [name, request] : parse_cases) {
+            benches.push_back({"parse/fast/" + name, 500000, timed([request = request](uint64_t) {
+                FastRequest fast;
+                g_sink = g_sink + (parse_fast_request(request, fast) ? fast.action.size() : 0);
+            })});
+            benches.push_back({"parse/fast_scalar/" + name, 500000, timed([request = request](uint64_t) {
+                FastRequest fast;
+                g_sink = g_sink + (parse_fast_request_scalar(request, fast) ? fast.action.size() : 0);
+            })});
+            benches.push_back({"parse/dom/" + name, 100000, timed([request = request](uint64_t) {
+                const json data = json::parse(request, nullptr, false);
+                g_sink = g_sink + data["action"].get_ref<const std::string&>().size();
+            })});
+        }
+
+        // --- 响应构建 ---
+        benches.push_back({"create_success_response", 200000, timed([&handler](uint64_t) {
+            g_sink = g_sink + handler.create_success_response("moveForward executed").size();
+        })});
+        benches.push_back({"create_error_response", 200000, timed([&handler](uint64_t) {
+            g_sink = g_sink + handler.create_error_response("INVALID_ACTION", "Unknown action: flyToTheMoon").size();
+        })});
+
+        // --- 帧读写（socketpair 上一写一读） ---
+        for (size_t size : {32u, 1024u, 16384u}) {
+            std::string payload(size, 'x');
+            benches.push_back({"framing/write_read/" + std::to_string(size) + "B", 50000,
+                [payload](uint64_t iterations) {
+                    int fds[2];
+                    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+                        std::perror("socketpair");
+                        std::exit(1);
+                    }
+                    auto start = BenchClock::now();
+                    std::string message;
+                    for (uint64_t i = 0; i < iterations; ++i) {
+                        ipc::write_message(fds[0], payload);
+                        ipc::read_message(fds[1], message);
+                        g_sink = g_sink + message.size();
+                    }
+                    auto elapsed = BenchClock::now() - start;
+                    ::close(fds[0]);
+                    ::close(fds[1]);
+                    return elapsed;
+                }});
+        }
+
+        // --- DesiredStateManager 读写竞争 ---
+        const int max_threads = static_cast<int>(std::max(2u, std::min(8u, std::thread::hardware_concurrency())));
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            benches.push_back({"desired_state/get/threads:" + std::to_string(threads), 200000,
+                [&manager, threads](uint64_t iterations) {
+                    return run_parallel(threads, iterations, [&manager](int, uint64_t) {
+                        g_sink = g_sink + static_cast<uint64_t>(manager.get_desired_state());
+                    });
+                }});
+            // 每 8 次操作中 1 次写、7 次读，模拟 IPC 线程写入与控制循环读取
+            benches.push_back({"desired_state/mixed/threads:" + std::to_string(threads), 200000,
+                [&manager, threads](uint64_t iterations) {
+                    return run_parallel(threads, iterations, [&manager](int, uint64_t i) {
+                        if (i % 8 == 0) {
+                            manager.set_desired_state((i & 8) ? DesiredState::MOVING_FORWARD : DesiredState::STOPPING);
+                        } else {
+                            g_sink = g_sink + static_cast<uint64_t>(manager.get_desired_state());
+                        }
+                    });
+                }});
+        }
+
+        // --- 飞行记录器：常开，每条指令、状态变更和电机调用各记录一次 ---
+        benches.push_back({"flight_recorder/record/disabled", 1000000, [](uint64_t iterations) {
+            recorder::set_enabled(false);
+            auto start = BenchClock::now();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                recorder::record_motor_call(DesiredState::MOVING_FORWARD, recorder::MotorCallResult::OK, i);
+            }
+            auto elapsed = BenchClock::now() - start;
+            recorder::set_enabled(true);
+            return elapsed;
+        }});
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            benches.push_back({"flight_recorder/record/threads:" + std::to_string(threads), 500000,
+                [threads](uint64_t iterations) {
+                    return run_parallel(threads, iterations, [](int t, uint64_t i) {
+                        recorder::record_motor_call(DesiredState::MOVING_FORWARD, recorder::MotorCallResult::OK, i + static_cast<uint64_t>(t));
+                    });
+                }});
+        }
+        benches.push_back({"flight_recorder/dump", 20, timed([](uint64_t) {
+            auto res = recorder::dump("/tmp/fpvcar_microbench_flight.bin", recorder::DumpReason::REQUEST);
+            if (!res) {
+                std::cerr << res.error() << std::endl;
+                std::exit(1);
+            }
+        })});
+
+        // --- 配置加载 ---
+        benches.push_back({"load_config", 2000, timed([config_path](uint64_t) {
+            auto cfg = config::load_config(config_path);
+            if (!cfg) {
+                std::cerr << cfg.error() << std::endl;
+                std::exit(1);
+            }
+            g_sink = g_sink + cfg->ipc_socket_path.size();
+        })});
+
+        return benches;
+    }
+
+    /**
+     * @brief 写一份临时配置文件供 load_config 基准使用（内容与 config/default_config.json 一致）
+     */
+    std::string write_temp_config() {
+        char path[] = "/tmp/fpvcar_microbench_config_XXXXXX";
+        int fd = ::mkstemp(path);
+        if (fd < 0) {
+            std::perror("mkstemp");
+            std::exit(1);
+        }
+        ::close(fd);
+        json j = {
+            {"ipc_socket_path", "/tmp/fpvcar_control.sock"},
+            {"i2c_device_path", "/dev/i2c-1"},
+            {"pwm_frequency", 10000.0},
+            {"pca9685_address", 64},
+            {"channels", {
+                {"fl_channel_speed", 12}, {"fl_channel_1", 0}, {"fl_channel_2", 1},
+                {"fr_channel_speed", 13}, {"fr_channel_1", 2}, {"fr_channel_2", 3},
+                {"bl_channel_speed", 14}, {"bl_channel_1", 4}, {"bl_channel_2", 5},
+                {"br_channel_speed", 15}, {"br_channel_1", 6}, {"br_channel_2", 7},
+            }},
+        };
+        std::ofstream(path) << j.dump(2);
+        return path;
+    }
+
+    bool parse_args(int argc, char** argv, Options& opt) {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string arg = argv[i];
+            const char* value = argv[i + 1];
+            if (arg == "--out") opt.out_path = value;
+            else if (arg == "--filter") opt.filter = value;
+            else if (arg == "--samples") opt.samples = std::max(1, std::atoi(value));
+            else if (arg == "--scale") opt.scale = std::max(0.0001, std::atof(value));
+            else return false;
+        }
+        return argc % 2 == 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        std::fprintf(stderr, "Usage: %s [--out PATH] [--filter SUBSTR] [--samples N] [--scale FACTOR]\n", argv[0]);
+        return 1;
+    }
+
+    DesiredStateManager manager;
+    RequestHandler handler(manager);
+    const std::string config_path = write_temp_config();
+    auto benches = make_benchmarks(manager, handler, config_path);
+
+    // 错误路径会向 std::cerr 打印日志，基准运行期间丢弃这些输出
+    std::ostringstream discarded;
+    std::streambuf* saved_cerr = std::cerr.rdbuf();
+
+    std::printf("%-44s %10s %10s %10s %10s %10s\n", "benchmark", "mean", "median", "stddev", "min", "p99");
+    json results = json::array();
+    for (const auto& bench : benches) {
+        if (!opt.filter.empty() && bench.name.find(opt.filter) == std::string::npos) continue;
+        std::cerr.rdbuf(discarded.rdbuf());
+        Result r = run(bench, opt);
+        std::cerr.rdbuf(saved_cerr);
+        discarded.str("");
+
+        std::printf("%-44s %10.1f %10.1f %10.1f %10.1f %10.1f\n", r.name.c_str(), r.mean, r.median, r.stddev, r.min, r.p99);
+        results.push_back({
+            {"name", r.name}, {"iterations", r.iterations}, {"samples", r.samples}, {"unit", "ns/op"},
+            {"mean", r.mean}, {"median", r.median}, {"stddev", r.stddev},
+            {"min", r.min}, {"max", r.max}, {"p99", r.p99},
+        });
+    }
+    ::unlink(config_path.c_str());
+
+    json root;
+    root["context"] = {
+        {"timestamp", static_cast<int64_t>(std::time(nullptr))},
+        {"hardware_concurrency", std::thread::hardware_concurrency()},
+        {"samples", opt.samples},
+        {"scale", opt.scale},
+    };
+    root["benchmarks"] = std::move(results);
+    std::ofstream ofs(opt.out_path);
+    if (!ofs) {
+        std::fprintf(stderr, "Failed to open output file: %s\n", opt.out_path.c_str());
+        return 1;
+    }
+    ofs << root.dump(2) << std::endl;
+    std::printf("results written to %s\n", opt.out_path.c_str());
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "fpvcar_device_control/fast_request_parser.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// fpvcar-parser-fuzz：快速解析路径的差分模糊测试
+// 对种子请求做随机变异（替换/插入/删除字节、截断、拼接、构造不同长度与特殊字节位置的字符串），对每个输入检查：
+//   - SIMD 扫描与标量扫描的解析结果完全一致
+//   - 快速路径接受的输入，nlohmann DOM 解析也必须接受，且是只含 action（字符串）和可选 ttl_ms、seq、ts_us（整数）的对象，字段值相同
+// 快速路径拒绝的输入由 DOM 路径处理，因此以上两点保证了整体接受的输入集合与 DOM 解析器完全一致
+// 出现任何不一致时打印输入并以退出码 1 结束
+//
+// 用法: fpvcar-parser-fuzz [输入数，默认 1000000] [随机种子，默认 1]
+
+using nlohmann::json;
+using namespace fpvcar::device_control;
+
+namespace {
+    const std::vector<std::string> SEEDS = {
+        "{\"action\":\"moveForward\"}",
+        "{\"action\":\"moveForward\",\"ttl_ms\":150}",
+        "{ \"ttl_ms\" : 500 , \"action\" : \"moveBackwardAndTurnRight\" }",
+        "{\"action\":\"stopAll\"}\n",
+        "\t{\r\n\"action\":\"turnLeft\",\n\"ttl_ms\":1}",
+        "{\"action\":\"turn\\u004ceft\"}",
+        "{\"action\":\"moveForward\",\"action\":\"stopAll\"}",
+        "{\"action\":\"moveForward\",\"speed\":1}",
+        "{\"action\":\"moveForward\",\"ttl_ms\":-5}",
+        "{\"action\":\"moveForward\",\"ttl_ms\":1.5}",
+        "{\"action\":\"moveForward\",\"ttl_ms\":1e3}",
+        "{\"action\":\"moveForward\",\"ttl_ms\":0150}",
+        "{\"action\":\"moveForward\",\"ttl_ms\":99999999999999999999}",
+        "{\"action\":\"\"}",
+        "{\"action\":null}",
+        "{\"action\":[\"moveForward\"]}",
+        "[\"moveForward\"]",
+        "{}",
+        "{\"action\":\"moveForward\"}}",
+        "{\"action\":\"moveForward\",}",
+        "{\"action\":\"m\xc3\xa9\"}",
+        "{\"action\":\"moveForward\",\"ttl_ms\":150,\"seq\":42,\"ts_us\":1930262980}",
+        "{\"seq\":0,\"action\":\"stopAll\",\"ts_us\":7}",
+        "{\"action\":\"turnRight\",\"seq\":1,\"seq\":2,\"ts_us\":3}",
+        "{\"action\":\"turnRight\",\"seq\":-1,\"ts_us\":3.5}",
+    };
+
+    // 变异时使用的字节：JSON 结构字符、数字、空白、控制字符与非 ASCII 字节
+    const char ALPHABET[] = "{}[]\":,\\ \t\r\n0123456789-+.eEactionmvFwrdtl_suq\x01\x1f\x7f\x80\xc3\xff";
+
+    char random_byte(std::mt19937& rng) {
+        std::uniform_int_distribution<size_t> pick(0, sizeof(ALPHABET) - 1); // 包含结尾的 '\0'
+        return ALPHABET[pick(rng)];
+    }
+
+    /**
+     * @brief 构造 {"action":"<随机长度字符串>"}，在随机位置放一个特殊字节，覆盖 16 字节块边界上的各种位置
+     */
+    std::string make_long_string_request(std::mt19937& rng) {
+        std::uniform_int_distribution<size_t> length(0, 80);
+        std::uniform_int_distribution<int> letter('a', 'z');
+        std::string value(length(rng), 'x');
+        for (auto& c : value) c = static_cast<char>(letter(rng));
+        if (!value.empty() && rng() % 2) {
+            std::uniform_int_distribution<size_t> pos(0, value.size() - 1);
+            value[pos(rng)] = random_byte(rng);
+        }
+        std::string request = "{\"action\":\"" + value + "\"";
+        if (rng() % 2) request += ",\"ttl_ms\":" + std::to_string(rng() % 100000);
+        if (rng() % 2) request += ",\"seq\":" + std::to_string(rng()) + ",\"ts_us\":" + std::to_string(rng());
+        return request + "}";
+    }
+
+    std::string mutate(std::string input, std::mt19937& rng) {
+        const int rounds = 1 + static_cast<int>(rng() % 4);
+        for (int r = 0; r < rounds; ++r) {
+            const size_t pos = input.empty() ? 0 : rng() % (input.size() + 1);
+            switch (rng() % 6) {
+                case 0: // 替换
+                    if (pos < input.size()) input[pos] = random_byte(rng);
+                    break;
+                case 1: // 插入
+                    input.insert(input.begin() + static_cast<std::ptrdiff_t>(pos), random_byte(rng));
+                    break;
+                case 2: // 删除
+                    if (pos < input.size()) input.erase(pos, 1);
+                    break;
+                case 3: // 截断
+                    input.resize(pos);
+                    break;
+                case 4: { // 复制一段到别处
+                    if (input.empty()) break;
+                    const size_t from = rng() % input.size();
+                    const size_t len = std::min<size_t>(input.size() - from, 1 + rng() % 16);
+                    input.insert(pos, input.substr(from, len));
+                    break;
+                }
+                case 5: { // 与另一个种子拼接
+                    const std::string& other = SEEDS[rng() % SEEDS.size()];
+                    const size_t cut = other.empty() ? 0 : rng() % other.size();
+                    input = input.substr(0, pos) + other.substr(cut);
+                    break;
+                }
+            }
+        }
+        return input;
+    }
+
+    std::string escape(const std::string& input) {
+        std::string out;
+        char hex[8];
+        for (unsigned char c : input) {
+            if (c >= 0x20 && c < 0x7f && c != '\\') {
+                out += static_cast<char>(c);
+            } else {
+                std::snprintf(hex, sizeof(hex), "\\x%02x", c);
+                out += hex;
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief 检查一个输入
+     * @return 不一致时返回描述，一致时返回空字符串
+     */
+    std::string check(const std::string& input, uint64_t& fast_accepted, uint64_t& dom_accepted) {
+        FastRequest simd;
+        FastRequest scalar;
+        const bool simd_ok = parse_fast_request(input, simd);
+        const bool scalar_ok = parse_fast_request_scalar(input, scalar);
+        if (simd_ok != scalar_ok) return "simd/scalar disagree on acceptance";
+        if (simd_ok && (simd.action != scalar.action || simd.has_ttl != scalar.has_ttl || simd.ttl_ms != scalar.ttl_ms ||
+                        simd.has_seq != scalar.has_seq || simd.seq != scalar.seq ||
+                        simd.has_ts != scalar.has_ts || simd.ts_us != scalar.ts_us)) {
+            return "simd/scalar disagree on fields";
+        }
+
+        const json dom = json::parse(input, nullptr, /*allow_exceptions=*/false);
+        if (!dom.is_discarded()) ++dom_accepted;
+        if (!simd_ok) return ""; // 快速路径拒绝的输入由 DOM 路径处理
+        ++fast_accepted;
+
+        if (dom.is_discarded()) return "fast path accepted invalid JSON";
+        if (!dom.is_object()) return "fast path accepted a non-object";
+        const size_t fields = 1u + (simd.has_ttl ? 1u : 0u) + (simd.has_seq ? 1u : 0u) + (simd.has_ts ? 1u : 0u);
+        if (dom.size() != fields) return "fast path accepted extra or duplicate fields";
+        if (!dom.contains("action") || !dom["action"].is_string() || dom["action"].get<std::string>() != simd.action) {
+            return "action differs from DOM";
+        }
+        if (dom.contains("ttl_ms") != simd.has_ttl) return "ttl_ms presence differs from DOM";
+        if (simd.has_ttl && (!dom["ttl_ms"].is_number_integer() || dom["ttl_ms"].get<int64_t>() != simd.ttl_ms)) {
+            return "ttl_ms differs from DOM";
+        }
+        if (dom.contains("seq") != simd.has_seq) return "seq presence differs from DOM";
+        if (simd.has_seq && (!dom["seq"].is_number_integer() || dom["seq"].get<int64_t>() != simd.seq)) {
+            return "seq differs from DOM";
+        }
+        if (dom.contains("ts_us") != simd.has_ts) return "ts_us presence differs from DOM";
+        if (simd.has_ts && (!dom["ts_us"].is_number_integer() || dom["ts_us"].get<int64_t>() != simd.ts_us)) {
+            return "ts_us differs from DOM";
+        }
+        return "";
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t inputs = 1000000;
+    uint32_t seed = 1;
+    if (argc > 1) inputs = std::max<uint64_t>(1, std::strtoull(argv[1], nullptr, 10));
+    if (argc > 2) seed = static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10));
+
+    std::mt19937 rng(seed);
+    uint64_t fast_accepted = 0;
+    uint64_t dom_accepted = 0;
+    uint64_t mismatches = 0;
+    for (uint64_t i = 0; i < inputs; ++i) {
+        std::string input;
+        if (i < SEEDS.size()) {
+            input = SEEDS[i];
+        } else if (i % 4 == 0) {
+            input = make_long_string_request(rng);
+        } else {
+            input = mutate(SEEDS[rng() % SEEDS.size()], rng);
+        }
+
+        const std::string error = check(input, fast_accepted, dom_accepted);
+        if (!error.empty()) {
+            if (++mismatches <= 10) std::printf("MISMATCH (%s): %s\n", error.c_str(), escape(input).c_str());
+        }
+    }
+
+    std::printf("scanner=%s inputs=%llu fast_accepted=%llu dom_accepted=%llu mismatches=%llu  %s\n",
+        fast_request_scanner(),
+        static_cast<unsigned long long>(inputs),
+        static_cast<unsigned long long>(fast_accepted),
+        static_cast<unsigned long long>(dom_accepted),
+        static_cast<unsigned long long>(mismatches),
+        mismatches == 0 ? "PASS" : "FAIL");
+    return mismatches == 0 ? 0 : 1;
+}
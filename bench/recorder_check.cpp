@@ -0,0 +1,192 @@
+#include "fpvcar_device_control/flight_recorder.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 飞行记录器检查：写入事件后导出到临时文件，用 load_dump 读回并逐条比对，检查：
+//   - 往返：导出的文件头（magic、版本、原因、数量）与事件内容、顺序和写入时一致；记录关闭时不写入
+//   - 环形覆盖：写入 CAPACITY + 1000 条后只保留最新的 CAPACITY 条，recorded 为写入总数
+//   - 并发写入：多个线程持续写入的同时反复导出，导出的每条事件都是某次完整写入的内容（没有撕裂），各线程的事件保持写入顺序
+//   - 崩溃导出：子进程安装致命信号处理函数后 abort()，自动导出路径中的文件记录了原因、信号编号和崩溃前的事件
+// 任一检查失败时以退出码 1 结束
+// 用法: fpvcar-recorder-check
+
+using namespace fpvcar::device_control;
+
+namespace {
+    struct Result {
+        std::string name;
+        bool ok;
+        std::string detail;
+    };
+
+    // 并发检查中由线程号与序号推出的校验值，撕裂的事件与之不符
+    uint32_t checksum(uint8_t thread, uint64_t seq) {
+        uint64_t x = (seq + 1) * 0x9E3779B97F4A7C15ULL ^ thread;
+        x ^= x >> 29;
+        return static_cast<uint32_t>(x);
+    }
+
+    bool same(const recorder::Event& event, recorder::EventType type, uint8_t a, uint16_t b, uint32_t c, uint64_t d) {
+        return event.type == type && event.a == a && event.b == b && event.c == c && event.d == d;
+    }
+
+    Result check_roundtrip(const std::string& path) {
+        recorder::clear();
+        recorder::set_enabled(true);
+        recorder::record_command(DesiredState::MOVING_FORWARD, false, 250);
+        recorder::record_state(DesiredState::MOVING_FORWARD, DesiredState::STOPPING, 7);
+        recorder::record_motor_call(DesiredState::MOVING_FORWARD, recorder::MotorCallResult::FAILED, 123456);
+        recorder::record(recorder::EventType::FAULT, 0, 1);
+        recorder::set_enabled(false);
+        recorder::record(recorder::EventType::ESTOP);
+        recorder::set_enabled(true);
+
+        recorder::FileHeader header{};
+        const auto dumped = recorder::dump(path, recorder::DumpReason::REQUEST);
+        const auto events = dumped ? recorder::load_dump(path, header) : tl::unexpected(dumped.error());
+        if (!events) return {"roundtrip", false, events.error()};
+
+        const auto& e = *events;
+        const bool ok = header.reason == static_cast<uint32_t>(recorder::DumpReason::REQUEST) && header.count == 4 &&
+                        header.recorded == 4 && e.size() == 4 &&
+                        same(e[0], recorder::EventType::COMMAND, static_cast<uint8_t>(DesiredState::MOVING_FORWARD), 0, 250, 0) &&
+                        same(e[1], recorder::EventType::STATE, static_cast<uint8_t>(DesiredState::MOVING_FORWARD),
+                             static_cast<uint16_t>(DesiredState::STOPPING), 0, 7) &&
+                        same(e[2], recorder::EventType::MOTOR_CALL, static_cast<uint8_t>(DesiredState::MOVING_FORWARD),
+                             static_cast<uint16_t>(recorder::MotorCallResult::FAILED), 123456, 0) &&
+                        same(e[3], recorder::EventType::FAULT, 0, 1, 0, 0) && e[0].ts_ns <= e[3].ts_ns;
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "count=%llu recorded=%llu", static_cast<unsigned long long>(header.count),
+                      static_cast<unsigned long long>(header.recorded));
+        return {"roundtrip", ok, detail};
+    }
+
+    Result check_wraparound(const std::string& path) {
+        constexpr uint64_t extra = 1000;
+        recorder::clear();
+        for (uint64_t i = 0; i < recorder::CAPACITY + extra; ++i) {
+            recorder::record(recorder::EventType::WATCHDOG_FEED, 0, 0, 0, i);
+        }
+
+        recorder::FileHeader header{};
+        const auto dumped = recorder::dump(path, recorder::DumpReason::REQUEST);
+        const auto events = dumped ? recorder::load_dump(path, header) : tl::unexpected(dumped.error());
+        if (!events) return {"wraparound", false, events.error()};
+
+        bool ordered = events->size() == recorder::CAPACITY;
+        for (size_t i = 0; ordered && i < events->size(); ++i) {
+            ordered = (*events)[i].d == extra + i;
+        }
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "count=%llu recorded=%llu oldest=%llu",
+                      static_cast<unsigned long long>(header.count), static_cast<unsigned long long>(header.recorded),
+                      static_cast<unsigned long long>(events->empty() ? 0 : events->front().d));
+        return {"wraparound", ordered && header.recorded == recorder::CAPACITY + extra, detail};
+    }
+
+    Result check_concurrent(const std::string& path) {
+        constexpr int writers = 3;
+        constexpr int dumps = 100;
+        recorder::clear();
+        std::atomic<bool> running{true};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < writers; ++t) {
+            threads.emplace_back([t, &running]() {
+                const uint8_t id = static_cast<uint8_t>(t);
+                for (uint64_t seq = 0; running.load(std::memory_order_relaxed); ++seq) {
+                    recorder::record(recorder::EventType::MOTOR_CALL, id, static_cast<uint16_t>(seq), checksum(id, seq), seq);
+                }
+            });
+        }
+
+        uint64_t checked = 0;
+        uint64_t torn = 0;
+        uint64_t reordered = 0;
+        std::string error;
+        for (int i = 0; i < dumps && error.empty(); ++i) {
+            recorder::FileHeader header{};
+            const auto dumped = recorder::dump(path, recorder::DumpReason::REQUEST);
+            const auto events = dumped ? recorder::load_dump(path, header) : tl::unexpected(dumped.error());
+            if (!events) {
+                error = events.error();
+                break;
+            }
+            std::vector<uint64_t> next(writers, 0);
+            std::vector<bool> seen(writers, false);
+            for (const recorder::Event& event : *events) {
+                ++checked;
+                if (event.type != recorder::EventType::MOTOR_CALL || event.a >= writers ||
+                    event.b != static_cast<uint16_t>(event.d) || event.c != checksum(event.a, event.d)) {
+                    ++torn;
+                    continue;
+                }
+                if (seen[event.a] && event.d < next[event.a]) ++reordered;
+                seen[event.a] = true;
+                next[event.a] = event.d + 1;
+            }
+        }
+        running.store(false);
+        for (std::thread& thread : threads) thread.join();
+        if (!error.empty()) return {"concurrent_writers", false, error};
+
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "dumps=%d events=%llu torn=%llu reordered=%llu", dumps,
+                      static_cast<unsigned long long>(checked), static_cast<unsigned long long>(torn),
+                      static_cast<unsigned long long>(reordered));
+        return {"concurrent_writers", checked > 0 && torn == 0 && reordered == 0, detail};
+    }
+
+    Result check_crash_dump(const std::string& path) {
+        ::unlink(path.c_str());
+        const pid_t child = ::fork();
+        if (child < 0) return {"crash_dump", false, std::string("fork: ") + std::strerror(errno)};
+        if (child == 0) {
+            recorder::clear();
+            recorder::set_dump_path(path);
+            recorder::install_crash_handler();
+            for (uint64_t i = 0; i < 10; ++i) recorder::record(recorder::EventType::OVERRUN, 0, 0, 0, i);
+            std::abort();
+        }
+
+        int status = 0;
+        ::waitpid(child, &status, 0);
+        const bool aborted = WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+        recorder::FileHeader header{};
+        const auto events = recorder::load_dump(path, header);
+        if (!events) return {"crash_dump", false, events.error()};
+
+        bool ordered = events->size() == 10;
+        for (size_t i = 0; ordered && i < events->size(); ++i) {
+            ordered = (*events)[i].type == recorder::EventType::OVERRUN && (*events)[i].d == i;
+        }
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "aborted=%d reason=%u signal=%u count=%llu", aborted, header.reason,
+                      header.signal, static_cast<unsigned long long>(header.count));
+        const bool ok = aborted && ordered && header.reason == static_cast<uint32_t>(recorder::DumpReason::CRASH) &&
+                        header.signal == static_cast<uint32_t>(SIGABRT);
+        return {"crash_dump", ok, detail};
+    }
+}
+
+int main() {
+    const std::string path = "/tmp/fpvcar-recorder-check." + std::to_string(::getpid()) + ".bin";
+
+    const Result results[] = {check_roundtrip(path), check_wraparound(path), check_concurrent(path), check_crash_dump(path)};
+    ::unlink(path.c_str());
+
+    bool pass = true;
+    std::printf("%-24s %-6s %s\n", "check", "result", "detail");
+    for (const Result& result : results) {
+        pass = pass && result.ok;
+        std::printf("%-24s %-6s %s\n", result.name.c_str(), result.ok ? "PASS" : "FAIL", result.detail.c_str());
+    }
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,372 @@
+#include "fpvcar_device_control/config.hpp"
+#include "fpvcar_device_control/device_control_service.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/takeover.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 进程接管检查：用本程序（--instance 模式）启动两个独立的服务进程（PCA9685 仿真器，套接字路径带本进程 pid），检查：
+//   - handoff：一条客户端连接持续发送指令期间新实例以 --takeover 接管，旧实例自动退出；
+//     这条连接上的每个请求都收到成功响应（没有断开、丢失或错位），新连接由新实例服务
+//   - rollback：新实例收到状态和套接字（SCM_RIGHTS）后不回复 ready 就退出，旧实例恢复服务，同一条连接继续收到响应
+//   - malformed_request：字段类型错误的接管请求收到 error 帧，运行中的实例不受影响
+//   - shutdown：SIGTERM 后实例以退出码 0 结束并删除套接字文件
+// 任一检查失败时以退出码 1 结束，并保留各实例的日志文件
+// 用法: fpvcar-takeover-check [blocking|io_uring]
+
+using namespace fpvcar::device_control;
+using CheckClock = std::chrono::steady_clock;
+
+namespace {
+    struct Paths {
+        std::string ipc;
+        std::string takeover;
+        std::string estop;
+    };
+
+    Paths make_paths(const std::string& base) {
+        return {base + ".sock", base + ".takeover.sock", base + ".estop.sock"};
+    }
+
+    // --- 服务实例（子进程） ---
+
+    std::atomic<bool> g_instance_shutdown{false};
+
+    void on_instance_signal(int) {
+        g_instance_shutdown.store(true);
+    }
+
+    /**
+     * @brief 服务实例：按参数构建配置，启动或接管后向 ready_fd 写入一个字节（'R' 成功，'F' 失败），
+     *        直到收到 SIGTERM 或服务被接管后停止服务并退出
+     */
+    int run_instance(const std::string& base, const std::string& backend, bool takeover, int ready_fd) {
+        std::signal(SIGTERM, on_instance_signal);
+        const Paths paths = make_paths(base);
+        config::AppConfig cfg;
+        cfg.channels = fpvcar::motorconfig::DEFAULT_CHANNELS;
+        cfg.i2c_device_path = "emu:pca9685";
+        cfg.motor_driver = "pca9685";
+        cfg.ipc_socket_path = paths.ipc;
+        cfg.takeover_socket_path = paths.takeover;
+        cfg.estop_socket_path = paths.estop;
+        cfg.ipc_backend = backend;
+        cfg.ipc_rate_limit_hz = 0.0;
+        cfg.flight_recorder_enabled = false;
+        cfg.diagnostics_dir.clear();
+
+        auto service = DeviceControlService::create(cfg);
+        tl::expected<void, std::string> started = tl::unexpected(service ? std::string() : service.error());
+        if (service) started = takeover ? (*service)->start_takeover() : (*service)->start();
+        const char status = started ? 'R' : 'F';
+        if (::write(ready_fd, &status, 1) != 1 || !started) {
+            std::fprintf(stderr, "instance failed to start: %s\n", started ? "ready pipe closed" : started.error().c_str());
+            return 1;
+        }
+        ::close(ready_fd);
+        while (!g_instance_shutdown.load() && !(*service)->handed_over()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        (*service)->stop();
+        return 0;
+    }
+
+    // --- 检查程序（父进程） ---
+
+    struct Instance {
+        pid_t pid = -1;
+        std::string log;
+    };
+
+    /**
+     * @brief 启动一个服务实例并等待它报告启动结果（最多 5 秒）
+     * @return 启动成功返回 true；实例的标准输出与错误输出写入日志文件
+     */
+    bool spawn_instance(const std::string& base, const std::string& backend, const char* name, bool takeover, Instance& out) {
+        int pipe_fds[2];
+        if (::pipe2(pipe_fds, O_CLOEXEC) < 0) return false;
+        out.log = base + "." + name + ".log";
+        const pid_t pid = ::fork();
+        if (pid < 0) return false;
+        if (pid == 0) {
+            // 子进程只调用异步信号安全的函数，然后 exec 本程序
+            const int log_fd = ::open(out.log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (log_fd >= 0) {
+                ::dup2(log_fd, STDOUT_FILENO);
+                ::dup2(log_fd, STDERR_FILENO);
+            }
+            ::dup2(pipe_fds[1], 3);
+            const char* argv[] = {"fpvcar-takeover-check", "--instance", base.c_str(), backend.c_str(),
+                                  takeover ? "takeover" : "start", nullptr};
+            ::execv("/proc/self/exe", const_cast<char* const*>(argv));
+            ::_exit(127);
+        }
+        ::close(pipe_fds[1]);
+        out.pid = pid;
+        pollfd pfd{pipe_fds[0], POLLIN, 0};
+        char status = 0;
+        const bool ready = ::poll(&pfd, 1, 5000) == 1 && ::read(pipe_fds[0], &status, 1) == 1 && status == 'R';
+        ::close(pipe_fds[0]);
+        return ready;
+    }
+
+    /**
+     * @brief 等待实例退出（最多 timeout），返回退出码；超时或被信号终止时返回 -1
+     */
+    int wait_exit(pid_t pid, std::chrono::milliseconds timeout) {
+        const auto deadline = CheckClock::now() + timeout;
+        while (CheckClock::now() < deadline) {
+            int status = 0;
+            const pid_t r = ::waitpid(pid, &status, WNOHANG);
+            if (r == pid) return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+            if (r < 0) return -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return -1;
+    }
+
+    bool alive(pid_t pid) {
+        int status = 0;
+        return ::waitpid(pid, &status, WNOHANG) == 0;
+    }
+
+    int connect_to(const std::string& path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        timeval tv{2, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        return fd;
+    }
+
+    /**
+     * @brief 发送一条请求并等待响应，响应必须是成功响应且对应这条请求的 action
+     * @note 与客户端库一样整帧一次写入：服务端只移交停在帧边界的连接，分两次写入的帧可能在切换时被截断而断开
+     */
+    bool round_trip(int fd, const char* action) {
+        std::string frame;
+        ipc::append_frame(frame, std::string("{\"action\":\"") + action + "\",\"ttl_ms\":500}");
+        std::string response;
+        if (ipc::write_exact(fd, frame.data(), frame.size()) != static_cast<ssize_t>(frame.size()) ||
+            !ipc::read_message(fd, response)) {
+            return false;
+        }
+        return response.find("\"status\":\"ok\"") != std::string::npos &&
+               response.find(std::string(action) + " executed") != std::string::npos;
+    }
+
+    /**
+     * @brief 在一条连接上持续发送请求（交替两种指令，每毫秒一条），统计成功、失败与最长往返时间
+     * @note 响应中的 action 与请求逐条比对，连接在切换时错位或丢帧都记为失败
+     */
+    class Client {
+    public:
+        explicit Client(int fd) : m_fd(fd), m_thread([this]() { run(); }) {}
+
+        ~Client() {
+            stop();
+            ::close(m_fd);
+        }
+
+        void stop() {
+            m_running.store(false);
+            if (m_thread.joinable()) m_thread.join();
+        }
+
+        uint64_t ok() const { return m_ok.load(); }
+        uint64_t failed() const { return m_failed.load(); }
+        double max_round_trip_ms() const { return static_cast<double>(m_max_round_trip_us.load()) / 1000.0; }
+
+    private:
+        void run() {
+            for (uint64_t i = 0; m_running.load(); ++i) {
+                const auto start = CheckClock::now();
+                if (round_trip(m_fd, i % 2 == 0 ? "moveForward" : "turnLeft")) {
+                    m_ok.fetch_add(1);
+                } else {
+                    m_failed.fetch_add(1);
+                    return; // 连接已不可用，之后的请求没有意义
+                }
+                const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(CheckClock::now() - start).count();
+                m_max_round_trip_us.store(std::max(m_max_round_trip_us.load(), us));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        const int m_fd;
+        std::atomic<bool> m_running{true};
+        std::atomic<uint64_t> m_ok{0};
+        std::atomic<uint64_t> m_failed{0};
+        std::atomic<int64_t> m_max_round_trip_us{0};
+        std::thread m_thread;
+    };
+
+    /**
+     * @brief 等待客户端在当前基础上再收到 count 个成功响应（最多 2 秒）
+     */
+    bool client_progresses(const Client& client, uint64_t count) {
+        const uint64_t target = client.ok() + count;
+        const auto deadline = CheckClock::now() + std::chrono::seconds(2);
+        while (client.ok() < target && client.failed() == 0 && CheckClock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return client.ok() >= target && client.failed() == 0;
+    }
+
+    struct Result {
+        std::string name;
+        bool ok;
+        std::string detail;
+    };
+
+    /**
+     * @brief 模拟启动失败的新实例：接收状态和套接字后不回复 ready，直接关闭
+     */
+    Result fake_failed_takeover(const Paths& paths, const Instance& running, const Client& client) {
+        auto fd = takeover::request_takeover(paths.takeover);
+        if (!fd) return {"rollback", false, fd.error()};
+        auto received = takeover::receive_state(*fd);
+        if (!received) {
+            ::close(*fd);
+            return {"rollback", false, received.error()};
+        }
+        const size_t clients = received->second.client_fds.size();
+        const std::string desired = desired_state_to_action(received->first.desired_state);
+        takeover::close_sockets(received->second);
+        ::close(*fd);
+
+        const bool resumed = client_progresses(client, 50);
+        const int probe = connect_to(paths.ipc);
+        const bool new_connection = probe >= 0 && round_trip(probe, "stopAll");
+        if (probe >= 0) ::close(probe);
+        const bool still_running = alive(running.pid);
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "received client_fds=%zu desired=%s resumed=%d new_connection=%d running=%d",
+                      clients, desired.c_str(), resumed, new_connection, still_running);
+        return {"rollback", clients >= 1 && resumed && new_connection && still_running, detail};
+    }
+
+    Result malformed_request(const Paths& paths, const Instance& running, const Client& client) {
+        int replies = 0;
+        for (const char* request : {"{\"type\":1}", "{\"type\":\"takeover\",\"version\":\"1\"}"}) {
+            const int fd = connect_to(paths.takeover);
+            std::string reply;
+            if (fd >= 0 && ipc::write_message(fd, request) && ipc::read_message(fd, reply) &&
+                reply.find("\"type\":\"error\"") != std::string::npos) {
+                ++replies;
+            }
+            if (fd >= 0) ::close(fd);
+        }
+        const bool still_running = alive(running.pid) && client_progresses(client, 20);
+        char detail[96];
+        std::snprintf(detail, sizeof(detail), "error_replies=%d/2 running=%d", replies, still_running);
+        return {"malformed_request", replies == 2 && still_running, detail};
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc == 5 && std::string(argv[1]) == "--instance") {
+        return run_instance(argv[2], argv[3], std::string(argv[4]) == "takeover", 3);
+    }
+    const std::string backend = argc > 1 ? argv[1] : "blocking";
+    if (argc > 2 || (backend != "blocking" && backend != "io_uring")) {
+        std::fprintf(stderr, "Usage: %s [blocking|io_uring]\n", argv[0]);
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    const std::string base = "/tmp/fpvcar-takeover-check." + std::to_string(::getpid());
+    const Paths paths = make_paths(base);
+
+    std::vector<Result> results;
+    Instance old_instance;
+    Instance new_instance;
+    if (!spawn_instance(base, backend, "old", false, old_instance)) {
+        std::fprintf(stderr, "old instance failed to start, see %s\n", old_instance.log.c_str());
+        return 1;
+    }
+    const int client_fd = connect_to(paths.ipc);
+    if (client_fd < 0) {
+        std::fprintf(stderr, "failed to connect to %s\n", paths.ipc.c_str());
+        ::kill(old_instance.pid, SIGKILL);
+        return 1;
+    }
+
+    {
+        Client client(client_fd);
+        const bool warmed_up = client_progresses(client, 50);
+
+        // handoff：客户端不停发送期间接管，旧实例移交后退出
+        const bool took_over = spawn_instance(base, backend, "new", true, new_instance);
+        const int old_exit = wait_exit(old_instance.pid, std::chrono::seconds(3));
+        const uint64_t before = client.ok();
+        const bool served_after = client_progresses(client, 100);
+        const int probe = connect_to(paths.ipc);
+        const bool new_connection = probe >= 0 && round_trip(probe, "stopAll");
+        if (probe >= 0) ::close(probe);
+        char detail[192];
+        std::snprintf(detail, sizeof(detail), "took_over=%d old_exit=%d requests=%llu failed=%llu served_after=%d "
+                      "new_connection=%d max_rtt=%.1fms", took_over, old_exit, static_cast<unsigned long long>(before),
+                      static_cast<unsigned long long>(client.failed()), served_after, new_connection, client.max_round_trip_ms());
+        results.push_back({"handoff", warmed_up && took_over && old_exit == 0 && served_after && new_connection, detail});
+
+        // rollback 与 malformed_request：由接管后的实例应对
+        if (took_over) {
+            results.push_back(fake_failed_takeover(paths, new_instance, client));
+            results.push_back(malformed_request(paths, new_instance, client));
+        }
+        client.stop();
+        if (client.failed() != 0) {
+            results.push_back({"client_connection", false, "the connection failed during the run"});
+        }
+    }
+
+    // shutdown
+    const Instance& last = new_instance.pid > 0 && alive(new_instance.pid) ? new_instance : old_instance;
+    ::kill(last.pid, SIGTERM);
+    const int exit_code = wait_exit(last.pid, std::chrono::seconds(3));
+    const bool removed = ::access(paths.ipc.c_str(), F_OK) != 0 && ::access(paths.takeover.c_str(), F_OK) != 0;
+    char detail[96];
+    std::snprintf(detail, sizeof(detail), "exit=%d sockets_removed=%d", exit_code, removed);
+    results.push_back({"shutdown", exit_code == 0 && removed, detail});
+    for (const Instance* instance : {&old_instance, &new_instance}) {
+        if (instance->pid > 0 && alive(instance->pid)) {
+            ::kill(instance->pid, SIGKILL);
+            ::waitpid(instance->pid, nullptr, 0);
+        }
+    }
+
+    bool pass = true;
+    std::printf("fpvcar-takeover-check: ipc_backend=%s\n", backend.c_str());
+    std::printf("%-20s %-6s %s\n", "check", "result", "detail");
+    for (const Result& result : results) {
+        pass = pass && result.ok;
+        std::printf("%-20s %-6s %s\n", result.name.c_str(), result.ok ? "PASS" : "FAIL", result.detail.c_str());
+    }
+    if (pass) {
+        ::unlink(old_instance.log.c_str());
+        ::unlink(new_instance.log.c_str());
+    } else {
+        std::printf("instance logs: %s %s\n", old_instance.log.c_str(), new_instance.log.c_str());
+    }
+    return pass ? 0 : 1;
+}
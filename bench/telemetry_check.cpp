@@ -0,0 +1,268 @@
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/ipc_server.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/telemetry.hpp"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// 遥测订阅检查：进程内驱动 TelemetryChannel / TelemetryPublisher / IpcServer（无需控制循环，快照由检查程序发布），检查：
+//   - seqlock：一个线程连续发布、两个线程同时读取，读到的每个快照都是某次完整发布的内容（没有撕裂），同一读者读到的快照不倒退
+//   - 合并：订阅连接的发送缓冲区很小且订阅者暂停读取，生产者照常连续发布；订阅者恢复读取后收到的更新 ticks 严格递增，
+//     最后一条是最终快照，被合并的更新计入 updates_coalesced，订阅者没有被断开
+//   - 移交（两个后端各一次）：IPC 连接发送 subscribe 后收到 "subscribed" 响应和 subscribe 快照，之后只收到推送；
+//     这条连接上再发送的指令不再被执行，其它连接照常服务
+// 任一检查失败时以退出码 1 结束
+// 用法: fpvcar-telemetry-check
+
+using namespace fpvcar::device_control;
+using CheckClock = std::chrono::steady_clock;
+
+namespace {
+    /**
+     * @brief 丢弃所有输出的流缓冲区（IPC 服务器日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    // seqlock 检查中由序号推出全部字段，撕裂的快照与之不符
+    TelemetrySnapshot make_snapshot(uint64_t k) {
+        TelemetrySnapshot s;
+        s.timestamp_us = k * 7;
+        s.ticks = k;
+        s.overruns = k ^ 0x5555555555555555ULL;
+        s.motor_calls = k * 3;
+        s.tick_max_jitter_ns = ~k;
+        for (int i = 0; i < 4; ++i) {
+            s.wheel_speed_eps[i] = static_cast<int64_t>(k) * (i + 1);
+            s.wheel_duty[i] = -static_cast<int64_t>(k) - i;
+        }
+        return s;
+    }
+
+    bool consistent(const TelemetrySnapshot& s) {
+        const TelemetrySnapshot expected = make_snapshot(s.ticks);
+        bool ok = s.timestamp_us == expected.timestamp_us && s.overruns == expected.overruns &&
+                  s.motor_calls == expected.motor_calls && s.tick_max_jitter_ns == expected.tick_max_jitter_ns;
+        for (int i = 0; ok && i < 4; ++i) {
+            ok = s.wheel_speed_eps[i] == expected.wheel_speed_eps[i] && s.wheel_duty[i] == expected.wheel_duty[i];
+        }
+        return ok;
+    }
+
+    /**
+     * @brief 读取一条推送并解析（超时或连接关闭时返回 discarded）
+     */
+    nlohmann::json read_frame(int fd) {
+        std::string frame;
+        if (!ipc::read_message(fd, frame)) return nlohmann::json(nlohmann::json::value_t::discarded);
+        return nlohmann::json::parse(frame, nullptr, false);
+    }
+
+    bool is_update(const nlohmann::json& frame, const char* event) {
+        return frame.is_object() && frame.value("type", "") == "telemetry" && frame.value("event", "") == event;
+    }
+
+    void set_timeout(int fd, int seconds) {
+        timeval tv{seconds, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    struct Result {
+        std::string name;
+        bool ok;
+        std::string detail;
+    };
+
+    Result check_seqlock() {
+        constexpr int readers = 2;
+        TelemetryChannel channel;
+        channel.publish(make_snapshot(0), false);
+        std::atomic<bool> running{true};
+        std::atomic<uint64_t> reads{0};
+        std::atomic<uint64_t> torn{0};
+        std::atomic<uint64_t> regressions{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < readers; ++t) {
+            threads.emplace_back([&]() {
+                uint64_t last = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    const TelemetrySnapshot s = channel.read();
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                    if (!consistent(s)) torn.fetch_add(1, std::memory_order_relaxed);
+                    if (s.ticks < last) regressions.fetch_add(1, std::memory_order_relaxed);
+                    last = s.ticks;
+                }
+            });
+        }
+
+        uint64_t published = 0;
+        const auto deadline = CheckClock::now() + std::chrono::milliseconds(300);
+        while (CheckClock::now() < deadline) {
+            channel.publish(make_snapshot(++published), false);
+        }
+        running.store(false);
+        for (std::thread& thread : threads) thread.join();
+        const TelemetrySnapshot final_snapshot = channel.read();
+
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "published=%llu reads=%llu torn=%llu regressions=%llu",
+                      static_cast<unsigned long long>(published), static_cast<unsigned long long>(reads.load()),
+                      static_cast<unsigned long long>(torn.load()), static_cast<unsigned long long>(regressions.load()));
+        const bool ok = reads.load() > 0 && torn.load() == 0 && regressions.load() == 0 &&
+                        final_snapshot.ticks == published && consistent(final_snapshot);
+        return {"seqlock", ok, detail};
+    }
+
+    Result check_coalescing() {
+        constexpr uint64_t updates = 2000;
+        TelemetryChannel channel;
+        TelemetryPublisher publisher(channel, std::chrono::milliseconds(0), 4);
+        auto started = publisher.start();
+        if (!started) return {"coalescing", false, started.error()};
+
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) return {"coalescing", false, "socketpair failed"};
+        // 发送缓冲区只能容纳少量更新，订阅者暂停读取时推送器很快进入合并
+        const int sndbuf = 4096;
+        ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        set_timeout(fds[1], 2);
+        publisher.add_subscriber(fds[0], "{\"message\":\"subscribed\",\"status\":\"ok\"}");
+
+        // 订阅者暂停读取期间，每条发布都是执行状态变更（带事件通知）
+        for (uint64_t k = 1; k <= updates; ++k) {
+            TelemetrySnapshot s = make_snapshot(k);
+            s.applied_state = k % 2 ? DesiredState::MOVING_FORWARD : DesiredState::TURNING_LEFT;
+            channel.publish(s, true);
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        // 恢复读取：订阅响应、subscribe 快照，之后 ticks 严格递增，直到最终快照
+        const bool subscribed = read_frame(fds[1]).value("message", "") == "subscribed" &&
+                                is_update(read_frame(fds[1]), "subscribe");
+        uint64_t received = 0;
+        uint64_t last_ticks = 0;
+        bool ordered = true;
+        while (last_ticks < updates) {
+            const nlohmann::json frame = read_frame(fds[1]);
+            if (!is_update(frame, "state")) break;
+            const uint64_t ticks = frame.value("ticks", uint64_t{0});
+            ordered = ordered && ticks > last_ticks;
+            last_ticks = ticks;
+            ++received;
+        }
+        const TelemetryPublisherStats stats = publisher.stats();
+        publisher.stop();
+        ::close(fds[1]);
+
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "published=%llu received=%llu last_ticks=%llu coalesced=%llu dropped=%llu",
+                      static_cast<unsigned long long>(updates), static_cast<unsigned long long>(received),
+                      static_cast<unsigned long long>(last_ticks), static_cast<unsigned long long>(stats.updates_coalesced),
+                      static_cast<unsigned long long>(stats.subscribers_dropped));
+        const bool ok = subscribed && ordered && last_ticks == updates && received < updates && stats.updates_coalesced > 0 &&
+                        stats.subscribers_dropped == 0;
+        return {"coalescing", ok, detail};
+    }
+
+    int connect_to(const std::string& path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        set_timeout(fd, 2);
+        return fd;
+    }
+
+    nlohmann::json request(int fd, const char* action) {
+        if (!ipc::write_message(fd, std::string("{\"action\":\"") + action + "\"}")) {
+            return nlohmann::json(nlohmann::json::value_t::discarded);
+        }
+        return read_frame(fd);
+    }
+
+    Result check_handoff(IpcBackend backend, const char* name) {
+        const std::string path = "/tmp/fpvcar-telemetry-check." + std::to_string(::getpid()) + ".sock";
+        TelemetryChannel channel;
+        TelemetryPublisher publisher(channel, std::chrono::milliseconds(0), 4);
+        DesiredStateManager manager;
+        RequestHandler handler(manager, std::string());
+        // 与 DeviceControlService 相同：订阅请求的连接连同响应移交给推送器
+        IpcServer server(path, [&handler](std::string_view req, std::string& response) {
+            return handler.handle_request(req, response) == RequestOutcome::SUBSCRIBE ? IpcDisposition::HAND_OFF
+                                                                                       : IpcDisposition::KEEP;
+        }, backend);
+        server.set_handoff([&publisher](int fd, std::string response) { publisher.add_subscriber(fd, std::move(response)); });
+        auto started = publisher.start();
+        auto prepared = started ? server.prepare() : tl::expected<void, std::string>(tl::unexpected(started.error()));
+        if (!prepared) return {name, false, prepared.error()};
+        std::thread server_thread([&server]() { server.run(); });
+
+        const int fd = connect_to(path);
+        const bool served = fd >= 0 && request(fd, "moveForward").value("status", "") == "ok";
+        const bool subscribed = served && request(fd, "subscribe").value("message", "") == "subscribed" &&
+                                is_update(read_frame(fd), "subscribe");
+
+        // 移交后这条连接上的指令不再执行，下一帧是推送而不是响应
+        const bool sent = fd >= 0 && ipc::write_message(fd, "{\"action\":\"stopAll\"}");
+        TelemetrySnapshot s;
+        s.ticks = 42;
+        s.applied_state = DesiredState::TURNING_RIGHT; // 与尚未发布过的通道（全零，即 MOVING_FORWARD）不同，产生 state 事件
+        channel.publish(s, true);
+        const nlohmann::json pushed = read_frame(fd);
+        const bool pushed_only = sent && is_update(pushed, "state") && pushed.value("ticks", uint64_t{0}) == 42 &&
+                                 manager.get_desired_state() == DesiredState::MOVING_FORWARD;
+
+        // 其它连接照常由 IPC 服务器服务
+        const int other = connect_to(path);
+        const bool others_served = other >= 0 && request(other, "turnLeft").value("status", "") == "ok" &&
+                                   manager.get_desired_state() == DesiredState::TURNING_LEFT;
+        const uint64_t subscribers = publisher.stats().subscribers;
+
+        server.stop();
+        server_thread.join();
+        publisher.stop();
+        if (fd >= 0) ::close(fd);
+        if (other >= 0) ::close(other);
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "served=%d subscribed=%d pushed_only=%d others_served=%d subscribers=%llu",
+                      served, subscribed, pushed_only, others_served, static_cast<unsigned long long>(subscribers));
+        return {name, served && subscribed && pushed_only && others_served && subscribers == 1, detail};
+    }
+}
+
+int main() {
+    NullBuffer null_buffer;
+    std::streambuf* const cout_buffer = std::cout.rdbuf(&null_buffer);
+    std::streambuf* const cerr_buffer = std::cerr.rdbuf(&null_buffer);
+    const Result results[] = {check_seqlock(), check_coalescing(), check_handoff(IpcBackend::BLOCKING, "handoff"),
+                              check_handoff(IpcBackend::IO_URING, "handoff_uring")};
+    std::cout.rdbuf(cout_buffer);
+    std::cerr.rdbuf(cerr_buffer);
+
+    bool pass = true;
+    std::printf("%-24s %-6s %s\n", "check", "result", "detail");
+    for (const Result& result : results) {
+        pass = pass && result.ok;
+        std::printf("%-24s %-6s %s\n", result.name.c_str(), result.ok ? "PASS" : "FAIL", result.detail.c_str());
+    }
+    return pass ? 0 : 1;
+}
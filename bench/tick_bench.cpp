@@ -0,0 +1,95 @@
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/simulated_motor_backend.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+#include <sys/resource.h>
+
+// 控制周期抖动基准：真实时钟下分别以开环 100Hz 与闭环 1kHz（仿真电机 + 仿真编码器）驱动车辆前进，
+// 报告周期间隔与 |实际周期 - 目标周期| 的分位数、掉帧次数，以及每个周期的 CPU 时间
+// 用法: fpvcar-tick-bench [每种模式的秒数]
+
+using namespace fpvcar::device_control;
+
+namespace {
+    constexpr double EDGES_PER_METER = 2000.0;
+
+    /**
+     * @brief 丢弃所有输出的流缓冲区（控制循环的状态日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    double cpu_seconds() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+               static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+
+    void run(const char* name, bool closed_loop, double seconds) {
+        Clock& clock = SteadyClock::instance();
+        DesiredStateManager manager(clock);
+        SimulatedMotorBackend motor(clock);
+        SimulatedEncoder encoder(motor, clock, EDGES_PER_METER);
+        ControlLoop loop(manager, motor, DesiredState::STOPPING, MotorFaultPolicy(), clock);
+        if (closed_loop) {
+            WheelSpeedConfig speed;
+            speed.enabled = true;
+            speed.max_speed_eps = 0.7 * EDGES_PER_METER;
+            speed.feedforward = 0.7;
+            loop.set_wheel_speed_control(encoder, speed);
+        }
+
+        const double cpu_begin = cpu_seconds();
+        loop.start();
+        manager.set_desired_state(DesiredState::MOVING_FORWARD);
+        const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end) {
+            loop.feed_watchdog();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        const TickTimingStats stats = loop.tick_timing();
+        const SimulatedVehicleState vehicle = motor.state();
+        loop.stop();
+        const double cpu = cpu_seconds() - cpu_begin;
+
+        std::printf("%-12s target=%6.0fus mean=%8.2fus p50<=%5.0fus p99<=%5.0fus p99.9<=%5.0fus max=%7.1fus "
+                    "overruns=%llu intervals=%llu cpu/tick=%.2fus speed=%.3fm/s\n",
+            name, static_cast<double>(stats.target_interval_ns) / 1e3, static_cast<double>(stats.mean_interval_ns) / 1e3,
+            static_cast<double>(stats.jitter_p50_ns) / 1e3, static_cast<double>(stats.jitter_p99_ns) / 1e3,
+            static_cast<double>(stats.jitter_p999_ns) / 1e3, static_cast<double>(stats.max_jitter_ns) / 1e3,
+            static_cast<unsigned long long>(stats.overruns), static_cast<unsigned long long>(stats.intervals),
+            stats.intervals > 0 ? cpu * 1e6 / static_cast<double>(stats.intervals) : 0.0,
+            0.5 * (vehicle.left_mps + vehicle.right_mps));
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = 5.0;
+    if (argc > 1) {
+        seconds = std::atof(argv[1]);
+        if (seconds <= 0.0) seconds = 1.0;
+    }
+
+    // 控制循环的状态日志写入空缓冲区
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf(&null_buffer);
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    std::printf("fpvcar-tick-bench: %.1fs per mode\n", seconds);
+    run("open_loop", false, seconds);
+    run("closed_loop", true, seconds);
+
+    std::cout.rdbuf(saved_cout);
+    std::cerr.rdbuf(saved_cerr);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "fpvcar_device_control/trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// 追踪开销基准：分别测量空循环、追踪关闭、追踪打开时每个追踪点的平均开销
+// 用法: fpvcar-trace-bench [迭代次数]
+
+using fpvcar::device_control::trace::Span;
+namespace trace = fpvcar::device_control::trace;
+
+namespace {
+    volatile uint64_t g_sink = 0; // 防止编译器把循环优化掉
+
+    template <typename F>
+    double measure_ns_per_iter(uint64_t iterations, F&& body) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            body(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t iterations = 10'000'000;
+    if (argc > 1) {
+        iterations = std::strtoull(argv[1], nullptr, 10);
+        if (iterations == 0) iterations = 1;
+    }
+
+    // 1. 基线：不带追踪点的空循环
+    double baseline = measure_ns_per_iter(iterations, [](uint64_t i) { g_sink = g_sink + i; });
+
+    // 2. 追踪关闭
+    trace::set_enabled(false);
+    double disabled = measure_ns_per_iter(iterations, [](uint64_t i) {
+        Span span("bench::disabled", i);
+        g_sink = g_sink + i;
+    });
+
+    // 3. 追踪打开（写入环形缓冲区）
+    trace::set_enabled(true);
+    double enabled = measure_ns_per_iter(iterations, [](uint64_t i) {
+        Span span("bench::enabled", i);
+        g_sink = g_sink + i;
+    });
+    trace::set_enabled(false);
+    trace::clear();
+
+    std::printf("iterations:        %llu\n", static_cast<unsigned long long>(iterations));
+    std::printf("baseline:          %8.2f ns/iter\n", baseline);
+    std::printf("trace disabled:    %8.2f ns/iter (overhead %+.2f ns)\n", disabled, disabled - baseline);
+    std::printf("trace enabled:     %8.2f ns/iter (overhead %+.2f ns)\n", enabled, enabled - baseline);
+    return 0;
+}
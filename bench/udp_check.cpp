@@ -0,0 +1,260 @@
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/udp_server.hpp"
+#include <nlohmann/json.hpp>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// UDP 控制通道检查：在 127.0.0.1 上启动 UdpServer（回调为 RequestHandler），用本机 UDP 套接字发送数据报并核对回复、统计与期望状态，检查：
+//   - 序号：递增序号被执行，回退和重复的序号回复 OUT_OF_ORDER 且不执行；发送端沉默超过 sender_idle_reset 后序号重新开始
+//   - 过期：单向延迟超过延迟基线 max_delay 的数据报回复 STALE 且不执行；基线按发送端单独建立，两端时钟偏差很大时同样适用
+//   - 动作过滤：追踪导出、飞行记录器导出、订阅等非运动指令回复 ACTION_NOT_ALLOWED，不到达回调，不占用发送端的序号
+//   - 错误隔离：回调抛出异常时回复 SERVER_ERROR，缺少序号、非法 JSON 与超长的数据报回复 INVALID_DATAGRAM，接收线程继续服务
+// 任一检查失败时以退出码 1 结束
+// 用法: fpvcar-udp-check
+
+using namespace fpvcar::device_control;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr std::chrono::microseconds MAX_DELAY = 100ms;
+    constexpr std::chrono::milliseconds IDLE_RESET = 100ms;
+
+    /**
+     * @brief 丢弃所有输出的流缓冲区（服务端的连接与错误日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    int64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 被测服务端：RequestHandler 执行指令，统计回调次数，可令下一次回调抛出异常
+     */
+    struct Harness {
+        DesiredStateManager manager;
+        RequestHandler handler{manager, std::string()};
+        std::atomic<uint64_t> calls{0};
+        std::atomic<bool> throw_next{false};
+        UdpServer server{"127.0.0.1", 0,
+                         [this](std::string_view request, std::string& response) {
+                             calls.fetch_add(1);
+                             if (throw_next.exchange(false)) throw std::runtime_error("injected handler failure");
+                             handler.handle_request(request, response);
+                             return IpcDisposition::KEEP;
+                         },
+                         UdpPolicy{MAX_DELAY, IDLE_RESET}};
+    };
+
+    /**
+     * @brief 一个 UDP 发送端（独立端口，即服务端眼中独立的发送端）
+     */
+    class Sender {
+    public:
+        explicit Sender(uint16_t port) : m_fd(::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            ::connect(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            timeval tv{1, 0};
+            ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        }
+
+        ~Sender() { ::close(m_fd); }
+
+        Sender(const Sender&) = delete;
+        Sender& operator=(const Sender&) = delete;
+
+        /**
+         * @brief 发送一个数据报并等待回复
+         * @return 回复的 JSON；超时或回复无法解析时为 discarded
+         */
+        nlohmann::json exchange(const std::string& datagram) {
+            if (::send(m_fd, datagram.data(), datagram.size(), 0) != static_cast<ssize_t>(datagram.size())) {
+                return nlohmann::json(nlohmann::json::value_t::discarded);
+            }
+            char buffer[4096];
+            const ssize_t n = ::recv(m_fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) return nlohmann::json(nlohmann::json::value_t::discarded);
+            return nlohmann::json::parse(std::string_view(buffer, static_cast<size_t>(n)), nullptr, false);
+        }
+
+        /**
+         * @brief 发送一条带 seq 与 ts_us 的指令
+         */
+        nlohmann::json command(const char* action, int64_t seq, int64_t ts_us) {
+            return exchange(std::string("{\"action\":\"") + action + "\",\"seq\":" + std::to_string(seq) +
+                            ",\"ts_us\":" + std::to_string(ts_us) + "}");
+        }
+
+    private:
+        const int m_fd;
+    };
+
+    /**
+     * @brief 回复为成功（status ok）或指定错误码，且带有对应的 seq（seq < 0 时不检查）
+     */
+    bool reply_is(const nlohmann::json& reply, const char* error_code, int64_t seq) {
+        if (reply.is_discarded() || !reply.is_object()) return false;
+        if (seq >= 0 && reply.value("seq", int64_t{-1}) != seq) return false;
+        if (error_code == nullptr) return reply.value("status", "") == "ok";
+        return reply.value("status", "") == "error" && reply.value("error_code", "") == error_code;
+    }
+
+    struct Result {
+        std::string name;
+        bool ok;
+        std::string detail;
+    };
+
+    Result check_sequencing(Harness& h) {
+        Sender sender(h.server.port());
+        const uint64_t calls_before = h.calls.load();
+        int bad = 0;
+        // 1..3 依次执行，期望状态为最后一条
+        if (!reply_is(sender.command("moveForward", 1, now_us()), nullptr, 1)) ++bad;
+        if (!reply_is(sender.command("turnLeft", 2, now_us()), nullptr, 2)) ++bad;
+        if (!reply_is(sender.command("moveBackward", 3, now_us()), nullptr, 3)) ++bad;
+        const bool executed = h.manager.get_desired_state() == DesiredState::MOVING_BACKWARD;
+        // 迟到的 2 与重复的 3 被丢弃，期望状态不变
+        if (!reply_is(sender.command("turnRight", 2, now_us()), "OUT_OF_ORDER", 2)) ++bad;
+        if (!reply_is(sender.command("turnRight", 3, now_us()), "OUT_OF_ORDER", 3)) ++bad;
+        const bool dropped = h.manager.get_desired_state() == DesiredState::MOVING_BACKWARD;
+        // 跳号的 10 照常执行
+        if (!reply_is(sender.command("turnLeft", 10, now_us()), nullptr, 10)) ++bad;
+        // 沉默超过 sender_idle_reset 后发送端视为重启，序号 1 重新被接受
+        std::this_thread::sleep_for(IDLE_RESET + 50ms);
+        if (!reply_is(sender.command("stopAll", 1, now_us()), nullptr, 1)) ++bad;
+        const bool restarted = h.manager.get_desired_state() == DesiredState::STOPPING;
+
+        const uint64_t calls = h.calls.load() - calls_before;
+        const UdpServerStats stats = h.server.stats();
+        char detail[160];
+        std::snprintf(detail, sizeof(detail), "bad_replies=%d executed=%d dropped=%d restarted=%d calls=%llu reordered=%llu",
+                      bad, executed, dropped, restarted, static_cast<unsigned long long>(calls),
+                      static_cast<unsigned long long>(stats.reordered));
+        return {"sequencing", bad == 0 && executed && dropped && restarted && calls == 5 && stats.reordered == 2, detail};
+    }
+
+    Result check_stale(Harness& h) {
+        const int64_t late = std::chrono::duration_cast<std::chrono::microseconds>(MAX_DELAY).count() * 2;
+        const uint64_t calls_before = h.calls.load();
+        const uint64_t stale_before = h.server.stats().stale;
+        int bad = 0;
+        // 与服务端同一时钟的发送端：基线约为 0，迟到 2 倍 max_delay 的数据报过期
+        Sender local(h.server.port());
+        if (!reply_is(local.command("moveForward", 1, now_us()), nullptr, 1)) ++bad;
+        if (!reply_is(local.command("turnLeft", 2, now_us() - late), "STALE", 2)) ++bad;
+        const bool dropped = h.manager.get_desired_state() == DesiredState::MOVING_FORWARD;
+        // 之后的新鲜数据报照常执行
+        if (!reply_is(local.command("turnRight", 3, now_us()), nullptr, 3)) ++bad;
+        // 时钟领先 10 秒的发送端：单向延迟为负，基线按该发送端建立，同样只丢弃相对基线迟到的数据报
+        Sender skewed(h.server.port());
+        const int64_t skew = 10'000'000;
+        if (!reply_is(skewed.command("moveBackward", 1, now_us() + skew), nullptr, 1)) ++bad;
+        if (!reply_is(skewed.command("moveBackward", 2, now_us() + skew - late), "STALE", 2)) ++bad;
+        if (!reply_is(skewed.command("stopAll", 3, now_us() + skew), nullptr, 3)) ++bad;
+
+        const uint64_t calls = h.calls.load() - calls_before;
+        const uint64_t stale = h.server.stats().stale - stale_before;
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "bad_replies=%d dropped=%d calls=%llu stale=%llu", bad, dropped,
+                      static_cast<unsigned long long>(calls), static_cast<unsigned long long>(stale));
+        return {"stale_drop", bad == 0 && dropped && calls == 4 && stale == 2, detail};
+    }
+
+    Result check_action_filter(Harness& h) {
+        Sender sender(h.server.port());
+        const uint64_t calls_before = h.calls.load();
+        const uint64_t rejected_before = h.server.stats().rejected;
+        int bad = 0;
+        int64_t seq = 1;
+        for (const char* action : {"traceExport", "recorderDump", "subscribe", "selfTest"}) {
+            if (!reply_is(sender.command(action, seq, now_us()), "ACTION_NOT_ALLOWED", seq)) ++bad;
+            ++seq;
+        }
+        // 被拒绝的数据报不记入发送端：之后序号 1 的运动指令照常执行
+        if (!reply_is(sender.command("turnLeft", 1, now_us()), nullptr, 1)) ++bad;
+
+        const uint64_t calls = h.calls.load() - calls_before;
+        const uint64_t rejected = h.server.stats().rejected - rejected_before;
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "bad_replies=%d calls=%llu rejected=%llu", bad,
+                      static_cast<unsigned long long>(calls), static_cast<unsigned long long>(rejected));
+        return {"action_filter", bad == 0 && calls == 1 && rejected == 4, detail};
+    }
+
+    Result check_errors(Harness& h) {
+        Sender sender(h.server.port());
+        const UdpServerStats before = h.server.stats();
+        int bad = 0;
+        h.throw_next.store(true);
+        if (!reply_is(sender.command("moveForward", 1, now_us()), "SERVER_ERROR", 1)) ++bad;
+        if (!reply_is(sender.exchange("{\"action\":\"moveForward\",\"ts_us\":1}"), "INVALID_DATAGRAM", -1)) ++bad;
+        if (!reply_is(sender.exchange("{\"action\":\"moveForward\",\"seq\":2,\"ts_us\":-5}"), "INVALID_DATAGRAM", 2)) ++bad;
+        if (!reply_is(sender.exchange("{\"action\":"), "INVALID_DATAGRAM", -1)) ++bad;
+        if (!reply_is(sender.exchange("{\"action\":\"moveForward\",\"pad\":\"" + std::string(4000, 'x') + "\"}"),
+                      "INVALID_DATAGRAM", -1)) {
+            ++bad;
+        }
+        // 接收线程仍在服务
+        if (!reply_is(sender.command("turnRight", 3, now_us()), nullptr, 3)) ++bad;
+        const bool served = h.manager.get_desired_state() == DesiredState::TURNING_RIGHT;
+
+        const UdpServerStats after = h.server.stats();
+        char detail[128];
+        std::snprintf(detail, sizeof(detail), "bad_replies=%d served=%d errors=%llu malformed=%llu", bad, served,
+                      static_cast<unsigned long long>(after.errors - before.errors),
+                      static_cast<unsigned long long>(after.malformed - before.malformed));
+        return {"error_containment", bad == 0 && served && after.errors - before.errors == 1 &&
+                                         after.malformed - before.malformed == 4, detail};
+    }
+}
+
+int main() {
+    NullBuffer null_buffer;
+    std::streambuf* const cout_buffer = std::cout.rdbuf(&null_buffer);
+    std::streambuf* const cerr_buffer = std::cerr.rdbuf(&null_buffer);
+
+    std::vector<Result> results;
+    {
+        Harness h;
+        auto started = h.server.start();
+        if (!started) {
+            results.push_back({"start", false, started.error()});
+        } else {
+            results.push_back(check_sequencing(h));
+            results.push_back(check_stale(h));
+            results.push_back(check_action_filter(h));
+            results.push_back(check_errors(h));
+            h.server.stop();
+        }
+    }
+
+    std::cout.rdbuf(cout_buffer);
+    std::cerr.rdbuf(cerr_buffer);
+    bool pass = true;
+    std::printf("%-24s %-6s %s\n", "check", "result", "detail");
+    for (const Result& result : results) {
+        pass = pass && result.ok;
+        std::printf("%-24s %-6s %s\n", result.name.c_str(), result.ok ? "PASS" : "FAIL", result.detail.c_str());
+    }
+    return pass ? 0 : 1;
+}
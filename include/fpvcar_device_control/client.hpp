@@ -0,0 +1,223 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <tl/expected.hpp>
+
+// 这个文件提供 gateway 等进程使用的客户端库（fpvcar-devicecontrol-client），与 IpcServer 共用 ipc_framing 的帧格式：
+//   - 持久连接：一条 Unix 套接字连接复用给所有指令，断开后按指数退避自动重连
+//   - 非阻塞发送：send() 只把请求放入队列并唤醒 I/O 线程，不等待响应；多条在途请求在同一连接上流水线发送，
+//     服务端按请求顺序返回响应（见 json 格式文档"限速与过载保护"一节），客户端按顺序与在途请求对应
+//   - 响应通过回调（在 I/O 线程中调用）或 future 交付；每个被接受的请求恰好交付一次结果
+//   - 客户端侧统计：提交到收到响应的延迟分位数、失败数与重连次数
+// 断开时已发送和仍在排队的请求都以失败交付，不会在重连后补发（过时的运动指令不应被执行）
+// 订阅（subscribe）会把连接转为推送流，不要通过本客户端发送，请另开连接
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 客户端选项
+     * @param socket_path 服务端 IPC 套接字路径
+     * @param reconnect_min, reconnect_max 重连退避的初始值与上限（每次失败翻倍，连接成功后复位）
+     * @param max_pending 已接受但尚未交付结果的请求（排队 + 在途）上限，超过时 send() 立即返回 false
+     * @param response_timeout 最早的在途请求超过这个时间没有响应即认为连接异常：该请求以 TIMEOUT 交付，断开并重连
+     */
+    struct ClientOptions {
+        std::string socket_path = "/tmp/fpvcar_control.sock";
+        std::chrono::milliseconds reconnect_min{20};
+        std::chrono::milliseconds reconnect_max{1000};
+        size_t max_pending = 256;
+        std::chrono::milliseconds response_timeout{1000};
+    };
+
+    /**
+     * @brief 请求的交付结果
+     */
+    enum class ClientStatus {
+        OK,            // 收到服务端响应（响应本身可能是 "status":"error"）
+        NOT_CONNECTED, // 请求由 I/O 线程处理时没有连接，未发送
+        DISCONNECTED,  // 已发送或排队，但连接在收到响应前断开
+        TIMEOUT,       // 超过 response_timeout 没有响应
+        STOPPED,       // 客户端已停止
+        QUEUE_FULL     // 未完成请求达到 max_pending（只出现在 request() 返回的 future 中）
+    };
+
+    /**
+     * @brief 将交付结果转换为字符串（用于日志）
+     */
+    const char* client_status_to_string(ClientStatus status);
+
+    /**
+     * @brief 一个请求的结果
+     * @param status 交付结果
+     * @param response 服务端响应 JSON（status 为 OK 时）
+     * @param latency_ns 从 send()/request() 提交到交付的时间
+     */
+    struct ClientResult {
+        ClientStatus status = ClientStatus::STOPPED;
+        std::string response;
+        int64_t latency_ns = 0;
+    };
+
+    /**
+     * @brief 客户端统计
+     * @param submitted 已接受的请求数
+     * @param completed 收到响应的请求数
+     * @param failed 以 OK 以外的结果交付的请求数
+     * @param rejected 因达到 max_pending 被拒绝的请求数
+     * @param reconnects 连接成功的次数（不含第一次连接）
+     * @param connected 当前是否已连接
+     * @param mean_latency_ns 收到响应的请求的平均延迟
+     * @param p50_latency_ns, p99_latency_ns, p999_latency_ns 延迟分位数（按 LATENCY_BUCKET 取整到桶的上界）
+     * @param max_latency_ns 最大延迟
+     */
+    struct ClientStats {
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        uint64_t failed = 0;
+        uint64_t rejected = 0;
+        uint64_t reconnects = 0;
+        bool connected = false;
+        int64_t mean_latency_ns = 0;
+        int64_t p50_latency_ns = 0;
+        int64_t p99_latency_ns = 0;
+        int64_t p999_latency_ns = 0;
+        int64_t max_latency_ns = 0;
+    };
+
+    /**
+     * @brief 设备控制服务的客户端
+     * @note send()/request()/command() 可以在任意线程调用；回调在客户端的 I/O 线程中调用，不应阻塞，也不应调用 stop()
+     */
+    class DeviceControlClient {
+    public:
+        /**
+         * @brief 结果回调
+         */
+        using ResponseCallback = std::function<void(const ClientResult&)>;
+
+        explicit DeviceControlClient(ClientOptions options = {});
+        ~DeviceControlClient();
+
+        DeviceControlClient(const DeviceControlClient&) = delete;
+        DeviceControlClient& operator=(const DeviceControlClient&) = delete;
+
+        /**
+         * @brief 在调用线程中尝试第一次连接，然后启动 I/O 线程
+         * @return 成功返回 void，失败返回错误信息字符串
+         * @note 服务端未运行不算失败：I/O 线程会按退避继续重连，可用 wait_connected() 等待
+         */
+        tl::expected<void, std::string> start();
+
+        /**
+         * @brief 停止 I/O 线程并关闭连接，所有未完成的请求以 STOPPED 交付
+         */
+        void stop();
+
+        /**
+         * @brief 提交一条请求（JSON 字符串），不等待响应
+         * @param request 请求内容
+         * @param callback 结果回调，可以为空
+         * @return 请求被接受返回 true（回调之后恰好被调用一次）；未启动或达到 max_pending 时返回 false（回调不会被调用）
+         */
+        bool send(std::string_view request, ResponseCallback callback = {});
+
+        /**
+         * @brief 提交一条请求，通过 future 取得结果
+         * @note 请求未被接受时 future 立即就绪（STOPPED 或 QUEUE_FULL）
+         */
+        std::future<ClientResult> request(std::string_view request);
+
+        /**
+         * @brief 按 action 与可选的 ttl_ms 组装请求并提交（同 send）
+         * @param action 指令名称，例如 "moveForward"
+         * @param ttl_ms 指令租约（毫秒），0 表示不带租约
+         */
+        bool command(std::string_view action, int ttl_ms = 0, ResponseCallback callback = {});
+
+        /**
+         * @brief 当前是否已连接
+         */
+        bool connected() const { return m_connected.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief 等待连接建立
+         * @return 超时前已连接返回 true
+         */
+        bool wait_connected(std::chrono::milliseconds timeout);
+
+        /**
+         * @brief 获取统计，可在任意线程调用
+         */
+        ClientStats stats() const;
+
+    private:
+        using SteadyTime = std::chrono::steady_clock::time_point;
+
+        /**
+         * @brief 一个未完成的请求
+         */
+        struct Pending {
+            std::string request;
+            ResponseCallback callback;
+            SteadyTime submitted;
+        };
+
+        void run();
+        bool try_connect();
+        void disconnect(ClientStatus in_flight_status);
+        void dispatch_queued();
+        bool flush_output();
+        bool read_responses();
+        void deliver(Pending& pending, ClientStatus status, std::string_view response);
+
+        // 延迟直方图：按 LATENCY_BUCKET 分桶，最后一个桶收纳更大的延迟
+        static constexpr std::chrono::microseconds LATENCY_BUCKET{10};
+        static constexpr size_t LATENCY_BUCKETS = 1001;
+
+        const ClientOptions m_options;
+
+        // 提交方与 I/O 线程共享的请求队列
+        std::mutex m_queue_mutex;
+        std::vector<Pending> m_queue;
+        std::atomic<size_t> m_outstanding{0}; // 已接受但尚未交付的请求数
+
+        // 以下只由 I/O 线程访问（start() 在线程启动前的第一次连接除外）
+        int m_fd = -1;
+        int m_wake_fd = -1;
+        std::vector<Pending> m_batch;  // 从队列取出的一批请求
+        std::deque<Pending> m_in_flight; // 已写入发送缓冲区、等待响应的请求（按发送顺序）
+        std::string m_output;          // 待发送的帧
+        size_t m_output_offset = 0;
+        std::string m_input;           // 已接收但尚未解析的数据
+        std::vector<std::string_view> m_frames;
+        std::chrono::milliseconds m_backoff{0};
+        SteadyTime m_next_connect;
+        bool m_ever_connected = false;
+
+        std::atomic<bool> m_running{false};
+        std::atomic<bool> m_connected{false};
+        std::thread m_thread;
+        mutable std::mutex m_connected_mutex;
+        std::condition_variable m_connected_cv;
+
+        std::atomic<uint64_t> m_submitted{0};
+        std::atomic<uint64_t> m_completed{0};
+        std::atomic<uint64_t> m_failed{0};
+        std::atomic<uint64_t> m_rejected{0};
+        std::atomic<uint64_t> m_reconnects{0};
+        std::atomic<int64_t> m_latency_sum_ns{0};
+        std::atomic<int64_t> m_max_latency_ns{0};
+        std::array<std::atomic<uint64_t>, LATENCY_BUCKETS> m_latency_histogram{};
+    };
+}
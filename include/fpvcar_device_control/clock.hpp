@@ -0,0 +1,123 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+// 这个文件提供可注入的时钟与休眠抽象
+// ControlLoop、SoftwareWatchdog 和 DesiredStateManager（指令租约）都通过 Clock 读取时间和休眠：
+//   - SteadyClock：真实的 std::chrono::steady_clock，服务默认使用
+//   - VirtualClock：虚拟时间，由驱动方（仿真器）推进，可以在几秒内跑完一小时的控制周期
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 时钟与休眠接口
+     * @note 时间点类型与 std::chrono::steady_clock 相同，便于与现有代码互换
+     */
+    class Clock {
+    public:
+        using duration = std::chrono::steady_clock::duration;
+        using time_point = std::chrono::steady_clock::time_point;
+
+        virtual ~Clock() = default;
+
+        /**
+         * @brief 当前时间
+         */
+        virtual time_point now() const = 0;
+
+        /**
+         * @brief 休眠到指定时间
+         * @param deadline 唤醒时间
+         * @note 可能因 wake_all() 提前返回，调用方需要自行检查是否已到达 deadline
+         */
+        virtual void sleep_until(time_point deadline) = 0;
+
+        /**
+         * @brief 唤醒所有正在休眠的线程（用于 stop() 时让线程尽快退出）
+         */
+        virtual void wake_all() = 0;
+
+        /**
+         * @brief 登记一个会在该时钟上休眠的线程
+         * @note 必须由创建线程的一方在创建线程之前调用，线程退出前调用 unregister_thread()
+         * @note VirtualClock 据此判断所有线程是否都已休眠（见 VirtualClock::advance_to），SteadyClock 忽略
+         */
+        virtual void register_thread() {}
+
+        /**
+         * @brief 注销线程（由线程自己在退出前调用）
+         */
+        virtual void unregister_thread() {}
+    };
+
+    /**
+     * @brief 真实时钟：std::chrono::steady_clock + 可被 wake_all() 打断的休眠
+     */
+    class SteadyClock : public Clock {
+    public:
+        /**
+         * @brief 进程内共享的默认实例
+         */
+        static SteadyClock& instance();
+
+        time_point now() const override { return std::chrono::steady_clock::now(); }
+        void sleep_until(time_point deadline) override;
+        void wake_all() override;
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        uint64_t m_generation = 0; // 每次 wake_all() 递增
+    };
+
+    /**
+     * @brief 虚拟时钟：时间只在驱动方调用 advance_to()/advance() 时前进
+     * @note 推进时间前会等待所有登记的线程进入休眠，再按截止时间顺序逐个唤醒，
+     *       因此在相同输入下，各线程看到的时间和执行顺序是确定的（可复现）
+     * @note 驱动方自身不应登记为休眠线程
+     */
+    class VirtualClock : public Clock {
+    public:
+        /**
+         * @param start 起始时间
+         */
+        explicit VirtualClock(time_point start = time_point(std::chrono::hours(1)));
+
+        time_point now() const override;
+        void sleep_until(time_point deadline) override;
+        void wake_all() override;
+        void register_thread() override;
+        void unregister_thread() override;
+
+        /**
+         * @brief 把时间推进到 target
+         * @note 依次跳到每个不晚于 target 的休眠截止时间，唤醒到期的线程并等待它们重新休眠或退出
+         */
+        void advance_to(time_point target);
+
+        /**
+         * @brief 把时间推进 d
+         */
+        void advance(duration d) { advance_to(now() + d); }
+
+        /**
+         * @brief 等待所有登记的线程进入休眠（或退出）
+         */
+        void wait_idle();
+
+    private:
+        struct Sleeper {
+            bool woken = false;
+        };
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_sleepers_cv; // 唤醒休眠线程
+        std::condition_variable m_idle_cv;     // 通知驱动方：有线程进入休眠或退出
+        time_point m_now;
+        int m_active = 0; // 已登记且未休眠的线程数
+        std::multimap<time_point, Sleeper*> m_sleepers; // 按截止时间排序的休眠线程
+    };
+}
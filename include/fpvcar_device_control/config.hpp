@@ -1,8 +1,12 @@
 #pragma once
+#include <array>
 #include <string>
 #include <cstdint>
 #include <tl/expected.hpp>
 #include "fpvcar-motor/config.hpp" // 引入 FpvCarChannelConfig
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/motor_fault.hpp"
+#include "fpvcar_device_control/wheel_speed.hpp"
 
 namespace fpvcar::device_control::config {
     /**
@@ -11,14 +15,59 @@ namespace fpvcar::device_control::config {
      * @param i2c_device_path I2C设备路径，默认值为 "/dev/i2c-1"
      * @param pwm_frequency PWM频率（Hz），默认值为10000.0
      * @param pca9685_address PCA9685的I2C地址，默认值为0x40
+     * @param motor_driver 电机驱动："fpvcar-motor"（默认，fpvcar-motor 库）或 "pca9685"（经 I2C 传输层直接写 PCA9685 寄存器，支持闭环）；
+     *        i2c_device_path 以 "emu:" 开头时总是使用 "pca9685" 驱动与寄存器级仿真器
+     * @param i2c_bus_speed_hz I2C 总线速率（Hz）：100000、400000（默认）或 1000000；仿真器按它限速，真实总线只用于计算总线占用时间
      * @param ipc_socket_path IPC 通信使用的 Unix 域套接字文件路径，默认值为 /tmp/fpvcar_control.sock
+     * @param takeover_socket_path 进程接管（不停车升级）使用的 Unix 域套接字路径，默认值为 /tmp/fpvcar_control.takeover.sock，空字符串表示不接受接管
+     * @param estop_socket_path 紧急停车通道的 Unix 域套接字路径（SOCK_SEQPACKET），默认值为 /tmp/fpvcar_control.estop.sock，空字符串表示只接收 SIGUSR1
+     * @param ipc_backend IPC 服务器 I/O 后端："blocking"（默认）或 "io_uring"（内核不支持时自动回退到 blocking）
+     * @param ipc_rate_limit_hz 每条 IPC 连接的请求速率上限（条/秒，令牌桶），默认 1000，0 表示不限速；超出的非停止请求回复 RATE_LIMITED
+     * @param ipc_rate_limit_burst 令牌桶容量（允许的突发条数），默认 100
+     * @param udp_port UDP 控制通道端口，默认 0 表示不开启（数据报格式见 json 格式文档）
+     * @param udp_bind_address UDP 控制通道绑定的 IPv4 地址，默认 "127.0.0.1"（只接受本机数据报）；gateway 在另一块板子上时配置为对应网卡的地址
+     * @param udp_max_delay_ms UDP 数据报单向延迟超出发送端延迟基线多少毫秒即视为过期并丢弃，默认 100
+     * @param diagnostics_dir traceExport 与 recorderDump 指令导出文件的目录（文件名由服务端生成），默认 /tmp/fpvcar_diagnostics，不存在时以 0700 创建；空字符串表示不允许导出
+     * @param trace_enabled 启动时是否打开按请求追踪，默认关闭（运行时可通过 traceStart/traceStop 切换）
+     * @param flight_recorder_enabled 是否打开飞行记录器（常开的事件环形缓冲区），默认打开
+     * @param flight_recorder_path 飞行记录自动导出（看门狗停下运动中的车辆、致命信号）的文件路径，默认 /tmp/fpvcar_flight.bin，空字符串表示不自动导出
+     * @param lease_safe_state 带 ttl_ms 的指令租约到期后切换到的安全状态，配置文件中以 action 名称表示，默认 "stopAll"
+     * @param telemetry_rate_hz 订阅连接的周期遥测推送频率（Hz），默认 10，0 表示只推送状态变更和看门狗事件
+     * @param telemetry_max_subscribers 最大订阅连接数，默认 8
+     * @param motor_fault_policy 电机调用故障处理策略，配置文件中对应 motor_call_timeout_ms（默认 20）、motor_max_backoff_ms（默认 500）、
+     *        motor_reinit_after_failures（默认 3，0 表示不重新初始化）、motor_degraded_after_failures（默认 6）、motor_fault_cpu_share（默认 0.2）
+     * @param wheel_speed 闭环轮速控制参数，配置文件中对应 closed_loop_enabled（默认 false）、closed_loop_rate_hz（默认 1000）、
+     *        closed_loop_max_speed_eps（默认 2000）、closed_loop_kp（默认 0.5）、closed_loop_ki（默认 12）、closed_loop_feedforward（默认 0.8）
+     * @param encoder_gpio_chip 闭环使用的编码器 GPIO 芯片设备，默认 "/dev/gpiochip0"
+     * @param encoder_gpio_lines 各车轮编码器信号线编号（左前、右前、左后、右后），默认 [17, 27, 22, 23]
      */
     struct AppConfig {
         fpvcar::motorconfig::FpvCarChannelConfig channels; // 小车电机通道配置
         std::string i2c_device_path = fpvcar::motorconfig::I2C_DEVICE_PATH;
         float pwm_frequency = fpvcar::motorconfig::DEFAULT_PWM_FREQUENCY;
         uint8_t pca9685_address = fpvcar::motorconfig::PCA9685_I2C_ADDRESS;
+        std::string motor_driver = "fpvcar-motor";
+        uint32_t i2c_bus_speed_hz = 400000;
         std::string ipc_socket_path = "/tmp/fpvcar_control.sock";
+        std::string takeover_socket_path = "/tmp/fpvcar_control.takeover.sock";
+        std::string estop_socket_path = "/tmp/fpvcar_control.estop.sock";
+        std::string ipc_backend = "blocking";
+        double ipc_rate_limit_hz = 1000.0;
+        double ipc_rate_limit_burst = 100.0;
+        uint16_t udp_port = 0;
+        std::string udp_bind_address = "127.0.0.1";
+        uint32_t udp_max_delay_ms = 100;
+        std::string diagnostics_dir = "/tmp/fpvcar_diagnostics";
+        bool trace_enabled = false;
+        bool flight_recorder_enabled = true;
+        std::string flight_recorder_path = "/tmp/fpvcar_flight.bin";
+        DesiredState lease_safe_state = DesiredState::STOPPING;
+        double telemetry_rate_hz = 10.0;
+        uint32_t telemetry_max_subscribers = 8;
+        MotorFaultPolicy motor_fault_policy;
+        WheelSpeedConfig wheel_speed;
+        std::string encoder_gpio_chip = "/dev/gpiochip0";
+        std::array<uint32_t, WHEEL_COUNT> encoder_gpio_lines{17, 27, 22, 23};
     };
 
     /**
@@ -1,28 +1,80 @@
 #pragma once
 
+#include <array>
 #include <thread>
 #include <chrono>
 #include <atomic> // <--- 包含 atomic
+#include <memory>
+#include <mutex>
 
-#include "fpvcar-motor/fpvcar_controller.hpp"
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
+#include "fpvcar_device_control/motor_fault.hpp"
 #include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/pi_mutex.hpp"
 #include "fpvcar_device_control/watch_dog.hpp"
+#include "fpvcar_device_control/telemetry.hpp"
+#include "fpvcar_device_control/wheel_speed.hpp"
 //这个类用于具体控制小车的运动，根据期望状态管理器中的期望状态，控制小车运动
 
 namespace fpvcar::device_control {
 
+    /**
+    * @brief 控制循环在进程接管时移交的状态
+    * @param applied_state 最近一次实际执行的状态（电机保持在这个状态）
+    * @param watchdog 看门狗计时状态
+    */
+    struct ControlLoopResumeState {
+        DesiredState applied_state = DesiredState::STOPPING;
+        WatchdogState watchdog;
+    };
+
+    /**
+    * @brief 控制周期的时间统计
+    * @param intervals 统计的周期间隔数
+    * @param target_interval_ns 目标周期
+    * @param mean_interval_ns 平均周期
+    * @param jitter_p50_ns, jitter_p99_ns, jitter_p999_ns |实际周期 - 目标周期| 的分位数（按 JITTER_BUCKET 取整到桶的上界）
+    * @param max_jitter_ns |实际周期 - 目标周期| 的最大值
+    * @param overruns 掉帧（本周期的工作超过周期长度）次数
+    */
+    struct TickTimingStats {
+        uint64_t intervals = 0;
+        int64_t target_interval_ns = 0;
+        int64_t mean_interval_ns = 0;
+        int64_t jitter_p50_ns = 0;
+        int64_t jitter_p99_ns = 0;
+        int64_t jitter_p999_ns = 0;
+        int64_t max_jitter_ns = 0;
+        uint64_t overruns = 0;
+    };
+
     /**
     * @brief 控制循环，用于控制小车运动
     * @param desired_state_manager 期望状态管理器
-    * @param car 小车控制器
+    * @param car 电机后端
+    * @param lease_safe_state 指令租约（ttl_ms）到期后切换到的安全状态，默认停止
+    * @param fault_policy 电机调用的故障处理策略（超时、退避重试、重新初始化与降级）
+    * @param clock 时间与休眠来源，默认真实时钟；仿真时传入 VirtualClock（看门狗使用同一个时钟）
     * @note 控制循环会定期检查期望状态管理器中的期望状态，并根据期望状态控制小车运动
+    * @note 租约到期检查在控制循环线程内完成，循环会在租约到期时刻提前醒来，因此精度为毫秒级且不依赖看门狗线程
+    * @note 启用闭环轮速控制后（set_wheel_speed_control），控制周期改为闭环频率，运动状态下每个周期按编码器反馈更新各轮占空比；
+    *       停止状态仍调用 stopAll
+    * @note 所有电机调用都持有执行锁（优先级继承互斥锁，见 pi_mutex.hpp）：每个周期"读取期望状态 → 调用电机"的部分、
+    *       emergency_stop()、看门狗停车与 stop() 的停车调用互不并发，后端不需要自己保证线程安全（见 MotorBackend）
 
     */
 class ControlLoop {
 public:
-    ControlLoop(DesiredStateManager& desired_state_manager, control::FpvCarController& car);
+    ControlLoop(DesiredStateManager& desired_state_manager, MotorBackend& car,
+                DesiredState lease_safe_state = DesiredState::STOPPING,
+                const MotorFaultPolicy& fault_policy = MotorFaultPolicy(),
+                Clock& clock = SteadyClock::instance());
     ~ControlLoop(); // <--- 添加析构函数
 
+    static constexpr std::chrono::milliseconds TARGET_INTERVAL{10}; // 控制周期
+    static constexpr std::chrono::milliseconds WATCHDOG_TIMEOUT{5000}; // 看门狗超时时间
+
     // 禁止拷贝和赋值，因为我们管理着一个线程
     ControlLoop(const ControlLoop&) = delete;
     ControlLoop& operator=(const ControlLoop&) = delete;
@@ -33,31 +85,124 @@ public:
     */
     void start();
 
+    /**
+    * @brief 从另一个进程移交的状态继续运行（进程接管）
+    * @param resume 旧进程 detach() 返回的状态
+    * @note 第一个周期会重新下发当前期望状态（与旧进程写入的寄存器值相同，电机不会中断）
+    */
+    void start(const ControlLoopResumeState& resume);
+
+    /**
+    * @brief 启用闭环轮速控制
+    * @param feedback 编码器反馈（生命周期长于控制循环）
+    * @param config 闭环参数；控制频率限制在 (0, 1000] Hz
+    * @note 必须在 start() 之前调用；电机后端需要支持按车轮设置占空比
+    */
+    void set_wheel_speed_control(WheelFeedback& feedback, const WheelSpeedConfig& config);
+
+    /**
+    * @brief 控制周期（默认 TARGET_INTERVAL，闭环时为闭环频率对应的周期）
+    */
+    Clock::duration target_interval() const { return m_target_interval; }
+
+    /**
+    * @brief 获取控制周期的时间统计（可在任意线程调用）
+    */
+    TickTimingStats tick_timing() const;
+
     /**
     * @brief 停止控制循环
     * @note 停止控制循环会停止控制循环线程
     */
     void stop();
 
+    /**
+    * @brief 停止控制循环线程和看门狗，但不停车，用于把控制权交给新进程
+    * @return 移交给新进程的状态
+    * @note 之后可以用 start(resume) 恢复（移交失败时回滚）；未运行时返回当前状态
+    */
+    ControlLoopResumeState detach();
+
+    /**
+    * @brief 紧急停车：把期望状态置为停止并直接调用电机停车，不等下一个控制周期
+    * @return 停车调用成功返回 true；失败时期望状态仍为停止，由控制循环的故障处理继续重试
+    * @note 可在任意线程调用（见 estop.hpp）。与控制周期的执行部分互斥：最多等待正在进行的一次电机调用，
+    *       之后控制循环读到的一定是停止状态，不会在停车之后再下发此前读到的运动状态
+    * @note 控制循环未运行时同样直接停车
+    */
+    bool emergency_stop();
+
     /**
     * @brief 喂看门狗（当接收到新指令时调用）
     * @note 看门狗用于监控是否长时间没有接收新指令或者执行指令，如果超时会自动停止车辆
     */
     void feed_watchdog();
 
+    /**
+    * @brief 获取遥测快照通道（control_loop 线程是唯一的生产者）
+    * @note 每个周期发布一次快照；执行状态变更和看门狗超时时额外发出通知
+    */
+    const TelemetryChannel& telemetry() const { return m_telemetry; }
+
+    /**
+    * @brief 获取电机调用的故障统计（可在任意线程调用）
+    */
+    MotorFaultStats motor_faults() const { return m_fault_guard.stats(); }
+
 private:
     void run_loop(); // <--- 循环的私有实现
+    void apply_state(DesiredState desired_state, uint64_t request_id); // 调用控制器执行期望状态
+    void publish_telemetry(DesiredState desired_state, bool notify); // 发布遥测快照
+    void record_tick(Clock::time_point now); // 记录一个周期的开始时间，更新周期与抖动统计
+    void apply_wheel_speed(DesiredState target_state); // 闭环：采样编码器、更新 PI 并下发各轮占空比
 
     DesiredStateManager& m_desired_state_manager;
-    control::FpvCarController& m_car;
+    MotorBackend& m_car;
+    Clock& m_clock; // 时间与休眠来源
     DesiredState m_old_desired_state;
+    const DesiredState m_lease_safe_state; // 租约到期后的安全状态
+    PiMutex m_actuation_mutex; // 执行锁：所有电机调用（控制周期、emergency_stop()、看门狗、stop()）互斥，优先级继承
     SoftwareWatchdog m_watchdog; // 看门狗
+    MotorFaultGuard m_fault_guard; // 电机调用故障处理（只由控制循环线程调用）
+    bool m_was_degraded = false; // 上一次循环时是否处于降级模式
+    bool m_reapply = false; // 接管后第一次循环强制重新下发期望状态
+    std::atomic<uint64_t> m_estops{0}; // 紧急停车次数
     
     std::atomic<bool> m_is_running{false}; // <--- 使用 atomic 并默认为 false // 避免编译器优化导致线程不安全
     std::thread m_loop_thread; // <--- 用于运行循环的线程
 
-    const std::chrono::milliseconds m_target_interval = std::chrono::milliseconds(10); // <--- 目标循环间隔时间
-    std::chrono::time_point<std::chrono::steady_clock> m_next_loop_start_time;
+    Clock::duration m_target_interval = TARGET_INTERVAL; // <--- 目标循环间隔时间
+    Clock::time_point m_next_loop_start_time;
+
+    // 闭环轮速控制（未启用时 m_speed_controller 为空）
+    WheelFeedback* m_feedback = nullptr;
+    std::unique_ptr<WheelSpeedController> m_speed_controller;
+    EncoderSample m_encoder_sample;
+    WheelDuty m_duty{};
+    uint64_t m_feedback_failures = 0;
+
+    // 周期时间统计：直方图按 JITTER_BUCKET 分桶，最后一个桶收纳更大的抖动
+    static constexpr std::chrono::microseconds JITTER_BUCKET{5};
+    static constexpr size_t JITTER_BUCKETS = 401;
+    Clock::time_point m_last_tick_start{};
+    bool m_has_last_tick = false;
+    int64_t m_interval_ewma_ns = 0;
+    int64_t m_jitter_ewma_ns = 0;
+    std::array<std::atomic<uint64_t>, JITTER_BUCKETS> m_jitter_histogram{};
+    std::atomic<uint64_t> m_intervals{0};
+    std::atomic<int64_t> m_interval_sum_ns{0};
+    std::atomic<int64_t> m_max_jitter_ns{0};
+
+    // 掉帧告警每秒最多打印一次
+    Clock::time_point m_next_overrun_report{};
+    uint64_t m_reported_overruns = 0;
+
+    // 遥测计数（只由控制循环线程修改）
+    TelemetryChannel m_telemetry;
+    uint64_t m_ticks = 0;
+    std::atomic<uint64_t> m_overruns{0};
+    uint64_t m_lease_expiries = 0;
+    uint64_t m_last_watchdog_trips = 0;
 };
 
 } // namespace fpvcar::device_control
\ No newline at end of file
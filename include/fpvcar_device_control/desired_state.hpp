@@ -1,10 +1,14 @@
 #pragma once
 #include <tl/expected.hpp>
 #include <string>        
+#include <cstdint>
 #include <atomic>        
 #include <chrono>      
 #include <mutex>   
-#include <shared_mutex>   
+#include <optional>
+#include <string_view>
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/pi_mutex.hpp"
 
 // 这个文件主要提供共享状态模型的实现，用于管理期望状态
 // 向control_loop提供读取共享状态的接口
@@ -31,9 +35,47 @@ namespace fpvcar::device_control {
         STOPPING
     };
 
+    // 指令租约的时间点类型（由 DesiredStateManager 注入的 Clock 提供）
+    using LeaseTimePoint = Clock::time_point;
+
+    /**
+     * @brief 表示"没有租约"（指令一直有效，直到被新的指令覆盖）
+     */
+    constexpr LeaseTimePoint NO_LEASE = LeaseTimePoint::max();
+
+    /**
+     * @brief 指令租约 ttl_ms 的上限（1 小时）；超出时请求回复 INVALID_TTL
+     * @note 上限保证 now + ttl 换算为纳秒时不会溢出
+     */
+    constexpr int64_t MAX_LEASE_TTL_MS = 3600 * 1000;
+
+    /**
+     * @brief ttl_ms 是否为合法的租约有效期（1 到 MAX_LEASE_TTL_MS 毫秒）
+     */
+    constexpr bool lease_ttl_valid(int64_t ttl_ms) {
+        return ttl_ms > 0 && ttl_ms <= MAX_LEASE_TTL_MS;
+    }
+
+    /**
+     * @brief 把 IPC 请求中的 action 名称转换为期望状态
+     * @param action action 名称，如 "moveForward"、"stopAll"
+     * @return 成功返回对应的期望状态，未知 action 返回 std::nullopt
+     */
+    std::optional<DesiredState> desired_state_from_action(std::string_view action);
+
+    /**
+     * @brief 把期望状态转换为对应的 action 名称（desired_state_from_action 的逆操作）
+     * @param state 期望状态
+     * @return action 名称，如 "moveForward"、"stopAll"
+     */
+    const char* desired_state_to_action(DesiredState state);
+
     class DesiredStateManager {
     public:
-        DesiredStateManager();
+        /**
+        * @param clock 计算租约到期时间使用的时钟，需与 control_loop 使用同一个时钟
+        */
+        explicit DesiredStateManager(Clock& clock = SteadyClock::instance());
         ~DesiredStateManager();
 
         /**
@@ -44,6 +86,22 @@ namespace fpvcar::device_control {
         */
         void set_desired_state(const DesiredState& desired_state);
 
+        /**
+        * @brief 设置带租约（有效期）的期望状态
+        * @param desired_state 期望状态
+        * @param ttl 有效期，从现在起计算；ttl <= 0 等同于不带租约，超过 MAX_LEASE_TTL_MS 时按 MAX_LEASE_TTL_MS 计算
+        * @note 租约到期且期间没有新的指令时，control_loop 会切换到安全状态（见 expire_lease）
+        * @note 同一状态的重复指令会续期租约
+        */
+        void set_desired_state(const DesiredState& desired_state, std::chrono::milliseconds ttl);
+
+        /**
+        * @brief 恢复期望状态与租约到期时间（进程接管时使用）
+        * @param desired_state 期望状态
+        * @param lease_deadline 租约到期时间（绝对时间），NO_LEASE 表示不带租约；已经过去时由 control_loop 在下一个周期处理
+        */
+        void restore_desired_state(const DesiredState& desired_state, LeaseTimePoint lease_deadline);
+
         /**
         * @brief 获取期望状态
         * @return 返回期望状态
@@ -51,8 +109,36 @@ namespace fpvcar::device_control {
         */
         DesiredState get_desired_state();
 
+        /**
+        * @brief 获取最近一次设置期望状态的请求 ID
+        * @return 返回请求 ID，追踪关闭或未设置时为 0
+        * @note 供 control_loop 在追踪中把状态变更关联回原始请求
+        */
+        uint64_t get_request_id() const;
+
+        /**
+        * @brief 获取当前期望状态的租约到期时间
+        * @return 返回到期时间，没有租约时返回 NO_LEASE
+        */
+        LeaseTimePoint get_lease_deadline();
+
+        /**
+        * @brief 使租约过期：把期望状态切换为安全状态并清除租约
+        * @param deadline 调用者观察到的租约到期时间
+        * @param safe_state 租约过期后切换到的安全状态
+        * @return 成功切换返回 true；如果租约在此期间已被续期或替换（到期时间不再等于 deadline），不做修改并返回 false
+        * @note 比较和切换在同一把锁内完成，避免覆盖刚刚到达的新指令
+        */
+        bool expire_lease(LeaseTimePoint deadline, DesiredState safe_state);
+
     private:
+        Clock& m_clock; // 租约时钟
         DesiredState m_desired_state; // 期望状态结构体
-        std::shared_mutex m_mutex; // 共享锁
+        LeaseTimePoint m_lease_deadline = NO_LEASE; // 租约到期时间
+        std::atomic<uint64_t> m_request_id{0}; // 最近一次写入的请求 ID（仅用于追踪）
+        // 优先级继承互斥锁：紧急停车线程（SCHED_FIFO）也会写期望状态；glibc 的读写锁不处理优先级，
+        // 单核上高优先级的写者可能一直占着 CPU 等待被抢占的读者，直到实时调度限流才放行（约 1 秒）
+        // 临界区只有几次赋值，读者之间不需要并发
+        PiMutex m_mutex;
     };
 }
\ No newline at end of file
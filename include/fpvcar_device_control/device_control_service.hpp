@@ -2,8 +2,14 @@
 #include "fpvcar_device_control/config.hpp"
 #include "fpvcar_device_control/request_handler.hpp"
 #include "fpvcar_device_control/ipc_server.hpp"
-#include "fpvcar-motor/fpvcar_controller.hpp"
+#include "fpvcar_device_control/udp_server.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
+#include "fpvcar_device_control/i2c_transport.hpp"
 #include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/telemetry.hpp"
+#include "fpvcar_device_control/takeover.hpp"
+#include "fpvcar_device_control/estop.hpp"
+#include <atomic>
 #include <thread>
 #include <memory>
 #include <tl/expected.hpp>
@@ -38,20 +44,76 @@ namespace fpvcar::device_control {
          */
         tl::expected<void, std::string> start();
         
+        /**
+         * @brief 接管正在运行的实例（不停车升级），代替 start()
+         * @return 成功返回 void，失败返回错误信息字符串（旧实例会恢复服务）
+         * @note 从旧实例取得 IPC 监听套接字、客户端连接、期望状态与看门狗计时，电机在切换期间保持当前输出
+         * @note 接管套接字上没有正在运行的实例时按 start() 正常启动
+         */
+        tl::expected<void, std::string> start_takeover();
+
         /**
          * @brief 停止服务：停止 IPC 服务器并等待服务器线程结束
          * @note 线程安全，可被多次调用
+         * @note 服务已移交给新实例时不停车、不删除套接字文件
          */
         void stop();
 
+        /**
+         * @brief 服务是否已移交给新实例（此后应调用 stop() 并退出进程）
+         */
+        bool handed_over() const { return m_handed_over.load(); }
+
     private:
         config::AppConfig m_config; // 应用配置
         DesiredStateManager m_desired_state_manager; // 期望状态管理器
-        fpvcar::control::FpvCarController m_controller; // 控制器
+        std::unique_ptr<I2cTransport> m_i2c; // motor_driver 为 "pca9685" 时的 I2C 传输层（真实总线或 PCA9685 仿真器），否则为空
+        std::unique_ptr<MotorBackend> m_controller; // 电机后端（fpvcar-motor 控制器或 Pca9685MotorBackend）
+        std::unique_ptr<WheelFeedback> m_encoder; // 闭环轮速控制的编码器反馈（未启用闭环时为空）
         ControlLoop m_control_loop; // 控制循环
+        EmergencyStop m_estop; // 紧急停车通道（专用套接字与 SIGUSR1，绕过 IPC 服务器与控制周期）
         RequestHandler m_handler; // 请求处理器
+        TelemetryPublisher m_telemetry; // 状态与遥测订阅推送
         IpcServer m_server; // IPC 服务器
         std::thread m_server_thread; // 服务器线程
+        UdpServer m_udp; // UDP 控制通道（udp_port 为 0 时不启动）
+        std::atomic<bool> m_udp_reported{false}; // 是否已打印 UDP 通道统计
+        std::atomic<bool> m_estop_reported{false}; // 是否已打印紧急停车统计
+        std::atomic<bool> m_i2c_reported{false}; // 是否已打印 I2C 总线统计
+        std::atomic<bool> m_handed_over{false}; // 是否已移交给新实例
+        takeover::TakeoverListener m_takeover; // 接管套接字（新实例通过它接管本实例）
+
+        /**
+         * @brief 处理一条指令（IPC 与 UDP 共用），并喂看门狗
+         */
+        IpcDisposition handle_command(std::string_view request, std::string& response);
+
+        /**
+         * @brief 按配置启用闭环轮速控制（在控制循环启动之前调用）
+         */
+        void enable_wheel_speed_control();
+
+        /**
+         * @brief 按配置启动 UDP 控制通道；启动失败时只打印告警（IPC 仍可用）
+         */
+        void start_udp();
+
+        /**
+         * @brief 启动紧急停车通道；启动失败时只打印告警（普通 stopAll 仍可用）
+         */
+        void start_estop();
+
+        /**
+         * @brief 处理新实例的接管请求（在接管监听线程中执行）
+         * @param fd 接管连接
+         * @return 移交成功返回 true；失败时恢复服务并返回 false
+         */
+        bool hand_over(int fd);
+
+        /**
+         * @brief 移交失败时用保留的套接字和状态恢复服务
+         */
+        void resume_after_failed_handover(const takeover::TakeoverState& state, IpcSockets sockets);
     };
 }
 
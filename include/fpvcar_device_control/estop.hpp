@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tl/expected.hpp>
+
+// 这个文件提供紧急停车快速通道：普通的 stopAll 要经过 JSON 解析与期望状态，再等最多一个控制周期才执行，
+// 而且在串行的 IpcServer 中可能排在其它客户端的请求之后
+// 紧急停车通道在独立的高优先级线程中直接执行停车动作（ControlLoop::emergency_stop），不经过 IPC 服务器与控制周期：
+//   - 专用 Unix 套接字（SOCK_SEQPACKET，保留消息边界）：每条消息为一个字节 ESTOP_FRAME，停车调用返回后回复一个字节
+//     （ESTOP_ACK_OK / ESTOP_ACK_FAILED），其它消息回复 ESTOP_ACK_INVALID 且不停车。客户端应保持连接，不必每次重新连接
+//   - SIGUSR1：信号处理函数只记录时间并写 eventfd（异步信号安全），由同一个线程执行停车；适合看门狗脚本、硬件按键守护进程等外部触发
+// 停车调用与控制周期共用 ControlLoop 的执行锁（优先级继承），控制循环线程正在写 I2C 时紧急停车线程等待这一次调用结束，
+// 持锁线程在此期间以紧急停车线程的优先级运行，不会被其它普通线程抢占
+// 紧急停车不锁存：之后新的运动指令照常执行
+
+namespace fpvcar::device_control {
+
+    constexpr char ESTOP_FRAME = '!';
+    constexpr char ESTOP_ACK_OK = 'K';
+    constexpr char ESTOP_ACK_FAILED = 'F';
+    constexpr char ESTOP_ACK_INVALID = 'E';
+
+    /**
+     * @brief 紧急停车统计（延迟从收到消息/信号到停车调用返回）
+     * @param triggers 执行停车的次数
+     * @param socket_triggers 其中由套接字消息触发的次数
+     * @param signal_triggers 其中由 SIGUSR1 触发的次数（处理前合并到达的多个信号只计一次）
+     * @param failures 停车调用失败的次数
+     * @param invalid_frames 无效消息数
+     * @param last_latency_ns, max_latency_ns, total_latency_ns 停车延迟：最近一次、最大值与总和（平均值 = total / triggers）
+     */
+    struct EstopStats {
+        uint64_t triggers = 0;
+        uint64_t socket_triggers = 0;
+        uint64_t signal_triggers = 0;
+        uint64_t failures = 0;
+        uint64_t invalid_frames = 0;
+        int64_t last_latency_ns = 0;
+        int64_t max_latency_ns = 0;
+        int64_t total_latency_ns = 0;
+    };
+
+    /**
+     * @brief 紧急停车通道
+     * @note 线程以 SCHED_FIFO 运行（需要 CAP_SYS_NICE，没有权限时以普通优先级运行并打印提示）
+     * @note 同一时间只有一个已启动的实例接收 SIGUSR1（最后启动的那个）
+     */
+    class EmergencyStop {
+    public:
+        /**
+         * @brief 停车动作：返回停车调用是否成功（在紧急停车线程中调用）
+         */
+        using StopAction = std::function<bool()>;
+
+        static constexpr size_t MAX_CLIENTS = 8;  // 同时保持的连接数上限，超出的连接直接关闭
+        static constexpr int THREAD_PRIORITY = 80; // SCHED_FIFO 优先级
+
+        /**
+         * @param socket_path 专用套接字路径，空字符串表示只接收 SIGUSR1
+         * @param action 停车动作
+         */
+        EmergencyStop(std::string socket_path, StopAction action);
+        ~EmergencyStop();
+
+        EmergencyStop(const EmergencyStop&) = delete;
+        EmergencyStop& operator=(const EmergencyStop&) = delete;
+
+        /**
+         * @brief 绑定套接字、注册 SIGUSR1 并启动线程
+         * @return 成功返回 void，失败返回错误信息字符串
+         * @note stop() 之后可以再次 start()（进程接管回滚时使用），统计保留
+         */
+        tl::expected<void, std::string> start();
+
+        /**
+         * @brief 停止线程、关闭所有连接并停止接收 SIGUSR1
+         * @param remove_socket 是否删除套接字文件（移交给新进程时由新进程重新绑定，不删除）
+         */
+        void stop(bool remove_socket = true);
+
+        /**
+         * @brief 获取统计，可在任意线程调用
+         */
+        EstopStats stats() const;
+
+    private:
+        void run();
+        bool trigger(bool from_signal, int64_t received_ns); // 执行停车并记录统计，返回停车调用是否成功
+
+        const std::string m_socket_path;
+        const StopAction m_action;
+
+        int m_listen_fd = -1;
+        int m_wake_fd = -1; // stop() 与 SIGUSR1 共用的 eventfd
+        std::vector<int> m_clients;
+        std::atomic<bool> m_running{false};
+        std::thread m_thread;
+
+        std::atomic<uint64_t> m_triggers{0};
+        std::atomic<uint64_t> m_socket_triggers{0};
+        std::atomic<uint64_t> m_signal_triggers{0};
+        std::atomic<uint64_t> m_failures{0};
+        std::atomic<uint64_t> m_invalid_frames{0};
+        std::atomic<int64_t> m_last_latency_ns{0};
+        std::atomic<int64_t> m_max_latency_ns{0};
+        std::atomic<int64_t> m_total_latency_ns{0};
+    };
+}
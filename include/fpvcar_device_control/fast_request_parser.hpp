@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+// 这个文件提供运动指令请求的快速解析路径
+// 只识别最常见的请求形式 {"action":"<名称>"} 以及可选的 "ttl_ms"、"seq"、"ts_us"（都是非负整数，后两者用于 UDP 传输），
+// 直接在输入上扫描，不构建 JSON DOM、不分配堆内存；字符串扫描在 x86 上使用 SSE2、在 AArch64 上使用 NEON，其它平台为标量实现
+// 任何超出这个子集的输入（转义字符、其它字段、非整数 ttl_ms 等）都交给 nlohmann DOM 路径处理，
+// 因此快速路径只会接受 DOM 路径同样接受、且语义一致的请求
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 快速路径解析结果
+     * @param action action 字段的值，指向输入缓冲区（输入失效后不可再使用）
+     * @param has_ttl 请求中是否包含 ttl_ms 字段
+     * @param ttl_ms ttl_ms 字段的值（仅当 has_ttl 为 true 时有效）
+     * @param has_seq, seq 请求中是否包含 seq 字段及其值（UDP 传输的序号）
+     * @param has_ts, ts_us 请求中是否包含 ts_us 字段及其值（UDP 传输的发送端时间戳）
+     */
+    struct FastRequest {
+        std::string_view action;
+        bool has_ttl = false;
+        int64_t ttl_ms = 0;
+        bool has_seq = false;
+        int64_t seq = 0;
+        bool has_ts = false;
+        int64_t ts_us = 0;
+    };
+
+    /**
+     * @brief 尝试用快速路径解析一条请求
+     * @param json_request 请求 JSON 字符串
+     * @param out 解析结果
+     * @return 输入属于快速路径支持的子集时返回 true；否则返回 false，调用方应回退到 DOM 解析
+     * @note 返回 false 并不代表输入非法，只代表快速路径无法确定
+     */
+    bool parse_fast_request(std::string_view json_request, FastRequest& out);
+
+    /**
+     * @brief 与 parse_fast_request 相同，但字符串扫描固定使用标量实现
+     * @note 作为 SIMD 实现的参照，供差分模糊测试与基准测试使用
+     */
+    bool parse_fast_request_scalar(std::string_view json_request, FastRequest& out);
+
+    /**
+     * @brief parse_fast_request 使用的字符串扫描实现："sse2"、"neon" 或 "scalar"
+     */
+    const char* fast_request_scanner();
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <tl/expected.hpp>
+#include "fpvcar_device_control/desired_state.hpp"
+
+// 这个文件提供常开的飞行记录器（flight recorder）：进程内一个固定大小的无锁环形缓冲区，
+// 记录最近的事件（收到的指令、控制循环的状态变更、电机调用及耗时、掉帧、看门狗喂狗/超时、租约到期、紧急停车、降级）
+// 在看门狗停下运动中的车辆、进程收到致命信号或收到 recorderDump 指令时导出为紧凑的二进制文件，用 fpvcar-flight-decode 解码
+// 与按请求追踪（trace.hpp）不同，记录器默认打开：每条事件只有一次原子自增、一次时钟读取和几次 relaxed 存储，不加锁也不分配内存
+
+namespace fpvcar::device_control::recorder {
+
+    // 全局记录开关，请通过 set_enabled()/is_enabled() 访问
+    extern std::atomic<bool> g_recorder_enabled;
+
+    /**
+     * @brief 环形缓冲区可保存的事件数量（2 的幂），写满后覆盖最旧的事件
+     * @note 正常驾驶（50Hz 指令）时约可保存数分钟，指令洪泛或 1kHz 闭环时约为十几秒
+     */
+    constexpr size_t CAPACITY = 16384;
+
+    /**
+     * @brief fpvcar-flight-decode 未指定文件时读取的默认路径（与配置项 flight_recorder_path 的默认值相同）
+     */
+    constexpr const char* DEFAULT_DUMP_PATH = "/tmp/fpvcar_flight.bin";
+
+    /**
+     * @brief 事件类型；各类型的参数含义见 Event
+     */
+    enum class EventType : uint8_t {
+        COMMAND = 1,       // 收到运动指令：a = 期望状态，b = 1 表示非法指令（已改为停车），c = ttl_ms
+        STATE = 2,         // 控制循环实际执行的状态变更：a = 新状态，b = 原状态，d = 周期序号
+        MOTOR_CALL = 3,    // 电机调用（退避期内跳过的不记录）：a = 目标状态，b = MotorCallResult，c = 耗时（纳秒，饱和到 uint32）
+        OVERRUN = 4,       // 掉帧：c = 超出周期的时间（微秒，饱和），d = 周期序号
+        WATCHDOG_FEED = 5, // 喂狗
+        WATCHDOG_TRIP = 6, // 看门狗超时停车：a = 超时时的期望状态，b = 1 表示停车调用失败
+        LEASE_EXPIRY = 7,  // 指令租约到期：a = 切换到的安全状态
+        ESTOP = 8,         // 紧急停车：b = 1 表示停车调用失败
+        FAULT = 9,         // 降级模式：b = 1 进入，0 退出
+    };
+
+    /**
+     * @brief 电机调用结果
+     */
+    enum class MotorCallResult : uint16_t {
+        OK = 0,
+        FAILED = 1,
+    };
+
+    /**
+     * @brief 导出原因
+     */
+    enum class DumpReason : uint32_t {
+        REQUEST = 1,  // recorderDump 指令
+        WATCHDOG = 2, // 看门狗停下了运动中的车辆
+        CRASH = 3,    // 致命信号
+    };
+
+    /**
+     * @brief 一条事件（解码后的形式）
+     * @param ts_ns 时间（steady_clock，纳秒）
+     * @param type 事件类型
+     * @param a, b, c, d 参数，含义随类型而定（见 EventType）
+     */
+    struct Event {
+        uint64_t ts_ns = 0;
+        EventType type = EventType::COMMAND;
+        uint8_t a = 0;
+        uint16_t b = 0;
+        uint32_t c = 0;
+        uint64_t d = 0;
+    };
+
+    /**
+     * @brief 导出文件头；文件内容为文件头加 count 条 24 字节的事件（按时间从旧到新），均为本机字节序（小端）
+     * @param magic 固定为 "FPVFREC"
+     * @param version 格式版本，当前为 1
+     * @param record_size 每条事件的字节数（24）
+     * @param reason 导出原因（DumpReason）
+     * @param signal 致命信号编号（其它原因为 0）
+     * @param count 文件中的事件数
+     * @param recorded 进程启动以来记录的事件总数（recorded - count 即已被覆盖的事件数）
+     * @param dump_steady_ns 导出时的 steady_clock 时间，与事件时间同一时间轴
+     * @param dump_realtime_ns 导出时的系统时间（Unix 纪元纳秒），用于把事件时间换算为绝对时间
+     */
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t reason;
+        uint32_t signal;
+        uint64_t count;
+        uint64_t recorded;
+        int64_t dump_steady_ns;
+        int64_t dump_realtime_ns;
+    };
+
+    /**
+     * @brief 运行时打开或关闭记录（默认打开）
+     */
+    void set_enabled(bool enabled);
+
+    /**
+     * @brief 查询记录是否打开
+     */
+    inline bool is_enabled() {
+        return g_recorder_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 写入一条事件（任意线程，无锁，可在信号处理函数中调用）
+     * @note 调用者一般使用下面按类型封装的函数；记录关闭时只有一次 relaxed 原子读
+     */
+    void record(EventType type, uint8_t a = 0, uint16_t b = 0, uint32_t c = 0, uint64_t d = 0);
+
+    /**
+     * @brief 获取当前 steady_clock 时间（纳秒），用于计算电机调用耗时
+     */
+    uint64_t now_ns();
+
+    inline void record_command(DesiredState state, bool invalid, int64_t ttl_ms) {
+        record(EventType::COMMAND, static_cast<uint8_t>(state), invalid ? 1 : 0,
+               static_cast<uint32_t>(ttl_ms > 0 ? (ttl_ms < UINT32_MAX ? ttl_ms : UINT32_MAX) : 0));
+    }
+
+    inline void record_state(DesiredState to, DesiredState from, uint64_t tick) {
+        record(EventType::STATE, static_cast<uint8_t>(to), static_cast<uint16_t>(from), 0, tick);
+    }
+
+    inline void record_motor_call(DesiredState state, MotorCallResult result, uint64_t duration_ns) {
+        record(EventType::MOTOR_CALL, static_cast<uint8_t>(state), static_cast<uint16_t>(result),
+               static_cast<uint32_t>(duration_ns < UINT32_MAX ? duration_ns : UINT32_MAX));
+    }
+
+    inline void record_overrun(int64_t late_ns, uint64_t tick) {
+        const int64_t late_us = late_ns / 1000;
+        record(EventType::OVERRUN, 0, 0, static_cast<uint32_t>(late_us > 0 ? (late_us < UINT32_MAX ? late_us : UINT32_MAX) : 0), tick);
+    }
+
+    /**
+     * @brief 导出环形缓冲区到文件
+     * @param file_path 输出文件路径（覆盖已有文件）
+     * @param reason 导出原因
+     * @return 成功返回 void，失败返回错误信息字符串
+     * @note 导出时不阻塞写入者，正在被覆盖的事件会被跳过
+     */
+    tl::expected<void, std::string> dump(const std::string& file_path, DumpReason reason);
+
+    /**
+     * @brief 设置自动导出（看门狗停车、致命信号）使用的路径，空字符串表示不自动导出
+     * @note 路径保存在静态缓冲区中（最长 255 字节），信号处理函数中可以安全读取
+     */
+    void set_dump_path(const std::string& file_path);
+
+    /**
+     * @brief 获取自动导出路径（未设置时为空字符串）
+     */
+    std::string dump_path();
+
+    /**
+     * @brief 导出到自动导出路径（未设置时不导出）
+     * @return 已导出返回 true
+     */
+    bool dump_automatic(DumpReason reason);
+
+    /**
+     * @brief 为致命信号（SIGSEGV、SIGBUS、SIGFPE、SIGILL、SIGABRT）安装处理函数：导出到自动导出路径后按默认行为终止进程
+     * @note 导出只使用异步信号安全的系统调用；栈溢出引起的 SIGSEGV 没有备用栈，无法导出
+     */
+    void install_crash_handler();
+
+    /**
+     * @brief 读取导出文件
+     * @param file_path 文件路径
+     * @param header 输出文件头
+     * @return 成功返回事件列表（从旧到新），失败返回错误信息字符串
+     */
+    tl::expected<std::vector<Event>, std::string> load_dump(const std::string& file_path, FileHeader& header);
+
+    /**
+     * @brief 清空环形缓冲区（基准测试使用，应在没有线程写入时调用）
+     */
+    void clear();
+}
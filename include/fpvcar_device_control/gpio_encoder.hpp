@@ -0,0 +1,26 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tl/expected.hpp>
+#include "fpvcar_device_control/wheel_speed.hpp"
+
+// 这个文件提供基于 GPIO 边沿事件的编码器反馈
+// 使用 Linux GPIO 字符设备的 v2 接口（libgpiod 封装的同一套内核接口，不额外依赖 libgpiod）：
+// 四条编码器信号线在一次请求中打开，上升沿与下降沿都计数；内核为每条线维护事件序号（line_seqno），
+// 即使事件缓冲区溢出丢失了事件，最新事件的序号仍是该线的准确边沿总数
+// 编译选项 FPVCAR_GPIO_ENCODER 关闭时 open_gpio_encoder 总是返回错误
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 打开 GPIO 编码器
+     * @param chip_path GPIO 芯片设备，如 "/dev/gpiochip0"
+     * @param lines 各车轮编码器信号线在芯片上的编号（顺序为左前、右前、左后、右后）
+     * @return 成功返回编码器反馈；设备不存在、线被占用或编译时未启用时返回错误信息字符串
+     * @note sample() 以非阻塞方式读空内核事件缓冲区，每个控制周期一次系统调用，不需要额外线程
+     */
+    tl::expected<std::unique_ptr<WheelFeedback>, std::string> open_gpio_encoder(
+        const std::string& chip_path, const std::array<uint32_t, WHEEL_COUNT>& lines);
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tl/expected.hpp>
+
+// 这个文件提供可替换的 I2C 传输层，供 Pca9685MotorBackend 使用：
+//   - Linux i2c-dev（I2C_RDWR，一次 ioctl 一个总线事务）
+//   - PCA9685 寄存器级仿真器（见 pca9685.hpp），i2c_device_path 以 "emu:" 开头时使用，无需硬件
+// 两者都统计每个事务的字节数、按总线速率计算的总线占用时间和实际调用耗时，用于衡量每条指令、每个控制周期的总线开销
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief i2c_device_path 以这个前缀开头时使用 PCA9685 仿真器，例如 "emu:pca9685"
+     */
+    constexpr const char* I2C_EMULATOR_PREFIX = "emu:";
+
+    /**
+     * @brief 一个总线事务
+     * @param address 7 位从机地址
+     * @param write_bytes 写入的数据字节数（不含地址字节）
+     * @param read_bytes 读取的数据字节数（重复起始条件后读取，不含地址字节）
+     * @param bus_time_ns 按总线速率计算的总线占用时间
+     * @param duration_ns 调用实际耗时（仿真器限速时不小于 bus_time_ns）
+     */
+    struct I2cTransaction {
+        uint8_t address = 0;
+        uint32_t write_bytes = 0;
+        uint32_t read_bytes = 0;
+        int64_t bus_time_ns = 0;
+        int64_t duration_ns = 0;
+    };
+
+    /**
+     * @brief 传输层统计
+     * @param transactions 成功的事务数
+     * @param errors 失败的事务数（NACK、ioctl 失败等）
+     * @param write_bytes, read_bytes 数据字节数（不含地址字节）
+     * @param bus_time_ns 总线占用时间合计
+     * @param duration_ns 调用耗时合计
+     * @param max_bus_time_ns, max_duration_ns 单个事务的最大值
+     */
+    struct I2cStats {
+        uint64_t transactions = 0;
+        uint64_t errors = 0;
+        uint64_t write_bytes = 0;
+        uint64_t read_bytes = 0;
+        int64_t bus_time_ns = 0;
+        int64_t duration_ns = 0;
+        int64_t max_bus_time_ns = 0;
+        int64_t max_duration_ns = 0;
+    };
+
+    /**
+     * @brief 按标准 I2C 时序计算一个事务的总线占用时间
+     * @param write_bytes 写入的数据字节数
+     * @param read_bytes 读取的数据字节数（0 表示纯写事务）
+     * @param bus_speed_hz SCL 频率，例如 100000 或 400000
+     * @note 每个字节（含地址字节）8 位数据加 1 位应答共 9 个 SCL 周期，起始、重复起始与停止条件各计 1 个周期
+     */
+    int64_t i2c_bus_time_ns(size_t write_bytes, size_t read_bytes, uint32_t bus_speed_hz);
+
+    /**
+     * @brief I2C 传输层接口
+     * @note 失败时抛出 std::runtime_error（与电机后端一致，由 control_loop 的故障处理层处理）
+     * @note 调用方负责串行化事务；统计与观察回调可以在任意线程读取和设置
+     */
+    class I2cTransport {
+    public:
+        /**
+         * @brief 每个事务完成后的观察回调（在调用线程中执行，不应阻塞）
+         */
+        using TransactionObserver = std::function<void(const I2cTransaction&)>;
+
+        explicit I2cTransport(uint32_t bus_speed_hz) : m_bus_speed_hz(bus_speed_hz) {}
+        virtual ~I2cTransport() = default;
+
+        I2cTransport(const I2cTransport&) = delete;
+        I2cTransport& operator=(const I2cTransport&) = delete;
+
+        /**
+         * @brief 写事务：起始条件、地址、data，停止条件
+         */
+        virtual void write(uint8_t address, const uint8_t* data, size_t size) = 0;
+
+        /**
+         * @brief 写后读事务：写入 out（通常为寄存器地址），重复起始条件后读取 in_size 字节
+         */
+        virtual void write_read(uint8_t address, const uint8_t* out, size_t out_size, uint8_t* in, size_t in_size) = 0;
+
+        /**
+         * @brief 关闭并重新打开总线，用于连续故障后的恢复；失败时抛出异常，默认实现什么都不做
+         */
+        virtual void reopen() {}
+
+        /**
+         * @brief 总线速率（Hz）
+         */
+        uint32_t bus_speed_hz() const { return m_bus_speed_hz; }
+
+        /**
+         * @brief 获取统计
+         */
+        I2cStats stats() const;
+
+        /**
+         * @brief 设置事务观察回调（基准测试使用），传入空函数取消
+         */
+        void set_observer(TransactionObserver observer);
+
+    protected:
+        /**
+         * @brief 记录一个事务（由实现在事务完成或失败后调用）
+         */
+        void account(const I2cTransaction& transaction, bool ok);
+
+        const uint32_t m_bus_speed_hz;
+
+    private:
+        mutable std::mutex m_stats_mutex;
+        I2cStats m_stats;
+        TransactionObserver m_observer;
+    };
+
+    /**
+     * @brief 按 i2c_device_path 打开传输层
+     * @param device_path I2C 设备路径（如 "/dev/i2c-1"），以 I2C_EMULATOR_PREFIX 开头时创建 PCA9685 仿真器
+     * @param bus_speed_hz 总线速率：仿真器按它限速；真实总线的速率由设备树决定，这里只用于计算总线占用时间
+     * @param pca9685_address 仿真器应答的从机地址
+     * @return 成功返回传输层，设备无法打开时返回错误信息字符串
+     */
+    tl::expected<std::unique_ptr<I2cTransport>, std::string> open_i2c_transport(
+        const std::string& device_path, uint32_t bus_speed_hz, uint8_t pca9685_address);
+}
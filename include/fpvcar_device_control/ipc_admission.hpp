@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 这个文件提供 IPC 服务器的过载保护：按连接令牌桶限速、相同指令合并、停止指令插队
+// 两个后端都把一个连接上一次读取到的全部完整请求帧作为一批交给 BatchDispatcher：
+//   1. 批内最后一条 stopAll 最先执行（插队），排在它前面的运动指令已被它取代，不再写入期望状态
+//   2. 其余请求按到达顺序处理：每条非停止请求消耗一个令牌，令牌不足时直接回复 RATE_LIMITED（不调用请求处理、不写状态）
+//      识别停止指令需要先看 action，因此每条请求（包括之后被限速的）都先经过一次快速路径扫描（fast_request_parser.hpp，
+//      不分配、不构造 DOM）；被限速的请求不会再进入 RequestHandler 的 DOM 解析
+//   3. 连续的相同运动指令（action 与 ttl_ms 都相同）合并为一次状态写入（最后一条），响应与它相同
+// 响应总是按请求顺序写回；停止指令不受限速影响
+// 同一批请求在同一次读取中到达（间隔远小于 10ms 的控制周期），只应用最后的状态与逐条应用对控制循环没有区别
+// 每批的大小受后端单次读取长度限制，未读取的数据留在内核缓冲区中，洪泛的客户端因此受到发送端背压
+
+namespace fpvcar::device_control::ipc {
+
+    using AdmissionClock = std::chrono::steady_clock;
+
+    /**
+     * @brief 每连接限速参数
+     * @param rate_hz 令牌补充速率（条/秒），小于等于 0 表示不限速
+     * @param burst 令牌桶容量（允许的突发条数），小于 1 时按 1 处理
+     */
+    struct RateLimit {
+        double rate_hz = 0.0;
+        double burst = 0.0;
+    };
+
+    /**
+     * @brief 一个连接的令牌桶状态，由后端随连接保存
+     */
+    struct TokenBucket {
+        double tokens = 0.0;
+        AdmissionClock::time_point last_refill{};
+        bool primed = false; // 第一次使用时装满
+    };
+
+    /**
+     * @brief 过载保护统计
+     * @param rate_limited 因令牌不足被丢弃（回复 RATE_LIMITED）的请求数
+     * @param coalesced 被合并（没有单独写入期望状态）的相同指令数
+     * @param superseded 被同一批中后面的 stopAll 取代的运动指令数
+     * @param priority_stops 插队执行的 stopAll 数
+     */
+    struct AdmissionStats {
+        uint64_t rate_limited = 0;
+        uint64_t coalesced = 0;
+        uint64_t superseded = 0;
+        uint64_t priority_stops = 0;
+    };
+
+    /**
+     * @brief 按批处理请求帧并执行过载保护策略
+     * @note 非线程安全，只在服务器线程中使用；stats() 可在任意线程调用
+     */
+    class BatchDispatcher {
+    public:
+        // 处理一条请求（即 IpcServer::dispatch），返回 true 表示连接应连同响应一起移交
+        using Dispatch = std::function<bool(std::string_view request, std::string& response)>;
+
+        explicit BatchDispatcher(Dispatch dispatch);
+
+        /**
+         * @brief 设置每连接限速参数
+         * @note 必须在服务器运行前调用
+         */
+        void set_rate_limit(RateLimit limit) { m_limit = limit; }
+
+        /**
+         * @brief 处理一个连接上的一批请求
+         * @param bucket 该连接的令牌桶
+         * @param frames 按到达顺序排列的请求帧（不含长度前缀）
+         * @param out 带长度前缀的响应按请求顺序追加到这里
+         * @param handoff_response 需要移交连接时写入随连接移交的响应
+         * @return 需要移交连接时返回 true：移交请求之前的响应已追加到 out，之后的请求被丢弃
+         */
+        bool dispatch(TokenBucket& bucket, const std::vector<std::string_view>& frames,
+                      std::string& out, std::string& handoff_response);
+
+        /**
+         * @brief 获取统计
+         */
+        AdmissionStats stats() const;
+
+    private:
+        // 每条请求的处理方式
+        enum class Plan : uint8_t {
+            RUN,        // 按顺序调用 dispatch
+            PRIORITY,   // 插队的 stopAll，最先调用 dispatch
+            COPY,       // 复用 ref 指向的请求的响应（合并的相同指令、重复的 stopAll）
+            SUPERSEDED, // 被后面的 stopAll 取代
+            LIMITED     // 令牌不足
+        };
+
+        struct Entry {
+            Plan plan = Plan::RUN;
+            bool stop = false;       // 快速路径识别出的 stopAll
+            bool motion = false;     // 快速路径识别出的运动指令（可合并）
+            std::string_view action; // 快速路径解析出的 action（指向请求帧）
+            int64_t ttl_ms = -1;     // 没有 ttl_ms 时为 -1
+            size_t ref = 0;          // COPY 时响应来源的下标
+            size_t slot = 0;         // RUN/PRIORITY 时响应在 m_responses 中的位置
+        };
+
+        bool take_token(TokenBucket& bucket, AdmissionClock::time_point now) const;
+        void append_frame(std::string& out, std::string_view response) const;
+        void report(AdmissionClock::time_point now);
+
+        Dispatch m_dispatch;
+        RateLimit m_limit;
+
+        // 按批复用的工作区，容量增长到最大批次后不再分配
+        std::vector<Entry> m_entries;
+        std::vector<std::string> m_responses;
+        std::string m_scratch;
+
+        std::atomic<uint64_t> m_rate_limited{0};
+        std::atomic<uint64_t> m_coalesced{0};
+        std::atomic<uint64_t> m_superseded{0};
+        std::atomic<uint64_t> m_priority_stops{0};
+
+        // 丢弃请求时每秒最多打印一次告警
+        AdmissionClock::time_point m_next_report{};
+        uint64_t m_reported_rate_limited = 0;
+    };
+}
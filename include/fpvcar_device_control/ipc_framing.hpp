@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+#include <vector>
+
+// 这个文件提供 IPC 长度前缀协议的读写实现
+// 消息格式为 [4字节长度（网络字节序）][N字节JSON内容]
+// IpcServer 与压测、客户端等工具共用同一份实现，保证帧格式一致
+
+namespace fpvcar::device_control::ipc {
+
+    /**
+     * @brief 单条消息允许的最大长度（字节），超过则视为非法帧并断开连接
+     */
+    constexpr uint32_t MAX_MESSAGE_SIZE = 1024 * 1024;
+
+    /**
+     * @brief 从套接字读取指定长度的数据
+     * @param fd 文件描述符
+     * @param buffer 缓冲区
+     * @param size 要读取的字节数
+     * @return 成功返回读取的字节数，失败返回-1（errno 保留），连接关闭返回0
+     */
+    ssize_t read_exact(int fd, void* buffer, size_t size);
+
+    /**
+     * @brief 向套接字写入指定长度的数据
+     * @param fd 文件描述符
+     * @param buffer 缓冲区
+     * @param size 要写入的字节数
+     * @return 成功返回写入的字节数，失败返回-1（errno 保留）
+     */
+    ssize_t write_exact(int fd, const void* buffer, size_t size);
+
+    /**
+     * @brief 读取一条带长度前缀的消息
+     * @param fd 文件描述符
+     * @return 成功返回消息内容，失败返回空字符串
+     * @note 长度为 0 或超过 MAX_MESSAGE_SIZE 的帧视为失败
+     */
+    std::string read_message(int fd);
+
+    /**
+     * @brief 读取一条带长度前缀的消息到调用方提供的缓冲区
+     * @param fd 文件描述符
+     * @param message 接收缓冲区，原有内容会被覆盖；在多次读取间复用时不会重新分配堆内存（容量足够的情况下）
+     * @return 成功返回true，失败返回false（规则同上）
+     */
+    bool read_message(int fd, std::string& message);
+
+    /**
+     * @brief 写入一条带长度前缀的消息
+     * @param fd 文件描述符
+     * @param message 消息内容
+     * @return 成功返回true，失败返回false
+     */
+    bool write_message(int fd, std::string_view message);
+
+    /**
+     * @brief 把一条消息编码为帧（长度前缀 + 内容）追加到发送缓冲区（非阻塞写入的调用方自行发送缓冲区）
+     * @param buffer 发送缓冲区
+     * @param message 消息内容
+     */
+    void append_frame(std::string& buffer, std::string_view message);
+
+    /**
+     * @brief 从接收缓冲区中取出所有完整的帧（事件循环后端在自己的输入缓冲区上解析请求时使用）
+     * @param buffer 已接收的数据
+     * @param offset 已解析部分的长度，返回时前移到最后一个完整帧之后
+     * @param frames 帧内容（不含长度前缀，指向 buffer）按顺序追加到这里
+     * @return 遇到长度为 0 或超过 MAX_MESSAGE_SIZE 的帧时返回 false（之前取出的帧仍然有效），调用方应断开连接
+     */
+    bool split_frames(std::string_view buffer, size_t& offset, std::vector<std::string_view>& frames);
+
+    /**
+     * @brief 当前线程通过 read_exact/write_exact 发起的 read/send 系统调用总次数
+     * @note 线程局部计数，用于统计每条指令的系统调用开销
+     */
+    uint64_t syscall_count();
+}
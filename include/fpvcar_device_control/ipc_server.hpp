@@ -1,33 +1,108 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <functional>
 #include <atomic>
+#include <cstdint>
+#include <vector>
 #include <tl/expected.hpp>
+#include "fpvcar_device_control/ipc_admission.hpp"
 
 namespace fpvcar::device_control {
-    // 定义一个回调类型：const输入 string (请求字符串), 输出 string (响应字符串)
-    using IpcCallback = std::function<std::string(const std::string&)>;
+    /**
+     * @brief 回调对连接的处理方式
+     * @param KEEP 发送响应，连接继续接收请求
+     * @param HAND_OFF 把连接与响应一起移交给 IpcHandoff（例如转为订阅推送流），服务器不再读写该连接
+     */
+    enum class IpcDisposition {
+        KEEP,
+        HAND_OFF
+    };
+
+    // 定义一个回调类型：输入请求字符串，把响应写入调用方提供的缓冲区，返回连接的处理方式
+    // 响应缓冲区由服务器按连接复用，回调只需覆盖其内容，稳态下整个请求路径不分配堆内存
+    using IpcCallback = std::function<IpcDisposition(std::string_view request, std::string& response)>;
+
+    // 连接移交回调：接收连接的文件描述符（所有权转移）和尚未发送的响应内容
+    using IpcHandoff = std::function<void(int fd, std::string response)>;
+
+    /**
+     * @brief IPC 服务器的 I/O 后端
+     * @param BLOCKING 单线程 poll 循环：轮流读取各连接上已到达的请求，以非阻塞 send 写回响应（写不完的部分等待可写，期间不再读取该连接）
+     * @param IO_URING io_uring 事件循环（多发 accept/recv + 缓冲区环），内核不支持时自动回退到 BLOCKING
+     */
+    enum class IpcBackend {
+        BLOCKING,
+        IO_URING
+    };
+
+    /**
+     * @brief IPC 服务器运行统计
+     * @param commands 已处理的请求数
+     * @param syscalls 服务器线程发起的 I/O 系统调用次数（阻塞后端统计 poll/accept/recv/send，io_uring 后端统计 io_uring_enter）
+     * @param cpu_ns 服务器线程消耗的 CPU 时间（纳秒），在 run() 返回时更新
+     * @param admission 过载保护统计（限速丢弃、合并、被 stopAll 取代的请求数，见 ipc_admission.hpp）
+     */
+    struct IpcServerStats {
+        uint64_t commands = 0;
+        uint64_t syscalls = 0;
+        uint64_t cpu_ns = 0;
+        ipc::AdmissionStats admission;
+    };
+
+    /**
+     * @brief 在进程之间移交的服务器套接字（见 IpcServer::detach / adopt）
+     * @param listen_fd 监听套接字
+     * @param client_fds 客户端连接；只移交处于帧边界的连接（没有读了一半的请求，之前的响应都已发完）
+     */
+    struct IpcSockets {
+        int listen_fd = -1;
+        std::vector<int> client_fds;
+    };
 
     class IpcServer {
     public:
         /**
          * @brief 构造 IPC 服务器实例
          * @param socket_path Unix 域套接字文件路径
-         * @param callback 处理客户端请求的回调函数，接收 JSON 字符串并返回响应 JSON 字符串
+         * @param callback 处理客户端请求的回调函数，接收 JSON 字符串并把响应 JSON 字符串写入响应缓冲区
+         * @param backend I/O 后端，默认使用阻塞读写
          */
-        IpcServer(const std::string& socket_path, IpcCallback callback);
+        IpcServer(const std::string& socket_path, IpcCallback callback, IpcBackend backend = IpcBackend::BLOCKING);
         
         /**
          * @brief 析构函数，自动停止服务器并清理资源
          */
         ~IpcServer();
 
+        /**
+         * @brief 设置连接移交回调
+         * @param handoff 回调返回 IpcDisposition::HAND_OFF 时调用；未设置时 HAND_OFF 按 KEEP 处理
+         * @note 必须在 run() 之前调用；此前的所有响应都已发送完毕后才会移交连接
+         */
+        void set_handoff(IpcHandoff handoff);
+
+        /**
+         * @brief 设置每连接限速（令牌桶），默认不限速
+         * @param limit 超过速率的非停止请求直接回复 RATE_LIMITED，stopAll 总是被执行
+         * @note 必须在 run() 之前调用；相同指令合并与 stopAll 插队不受此设置影响，总是启用
+         */
+        void set_rate_limit(ipc::RateLimit limit);
+
         /**
          * @brief 准备服务器：创建并绑定 Unix 域套接字，开始监听连接
          * @return 成功返回 void，失败返回错误信息字符串
          * @note 如果套接字文件已存在，会先删除它再创建新的
          */
         tl::expected<void, std::string> prepare();
+
+        /**
+         * @brief 准备服务器：接管另一个进程（或本进程之前 detach）移交的套接字，代替 prepare()
+         * @param sockets 监听套接字与客户端连接，所有权转移给服务器
+         * @return 成功返回 void，失败返回错误信息字符串（此时套接字已被关闭）
+         * @note 不会删除或重新绑定套接字文件，已连接的客户端和监听队列中的连接都不会感知到切换
+         */
+        tl::expected<void, std::string> adopt(IpcSockets sockets);
         
         /**
          * @brief 运行服务器主循环，阻塞调用直到 stop() 被调用
@@ -38,17 +113,75 @@ namespace fpvcar::device_control {
         void run();
         
         /**
-         * @brief 停止服务器，中断 accept 循环并清理资源
-         * @note 线程安全，可被多个线程调用
+         * @brief 停止服务器：通过 eventfd 唤醒服务器线程并删除套接字文件
+         * @note 线程安全，可被多个线程调用；监听套接字由服务器线程在 run() 返回前关闭
          */
         void stop();
 
+        /**
+         * @brief 停止服务但保留套接字，用于把服务移交给另一个进程
+         * @note 线程安全；run() 在处理完已读到的请求、发完对应响应后返回，不关闭监听套接字也不删除套接字文件
+         * @note run() 返回后用 take_detached() 取出套接字
+         */
+        void detach();
+
+        /**
+         * @brief 取出 detach() 后保留的套接字（所有权转移给调用方）
+         * @note 只能在 run() 返回后调用；没有 detach 时返回空的 IpcSockets
+         */
+        IpcSockets take_detached();
+
+        /**
+         * @brief 获取运行统计
+         * @note 可在任意线程调用；cpu_ns 只在 run() 返回后有效
+         */
+        IpcServerStats stats() const;
+
     private:
+        /**
+         * @brief 阻塞后端：poll 等待所有连接，每轮从每个可读连接读取一次，把读到的完整请求作为一批处理并写回响应
+         */
+        void run_blocking();
+
+        /**
+         * @brief io_uring 后端
+         * @return 成功返回 void；内核不支持或运行出错时返回错误信息字符串，调用方回退到阻塞后端
+         */
+        tl::expected<void, std::string> run_uring();
+
+        /**
+         * @brief 调用回调处理一条请求，捕获回调抛出的异常并转换为错误响应
+         * @param request 请求内容
+         * @param response 响应缓冲区（复用）
+         * @return 连接的处理方式；未设置移交回调时总是 KEEP
+         */
+        IpcDisposition dispatch(std::string_view request, std::string& response);
+
+        /**
+         * @brief 创建唤醒用的 eventfd；已存在时清空其计数（回滚后重新运行）
+         */
+        tl::expected<void, std::string> init_wake_fd();
+
+        /**
+         * @brief 关闭监听套接字与尚未交给后端的接管连接（只在服务器线程或没有运行 run() 时调用）
+         */
+        void close_sockets();
+
         std::string m_socket_path; // Unix 域套接字文件路径
-        IpcCallback m_callback; // 处理客户端请求的回调函数，接收 JSON 字符串并返回响应 JSON 字符串
+        IpcCallback m_callback; // 处理客户端请求的回调函数
+        IpcHandoff m_handoff; // 连接移交回调
+        ipc::BatchDispatcher m_batch; // 按批处理请求：限速、合并、stopAll 插队
         int m_listen_fd; // 监听文件描述符
+        int m_wake_fd{-1}; // stop() 时写入的 eventfd，用于唤醒 io_uring 事件循环
         std::atomic<bool> m_running; // 运行状态
+        std::atomic<bool> m_detaching{false}; // detach() 触发的停止：保留套接字
+        std::vector<int> m_adopted_clients; // adopt() 接管、尚未交给后端的客户端连接
+        IpcSockets m_detached; // detach() 后保留的套接字
         bool m_prepared{false}; // 是否已准备好
+        IpcBackend m_backend; // I/O 后端
+        std::atomic<uint64_t> m_commands{0}; // 已处理的请求数
+        std::atomic<uint64_t> m_syscalls{0}; // I/O 系统调用次数
+        std::atomic<uint64_t> m_cpu_ns{0}; // 服务器线程 CPU 时间
     };
 }
 
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tl/expected.hpp>
+#include "fpvcar_device_control/ipc_admission.hpp"
+
+// 这个文件提供 IpcServer 的 io_uring 后端
+// 直接使用内核 io_uring 系统调用（不依赖 liburing）：
+//   - 多发（multishot）accept 接收新连接
+//   - 多发 recv + 提供缓冲区环（provided buffer ring）接收数据，无需为每个连接预先分配接收缓冲区
+//   - 同一批完成事件产生的所有响应按连接合并为一次 send
+// 一次 io_uring_enter 同时提交上一批的 send/recv 并收割新的完成事件，因此多条指令共享一次系统调用
+// 请求直接在连接输入缓冲区上解析，响应与发送缓冲区按连接复用，稳态下不分配堆内存
+
+namespace fpvcar::device_control::ipc {
+
+    /**
+     * @brief io_uring 事件循环
+     * @note 非线程安全，run() 只能在一个线程中调用
+     */
+    class UringLoop {
+    public:
+        // 接收被移交的连接（fd 为 dup 得到的副本，所有权转移）与尚未发送的响应
+        using Handoff = std::function<void(int fd, std::string response)>;
+
+        /**
+         * @brief 工厂方法：创建 io_uring 实例并注册缓冲区环
+         * @param listen_fd 已处于监听状态的套接字
+         * @param wake_fd 停止时由 IpcServer::stop() 写入的 eventfd，用于唤醒事件循环
+         * @return 成功返回事件循环实例，内核不支持 io_uring（或缺少所需特性）时返回错误信息字符串
+         * @note 调用方应在失败时回退到阻塞读写路径
+         */
+        static tl::expected<std::unique_ptr<UringLoop>, std::string> create(int listen_fd, int wake_fd);
+
+        ~UringLoop();
+
+        UringLoop(const UringLoop&) = delete;
+        UringLoop& operator=(const UringLoop&) = delete;
+
+        /**
+         * @brief 在 run() 之前加入已建立的客户端连接（进程接管时从旧进程移交过来的连接）
+         */
+        void adopt(std::vector<int> client_fds);
+
+        /**
+         * @brief 运行事件循环，直到 running 变为 false 且 wake_fd 被写入
+         * @param running 运行标志，由 IpcServer::stop() / detach() 清除
+         * @param detach running 被清除时为 true 表示保留连接：取消 accept 与 recv，处理完已收到的请求并发完响应后，
+         *        把停在帧边界的连接留给 take_detached()，其余连接照常关闭
+         * @param dispatcher 请求处理：一次 recv 完成事件带来的全部完整请求作为一批交给它（限速、合并、stopAll 插队）
+         * @param handoff 连接移交函数：该连接之前的响应全部发送完成后调用，随后事件循环取消该连接上的 recv 并关闭自己的 fd
+         * @return 成功返回 void，运行中出现不可恢复的错误时返回错误信息字符串
+         */
+        tl::expected<void, std::string> run(const std::atomic<bool>& running, const std::atomic<bool>& detach,
+                                             BatchDispatcher& dispatcher, const Handoff& handoff);
+
+        /**
+         * @brief 取出 adopt() 加入、尚未交给事件循环的连接（所有权转移给调用方）
+         * @note run() 因内核不支持多发 accept 而返回错误时，接管的连接还没有被读取过，由调用方交给阻塞后端
+         */
+        std::vector<int> take_adopted();
+
+        /**
+         * @brief 取出 detach 模式下保留的客户端连接（所有权转移给调用方）
+         */
+        std::vector<int> take_detached();
+
+        /**
+         * @brief 已处理的请求数
+         */
+        uint64_t commands() const { return m_commands; }
+
+        /**
+         * @brief 调用 io_uring_enter 的次数（事件循环的全部系统调用）
+         */
+        uint64_t syscalls() const { return m_syscalls; }
+
+    private:
+        struct Impl;
+        explicit UringLoop(std::unique_ptr<Impl> impl);
+
+        std::unique_ptr<Impl> m_impl;
+        uint64_t m_commands = 0;
+        uint64_t m_syscalls = 0;
+    };
+}
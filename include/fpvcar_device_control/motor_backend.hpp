@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <string>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include "fpvcar-motor/fpvcar_controller.hpp"
+#include "fpvcar-motor/config.hpp"
+
+// 这个文件定义电机后端接口
+// ControlLoop 和 SoftwareWatchdog 通过 MotorBackend 驱动电机，而不是直接依赖 FpvCarController：
+//   - FpvCarMotorBackend：真实硬件（fpvcar-motor 库，I2C/PCA9685）
+//   - Pca9685MotorBackend：经 I2cTransport 直接写 PCA9685 寄存器，可挂在真实总线或寄存器级仿真器上（见 pca9685.hpp）
+//   - StaticPca9685Backend：通道布局在编译期给定的 Pca9685MotorBackend，状态指令按编译期写入表发出（见 static_pca9685.hpp）
+//   - SimulatedMotorBackend：差速运动学模型，用于虚拟时钟仿真（见 simulated_motor_backend.hpp）
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 车轮数量与下标顺序：左前、右前、左后、右后（与通道配置 fl/fr/bl/br 对应）
+     */
+    constexpr size_t WHEEL_COUNT = 4;
+    enum class Wheel : uint8_t { FRONT_LEFT, FRONT_RIGHT, BACK_LEFT, BACK_RIGHT };
+
+    /**
+     * @brief 每个车轮的占空比，Q15 定点：±DUTY_FULL 为 ±100%，符号表示方向
+     */
+    using WheelDuty = std::array<int32_t, WHEEL_COUNT>;
+    constexpr int32_t DUTY_FULL = 32767;
+
+    /**
+     * @brief 电机后端接口，方法与 FpvCarController 的运动接口一一对应
+     * @note 失败时抛出异常（与 FpvCarController 一致），由调用方处理
+     * @note 线程安全要求：后端不需要自己加锁。调用方保证同一时刻只有一个线程在调用——ControlLoop 的控制周期、
+     *       emergency_stop()（紧急停车线程）、看门狗线程与 stop() 都在 ControlLoop 的执行锁内调用后端；
+     *       initialize()/adopt_outputs() 只在控制循环启动之前调用。直接使用后端的代码（bench、仿真）需要自行串行化
+     * @note 执行锁是优先级继承互斥锁，紧急停车线程最多等待正在进行的那一次调用，因此单次调用应在有限时间内返回
+     */
+    class MotorBackend {
+    public:
+        virtual ~MotorBackend() = default;
+
+        virtual void moveForward() = 0;
+        virtual void moveBackward() = 0;
+        virtual void turnLeft() = 0;
+        virtual void turnRight() = 0;
+        virtual void moveForwardAndTurnLeft() = 0;
+        virtual void moveForwardAndTurnRight() = 0;
+        virtual void moveBackwardAndTurnLeft() = 0;
+        virtual void moveBackwardAndTurnRight() = 0;
+        virtual void stopAll() = 0;
+
+        /**
+         * @brief 配置驱动芯片（所有输出关闭），正常启动时在控制循环启动前调用一次
+         * @note 构造后端时不访问芯片，接管启动时旧实例在提交之前仍在驱动电机
+         * @note 失败时抛出异常；默认实现什么都不做（构造时已完成初始化的后端）
+         */
+        virtual void initialize() {}
+
+        /**
+         * @brief 接管另一个实例正在驱动的芯片：不复位、不改变输出，读回当前寄存器作为之后写入的基准
+         * @note 接管提交之后、控制循环启动之前调用；移交失败、旧实例恢复服务时也调用（新实例可能已经写过芯片）
+         * @note 失败时抛出异常；默认实现什么都不做
+         */
+        virtual void adopt_outputs() {}
+
+        /**
+         * @brief 重新初始化后端（重新打开总线、重新配置驱动芯片），用于连续故障后的恢复
+         * @note 失败时抛出异常；默认实现什么都不做
+         */
+        virtual void reinitialize() {}
+
+        /**
+         * @brief 后端是否支持按车轮设置占空比（闭环速度控制需要）
+         */
+        virtual bool supports_wheel_duty() const { return false; }
+
+        /**
+         * @brief 按车轮设置占空比
+         * @note 失败时抛出异常；不支持时（默认实现）抛出 std::logic_error
+         */
+        virtual void set_wheel_duty(const WheelDuty& duty);
+    };
+
+    /**
+     * @brief 真实硬件后端：转发给 fpvcar-motor 的 FpvCarController
+     * @note FpvCarController 只提供固定占空比的运动接口，因此不支持按车轮设置占空比（只能开环运行）
+     * @note 内部加锁，reinitialize() 与 control_loop、看门狗线程的调用互斥
+     */
+    class FpvCarMotorBackend : public MotorBackend {
+    public:
+        /**
+         * @param i2c_device_path I2C 设备路径
+         * @param channels 电机通道配置
+         * @param pwm_frequency PWM 频率（Hz）
+         * @param pca9685_address PCA9685 的 I2C 地址
+         * @note 控制器初始化失败时抛出异常（与 FpvCarController 构造函数一致）
+         */
+        FpvCarMotorBackend(const std::string& i2c_device_path,
+                           const motorconfig::FpvCarChannelConfig& channels,
+                           float pwm_frequency,
+                           uint8_t pca9685_address);
+
+        void moveForward() override;
+        void moveBackward() override;
+        void turnLeft() override;
+        void turnRight() override;
+        void moveForwardAndTurnLeft() override;
+        void moveForwardAndTurnRight() override;
+        void moveBackwardAndTurnLeft() override;
+        void moveBackwardAndTurnRight() override;
+        void stopAll() override;
+
+        /**
+         * @brief 销毁并重新构造控制器：关闭并重新打开 I2C 设备，重新配置 PCA9685
+         * @note 构造失败时抛出异常，此后的调用都会失败，直到下一次重新初始化成功
+         */
+        void reinitialize() override;
+
+    private:
+        /**
+         * @brief 加锁后调用控制器方法
+         */
+        template <typename F>
+        void call(F&& f);
+
+        const std::string m_i2c_device_path;
+        const motorconfig::FpvCarChannelConfig m_channels;
+        const float m_pwm_frequency;
+        const uint8_t m_pca9685_address;
+
+        std::mutex m_mutex;
+        std::optional<control::FpvCarController> m_car; // 重新初始化失败时为空
+    };
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
+
+// 这个文件提供电机调用（I2C/PCA9685）的故障处理层，由 control_loop 使用：
+//   - 每次调用计时，超过 call_timeout 记为超时（阻塞中的 I2C 调用无法被抢占，只能事后判定）
+//   - 失败后按指数退避推迟重试，且退避时间不短于失败调用耗时的一定倍数，保证故障总线占用控制线程的 CPU 份额有上限
+//   - 连续失败 reinit_after_failures 次时重新初始化电机后端（重新打开总线、重新配置 PCA9685）
+//   - 连续失败 degraded_after_failures 次时进入降级模式：只尝试停车，直到停车调用成功
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 故障处理策略
+     * @param call_timeout 单次调用耗时上限，超过记为超时故障（调用结果仍然有效）
+     * @param initial_backoff 第一次失败后的重试间隔，之后每次翻倍
+     * @param max_backoff 重试间隔上限
+     * @param reinit_after_failures 每连续失败这么多次重新初始化一次后端，0 表示不重新初始化
+     * @param degraded_after_failures 连续失败这么多次后进入降级（保持停车）模式
+     * @param max_cpu_share 失败调用（含重新初始化）占控制线程时间的份额上限，取值 (0, 1]
+     */
+    struct MotorFaultPolicy {
+        std::chrono::milliseconds call_timeout{20};
+        std::chrono::milliseconds initial_backoff{10};
+        std::chrono::milliseconds max_backoff{500};
+        uint32_t reinit_after_failures = 3;
+        uint32_t degraded_after_failures = 6;
+        double max_cpu_share = 0.2;
+    };
+
+    /**
+     * @brief 故障统计（累计值）
+     * @param calls 实际发起的电机调用次数（不含退避期内被推迟的尝试）
+     * @param failures 抛出异常的调用次数
+     * @param timeouts 耗时超过 call_timeout 的调用次数
+     * @param reinits 重新初始化次数
+     * @param reinit_failures 重新初始化失败次数
+     * @param degraded_entries 进入降级模式的次数
+     * @param degraded 当前是否处于降级模式
+     */
+    struct MotorFaultStats {
+        uint64_t calls = 0;
+        uint64_t failures = 0;
+        uint64_t timeouts = 0;
+        uint64_t reinits = 0;
+        uint64_t reinit_failures = 0;
+        uint64_t degraded_entries = 0;
+        bool degraded = false;
+    };
+
+    /**
+     * @brief 电机调用的故障处理层
+     * @note 只由 control_loop 线程调用 run()；stats() 可在任意线程读取
+     */
+    class MotorFaultGuard {
+    public:
+        /**
+         * @param backend 电机后端（重新初始化时调用 backend.reinitialize()）
+         * @param clock 时间来源
+         * @param policy 故障处理策略
+         */
+        MotorFaultGuard(MotorBackend& backend, Clock& clock, MotorFaultPolicy policy = {});
+
+        /**
+         * @brief 在故障处理下执行一次电机调用
+         * @param call 实际调用，抛出异常表示失败
+         * @return 调用成功返回 true；调用失败或仍在退避期内（未调用）返回 false
+         */
+        template <typename F>
+        bool run(F&& call) {
+            const auto start = m_clock.now();
+            if (start < m_next_attempt) {
+                return false; // 退避期内不调用，避免故障总线占满控制线程
+            }
+            m_calls.fetch_add(1, std::memory_order_relaxed);
+            try {
+                call();
+            } catch (const std::exception& e) {
+                on_failure(start, e.what());
+                return false;
+            } catch (...) {
+                on_failure(start, "unknown error");
+                return false;
+            }
+            on_success(start);
+            return true;
+        }
+
+        /**
+         * @brief 是否处于降级（保持停车）模式
+         */
+        bool degraded() const { return m_degraded.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief 下一次允许调用的时间（退避期结束时间）
+         */
+        Clock::time_point next_attempt() const { return m_next_attempt; }
+
+        /**
+         * @brief 获取故障统计
+         */
+        MotorFaultStats stats() const;
+
+    private:
+        void on_success(Clock::time_point start);
+        void on_failure(Clock::time_point start, const char* what);
+        void record_fault(Clock::time_point start); // 更新连续故障计数、退避与降级状态
+
+        MotorBackend& m_backend;
+        Clock& m_clock;
+        const MotorFaultPolicy m_policy;
+
+        // 只由 control_loop 线程访问
+        uint32_t m_consecutive_faults = 0;
+        std::chrono::milliseconds m_backoff{0};
+        Clock::time_point m_next_attempt{};
+
+        // 统计（可在其它线程读取）
+        std::atomic<uint64_t> m_calls{0};
+        std::atomic<uint64_t> m_failures{0};
+        std::atomic<uint64_t> m_timeouts{0};
+        std::atomic<uint64_t> m_reinits{0};
+        std::atomic<uint64_t> m_reinit_failures{0};
+        std::atomic<uint64_t> m_degraded_entries{0};
+        std::atomic<bool> m_degraded{false};
+    };
+}
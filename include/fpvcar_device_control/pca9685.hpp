@@ -0,0 +1,367 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "fpvcar-motor/config.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/i2c_transport.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
+#include "fpvcar_device_control/wheel_speed.hpp"
+
+// 这个文件提供 PCA9685（16 通道 12 位 PWM 驱动芯片）的寄存器级仿真器与直接驱动它的电机后端：
+//   - Pca9685Emulator：实现芯片的寄存器映射（MODE1/MODE2、PRESCALE、LEDn_ON/OFF、ALL_LED、自动递增），
+//     作为 I2cTransport 挂在 i2c_device_path = "emu:..." 下，按配置的总线速率限速，并统计冗余写入（写入值与原值相同）
+//   - Pca9685MotorBackend：每个车轮一个调速通道（PWM）和两个方向通道（全开/全关），经 I2cTransport 写寄存器；
+//     保存已写入寄存器的副本，每条指令只写变化的字节，相邻的变化合并为一个自动递增事务
+
+namespace fpvcar::device_control {
+
+    namespace pca9685 {
+        // 寄存器地址
+        constexpr uint8_t MODE1 = 0x00;
+        constexpr uint8_t MODE2 = 0x01;
+        constexpr uint8_t SUBADR1 = 0x02;
+        constexpr uint8_t SUBADR2 = 0x03;
+        constexpr uint8_t SUBADR3 = 0x04;
+        constexpr uint8_t ALLCALLADR = 0x05;
+        constexpr uint8_t LED0_ON_L = 0x06;  // LEDn_ON_L = LED0_ON_L + 4n，依次为 ON_L、ON_H、OFF_L、OFF_H
+        constexpr uint8_t LED15_OFF_H = 0x45;
+        constexpr uint8_t ALL_LED_ON_L = 0xFA; // ALL_LED_ON_L..ALL_LED_OFF_H：只写，写入所有通道的对应寄存器
+        constexpr uint8_t ALL_LED_OFF_H = 0xFD;
+        constexpr uint8_t PRESCALE = 0xFE;   // 只能在 SLEEP 状态下写入
+        constexpr uint8_t TESTMODE = 0xFF;
+
+        // MODE1 位
+        constexpr uint8_t MODE1_RESTART = 0x80;
+        constexpr uint8_t MODE1_EXTCLK = 0x40;
+        constexpr uint8_t MODE1_AI = 0x20;
+        constexpr uint8_t MODE1_SLEEP = 0x10;
+        constexpr uint8_t MODE1_ALLCALL = 0x01;
+        // MODE2 位
+        constexpr uint8_t MODE2_OUTDRV = 0x04;
+        // LEDn_ON_H/LEDn_OFF_H 的第 4 位：全开/全关（全关优先）
+        constexpr uint8_t LED_FULL = 0x10;
+
+        constexpr size_t CHANNELS = 16;
+        constexpr uint16_t PWM_COUNTS = 4096;        // 每个 PWM 周期的计数
+        constexpr double OSCILLATOR_HZ = 25000000.0; // 内部振荡器
+        constexpr uint8_t PRESCALE_MIN = 3;          // 约 1526Hz
+        constexpr uint8_t ALLCALL_ADDRESS = 0x70;    // 上电默认的 ALLCALL 地址
+        constexpr int32_t TURN_INNER_DUTY = DUTY_FULL / 2; // 前进/后退并转向时内侧轮的占空比（Q15，半速）
+        // 两段变化之间未变化的字节不超过这个数时合并为一个事务：重写 2 字节比新开事务（起始、地址、寄存器指针、停止）便宜
+        constexpr size_t COALESCE_GAP = 2;
+
+        /**
+         * @brief LED 寄存器映像：16 个通道 × 4 字节（ON_L、ON_H、OFF_L、OFF_H），对应寄存器 LED0_ON_L..LED15_OFF_H
+         */
+        using LedImage = std::array<uint8_t, CHANNELS * 4>;
+
+        /**
+         * @brief 设置一个通道的高电平计数：0 为全关，PWM_COUNTS 为全开，其它为周期开始时拉高、计数到 counts 时拉低
+         */
+        constexpr void set_channel(LedImage& image, uint8_t channel, uint16_t counts) {
+            const size_t base = static_cast<size_t>(channel) * 4;
+            image[base + 0] = 0;
+            image[base + 1] = counts >= PWM_COUNTS ? LED_FULL : 0;
+            image[base + 2] = counts > 0 && counts < PWM_COUNTS ? static_cast<uint8_t>(counts & 0xff) : 0;
+            image[base + 3] = counts == 0 ? LED_FULL : counts < PWM_COUNTS ? static_cast<uint8_t>(counts >> 8) : 0;
+        }
+
+        /**
+         * @brief 占空比（Q15，符号表示方向）的绝对值换算为 12 位计数（四舍五入，饱和到 PWM_COUNTS）
+         */
+        constexpr uint16_t duty_counts(int32_t duty) {
+            const int64_t magnitude = duty < 0 ? -static_cast<int64_t>(duty) : duty;
+            const int64_t counts = (std::min<int64_t>(magnitude, DUTY_FULL) * PWM_COUNTS + DUTY_FULL / 2) / DUTY_FULL;
+            return static_cast<uint16_t>(counts);
+        }
+
+        /**
+         * @brief 一个车轮使用的通道：调速（PWM）与两个方向输入
+         */
+        struct WheelChannels {
+            uint8_t speed;
+            uint8_t in1;
+            uint8_t in2;
+        };
+
+        /**
+         * @brief 按 Wheel 的顺序（左前、右前、左后、右后）取出各车轮的通道
+         */
+        constexpr std::array<WheelChannels, WHEEL_COUNT> wheel_channels(const motorconfig::FpvCarChannelConfig& c) {
+            return {{{c.fl_channel_speed, c.fl_channel_1, c.fl_channel_2},
+                     {c.fr_channel_speed, c.fr_channel_1, c.fr_channel_2},
+                     {c.bl_channel_speed, c.bl_channel_1, c.bl_channel_2},
+                     {c.br_channel_speed, c.br_channel_1, c.br_channel_2}}};
+        }
+
+        /**
+         * @brief 把各车轮占空比写入寄存器映像：正转 in1 全开、in2 全关，反转相反，占空比为 0 时两者全关（滑行）
+         */
+        constexpr void set_wheel_duty(LedImage& image, const std::array<WheelChannels, WHEEL_COUNT>& channels, const WheelDuty& duty) {
+            for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+                set_channel(image, channels[w].speed, duty_counts(duty[w]));
+                set_channel(image, channels[w].in1, duty[w] > 0 ? PWM_COUNTS : 0);
+                set_channel(image, channels[w].in2, duty[w] < 0 ? PWM_COUNTS : 0);
+            }
+        }
+
+        /**
+         * @brief 配置中使用的通道
+         */
+        constexpr std::array<bool, CHANNELS> used_channels(const std::array<WheelChannels, WHEEL_COUNT>& channels) {
+            std::array<bool, CHANNELS> used{};
+            for (const WheelChannels& wheel : channels) {
+                used[wheel.speed] = true;
+                used[wheel.in1] = true;
+                used[wheel.in2] = true;
+            }
+            return used;
+        }
+
+        /**
+         * @brief 期望状态对应的寄存器映像（从所有通道全关开始，运动状态的各轮占空比同 wheel_setpoints）
+         */
+        constexpr LedImage state_image(const std::array<WheelChannels, WHEEL_COUNT>& channels, DesiredState state) {
+            LedImage image{};
+            for (size_t ch = 0; ch < CHANNELS; ++ch) set_channel(image, static_cast<uint8_t>(ch), 0);
+            set_wheel_duty(image, channels, wheel_setpoints(state, TURN_INNER_DUTY));
+            return image;
+        }
+
+        /**
+         * @brief 找出从 from 变为 to 需要写入的字节段，对每一段调用 emit(offset, count)（offset 相对 LED0_ON_L）
+         * @param from_valid 为 false 时 from 未知，写入所有使用中通道的全部字节
+         * @note 相邻段之间未变化的字节不超过 COALESCE_GAP 时合并为一段；运行时后端与编译期写入表共用这一规则
+         */
+        template <typename Emit>
+        constexpr void for_each_run(const LedImage& from, const LedImage& to, const std::array<bool, CHANNELS>& used,
+                                    bool from_valid, Emit&& emit) {
+            size_t i = 0;
+            while (i < to.size()) {
+                const auto dirty = [&](size_t k) { return from_valid ? to[k] != from[k] : used[k / 4]; };
+                if (!dirty(i)) {
+                    ++i;
+                    continue;
+                }
+                const size_t begin = i;
+                size_t end = i + 1; // 最后一个需要写入的字节之后
+                for (size_t j = end; j < to.size() && j <= end + COALESCE_GAP; ++j) {
+                    if (dirty(j)) end = j + 1;
+                }
+                emit(begin, end - begin);
+                i = end;
+            }
+        }
+
+        /**
+         * @brief PWM 频率对应的 PRESCALE 值（按数据手册的公式四舍五入，限制在 [PRESCALE_MIN, 255]）
+         */
+        constexpr uint8_t prescale_for(double pwm_frequency_hz) {
+            const double ratio = OSCILLATOR_HZ / (static_cast<double>(PWM_COUNTS) * (pwm_frequency_hz > 1.0 ? pwm_frequency_hz : 1.0));
+            const double value = static_cast<double>(static_cast<int64_t>(ratio + 0.5)) - 1.0;
+            return static_cast<uint8_t>(value < PRESCALE_MIN ? PRESCALE_MIN : value > 255.0 ? 255.0 : value);
+        }
+
+        /**
+         * @brief PWM 频率按公式得到的 PRESCALE 是否在 [PRESCALE_MIN, 255] 内（不在范围内时 prescale_for 会截断，实际频率与配置不符）
+         */
+        constexpr bool prescale_in_range(double pwm_frequency_hz) {
+            if (!(pwm_frequency_hz > 0.0)) return false;
+            const double ratio = OSCILLATOR_HZ / (static_cast<double>(PWM_COUNTS) * pwm_frequency_hz);
+            if (ratio > 1000.0) return false; // 频率过低（同时避免下面的整数转换溢出）
+            const double value = static_cast<double>(static_cast<int64_t>(ratio + 0.5)) - 1.0;
+            return value >= PRESCALE_MIN && value <= 255.0;
+        }
+
+        /**
+         * @brief 7 位地址是否可能属于 PCA9685（地址引脚 A5..A0 对应 0x40–0x7F）
+         */
+        constexpr bool address_in_range(uint8_t address) { return address >= 0x40 && address <= 0x7F; }
+
+        /**
+         * @brief PRESCALE 值对应的 PWM 频率
+         */
+        constexpr double frequency_for(uint8_t prescale) {
+            return OSCILLATOR_HZ / (static_cast<double>(PWM_COUNTS) * (static_cast<double>(prescale) + 1.0));
+        }
+
+        /**
+         * @brief 配置芯片：进入 SLEEP 写 PRESCALE 与 MODE2，所有通道全关，唤醒并等待振荡器稳定，打开自动递增
+         * @note 失败时抛出异常；之后芯片的 LED 寄存器与 state_image(STOPPING) 一致
+         */
+        void configure_chip(I2cTransport& transport, uint8_t address, uint8_t prescale);
+
+        /**
+         * @brief 从 first 开始写入连续的寄存器（一个自动递增事务）
+         */
+        void write_registers(I2cTransport& transport, uint8_t address, uint8_t first, const uint8_t* values, size_t count);
+
+        /**
+         * @brief 读回正在运行的芯片的 LED 寄存器（一个写后读事务，自动递增）
+         * @return 芯片已按 prescale 配置并在运行（未 SLEEP、自动递增已打开）时返回 true 并填写 image；否则返回 false，需要 configure_chip
+         * @note 失败时抛出异常
+         */
+        bool read_running_image(I2cTransport& transport, uint8_t address, uint8_t prescale, LedImage& image);
+    }
+
+    /**
+     * @brief 仿真器的寄存器访问统计
+     * @param register_writes 写入的寄存器字节数（ALL_LED 的一次写入计为 1）
+     * @param redundant_writes 写入值与寄存器原值相同的次数（ALL_LED 写入时所有通道都未变化才计入）
+     * @param ignored_writes 被芯片忽略的写入（非 SLEEP 状态写 PRESCALE、保留寄存器）
+     * @param register_reads 读取的寄存器字节数
+     * @param nacks 地址不匹配（未应答）的事务数
+     */
+    struct Pca9685EmulatorStats {
+        uint64_t register_writes = 0;
+        uint64_t redundant_writes = 0;
+        uint64_t ignored_writes = 0;
+        uint64_t register_reads = 0;
+        uint64_t nacks = 0;
+    };
+
+    /**
+     * @brief PCA9685 寄存器级仿真器
+     * @note 每个事务第一个写入字节为寄存器指针，之后的字节写入指针所指的寄存器；MODE1 的 AI 位置位时每个字节后指针加一
+     *       （LED15_OFF_H 之后回到 MODE1），否则所有字节写同一个寄存器；写后读从当前指针开始读取
+     * @note 按总线速率限速：每个事务在计算出的总线占用时间之后才返回，与真实总线上阻塞的 ioctl 一致
+     * @note 线程安全：寄存器状态与统计可以在其它线程读取
+     */
+    class Pca9685Emulator : public I2cTransport {
+    public:
+        /**
+         * @param address 应答的 7 位从机地址（MODE1 的 ALLCALL 位置位时同时应答 ALLCALL_ADDRESS）
+         * @param bus_speed_hz 总线速率，例如 100000 或 400000
+         * @param enforce_bus_timing 是否按总线速率限速；关闭时只统计总线占用时间，调用立即返回
+         */
+        explicit Pca9685Emulator(uint8_t address = motorconfig::PCA9685_I2C_ADDRESS, uint32_t bus_speed_hz = 400000,
+                                 bool enforce_bus_timing = true);
+
+        void write(uint8_t address, const uint8_t* data, size_t size) override;
+        void write_read(uint8_t address, const uint8_t* out, size_t out_size, uint8_t* in, size_t in_size) override;
+
+        /**
+         * @brief 恢复上电默认值（不清除统计）
+         */
+        void reset();
+
+        /**
+         * @brief 读取寄存器（不经过总线，不计入统计）
+         */
+        uint8_t register_value(uint8_t reg) const;
+
+        /**
+         * @brief 通道每个 PWM 周期的高电平计数：0 为常低，PWM_COUNTS 为常高；SLEEP 状态下振荡器关闭，所有通道为 0
+         */
+        uint16_t channel_counts(uint8_t channel) const;
+
+        /**
+         * @brief 当前 PRESCALE 对应的 PWM 频率
+         */
+        double pwm_frequency() const;
+
+        /**
+         * @brief 寄存器访问统计
+         */
+        Pca9685EmulatorStats device_stats() const;
+
+    private:
+        bool acknowledges(uint8_t address) const; // 调用方持有 m_mutex
+        void write_register(uint8_t reg, uint8_t value); // 调用方持有 m_mutex
+        uint8_t next_pointer(uint8_t reg) const; // 调用方持有 m_mutex
+        void finish(uint8_t address, size_t write_bytes, size_t read_bytes, std::chrono::steady_clock::time_point start, bool ok);
+
+        const uint8_t m_address;
+        const bool m_enforce_bus_timing;
+
+        mutable std::mutex m_mutex;
+        std::array<uint8_t, 256> m_registers{};
+        uint8_t m_pointer = 0;
+        Pca9685EmulatorStats m_stats;
+    };
+
+    /**
+     * @brief 寄存器写入策略
+     */
+    enum class Pca9685WritePolicy {
+        COALESCED,  // 只写变化的字节，相邻的变化（间隔不超过 2 字节）合并为一个自动递增事务（默认）
+        PER_CHANNEL // 每条指令按通道逐个写入所有使用中的通道（每个通道一个 4 字节事务），对照常见驱动的 setPWM 写法
+    };
+
+    /**
+     * @brief 直接经 I2C 驱动 PCA9685 的电机后端
+     * @note 运动状态对应的各轮占空比与闭环的目标速度一致（wheel_setpoints：原地转向左右反向，前进/后退并转向时内侧轮半速）
+     * @note 支持按车轮设置占空比，可以运行闭环轮速控制
+     * @note 事务失败时丢弃寄存器副本，下一次调用重写所有使用中的通道
+     * @note PCA9685 的 PWM 频率上限约 1526Hz，更高的 pwm_frequency（例如默认的 10000）按上限运行并打印告警
+     * @note 内部加锁，reinitialize() 与 control_loop、看门狗、紧急停车线程的调用互斥
+     */
+    class Pca9685MotorBackend : public MotorBackend {
+    public:
+        /**
+         * @param transport I2C 传输层（生命周期长于后端）
+         * @param channels 电机通道配置
+         * @param pwm_frequency PWM 频率（Hz）
+         * @param address PCA9685 的 I2C 地址
+         * @param policy 寄存器写入策略
+         * @note 构造时不访问芯片，使用前调用 initialize() 或 adopt_outputs()
+         */
+        Pca9685MotorBackend(I2cTransport& transport,
+                            const motorconfig::FpvCarChannelConfig& channels,
+                            float pwm_frequency,
+                            uint8_t address,
+                            Pca9685WritePolicy policy = Pca9685WritePolicy::COALESCED);
+
+        void moveForward() override { command(DesiredState::MOVING_FORWARD); }
+        void moveBackward() override { command(DesiredState::MOVING_BACKWARD); }
+        void turnLeft() override { command(DesiredState::TURNING_LEFT); }
+        void turnRight() override { command(DesiredState::TURNING_RIGHT); }
+        void moveForwardAndTurnLeft() override { command(DesiredState::MOVING_FORWARD_AND_TURN_LEFT); }
+        void moveForwardAndTurnRight() override { command(DesiredState::MOVING_FORWARD_AND_TURN_RIGHT); }
+        void moveBackwardAndTurnLeft() override { command(DesiredState::MOVING_BACKWARD_AND_TURN_LEFT); }
+        void moveBackwardAndTurnRight() override { command(DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT); }
+        void stopAll() override { command(DesiredState::STOPPING); }
+
+        /**
+         * @brief 配置芯片（MODE1/MODE2/PRESCALE，所有通道全关）
+         */
+        void initialize() override;
+
+        /**
+         * @brief 读回芯片当前的 LED 寄存器作为寄存器副本；芯片未按本后端的 PRESCALE 运行时打印告警并重新配置（输出关闭）
+         */
+        void adopt_outputs() override;
+
+        /**
+         * @brief 重新打开总线并重新配置芯片（MODE1/MODE2/PRESCALE，所有通道全关）
+         */
+        void reinitialize() override;
+
+        bool supports_wheel_duty() const override { return true; }
+        void set_wheel_duty(const WheelDuty& duty) override;
+
+        /**
+         * @brief 芯片实际运行的 PWM 频率
+         */
+        double pwm_frequency() const { return pca9685::frequency_for(m_prescale); }
+
+    private:
+        void command(DesiredState state);
+        void configure(); // 调用方持有 m_mutex
+        void write_image(const pca9685::LedImage& image); // 调用方持有 m_mutex
+
+        I2cTransport& m_transport;
+        const std::array<pca9685::WheelChannels, WHEEL_COUNT> m_channels;
+        const uint8_t m_address;
+        const uint8_t m_prescale;
+        const Pca9685WritePolicy m_policy;
+        const std::array<bool, pca9685::CHANNELS> m_used; // 配置中使用的通道
+
+        std::mutex m_mutex;
+        pca9685::LedImage m_shadow{}; // 已写入芯片的 LED 寄存器
+        bool m_shadow_valid = false;  // 为 false 时下一次写入所有使用中的通道
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <pthread.h>
+#include <system_error>
+
+// 这个文件提供优先级继承互斥锁（PTHREAD_PRIO_INHERIT）
+// 紧急停车线程以 SCHED_FIFO 运行，而执行锁可能正被普通优先级的控制循环线程持有（I2C 写入期间）：
+// 使用普通 std::mutex 时，持锁线程可能被其它普通线程抢占，高优先级线程随之无限期等待（优先级反转）；
+// 优先级继承让持锁线程在有高优先级线程等待时临时以等待者的优先级运行，等待时间只取决于正在进行的那次电机调用
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 优先级继承互斥锁，满足 Lockable / TimedLockable，可与 std::lock_guard、std::unique_lock 一起使用
+     * @note 不可复制、不可移动；加锁失败（系统错误）时抛出 std::system_error（与 std::mutex 一致）
+     */
+    class PiMutex {
+    public:
+        PiMutex() {
+            pthread_mutexattr_t attr;
+            ::pthread_mutexattr_init(&attr);
+            // 内核不支持优先级继承时退化为普通互斥锁
+            ::pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+            int err = ::pthread_mutex_init(&m_mutex, &attr);
+            ::pthread_mutexattr_destroy(&attr);
+            if (err != 0) throw std::system_error(err, std::generic_category(), "pthread_mutex_init");
+        }
+
+        ~PiMutex() { ::pthread_mutex_destroy(&m_mutex); }
+
+        PiMutex(const PiMutex&) = delete;
+        PiMutex& operator=(const PiMutex&) = delete;
+
+        void lock() {
+            if (int err = ::pthread_mutex_lock(&m_mutex); err != 0) {
+                throw std::system_error(err, std::generic_category(), "pthread_mutex_lock");
+            }
+        }
+
+        bool try_lock() { return ::pthread_mutex_trylock(&m_mutex) == 0; }
+
+        /**
+         * @brief 最多等待 timeout 加锁，超时返回 false
+         */
+        template <typename Rep, typename Period>
+        bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) {
+            // pthread_mutex_timedlock 使用 CLOCK_REALTIME 的绝对时间
+            timespec deadline{};
+            ::clock_gettime(CLOCK_REALTIME, &deadline);
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+            deadline.tv_sec += static_cast<time_t>(ns / 1000000000);
+            deadline.tv_nsec += static_cast<long>(ns % 1000000000);
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000;
+            }
+            int err;
+            while ((err = ::pthread_mutex_timedlock(&m_mutex, &deadline)) == EINTR) {}
+            if (err == ETIMEDOUT) return false;
+            if (err != 0) throw std::system_error(err, std::generic_category(), "pthread_mutex_timedlock");
+            return true;
+        }
+
+        void unlock() { ::pthread_mutex_unlock(&m_mutex); }
+
+    private:
+        pthread_mutex_t m_mutex;
+    };
+}
@@ -1,35 +1,65 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <tl/expected.hpp>
 #include <functional>
 #include "fpvcar_device_control/control_loop.hpp"
 
 namespace fpvcar::device_control {
+    /**
+     * @brief 请求处理结果
+     * @param REPLY 普通请求：发送响应后连接继续接收请求
+     * @param SUBSCRIBE 订阅请求：发送响应后连接转为推送流，移交给订阅推送器
+     */
+    enum class RequestOutcome {
+        REPLY,
+        SUBSCRIBE
+    };
+
+    /**
+     * @brief traceExport/recorderDump 导出文件的默认目录（配置项 diagnostics_dir）
+     */
+    constexpr const char* DEFAULT_DIAGNOSTICS_DIR = "/tmp/fpvcar_diagnostics";
+
     class RequestHandler {
     public:
         /**
             * @brief 构造函数，初始化请求处理器
             * @param desired_state_manager 期望状态管理器引用，用于更新期望状态
+            * @param diagnostics_dir 导出文件目录：traceExport 与 recorderDump 在其中创建文件，文件名由服务端生成；
+            *        目录不存在时以 0700 创建，已存在时必须是本进程用户所有、其他用户不可写的目录（不跟随符号链接）
             * @note 请求处理器负责解析IPC请求并更新期望状态，不直接操作硬件。硬件操作由 control_loop 线程执行
         */
-        explicit RequestHandler(DesiredStateManager& desired_state_manager);
+        explicit RequestHandler(DesiredStateManager& desired_state_manager, std::string diagnostics_dir = DEFAULT_DIAGNOSTICS_DIR);
         
         /**
          * @brief 处理来自客户端的 JSON 请求
          * @param json_request JSON 格式的请求字符串，必须包含 "action" 字段
          * @return JSON 格式的响应字符串，包含 "status" 字段（"ok" 或 "error"）
          * @note 支持的 action 包括: moveForward, moveBackward, turnLeft, turnRight, moveForwardAndTurnLeft, moveForwardAndTurnRight, moveBackwardAndTurnLeft, moveBackwardAndTurnRight, stopAll
+         * @note 追踪控制 action: traceStart, traceStop, traceExport（写入 diagnostics_dir，不接受 "path" 字段），不改变期望状态
+         * @note 飞行记录器 action: recorderDump（写入 diagnostics_dir，不接受 "path" 字段），不改变期望状态
+         * @note 订阅 action: subscribe，不改变期望状态；只有 IPC 服务器（见下面的重载）会据此移交连接
          * @note 如果 JSON 解析失败或 action 无效，返回错误响应
          * @note 此方法只更新期望状态并立即返回ACK，不等待硬件执行。硬件操作由 control_loop 线程异步执行
          */
         std::string handle_request(const std::string& json_request);
 
-    private:
-        DesiredStateManager& m_desired_state_manager;
+        /**
+         * @brief 处理来自客户端的 JSON 请求，把响应写入调用方提供的缓冲区
+         * @param json_request JSON 格式的请求字符串
+         * @param response 响应缓冲区，原有内容会被覆盖；调用方在多次请求间复用它以避免堆分配
+         * @note 常见的运动指令（{"action":...} 与可选的 "ttl_ms"）走快速解析路径，预热后不分配堆内存；
+         *       其余请求回退到 nlohmann DOM 解析，行为与 handle_request(const std::string&) 完全一致
+         * @return 订阅请求返回 RequestOutcome::SUBSCRIBE，其余返回 RequestOutcome::REPLY
+         */
+        RequestOutcome handle_request(std::string_view json_request, std::string& response);
+
         /**
          * @brief 创建成功响应的 JSON 字符串
          * @param message 成功消息
          * @return JSON 格式字符串，包含 status="ok" 和 message 字段
+         * @note 公开以便基准测试单独测量响应构建开销
          */
         std::string create_success_response(const std::string& message);
         
@@ -40,6 +70,15 @@ namespace fpvcar::device_control {
          * @return JSON 格式字符串，包含 status="error", error_code 和 message 字段
          */
         std::string create_error_response(const std::string& code, const std::string& message);
+
+    private:
+        /**
+         * @brief DOM 解析路径：支持全部 action 与字段
+         */
+        std::string handle_request_dom(std::string_view json_request, RequestOutcome& outcome);
+
+        DesiredStateManager& m_desired_state_manager;
+        const std::string m_diagnostics_dir;
     };
 }
 
@@ -0,0 +1,154 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
+#include "fpvcar_device_control/wheel_speed.hpp"
+
+// 这个文件提供仿真电机后端：简单的差速（左右两侧轮）运动学模型
+// 与 VirtualClock 配合可以在几秒内跑完一小时的驾驶脚本，用于检查看门狗、控制周期和加速度限制等时序性质
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 仿真车辆参数
+     * @param wheel_base_m 左右轮距（米）
+     * @param max_wheel_speed_mps 满占空比时的轮速（米/秒）
+     * @param max_wheel_accel_mps2 轮速变化率上限（米/秒²），模拟电机与车体惯性
+     * @param turn_inner_ratio 前进/后退并转向时内侧轮相对外侧轮的速度比例
+     * @param drive_efficiency 实际轮速与标称轮速之比，模拟电池电压跌落或负载（开环时车速随之下降）
+     */
+    struct SimulatedMotorParams {
+        double wheel_base_m = 0.16;
+        double max_wheel_speed_mps = 1.0;
+        double max_wheel_accel_mps2 = 4.0;
+        double turn_inner_ratio = 0.5;
+        double drive_efficiency = 1.0;
+    };
+
+    /**
+     * @brief 仿真车辆状态
+     * @param x_m, y_m, heading_rad 位姿（起点为原点，朝向 x 轴正方向）
+     * @param left_mps, right_mps 左右轮当前速度
+     * @param distance_m 累计行驶距离
+     * @param left_travel_m, right_travel_m 左右轮各自累计转过的距离（不分方向，仿真编码器由此计数）
+     * @param commands 收到的电机指令数（不含按车轮设置占空比）
+     * @param wheel_duty_commands 按车轮设置占空比的次数（闭环每个周期一次）
+     * @param abrupt_reversals 轮速超过一半最大速度时收到反向指令的次数
+     * @param max_accel_mps2 观测到的最大轮速变化率
+     * @param failed_commands 因注入故障而失败（抛出异常）的指令数
+     * @param reinits reinitialize() 调用次数
+     */
+    struct SimulatedVehicleState {
+        double x_m = 0.0;
+        double y_m = 0.0;
+        double heading_rad = 0.0;
+        double left_mps = 0.0;
+        double right_mps = 0.0;
+        double distance_m = 0.0;
+        double left_travel_m = 0.0;
+        double right_travel_m = 0.0;
+        uint64_t commands = 0;
+        uint64_t wheel_duty_commands = 0;
+        uint64_t abrupt_reversals = 0;
+        double max_accel_mps2 = 0.0;
+        uint64_t failed_commands = 0;
+        uint64_t reinits = 0;
+    };
+
+    /**
+     * @brief 仿真电机后端
+     * @note 运动学按 1ms 步长惰性积分到 clock.now()：每次收到指令或查询状态时推进
+     * @note 线程安全：control_loop、看门狗和仿真驱动方可以并发调用
+     */
+    class SimulatedMotorBackend : public MotorBackend {
+    public:
+        /**
+         * @brief 每条电机指令的观察回调（在调用线程中执行，持有内部锁，不应回调本对象）
+         */
+        using CommandObserver = std::function<void(Clock::time_point, DesiredState)>;
+
+        /**
+         * @param clock 时间来源（通常为 VirtualClock）
+         * @param params 车辆参数
+         */
+        explicit SimulatedMotorBackend(Clock& clock, SimulatedMotorParams params = {});
+
+        void moveForward() override { command(DesiredState::MOVING_FORWARD); }
+        void moveBackward() override { command(DesiredState::MOVING_BACKWARD); }
+        void turnLeft() override { command(DesiredState::TURNING_LEFT); }
+        void turnRight() override { command(DesiredState::TURNING_RIGHT); }
+        void moveForwardAndTurnLeft() override { command(DesiredState::MOVING_FORWARD_AND_TURN_LEFT); }
+        void moveForwardAndTurnRight() override { command(DesiredState::MOVING_FORWARD_AND_TURN_RIGHT); }
+        void moveBackwardAndTurnLeft() override { command(DesiredState::MOVING_BACKWARD_AND_TURN_LEFT); }
+        void moveBackwardAndTurnRight() override { command(DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT); }
+        void stopAll() override { command(DesiredState::STOPPING); }
+        void reinitialize() override;
+
+        bool supports_wheel_duty() const override { return true; }
+
+        /**
+         * @brief 按车轮设置占空比：同侧前后轮取平均作为该侧目标轮速（差速模型只有左右两侧）
+         */
+        void set_wheel_duty(const WheelDuty& duty) override;
+
+        /**
+         * @brief 注入故障：接下来的 count 条指令抛出异常（不改变车辆状态），模拟 I2C 总线故障
+         */
+        void inject_faults(uint32_t count);
+
+        /**
+         * @brief 设置指令观察回调
+         */
+        void set_observer(CommandObserver observer);
+
+        /**
+         * @brief 积分到当前时间并返回车辆状态
+         */
+        SimulatedVehicleState state();
+
+        /**
+         * @brief 车辆参数
+         */
+        const SimulatedMotorParams& params() const { return m_params; }
+
+    private:
+        void command(DesiredState state);
+        void set_targets(double left_mps, double right_mps); // 调用方持有 m_mutex
+        void check_fault(); // 调用方持有 m_mutex
+        void integrate_to(Clock::time_point now); // 调用方持有 m_mutex
+
+        Clock& m_clock;
+        const SimulatedMotorParams m_params;
+
+        std::mutex m_mutex;
+        CommandObserver m_observer;
+        SimulatedVehicleState m_state;
+        double m_target_left = 0.0;  // 左侧目标轮速
+        double m_target_right = 0.0; // 右侧目标轮速
+        uint32_t m_pending_faults = 0; // 剩余的注入故障数
+        Clock::time_point m_last_update;
+    };
+
+    /**
+     * @brief 仿真编码器：由仿真车辆左右轮的累计行程生成边沿计数（同侧前后轮相同）
+     */
+    class SimulatedEncoder : public WheelFeedback {
+    public:
+        /**
+         * @param backend 仿真电机后端
+         * @param clock 时间来源（与 backend 相同）
+         * @param edges_per_meter 每米行程的编码器边沿数
+         */
+        SimulatedEncoder(SimulatedMotorBackend& backend, Clock& clock, double edges_per_meter);
+
+        bool sample(EncoderSample& out) override;
+
+    private:
+        SimulatedMotorBackend& m_backend;
+        Clock& m_clock;
+        const double m_edges_per_meter;
+    };
+}
@@ -0,0 +1,272 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include "fpvcar-motor/config.hpp"
+#include "fpvcar_device_control/pca9685.hpp"
+
+// 这个文件提供编译期特化的 PCA9685 电机后端：通道布局、PWM 频率与 I2C 地址在编译期给定（Layout 模板参数），
+//   - 每个 DesiredState 的寄存器映像、任意两个状态之间要写入的寄存器段（写入表）都在编译期算好，
+//     运动指令只按表发出事务，不再查通道配置、比较寄存器副本
+//   - 按车轮设置占空比（闭环）仍在运行时比较副本，但通道下标是常量
+// 写入的事务与 Pca9685MotorBackend（COALESCED 策略）相同，两者由 fpvcar-channel-bench 比较
+// 特化只到后端为止：ControlLoop 仍通过虚接口 MotorBackend 调用它（每条指令一次虚调用），省掉的是后端内部的查表与比较
+// 构建时打开 FPVCAR_STATIC_CHANNEL_LAYOUT，由 CMake 生成 ConfiguredChannelLayout（static_channel_layout.hpp），
+// 服务在配置与它一致时使用这个后端，否则回退到 Pca9685MotorBackend
+
+namespace fpvcar::device_control {
+
+    namespace pca9685 {
+        /**
+         * @brief 一段连续的 LED 寄存器（offset 相对 LED0_ON_L），对应一个自动递增事务
+         */
+        struct RegisterRun {
+            uint8_t offset = 0;
+            uint8_t count = 0;
+        };
+
+        /**
+         * @brief 最多 N 段的写入表
+         */
+        template <size_t N>
+        struct RunList {
+            std::array<RegisterRun, N> runs{};
+            uint8_t size = 0;
+        };
+
+        /**
+         * @brief 所有通道都在 [0, CHANNELS) 内
+         */
+        constexpr bool channels_in_range(const std::array<WheelChannels, WHEEL_COUNT>& channels) {
+            for (const WheelChannels& wheel : channels) {
+                if (wheel.speed >= CHANNELS || wheel.in1 >= CHANNELS || wheel.in2 >= CHANNELS) return false;
+            }
+            return true;
+        }
+
+        constexpr size_t STATE_COUNT = static_cast<size_t>(DesiredState::STOPPING) + 1;
+        using StateImages = std::array<LedImage, STATE_COUNT>;
+
+        /**
+         * @brief 每个 DesiredState 的寄存器映像（按枚举值索引）
+         */
+        constexpr StateImages state_images(const std::array<WheelChannels, WHEEL_COUNT>& channels) {
+            StateImages images{};
+            for (size_t s = 0; s < STATE_COUNT; ++s) images[s] = state_image(channels, static_cast<DesiredState>(s));
+            return images;
+        }
+
+        /**
+         * @brief 任意两个状态之间（以及副本无效时）最多需要几段写入
+         */
+        constexpr size_t max_runs(const StateImages& images, const std::array<bool, CHANNELS>& used) {
+            size_t result = 1;
+            for (size_t to = 0; to < STATE_COUNT; ++to) {
+                for (size_t from = 0; from <= STATE_COUNT; ++from) {
+                    size_t runs = 0;
+                    // from == STATE_COUNT 表示副本无效
+                    const bool from_valid = from < STATE_COUNT;
+                    for_each_run(images[from_valid ? from : to], images[to], used, from_valid, [&](size_t, size_t) { ++runs; });
+                    result = runs > result ? runs : result;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief 编译期写入表
+         * @param transitions [from][to]：芯片处于 from 状态的映像时切换到 to 要写入的寄存器段
+         * @param full [to]：寄存器副本无效时切换到 to 要写入的寄存器段（所有使用中的通道）
+         */
+        template <size_t N>
+        struct WriteTable {
+            std::array<std::array<RunList<N>, STATE_COUNT>, STATE_COUNT> transitions{};
+            std::array<RunList<N>, STATE_COUNT> full{};
+        };
+
+        template <size_t N>
+        constexpr RunList<N> make_runs(const LedImage& from, const LedImage& to, const std::array<bool, CHANNELS>& used, bool from_valid) {
+            RunList<N> list{};
+            for_each_run(from, to, used, from_valid, [&](size_t offset, size_t count) {
+                list.runs[list.size].offset = static_cast<uint8_t>(offset);
+                list.runs[list.size].count = static_cast<uint8_t>(count);
+                ++list.size;
+            });
+            return list;
+        }
+
+        template <size_t N>
+        constexpr WriteTable<N> write_table(const StateImages& images, const std::array<bool, CHANNELS>& used) {
+            WriteTable<N> table{};
+            for (size_t to = 0; to < STATE_COUNT; ++to) {
+                for (size_t from = 0; from < STATE_COUNT; ++from) {
+                    table.transitions[from][to] = make_runs<N>(images[from], images[to], used, true);
+                }
+                table.full[to] = make_runs<N>(images[to], images[to], used, false);
+            }
+            return table;
+        }
+    }
+
+    /**
+     * @brief 默认的通道布局：fpvcar-motor 的默认通道与地址，PWM 频率 1000Hz（PCA9685 可达的频率）
+     * @note Layout 需要提供 channels（FpvCarChannelConfig）、pwm_frequency（Hz）、address 三个编译期常量
+     */
+    struct DefaultChannelLayout {
+        static constexpr motorconfig::FpvCarChannelConfig channels = motorconfig::DEFAULT_CHANNELS;
+        static constexpr double pwm_frequency = 1000.0;
+        static constexpr uint8_t address = motorconfig::PCA9685_I2C_ADDRESS;
+    };
+
+    /**
+     * @brief 通道布局在编译期给定的 PCA9685 电机后端
+     * @note 行为与 Pca9685MotorBackend（COALESCED）一致：同样的各轮占空比、同样的寄存器段合并规则，
+     *       因此任意指令序列写入的事务与寄存器值都相同
+     * @note 事务失败时丢弃寄存器副本，下一次调用重写所有使用中的通道
+     * @note 内部加锁，reinitialize() 与 control_loop、看门狗、紧急停车线程的调用互斥
+     */
+    template <typename Layout>
+    class StaticPca9685Backend : public MotorBackend {
+    public:
+        static constexpr std::array<pca9685::WheelChannels, WHEEL_COUNT> WHEELS = pca9685::wheel_channels(Layout::channels);
+        static_assert(pca9685::channels_in_range(WHEELS), "PCA9685 channel out of range");
+        static_assert(pca9685::prescale_in_range(Layout::pwm_frequency), "PWM frequency outside the PCA9685 prescale range (3-255)");
+        static_assert(pca9685::address_in_range(Layout::address), "PCA9685 I2C address outside 0x40-0x7F");
+        static constexpr uint8_t ADDRESS = Layout::address;
+        static constexpr uint8_t PRESCALE = pca9685::prescale_for(Layout::pwm_frequency);
+        static constexpr std::array<bool, pca9685::CHANNELS> USED = pca9685::used_channels(WHEELS);
+
+        /**
+         * @param transport I2C 传输层（生命周期长于后端）
+         * @note 构造时不访问芯片，使用前调用 initialize() 或 adopt_outputs()
+         */
+        explicit StaticPca9685Backend(I2cTransport& transport) : m_transport(transport) {}
+
+        void moveForward() override { command(DesiredState::MOVING_FORWARD); }
+        void moveBackward() override { command(DesiredState::MOVING_BACKWARD); }
+        void turnLeft() override { command(DesiredState::TURNING_LEFT); }
+        void turnRight() override { command(DesiredState::TURNING_RIGHT); }
+        void moveForwardAndTurnLeft() override { command(DesiredState::MOVING_FORWARD_AND_TURN_LEFT); }
+        void moveForwardAndTurnRight() override { command(DesiredState::MOVING_FORWARD_AND_TURN_RIGHT); }
+        void moveBackwardAndTurnLeft() override { command(DesiredState::MOVING_BACKWARD_AND_TURN_LEFT); }
+        void moveBackwardAndTurnRight() override { command(DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT); }
+        void stopAll() override { command(DesiredState::STOPPING); }
+
+        /**
+         * @brief 配置芯片（MODE1/MODE2/PRESCALE，所有通道全关）
+         */
+        void initialize() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            configure();
+        }
+
+        /**
+         * @brief 读回芯片当前的 LED 寄存器作为寄存器副本，与某个状态的映像一致时继续按写入表切换
+         * @note 芯片未按 PRESCALE 运行时打印告警并重新配置（输出关闭）
+         */
+        void adopt_outputs() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shadow_valid = false;
+            m_applied.reset();
+            pca9685::LedImage image{};
+            if (!pca9685::read_running_image(m_transport, ADDRESS, PRESCALE, image)) {
+                std::cerr << "Warning: PCA9685 is not running with the configured PWM frequency, reconfiguring (outputs off)" << std::endl;
+                configure();
+                return;
+            }
+            m_shadow = image;
+            m_shadow_valid = true;
+            for (size_t s = 0; s < pca9685::STATE_COUNT; ++s) {
+                if (IMAGES[s] == image) m_applied = static_cast<DesiredState>(s);
+            }
+        }
+
+        /**
+         * @brief 重新打开总线并重新配置芯片（MODE1/MODE2/PRESCALE，所有通道全关）
+         */
+        void reinitialize() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shadow_valid = false;
+            m_transport.reopen();
+            configure();
+        }
+
+        bool supports_wheel_duty() const override { return true; }
+
+        void set_wheel_duty(const WheelDuty& duty) override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            pca9685::LedImage image = m_shadow;
+            pca9685::set_wheel_duty(image, WHEELS, duty);
+            try {
+                pca9685::for_each_run(m_shadow, image, USED, m_shadow_valid, [&](size_t offset, size_t count) {
+                    write_run(image, offset, count);
+                });
+            } catch (...) {
+                m_shadow_valid = false;
+                m_applied.reset();
+                throw;
+            }
+            m_shadow = image;
+            m_shadow_valid = true;
+            m_applied.reset();
+        }
+
+        /**
+         * @brief 芯片实际运行的 PWM 频率
+         */
+        static constexpr double pwm_frequency() { return pca9685::frequency_for(PRESCALE); }
+
+    private:
+        // 每个状态的 LED 寄存器映像与状态之间的写入表
+        static constexpr pca9685::StateImages IMAGES = pca9685::state_images(WHEELS);
+        static constexpr size_t MAX_RUNS = pca9685::max_runs(IMAGES, USED);
+        using Runs = pca9685::RunList<MAX_RUNS>;
+        static constexpr pca9685::WriteTable<MAX_RUNS> TABLE = pca9685::write_table<MAX_RUNS>(IMAGES, USED);
+
+        void command(DesiredState state) {
+            const size_t to = static_cast<size_t>(state);
+            const pca9685::LedImage& image = IMAGES[to];
+            std::lock_guard<std::mutex> lock(m_mutex);
+            try {
+                if (m_shadow_valid && !m_applied) {
+                    // 上一次是按车轮设置的占空比，芯片不处于任何状态的映像，只能比较副本
+                    pca9685::for_each_run(m_shadow, image, USED, true, [&](size_t offset, size_t count) {
+                        write_run(image, offset, count);
+                    });
+                } else {
+                    const Runs& runs = m_shadow_valid ? TABLE.transitions[static_cast<size_t>(*m_applied)][to] : TABLE.full[to];
+                    for (size_t i = 0; i < runs.size; ++i) write_run(image, runs.runs[i].offset, runs.runs[i].count);
+                }
+            } catch (...) {
+                m_shadow_valid = false;
+                m_applied.reset();
+                throw;
+            }
+            m_shadow = image;
+            m_shadow_valid = true;
+            m_applied = state;
+        }
+
+        // 调用方持有 m_mutex
+        void configure() {
+            pca9685::configure_chip(m_transport, ADDRESS, PRESCALE);
+            m_shadow = IMAGES[static_cast<size_t>(DesiredState::STOPPING)];
+            m_shadow_valid = true;
+            m_applied = DesiredState::STOPPING;
+        }
+
+        void write_run(const pca9685::LedImage& image, size_t offset, size_t count) {
+            pca9685::write_registers(m_transport, ADDRESS, static_cast<uint8_t>(pca9685::LED0_ON_L + offset), &image[offset], count);
+        }
+
+        I2cTransport& m_transport;
+
+        std::mutex m_mutex;
+        pca9685::LedImage m_shadow{};           // 已写入芯片的 LED 寄存器
+        bool m_shadow_valid = false;            // 为 false 时下一次写入所有使用中的通道
+        std::optional<DesiredState> m_applied;  // 芯片处于哪个状态的映像（按车轮设置占空比后为空）
+    };
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <tl/expected.hpp>
+#include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/ipc_server.hpp"
+
+// 这个文件提供进程接管（不停车升级）：新进程通过接管套接字从正在运行的旧进程取得
+//   - IPC 监听套接字和停在帧边界的客户端连接（SCM_RIGHTS 传递文件描述符，gateway 不会感知到切换）
+//   - 期望状态、租约到期时间、最近执行的状态和看门狗计时状态
+// 然后在不停车的情况下接管控制循环
+//
+// 协议（接管套接字上的长度前缀 JSON 帧，与 IPC 帧格式相同）：
+//   1. 新进程 -> 旧进程  {"type":"takeover","version":1}；请求不合法时旧进程回复 {"type":"error","message":...} 并继续服务
+//   2. 旧进程停止服务（冻结），发送状态帧，帧的第一个字节携带 SCM_RIGHTS：[监听套接字, 客户端连接...]
+//   3. 新进程接管套接字和状态（尚未开始服务）后回复 {"type":"ready"}
+//   4. 旧进程回复 {"type":"commit"}，此后旧进程不再恢复服务，只等待退出
+//   5. 新进程启动控制循环和 IPC 服务器，回复 {"type":"started","gap_us":N}（N 为从冻结到恢复服务的时间）
+// 第 4 步之前任何一方失败或超时，旧进程恢复服务，新进程关闭收到的套接字并报错；
+// 第 4 步之后旧进程只在接管套接字被关闭且没有收到 started（说明新进程已经退出）时恢复服务
+//
+// 时间点在两个进程之间以 CLOCK_MONOTONIC（steady_clock）的纳秒数传递，同一台机器上的进程共享同一时间基准
+
+namespace fpvcar::device_control::takeover {
+
+    /**
+     * @brief 协议版本，不同版本的进程之间拒绝接管
+     */
+    constexpr int PROTOCOL_VERSION = 1;
+
+    /**
+     * @brief 每一步等待对方回复的超时时间；超时后旧进程恢复服务
+     */
+    constexpr std::chrono::milliseconds STEP_TIMEOUT{1000};
+
+    /**
+     * @brief 一次接管中最多传递的客户端连接数（其余连接由旧进程关闭，客户端需重连）
+     */
+    constexpr size_t MAX_CLIENT_FDS = 64;
+
+    /**
+     * @brief 在进程之间移交的服务状态
+     * @param desired_state 期望状态
+     * @param lease_deadline 期望状态的租约到期时间，NO_LEASE 表示不带租约
+     * @param control_loop 控制循环状态（最近执行的状态、看门狗计时）
+     * @param freeze_time 旧进程停止服务的时刻，用于计算接管间隙
+     */
+    struct TakeoverState {
+        DesiredState desired_state = DesiredState::STOPPING;
+        LeaseTimePoint lease_deadline = NO_LEASE;
+        ControlLoopResumeState control_loop;
+        Clock::time_point freeze_time{};
+    };
+
+    /**
+     * @brief 旧进程一侧：接管套接字的监听线程
+     * @note 每个接管请求在监听线程中同步处理；处理函数返回 true 表示服务已移交，监听线程随即退出且不删除套接字文件
+     */
+    class TakeoverListener {
+    public:
+        // 处理一个接管连接（fd 在处理函数返回后由监听线程关闭），返回 true 表示已移交
+        using Handler = std::function<bool(int fd)>;
+
+        TakeoverListener(const std::string& socket_path, Handler handler);
+        ~TakeoverListener();
+
+        TakeoverListener(const TakeoverListener&) = delete;
+        TakeoverListener& operator=(const TakeoverListener&) = delete;
+
+        /**
+         * @brief 创建并绑定接管套接字（权限 0600），启动监听线程
+         * @return 成功返回 void，失败返回错误信息字符串
+         */
+        tl::expected<void, std::string> start();
+
+        /**
+         * @brief 停止监听线程；没有移交时删除套接字文件
+         * @note 等待正在进行的接管处理结束（受 STEP_TIMEOUT 限制）
+         */
+        void stop();
+
+    private:
+        void run();
+
+        const std::string m_socket_path;
+        const Handler m_handler;
+        int m_listen_fd = -1;
+        std::atomic<bool> m_running{false};
+        std::atomic<bool> m_handed_over{false};
+        std::thread m_thread;
+    };
+
+    /**
+     * @brief 新进程一侧：连接旧进程的接管套接字并发送接管请求
+     * @return 成功返回连接的文件描述符；没有正在运行的旧进程时返回错误信息字符串
+     */
+    tl::expected<int, std::string> request_takeover(const std::string& socket_path);
+
+    /**
+     * @brief 旧进程一侧：读取并校验接管请求，同时检查对端与本进程属于同一用户（或 root）
+     * @note 请求类型或版本不符时回复 {"type":"error","message":...}，字段类型错误同样按不符处理，不抛出异常
+     */
+    tl::expected<void, std::string> accept_request(int fd);
+
+    /**
+     * @brief 旧进程一侧：发送状态帧和套接字（SCM_RIGHTS）
+     * @note 发送后旧进程仍持有这些套接字，直到 commit 后关闭（回滚时继续使用）
+     */
+    tl::expected<void, std::string> send_state(int fd, const TakeoverState& state, const IpcSockets& sockets);
+
+    /**
+     * @brief 新进程一侧：接收状态帧和套接字（所有权转移给调用方）
+     */
+    tl::expected<std::pair<TakeoverState, IpcSockets>, std::string> receive_state(int fd);
+
+    /**
+     * @brief 发送一条控制帧，如 {"type":"ready"}
+     * @param type 帧类型
+     * @param gap_us 大于等于 0 时附带 "gap_us" 字段
+     */
+    tl::expected<void, std::string> send_control(int fd, const char* type, int64_t gap_us = -1);
+
+    /**
+     * @brief 在 STEP_TIMEOUT 内等待一条指定类型的控制帧
+     * @param gap_us 非空时读取 "gap_us" 字段（没有时为 -1）
+     * @param peer_closed 非空时写入失败原因是否为对端已关闭连接（区别于超时）
+     * @return 成功返回 void；超时、对端关闭或类型不符时返回错误信息字符串
+     */
+    tl::expected<void, std::string> expect_control(int fd, const char* type, int64_t* gap_us = nullptr,
+                                                   bool* peer_closed = nullptr);
+
+    /**
+     * @brief 关闭 IpcSockets 中的全部文件描述符
+     */
+    void close_sockets(IpcSockets& sockets);
+}
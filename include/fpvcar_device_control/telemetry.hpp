@@ -0,0 +1,194 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <tl/expected.hpp>
+#include "fpvcar_device_control/desired_state.hpp"
+
+// 这个文件提供状态与遥测的推送订阅
+// control_loop 线程是唯一的生产者：每个周期把运行状态写入 TelemetryChannel（seqlock 快照），
+// 状态变更、看门狗超时时额外通过 eventfd 通知；TelemetryPublisher 线程读取快照并扇出给所有订阅者
+// 生产者从不等待订阅者：发送全部为非阻塞，慢订阅者只会收到合并后的最新更新，长时间无进展则被断开
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 一次遥测快照
+     * @param timestamp_us 发布时间（steady_clock，微秒）
+     * @param applied_state control_loop 最近一次实际执行的状态
+     * @param desired_state 期望状态管理器中的当前期望状态
+     * @param ticks control_loop 已执行的周期数
+     * @param overruns control_loop 掉帧（超过周期）次数
+     * @param watchdog_trips 看门狗超时停车次数
+     * @param lease_expiries 指令租约到期次数
+     * @param motor_calls 电机调用次数
+     * @param motor_failures 电机调用失败次数（错误率 = motor_failures / motor_calls）
+     * @param motor_timeouts 电机调用超时次数
+     * @param motor_reinits 电机后端重新初始化次数
+     * @param motor_degraded 是否处于降级（保持停车）模式，1 表示是
+     * @param estops 紧急停车次数（见 estop.hpp）
+     * @param tick_interval_ns 控制周期的平滑平均值（增益 1/16）
+     * @param tick_jitter_ns |实际周期 - 目标周期| 的平滑平均值（增益 1/16）
+     * @param tick_max_jitter_ns |实际周期 - 目标周期| 的最大值
+     * @param closed_loop 是否启用闭环轮速控制，1 表示是（以下两项只在闭环时有效）
+     * @param wheel_speed_eps 各轮测得的速度（编码器边沿/秒，带方向；顺序为左前、右前、左后、右后）
+     * @param wheel_duty 各轮占空比（Q15，±32767 为 ±100%）
+     */
+    struct TelemetrySnapshot {
+        uint64_t timestamp_us = 0;
+        DesiredState applied_state = DesiredState::STOPPING;
+        DesiredState desired_state = DesiredState::STOPPING;
+        uint64_t ticks = 0;
+        uint64_t overruns = 0;
+        uint64_t watchdog_trips = 0;
+        uint64_t lease_expiries = 0;
+        uint64_t motor_calls = 0;
+        uint64_t motor_failures = 0;
+        uint64_t motor_timeouts = 0;
+        uint64_t motor_reinits = 0;
+        uint64_t motor_degraded = 0;
+        uint64_t estops = 0;
+        uint64_t tick_interval_ns = 0;
+        uint64_t tick_jitter_ns = 0;
+        uint64_t tick_max_jitter_ns = 0;
+        uint64_t closed_loop = 0;
+        int64_t wheel_speed_eps[4] = {0, 0, 0, 0};
+        int64_t wheel_duty[4] = {0, 0, 0, 0};
+    };
+    static_assert(std::is_trivially_copyable<TelemetrySnapshot>::value, "TelemetrySnapshot must be trivially copyable");
+    static_assert(sizeof(TelemetrySnapshot) % sizeof(uint64_t) == 0, "TelemetrySnapshot must be a whole number of words");
+
+    /**
+     * @brief 单生产者、多读者的遥测快照通道（seqlock）
+     * @note publish() 只能由一个线程调用（control_loop），read() 可在任意线程调用且不会阻塞生产者
+     */
+    class TelemetryChannel {
+    public:
+        TelemetryChannel();
+        ~TelemetryChannel();
+
+        TelemetryChannel(const TelemetryChannel&) = delete;
+        TelemetryChannel& operator=(const TelemetryChannel&) = delete;
+
+        /**
+         * @brief 发布一次快照
+         * @param snapshot 快照内容
+         * @param notify 是否通过 eventfd 唤醒订阅推送线程（状态变更、看门狗超时等事件）
+         */
+        void publish(const TelemetrySnapshot& snapshot, bool notify);
+
+        /**
+         * @brief 读取最近一次发布的完整快照（与发布并发时自动重试）
+         */
+        TelemetrySnapshot read() const;
+
+        /**
+         * @brief 事件通知使用的 eventfd，创建失败时为 -1（此时订阅者只收到周期推送）
+         */
+        int event_fd() const { return m_event_fd; }
+
+    private:
+        static constexpr size_t WORDS = sizeof(TelemetrySnapshot) / sizeof(uint64_t);
+
+        std::atomic<uint64_t> m_sequence{0}; // 奇数表示正在写入
+        std::array<std::atomic<uint64_t>, WORDS> m_words{}; // 快照按 64 位字存储，读写均为原子操作
+        int m_event_fd = -1;
+    };
+
+    /**
+     * @brief 订阅推送统计
+     * @param subscribers 当前订阅者数量
+     * @param updates_sent 已完整发送的更新帧数（所有订阅者合计）
+     * @param updates_coalesced 因订阅者发送缓慢被较新更新替换掉的帧数
+     * @param subscribers_dropped 因对端关闭、发送错误或长时间无进展被断开的订阅者数
+     */
+    struct TelemetryPublisherStats {
+        uint64_t subscribers = 0;
+        uint64_t updates_sent = 0;
+        uint64_t updates_coalesced = 0;
+        uint64_t subscribers_dropped = 0;
+    };
+
+    /**
+     * @brief 订阅推送线程：把 TelemetryChannel 的快照推送给所有订阅连接
+     * @note 每条推送使用与 IPC 请求相同的长度前缀帧，内容为一行紧凑 JSON，例如
+     *       {"type":"telemetry","event":"state","ts_us":...,"state":"moveForward",...}
+     * @note event 取值：subscribe（订阅后的首个快照）、state（执行状态变更）、watchdog（看门狗停车）、
+     *       fault（进入或离开电机故障降级模式）、periodic（周期推送）
+     */
+    class TelemetryPublisher {
+    public:
+        /**
+         * @brief 构造订阅推送器
+         * @param channel 快照来源
+         * @param period 周期推送间隔，0 表示只推送事件
+         * @param max_subscribers 最大订阅者数量，超出时拒绝新的订阅
+         */
+        TelemetryPublisher(const TelemetryChannel& channel, std::chrono::milliseconds period, size_t max_subscribers);
+        ~TelemetryPublisher();
+
+        TelemetryPublisher(const TelemetryPublisher&) = delete;
+        TelemetryPublisher& operator=(const TelemetryPublisher&) = delete;
+
+        /**
+         * @brief 启动推送线程
+         * @return 成功返回 void，失败返回错误信息字符串
+         */
+        tl::expected<void, std::string> start();
+
+        /**
+         * @brief 停止推送线程并关闭所有订阅连接
+         * @note 可重复调用
+         */
+        void stop();
+
+        /**
+         * @brief 添加一个订阅者（线程安全）
+         * @param fd 已连接的套接字，所有权转移给推送器
+         * @param response 订阅请求的响应内容（不含长度前缀），在任何推送之前发送
+         */
+        void add_subscriber(int fd, std::string response);
+
+        /**
+         * @brief 获取推送统计
+         */
+        TelemetryPublisherStats stats() const;
+
+    private:
+        struct Subscriber {
+            int fd = -1;
+            std::string out;        // 正在发送的帧
+            size_t out_offset = 0;  // out 中已发送的字节数
+            std::string latest;     // 等待发送的最新帧（新的更新会替换它）
+            std::chrono::steady_clock::time_point last_progress;
+            bool dead = false;
+        };
+
+        void run();
+        void enqueue(Subscriber& sub, const std::string& frame);
+        void flush(Subscriber& sub, std::chrono::steady_clock::time_point now);
+
+        const TelemetryChannel& m_channel;
+        const std::chrono::milliseconds m_period;
+        const size_t m_max_subscribers;
+
+        std::mutex m_incoming_mutex; // 保护 m_incoming
+        std::vector<std::pair<int, std::string>> m_incoming; // 等待推送线程接管的新订阅
+        std::vector<Subscriber> m_subscribers; // 只由推送线程访问
+
+        int m_wake_fd = -1; // add_subscriber()/stop() 写入，唤醒推送线程
+        std::atomic<bool> m_running{false};
+        std::thread m_thread;
+
+        std::atomic<uint64_t> m_subscriber_count{0};
+        std::atomic<uint64_t> m_updates_sent{0};
+        std::atomic<uint64_t> m_updates_coalesced{0};
+        std::atomic<uint64_t> m_subscribers_dropped{0};
+    };
+}
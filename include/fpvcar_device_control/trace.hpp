@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <tl/expected.hpp>
+
+// 这个文件提供按请求追踪（tracing）的实现
+// 每个线程把追踪片段写入自己的环形缓冲区，可导出为 Chrome trace-event JSON（可用 Perfetto 打开）
+// 追踪默认关闭，关闭时每个追踪点只有一次 relaxed 原子读
+
+namespace fpvcar::device_control::trace {
+
+    // 全局追踪开关，请通过 set_enabled()/is_enabled() 访问
+    extern std::atomic<bool> g_trace_enabled;
+
+    /**
+     * @brief 每个线程环形缓冲区可保存的事件数量，写满后覆盖最旧的事件
+     */
+    constexpr size_t THREAD_BUFFER_CAPACITY = 2048;
+
+    /**
+     * @brief 一条追踪事件（完整片段）
+     * @param name 片段名称，必须是静态字符串
+     * @param request_id 关联的请求 ID，0 表示不属于任何请求
+     * @param start_ns 开始时间（steady_clock，纳秒）
+     * @param duration_ns 持续时间（纳秒）
+     */
+    struct TraceEvent {
+        const char* name;
+        uint64_t request_id;
+        uint64_t start_ns;
+        uint64_t duration_ns;
+    };
+
+    /**
+     * @brief 运行时打开或关闭追踪
+     * @param enabled true 打开，false 关闭
+     * @note 关闭追踪不会清空已记录的事件
+     */
+    void set_enabled(bool enabled);
+
+    /**
+     * @brief 查询追踪是否打开
+     */
+    inline bool is_enabled() {
+        return g_trace_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取当前 steady_clock 时间（纳秒）
+     */
+    uint64_t now_ns();
+
+    /**
+     * @brief 分配一个新的请求 ID（从 1 开始递增）
+     */
+    uint64_t next_request_id();
+
+    /**
+     * @brief 设置当前线程正在处理的请求 ID
+     * @note 由 IpcServer 在处理每条消息前设置，同一线程内的后续追踪点会自动关联该 ID
+     */
+    void set_current_request_id(uint64_t request_id);
+
+    /**
+     * @brief 获取当前线程正在处理的请求 ID，未设置时为 0
+     */
+    uint64_t current_request_id();
+
+    /**
+     * @brief 向当前线程的环形缓冲区写入一条事件
+     * @note 调用者应先检查 is_enabled()，一般请使用 Span
+     */
+    void record(const char* name, uint64_t request_id, uint64_t start_ns, uint64_t end_ns);
+
+    /**
+     * @brief 清空所有线程已记录的事件
+     * @note 应在追踪关闭、没有线程写入时调用
+     */
+    void clear();
+
+    /**
+     * @brief 把所有线程的缓冲区导出为 Chrome trace-event JSON 文件
+     * @param file_path 输出文件路径
+     * @return 成功返回 void，失败返回错误信息字符串
+     * @note 同一请求 ID 的事件会用 flow 事件串起来，在 Perfetto 中可以跨线程跟踪一条指令
+     * @note 导出时不阻塞写入者，正在写入或被覆盖的事件会被跳过；追踪打开时导出，最新的少量事件可能缺失
+     */
+    tl::expected<void, std::string> export_chrome_trace(const std::string& file_path);
+
+    /**
+     * @brief RAII 追踪片段：构造时记录开始时间，析构时写入缓冲区
+     * @note 追踪关闭时构造和析构都不读取时钟
+     */
+    class Span {
+    public:
+        explicit Span(const char* name)
+            : m_name(name), m_request_id(0), m_start_ns(0) {
+            if (is_enabled()) {
+                m_request_id = current_request_id();
+                m_start_ns = now_ns();
+            }
+        }
+
+        Span(const char* name, uint64_t request_id)
+            : m_name(name), m_request_id(request_id), m_start_ns(is_enabled() ? now_ns() : 0) {}
+
+        ~Span() {
+            if (m_start_ns != 0) {
+                record(m_name, m_request_id, m_start_ns, now_ns());
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_request_id;
+        uint64_t m_start_ns; // 0 表示追踪关闭，不记录
+    };
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+#include <tl/expected.hpp>
+#include "fpvcar_device_control/ipc_server.hpp"
+
+// 这个文件提供可选的 UDP 控制通道：gateway 运行在同一局域网的另一块板子上时直接发送数据报，
+// 不再经本机进程中转到 Unix 套接字，也没有流式连接的队头阻塞
+// 数据报内容与 IPC 请求相同（一个 JSON 对象，不带长度前缀），另外必须带两个字段：
+//   - "seq"：发送端递增的序号（非负整数）。不大于该发送端已接受的最大序号的数据报（乱序、重复）直接丢弃
+//   - "ts_us"：发送端单调时钟的微秒时间戳（起点任意）。到达时间减去 ts_us 即单向延迟加上两端时钟偏差，
+//     它与该发送端的最小值（延迟基线）之差超过 max_delay 的数据报视为过期，直接丢弃
+// 被丢弃的数据报既不执行也不喂看门狗；每个数据报都回复一个数据报（响应 JSON 中带 "seq"）
+// 每个发送端（地址:端口）单独统计接受/丢弃数与到达抖动（RFC 3550 到达间隔抖动）
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief UDP 通道的丢弃策略
+     * @param max_delay 单向延迟超过延迟基线多少即视为过期
+     * @param sender_idle_reset 发送端沉默超过这个时间后重置其序号与延迟基线（发送端重启后序号从头开始）
+     */
+    struct UdpPolicy {
+        std::chrono::microseconds max_delay{100000};
+        std::chrono::milliseconds sender_idle_reset{1000};
+    };
+
+    /**
+     * @brief 单个发送端的统计
+     * @param address 发送端地址，形如 "192.168.1.5:40000"
+     * @param accepted 已接受（执行）的数据报数
+     * @param stale 因过期丢弃的数据报数
+     * @param reordered 因乱序或重复丢弃的数据报数
+     * @param last_seq 最近接受的序号
+     * @param jitter_us 到达抖动估计（微秒，RFC 3550：|到达间隔 - 发送间隔| 的指数平滑，增益 1/16）
+     * @param max_jitter_us 观测到的最大 |到达间隔 - 发送间隔|（微秒）
+     */
+    struct UdpSenderStats {
+        std::string address;
+        uint64_t accepted = 0;
+        uint64_t stale = 0;
+        uint64_t reordered = 0;
+        int64_t last_seq = -1;
+        double jitter_us = 0.0;
+        double max_jitter_us = 0.0;
+    };
+
+    /**
+     * @brief UDP 通道统计
+     * @param received 收到的数据报数
+     * @param accepted 已接受（执行）的数据报数
+     * @param stale 因过期丢弃的数据报数
+     * @param reordered 因乱序或重复丢弃的数据报数
+     * @param malformed 无法解析或缺少 seq/ts_us 的数据报数
+     * @param rejected 因 action 不是运动或停止指令而拒绝的数据报数
+     * @param errors 处理回调抛出异常的数据报数
+     * @param senders 各发送端的统计（最多 MAX_SENDERS 个，最久不活动的发送端先被淘汰）
+     */
+    struct UdpServerStats {
+        uint64_t received = 0;
+        uint64_t accepted = 0;
+        uint64_t stale = 0;
+        uint64_t reordered = 0;
+        uint64_t malformed = 0;
+        uint64_t rejected = 0;
+        uint64_t errors = 0;
+        std::vector<UdpSenderStats> senders;
+    };
+
+    /**
+     * @brief UDP 控制通道
+     * @note 在自己的线程中用 recvmmsg/sendmmsg 成批收发；只支持 IPv4
+     * @note 只接受运动与停止指令（desired_state_from_action 能识别的 action）；其它 action（追踪、飞行记录器导出、
+     *       订阅等）在 UDP 上一律拒绝，回复 ACTION_NOT_ALLOWED，不执行也不喂看门狗
+     */
+    class UdpServer {
+    public:
+        /**
+         * @brief 同时跟踪的发送端数量上限
+         */
+        static constexpr size_t MAX_SENDERS = 16;
+
+        /**
+         * @param bind_address 绑定的 IPv4 地址，如 "127.0.0.1"
+         * @param port 端口，0 表示由内核分配（见 port()）
+         * @param callback 请求处理回调（与 IpcServer 相同），只会收到运动与停止指令；抛出的异常被捕获并回复 SERVER_ERROR
+         * @param policy 丢弃策略
+         */
+        UdpServer(std::string bind_address, uint16_t port, IpcCallback callback, UdpPolicy policy = {});
+        ~UdpServer();
+
+        UdpServer(const UdpServer&) = delete;
+        UdpServer& operator=(const UdpServer&) = delete;
+
+        /**
+         * @brief 绑定套接字并启动接收线程
+         * @return 成功返回 void，失败返回错误信息字符串
+         * @note stop() 之后可以再次 start()（进程接管回滚时使用），统计与发送端状态保留
+         */
+        tl::expected<void, std::string> start();
+
+        /**
+         * @brief 停止接收线程并关闭套接字
+         */
+        void stop();
+
+        /**
+         * @brief 实际绑定的端口（start() 成功后有效）
+         */
+        uint16_t port() const { return m_bound_port; }
+
+        /**
+         * @brief 获取统计，可在任意线程调用
+         */
+        UdpServerStats stats() const;
+
+    private:
+        // 一个发送端的状态
+        struct Sender {
+            uint64_t key = 0;            // IPv4 地址与端口
+            std::string address;
+            bool has_seq = false;
+            int64_t last_seq = -1;
+            int64_t baseline_us = 0;     // 延迟基线：到达时间 - ts_us 的最小值（允许缓慢上漂以跟随时钟漂移）
+            int64_t baseline_at_us = 0;  // 上次更新基线的到达时间
+            int64_t last_arrival_us = 0; // 最近接受的数据报的到达时间
+            int64_t last_ts_us = 0;      // 最近接受的数据报的 ts_us
+            int64_t last_seen_us = 0;    // 最近收到数据报（含被丢弃的）的时间
+            double jitter_us = 0.0;
+            double max_jitter_us = 0.0;
+            uint64_t accepted = 0;
+            uint64_t stale = 0;
+            uint64_t reordered = 0;
+        };
+
+        void run();
+
+        /**
+         * @brief 处理一个数据报，把回复写入 reply（不为空时发送）
+         */
+        void handle_datagram(const sockaddr_in& from, std::string_view datagram, bool truncated,
+                             int64_t arrival_us, std::string& reply);
+
+        /**
+         * @brief 查找或创建发送端（调用方持有 m_mutex）
+         */
+        Sender& sender_for(const sockaddr_in& from, int64_t now_us);
+
+        const std::string m_bind_address;
+        const uint16_t m_port;
+        const IpcCallback m_callback;
+        const UdpPolicy m_policy;
+
+        int m_fd = -1;
+        int m_wake_fd = -1;
+        uint16_t m_bound_port = 0;
+        std::atomic<bool> m_running{false};
+        std::thread m_thread;
+
+        mutable std::mutex m_mutex; // 保护以下统计与发送端状态
+        std::vector<Sender> m_senders;
+        uint64_t m_received = 0;
+        uint64_t m_accepted = 0;
+        uint64_t m_stale = 0;
+        uint64_t m_reordered = 0;
+        uint64_t m_malformed = 0;
+        uint64_t m_rejected = 0;
+        uint64_t m_errors = 0;
+        std::string m_response; // 回调的响应缓冲区（复用）
+    };
+}
@@ -4,25 +4,44 @@
 #include <chrono>
 #include <atomic>
 #include <functional> // 用于 std::function
-#include "fpvcar-motor/fpvcar_controller.hpp"
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
 #include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/pi_mutex.hpp"
 
 /**
  * @brief 一个简单的C++软件看门狗类 会直接调用底层控制库停止运动
  */
 namespace fpvcar::device_control {
+    /**
+     * @brief 看门狗的计时状态，用于进程接管时把看门狗原样交给新进程
+     * @param period_end 当前检查周期的结束时间：届时若未被喂狗则触发停车
+     * @param kicked 当前周期内是否已被喂狗
+     */
+    struct WatchdogState {
+        Clock::time_point period_end{};
+        bool kicked = true;
+    };
+
     class SoftwareWatchdog {
 public:
     /**
      * @param timeout 超时时间
-     * @param car 小车控制器引用，超时后直接调用 car.stopAll() 停止所有电机
+     * @param car 电机后端引用，超时后直接调用 car.stopAll() 停止所有电机
+     * @param actuation 执行锁（ControlLoop 持有），停车调用在锁内进行，与控制周期、紧急停车的电机调用互斥
      * @param desired_state_manager 期望状态管理器引用，超时后直接调用 desired_state_manager.set_desired_state(DesiredState::STOPPING) 更改状态
-     * @note 看门狗作为独立的安全机制，不依赖 control_loop，即使 control_loop 卡死也能直接停止硬件
+     * @param clock 时间与休眠来源，默认真实时钟
+     * @note 看门狗作为独立的安全机制，不依赖 control_loop 的周期，control_loop 停止喂狗时也能直接停止硬件
+     * @note 执行锁最多等待一个超时时间：control_loop 卡在某次电机调用里时不与之并发调用后端，
+     *       只把期望状态置为停止并记录停车失败（后端本身已无响应，并发调用也无法停车）
      */
-    SoftwareWatchdog(std::chrono::milliseconds timeout, control::FpvCarController& car, DesiredStateManager& desired_state_manager)
-        : m_timeout(timeout),
-          m_car(car),
+    SoftwareWatchdog(std::chrono::milliseconds timeout, MotorBackend& car, PiMutex& actuation,
+                     DesiredStateManager& desired_state_manager, Clock& clock = SteadyClock::instance())
+        : m_car(car),
+          m_actuation(actuation),
           m_desired_state_manager(desired_state_manager),
+          m_clock(clock),
+          m_timeout(timeout),
           m_stop(false),
           m_kicked(false) {}
 
@@ -35,6 +54,11 @@ public:
      */
     void start();
 
+    /**
+     * @brief 从给定的计时状态继续监控（进程接管时使用），period_end 已过去时立即检查
+     */
+    void start(const WatchdogState& resume);
+
     /**
      * @brief 停止看门狗
      */
@@ -45,17 +69,34 @@ public:
      */
     void feed();
 
+    /**
+     * @brief 看门狗超时（触发停车）的累计次数
+     * @note 可在任意线程调用，control_loop 据此发布遥测事件
+     */
+    uint64_t trips() const { return m_trips.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 获取当前的计时状态
+     * @note 停止后调用可得到停止时刻的状态
+     */
+    WatchdogState state() const;
+
 private:
     /**
      * @brief 看门狗监控循环
+     * @param period_end 第一个检查周期的结束时间
     */
-    void watchLoop();
+    void watchLoop(Clock::time_point period_end);
 
-    control::FpvCarController& m_car;
+    MotorBackend& m_car;
+    PiMutex& m_actuation; // 执行锁
     DesiredStateManager& m_desired_state_manager;
+    Clock& m_clock; // 时间与休眠来源
     std::chrono::milliseconds m_timeout; // 超时时间
     std::atomic<bool> m_stop; // 停止标志
     std::atomic<bool> m_kicked; // 被喂狗标志
+    std::atomic<uint64_t> m_trips{0}; // 超时次数
+    std::atomic<Clock::duration::rep> m_period_end{0}; // 当前检查周期的结束时间（time_since_epoch 计数）
     std::thread m_thread; // 看门狗线程
 };
 
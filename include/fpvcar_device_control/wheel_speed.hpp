@@ -0,0 +1,194 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/motor_backend.hpp"
+
+// 这个文件提供闭环轮速控制：开环时固定占空比下的实际车速随电池电压与负载变化，
+// 闭环模式由编码器反馈估计每个车轮的转速，ControlLoop 每个周期用定点 PI 控制器修正各轮占空比
+//   - WheelFeedback：编码器边沿计数来源（GPIO 边沿事件见 gpio_encoder.hpp，仿真见 SimulatedEncoder）
+//   - WheelSpeedEstimator：按时间窗口内的边沿数估计轮速
+//   - WheelSpeedController：期望状态 → 各轮目标转速 → PI → 占空比
+// 所有控制量都是 Q15 定点数（±32767 对应 ±100% 满速/满占空比），增益为 Q16，控制周期内不使用浮点运算，
+// 在没有 FPU 或 FPU 较慢的小核上也能以 1kHz 运行
+// 单相编码器无法区分转向，测得的转速取目标转速的符号
+
+namespace fpvcar::device_control {
+
+    /**
+     * @brief 闭环轮速控制参数
+     * @param enabled 是否启用闭环（还需要电机后端支持按车轮设置占空比，并且有编码器反馈）
+     * @param rate_hz 控制频率，最高 1000Hz
+     * @param max_speed_eps 目标 100% 对应的轮速（编码器边沿/秒），应低于满占空比时的实际轮速，给电压跌落留出余量
+     * @param kp 比例增益：每 100% 速度误差对应的占空比（满量程比例）
+     * @param ki 积分增益：每 100% 速度误差每秒累积的占空比
+     * @param feedforward 前馈：目标速度直接对应的占空比比例（空载时约为 max_speed_eps 与满占空比轮速之比）
+     * @param speed_window 轮速估计的时间窗口，越长越平滑、延迟越大
+     * @param turn_inner_ratio 前进/后退并转向时内侧轮相对外侧轮的目标速度比例
+     */
+    struct WheelSpeedConfig {
+        bool enabled = false;
+        double rate_hz = 1000.0;
+        double max_speed_eps = 2000.0;
+        double kp = 0.5;
+        double ki = 12.0;
+        double feedforward = 0.8;
+        std::chrono::milliseconds speed_window{20};
+        double turn_inner_ratio = 0.5;
+    };
+
+    /**
+     * @brief 编码器采样：各车轮累计边沿数
+     */
+    struct EncoderSample {
+        Clock::time_point time{};
+        std::array<uint64_t, WHEEL_COUNT> edges{};
+    };
+
+    /**
+     * @brief 编码器反馈来源
+     * @note sample() 只由 control_loop 线程调用，每个控制周期一次，不应阻塞
+     */
+    class WheelFeedback {
+    public:
+        virtual ~WheelFeedback() = default;
+
+        /**
+         * @brief 读取当前各轮累计边沿数
+         * @return 读取失败时返回 false（本周期只按前馈开环输出）
+         */
+        virtual bool sample(EncoderSample& out) = 0;
+    };
+
+    /**
+     * @brief 期望状态对应的各轮目标速度（Q15，相对 max_speed_eps）
+     * @param inner_q15 转向时内侧轮的速度比例（Q15）
+     * @note 原地转向为左右轮反向；前进/后退并转向时内侧轮按比例减速
+     */
+    constexpr std::array<int32_t, WHEEL_COUNT> wheel_setpoints(DesiredState state, int32_t inner_q15) {
+        int32_t left = 0;
+        int32_t right = 0;
+        switch (state) {
+            case DesiredState::MOVING_FORWARD: left = DUTY_FULL; right = DUTY_FULL; break;
+            case DesiredState::MOVING_BACKWARD: left = -DUTY_FULL; right = -DUTY_FULL; break;
+            case DesiredState::TURNING_LEFT: left = -DUTY_FULL; right = DUTY_FULL; break;
+            case DesiredState::TURNING_RIGHT: left = DUTY_FULL; right = -DUTY_FULL; break;
+            case DesiredState::MOVING_FORWARD_AND_TURN_LEFT: left = inner_q15; right = DUTY_FULL; break;
+            case DesiredState::MOVING_FORWARD_AND_TURN_RIGHT: left = DUTY_FULL; right = inner_q15; break;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_LEFT: left = -inner_q15; right = -DUTY_FULL; break;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT: left = -DUTY_FULL; right = -inner_q15; break;
+            case DesiredState::STOPPING: break;
+        }
+        return {left, right, left, right};
+    }
+
+    /**
+     * @brief 按时间窗口估计轮速
+     * @note 保存最近 HISTORY 个采样（固定数组，不分配内存）；窗口超过 HISTORY 个控制周期时取最老的采样
+     */
+    class WheelSpeedEstimator {
+    public:
+        static constexpr size_t HISTORY = 64;
+
+        /**
+         * @param max_speed_eps 100% 对应的轮速（边沿/秒）
+         * @param window 估计窗口
+         */
+        WheelSpeedEstimator(double max_speed_eps, std::chrono::milliseconds window);
+
+        void reset();
+
+        /**
+         * @brief 加入一个采样，并更新各轮的速度估计
+         * @note 任一车轮的计数小于上一个采样时（编码器重新打开）先 reset()，从这个采样重新开始估计
+         */
+        void update(const EncoderSample& sample);
+
+        /**
+         * @brief 轮速估计（Q15，相对 max_speed_eps，非负）
+         */
+        int32_t speed_q15(size_t wheel) const { return m_speed_q15[wheel]; }
+
+        /**
+         * @brief 轮速估计（边沿/秒，非负）
+         */
+        int64_t speed_eps(size_t wheel) const { return m_speed_eps[wheel]; }
+
+    private:
+        const int64_t m_max_speed_eps;
+        const int64_t m_window_us;
+        std::array<EncoderSample, HISTORY> m_history{};
+        size_t m_count = 0; // 有效采样数（不超过 HISTORY）
+        size_t m_head = 0;  // 下一个写入位置
+        std::array<int32_t, WHEEL_COUNT> m_speed_q15{};
+        std::array<int64_t, WHEEL_COUNT> m_speed_eps{};
+    };
+
+    /**
+     * @brief 定点 PI 控制器（带前馈与抗积分饱和）
+     * @note 输入输出为 Q15，增益为 Q16，积分器为 Q31；输出饱和且误差同向、或误差超过满量程的 20% 时停止积分
+     */
+    class FixedPointPi {
+    public:
+        FixedPointPi(double kp, double ki, double feedforward);
+
+        void reset() { m_integral_q31 = 0; }
+
+        /**
+         * @param setpoint_q15 目标速度
+         * @param measured_q15 测得速度
+         * @param dt_us 距上次更新的时间（微秒）
+         * @return 占空比（Q15，限制在 ±DUTY_FULL）
+         */
+        int32_t update(int32_t setpoint_q15, int32_t measured_q15, int64_t dt_us);
+
+    private:
+        const int64_t m_kp_q16;
+        const int64_t m_ki_q16;
+        const int64_t m_ff_q16;
+        int64_t m_integral_q31 = 0;
+    };
+
+    /**
+     * @brief 各轮的闭环速度控制器
+     * @note 只由 control_loop 线程使用
+     */
+    class WheelSpeedController {
+    public:
+        explicit WheelSpeedController(const WheelSpeedConfig& config);
+
+        /**
+         * @brief 清除积分器与速度历史（状态切换、停车后重新起步时调用）
+         */
+        void reset();
+
+        /**
+         * @brief 计算一个控制周期的占空比
+         * @param target 期望状态（STOPPING 时输出 0）
+         * @param sample 本周期的编码器采样
+         * @param duty 输出的各轮占空比
+         */
+        void update(DesiredState target, const EncoderSample& sample, WheelDuty& duty);
+
+        /**
+         * @brief 没有反馈时的开环输出：只用前馈，不更新积分器
+         */
+        void feedforward(DesiredState target, WheelDuty& duty) const;
+
+        /**
+         * @brief 各轮测得的速度（边沿/秒，带方向）
+         */
+        std::array<int64_t, WHEEL_COUNT> measured_eps() const;
+
+    private:
+        const WheelSpeedConfig m_config;
+        const int32_t m_inner_q15;
+        WheelSpeedEstimator m_estimator;
+        std::array<FixedPointPi, WHEEL_COUNT> m_pi;
+        std::array<int32_t, WHEEL_COUNT> m_setpoints{};
+        Clock::time_point m_last_time{};
+        bool m_primed = false;
+    };
+}
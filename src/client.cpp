@@ -0,0 +1,364 @@
+#include "fpvcar_device_control/client.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fpvcar::device_control {
+
+const char* client_status_to_string(ClientStatus status) {
+    switch (status) {
+        case ClientStatus::OK: return "OK";
+        case ClientStatus::NOT_CONNECTED: return "NOT_CONNECTED";
+        case ClientStatus::DISCONNECTED: return "DISCONNECTED";
+        case ClientStatus::TIMEOUT: return "TIMEOUT";
+        case ClientStatus::STOPPED: return "STOPPED";
+        case ClientStatus::QUEUE_FULL: return "QUEUE_FULL";
+    }
+    return "UNKNOWN";
+}
+
+DeviceControlClient::DeviceControlClient(ClientOptions options)
+    : m_options(std::move(options)) {}
+
+DeviceControlClient::~DeviceControlClient() {
+    stop();
+}
+
+tl::expected<void, std::string> DeviceControlClient::start() {
+    if (m_running.load()) return {};
+    m_wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wake_fd < 0) {
+        return tl::unexpected(std::string("Failed to create eventfd: ") + std::strerror(errno));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_running.store(true);
+    }
+    // 第一次连接在调用线程中进行，服务端已运行时 start() 返回后即可发送
+    m_next_connect = std::chrono::steady_clock::now();
+    try_connect();
+    m_thread = std::thread([this]() { run(); });
+    return {};
+}
+
+void DeviceControlClient::stop() {
+    {
+        // 与 send() 互斥：此后不会再有请求进入队列
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        if (!m_running.exchange(false)) return;
+    }
+    uint64_t one = 1;
+    ssize_t n = ::write(m_wake_fd, &one, sizeof(one));
+    (void)n;
+    if (m_thread.joinable()) m_thread.join();
+
+    // I/O 线程退出时已交付所有在途请求，这里交付仍在排队的请求
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_batch.swap(m_queue);
+    }
+    for (Pending& pending : m_batch) deliver(pending, ClientStatus::STOPPED, {});
+    m_batch.clear();
+    ::close(m_wake_fd);
+    m_wake_fd = -1;
+}
+
+bool DeviceControlClient::send(std::string_view request, ResponseCallback callback) {
+    // 先占用一个名额，超过上限立即拒绝（不阻塞调用方）
+    if (m_outstanding.fetch_add(1, std::memory_order_relaxed) >= m_options.max_pending) {
+        m_outstanding.fetch_sub(1, std::memory_order_relaxed);
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        if (!m_running.load(std::memory_order_relaxed)) {
+            m_outstanding.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_queue.push_back(Pending{std::string(request), std::move(callback), std::chrono::steady_clock::now()});
+        // 队列从空变为非空时才需要唤醒，I/O 线程一次取走整个队列
+        wake = m_queue.size() == 1;
+    }
+    m_submitted.fetch_add(1, std::memory_order_relaxed);
+    if (wake) {
+        uint64_t one = 1;
+        ssize_t n = ::write(m_wake_fd, &one, sizeof(one));
+        (void)n;
+    }
+    return true;
+}
+
+std::future<ClientResult> DeviceControlClient::request(std::string_view request) {
+    auto promise = std::make_shared<std::promise<ClientResult>>();
+    std::future<ClientResult> future = promise->get_future();
+    if (!send(request, [promise](const ClientResult& result) { promise->set_value(result); })) {
+        ClientResult result;
+        result.status = m_running.load() ? ClientStatus::QUEUE_FULL : ClientStatus::STOPPED;
+        promise->set_value(std::move(result));
+    }
+    return future;
+}
+
+bool DeviceControlClient::command(std::string_view action, int ttl_ms, ResponseCallback callback) {
+    // action 为指令名称（不含需要转义的字符），直接拼接
+    std::string request;
+    request.reserve(48 + action.size());
+    request.append("{\"action\":\"").append(action.data(), action.size()).append("\"");
+    if (ttl_ms > 0) request.append(",\"ttl_ms\":").append(std::to_string(ttl_ms));
+    request.append("}");
+    return send(request, std::move(callback));
+}
+
+bool DeviceControlClient::wait_connected(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_connected_mutex);
+    return m_connected_cv.wait_for(lock, timeout, [this]() { return m_connected.load(); });
+}
+
+ClientStats DeviceControlClient::stats() const {
+    ClientStats stats;
+    stats.submitted = m_submitted.load(std::memory_order_relaxed);
+    stats.completed = m_completed.load(std::memory_order_relaxed);
+    stats.failed = m_failed.load(std::memory_order_relaxed);
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.reconnects = m_reconnects.load(std::memory_order_relaxed);
+    stats.connected = m_connected.load(std::memory_order_relaxed);
+    stats.max_latency_ns = m_max_latency_ns.load(std::memory_order_relaxed);
+    if (stats.completed > 0) {
+        stats.mean_latency_ns = m_latency_sum_ns.load(std::memory_order_relaxed) / static_cast<int64_t>(stats.completed);
+    }
+
+    // 由直方图计算分位数（取桶的上界）
+    std::array<uint64_t, LATENCY_BUCKETS> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        counts[i] = m_latency_histogram[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    const int64_t bucket_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(LATENCY_BUCKET).count();
+    auto percentile = [&](double p) -> int64_t {
+        if (total == 0) return 0;
+        const uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return i + 1 < LATENCY_BUCKETS ? static_cast<int64_t>(i + 1) * bucket_ns : stats.max_latency_ns;
+        }
+        return stats.max_latency_ns;
+    };
+    stats.p50_latency_ns = percentile(50.0);
+    stats.p99_latency_ns = percentile(99.0);
+    stats.p999_latency_ns = percentile(99.9);
+    return stats;
+}
+
+void DeviceControlClient::run() {
+    while (m_running.load(std::memory_order_relaxed)) {
+        auto now = std::chrono::steady_clock::now();
+        if (m_fd < 0 && now >= m_next_connect) try_connect();
+
+        // 等待超时：未连接时到下一次重连，有在途请求时到最早请求的响应期限
+        int timeout_ms = -1;
+        auto until = [&now](SteadyTime deadline) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+            return static_cast<int>(std::max<int64_t>(0, left));
+        };
+        if (m_fd < 0) {
+            timeout_ms = until(m_next_connect);
+        } else if (!m_in_flight.empty()) {
+            timeout_ms = until(m_in_flight.front().submitted + m_options.response_timeout);
+        }
+
+        pollfd fds[2];
+        fds[0] = {m_wake_fd, POLLIN, 0};
+        fds[1] = {m_fd, static_cast<short>(POLLIN | (m_output_offset < m_output.size() ? POLLOUT : 0)), 0};
+        if (::poll(fds, m_fd >= 0 ? 2 : 1, timeout_ms) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: Client poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        // 1. 新请求或 stop()
+        if (fds[0].revents & POLLIN) {
+            uint64_t value = 0;
+            ssize_t n = ::read(m_wake_fd, &value, sizeof(value));
+            (void)n;
+            if (!m_running.load(std::memory_order_relaxed)) break;
+            dispatch_queued();
+        }
+
+        // 2. 响应与剩余的发送数据
+        if (m_fd >= 0 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) && !read_responses()) {
+            disconnect(ClientStatus::DISCONNECTED);
+        }
+        if (m_fd >= 0 && m_output_offset < m_output.size() && !flush_output()) {
+            disconnect(ClientStatus::DISCONNECTED);
+        }
+
+        // 3. 响应超时：最早的请求以 TIMEOUT 交付，其余随断开交付
+        now = std::chrono::steady_clock::now();
+        if (m_fd >= 0 && !m_in_flight.empty() && now >= m_in_flight.front().submitted + m_options.response_timeout) {
+            deliver(m_in_flight.front(), ClientStatus::TIMEOUT, {});
+            m_in_flight.pop_front();
+            disconnect(ClientStatus::DISCONNECTED);
+        }
+    }
+    if (m_fd >= 0) {
+        disconnect(ClientStatus::STOPPED);
+    }
+}
+
+bool DeviceControlClient::try_connect() {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd >= 0) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", m_options.socket_path.c_str());
+        // Unix 套接字的 connect 不会进入 EINPROGRESS：要么立即成功，要么失败（监听队列满时为 EAGAIN）
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) {
+        // 退避：每次失败翻倍，收到响应后复位
+        m_backoff = m_backoff.count() == 0 ? m_options.reconnect_min : std::min(m_backoff * 2, m_options.reconnect_max);
+        m_next_connect = std::chrono::steady_clock::now() + m_backoff;
+        return false;
+    }
+
+    m_fd = fd;
+    if (m_ever_connected) m_reconnects.fetch_add(1, std::memory_order_relaxed);
+    m_ever_connected = true;
+    {
+        std::lock_guard<std::mutex> lock(m_connected_mutex);
+        m_connected.store(true);
+    }
+    m_connected_cv.notify_all();
+    return true;
+}
+
+void DeviceControlClient::disconnect(ClientStatus in_flight_status) {
+    ::close(m_fd);
+    m_fd = -1;
+    m_connected.store(false);
+    m_output.clear();
+    m_output_offset = 0;
+    m_input.clear();
+    // 已发送的请求不补发：它们可能已经执行，也可能已经过时
+    while (!m_in_flight.empty()) {
+        deliver(m_in_flight.front(), in_flight_status, {});
+        m_in_flight.pop_front();
+    }
+    // 连接被服务端关闭时不立即重连，避免对反复断开的服务端形成重连风暴
+    m_backoff = m_backoff.count() == 0 ? m_options.reconnect_min : std::min(m_backoff * 2, m_options.reconnect_max);
+    m_next_connect = std::chrono::steady_clock::now() + m_backoff;
+}
+
+void DeviceControlClient::dispatch_queued() {
+    {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        m_batch.swap(m_queue);
+    }
+    for (Pending& pending : m_batch) {
+        if (m_fd < 0) {
+            deliver(pending, ClientStatus::NOT_CONNECTED, {});
+            continue;
+        }
+        ipc::append_frame(m_output, pending.request);
+        m_in_flight.push_back(std::move(pending));
+    }
+    m_batch.clear();
+    // 一批请求合并为尽量少的 send 调用
+    if (m_fd >= 0 && m_output_offset < m_output.size() && !flush_output()) {
+        disconnect(ClientStatus::DISCONNECTED);
+    }
+}
+
+bool DeviceControlClient::flush_output() {
+    while (m_output_offset < m_output.size()) {
+        ssize_t n = ::send(m_fd, m_output.data() + m_output_offset, m_output.size() - m_output_offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true; // 发送缓冲区满，等 POLLOUT
+            return false;
+        }
+        m_output_offset += static_cast<size_t>(n);
+    }
+    m_output.clear();
+    m_output_offset = 0;
+    return true;
+}
+
+bool DeviceControlClient::read_responses() {
+    char chunk[16384];
+    bool open = true;
+    while (true) {
+        ssize_t n = ::recv(m_fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            open = false;
+            break;
+        }
+        if (n == 0) {
+            // 服务端关闭连接：先交付已经收到的响应
+            open = false;
+            break;
+        }
+        m_input.append(chunk, static_cast<size_t>(n));
+    }
+
+    size_t offset = 0;
+    m_frames.clear();
+    const bool valid = ipc::split_frames(m_input, offset, m_frames);
+    for (std::string_view frame : m_frames) {
+        // 没有对应请求的帧（例如误发 subscribe 后的推送）说明响应已无法对应，断开
+        if (m_in_flight.empty()) return false;
+        deliver(m_in_flight.front(), ClientStatus::OK, frame);
+        m_in_flight.pop_front();
+    }
+    m_input.erase(0, offset);
+    if (!m_frames.empty()) m_backoff = std::chrono::milliseconds(0);
+    return valid && open;
+}
+
+void DeviceControlClient::deliver(Pending& pending, ClientStatus status, std::string_view response) {
+    ClientResult result;
+    result.status = status;
+    result.response.assign(response.data(), response.size());
+    result.latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - pending.submitted).count();
+
+    if (status == ClientStatus::OK) {
+        // 统计只由 I/O 线程写入（stop() 交付排队请求时 I/O 线程已退出），读取方只需要看到最终值
+        const size_t bucket = std::min<size_t>(static_cast<size_t>(result.latency_ns / std::chrono::duration_cast<std::chrono::nanoseconds>(LATENCY_BUCKET).count()),
+                                               LATENCY_BUCKETS - 1);
+        m_latency_histogram[bucket].store(m_latency_histogram[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_latency_sum_ns.store(m_latency_sum_ns.load(std::memory_order_relaxed) + result.latency_ns, std::memory_order_relaxed);
+        if (result.latency_ns > m_max_latency_ns.load(std::memory_order_relaxed)) m_max_latency_ns.store(result.latency_ns, std::memory_order_relaxed);
+        m_completed.store(m_completed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+        m_failed.store(m_failed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    // 先释放名额，回调中可以立即提交新请求
+    m_outstanding.fetch_sub(1, std::memory_order_relaxed);
+    if (!pending.callback) return;
+    try {
+        pending.callback(result);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Client response callback threw: " << e.what() << std::endl;
+    }
+}
+
+}
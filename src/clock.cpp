@@ -0,0 +1,100 @@
+#include "fpvcar_device_control/clock.hpp"
+#include <algorithm>
+
+namespace fpvcar::device_control {
+
+// ---------------- SteadyClock ----------------
+
+SteadyClock& SteadyClock::instance() {
+    static SteadyClock clock;
+    return clock;
+}
+
+void SteadyClock::sleep_until(time_point deadline) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t generation = m_generation;
+    m_cv.wait_until(lock, deadline, [this, generation]() { return m_generation != generation; });
+}
+
+void SteadyClock::wake_all() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+    }
+    m_cv.notify_all();
+}
+
+// ---------------- VirtualClock ----------------
+
+VirtualClock::VirtualClock(time_point start) : m_now(start) {}
+
+Clock::time_point VirtualClock::now() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_now;
+}
+
+void VirtualClock::sleep_until(time_point deadline) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (deadline <= m_now) return;
+
+    Sleeper sleeper;
+    m_sleepers.emplace(deadline, &sleeper);
+    --m_active;
+    m_idle_cv.notify_all();
+    // 唤醒方（advance_to / wake_all）负责移除登记并把本线程重新计入 m_active，
+    // 这样驱动方在本线程真正恢复运行之前不会继续推进时间
+    m_sleepers_cv.wait(lock, [&sleeper]() { return sleeper.woken; });
+}
+
+void VirtualClock::wake_all() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& [deadline, sleeper] : m_sleepers) {
+            sleeper->woken = true;
+            ++m_active;
+        }
+        m_sleepers.clear();
+    }
+    m_sleepers_cv.notify_all();
+}
+
+void VirtualClock::register_thread() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_active;
+}
+
+void VirtualClock::unregister_thread() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_active;
+    }
+    m_idle_cv.notify_all();
+}
+
+void VirtualClock::wait_idle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this]() { return m_active <= 0; });
+}
+
+void VirtualClock::advance_to(time_point target) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        // 等待上一步唤醒的线程全部重新休眠
+        m_idle_cv.wait(lock, [this]() { return m_active <= 0; });
+        if (m_sleepers.empty() || m_sleepers.begin()->first > target) {
+            m_now = std::max(m_now, target);
+            return;
+        }
+
+        // 跳到最早的截止时间，唤醒所有在该时间到期的线程
+        m_now = std::max(m_now, m_sleepers.begin()->first);
+        while (!m_sleepers.empty() && m_sleepers.begin()->first <= m_now) {
+            m_sleepers.begin()->second->woken = true;
+            ++m_active;
+            m_sleepers.erase(m_sleepers.begin());
+        }
+        m_sleepers_cv.notify_all();
+    }
+}
+
+}
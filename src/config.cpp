@@ -26,9 +26,100 @@ tl::expected<AppConfig, std::string> load_config(const std::string& file_path) {
     
     // 读取可选配置项，如果不存在则使用默认值
     cfg.ipc_socket_path = j.value("ipc_socket_path", cfg.ipc_socket_path);
+    cfg.takeover_socket_path = j.value("takeover_socket_path", cfg.takeover_socket_path);
+    cfg.estop_socket_path = j.value("estop_socket_path", cfg.estop_socket_path);
+    cfg.ipc_backend = j.value("ipc_backend", cfg.ipc_backend);
+    if (cfg.ipc_backend != "blocking" && cfg.ipc_backend != "io_uring") {
+        return tl::unexpected(std::string("Invalid 'ipc_backend' (expected \"blocking\" or \"io_uring\"): ") + cfg.ipc_backend);
+    }
+    cfg.ipc_rate_limit_hz = j.value("ipc_rate_limit_hz", cfg.ipc_rate_limit_hz);
+    cfg.ipc_rate_limit_burst = j.value("ipc_rate_limit_burst", cfg.ipc_rate_limit_burst);
+    if (cfg.ipc_rate_limit_hz < 0.0 || cfg.ipc_rate_limit_burst < 1.0) {
+        return tl::unexpected(std::string("Invalid 'ipc_rate_limit_hz' or 'ipc_rate_limit_burst' (expected rate >= 0 and burst >= 1)"));
+    }
+    cfg.udp_port = j.value("udp_port", cfg.udp_port);
+    cfg.udp_bind_address = j.value("udp_bind_address", cfg.udp_bind_address);
+    cfg.udp_max_delay_ms = j.value("udp_max_delay_ms", cfg.udp_max_delay_ms);
+    if (cfg.udp_max_delay_ms == 0) {
+        return tl::unexpected(std::string("Invalid 'udp_max_delay_ms' (expected > 0)"));
+    }
     cfg.i2c_device_path = j.value("i2c_device_path", cfg.i2c_device_path);
     cfg.pwm_frequency = j.value("pwm_frequency", cfg.pwm_frequency);
-    
+    cfg.pca9685_address = j.value("pca9685_address", cfg.pca9685_address);
+    cfg.motor_driver = j.value("motor_driver", cfg.motor_driver);
+    if (cfg.motor_driver != "fpvcar-motor" && cfg.motor_driver != "pca9685") {
+        return tl::unexpected(std::string("Invalid 'motor_driver' (expected \"fpvcar-motor\" or \"pca9685\"): ") + cfg.motor_driver);
+    }
+    cfg.i2c_bus_speed_hz = j.value("i2c_bus_speed_hz", cfg.i2c_bus_speed_hz);
+    if (cfg.i2c_bus_speed_hz != 100000 && cfg.i2c_bus_speed_hz != 400000 && cfg.i2c_bus_speed_hz != 1000000) {
+        return tl::unexpected(std::string("Invalid 'i2c_bus_speed_hz' (expected 100000, 400000 or 1000000): ") + std::to_string(cfg.i2c_bus_speed_hz));
+    }
+    cfg.diagnostics_dir = j.value("diagnostics_dir", cfg.diagnostics_dir);
+    cfg.trace_enabled = j.value("trace_enabled", cfg.trace_enabled);
+    cfg.flight_recorder_enabled = j.value("flight_recorder_enabled", cfg.flight_recorder_enabled);
+    cfg.flight_recorder_path = j.value("flight_recorder_path", cfg.flight_recorder_path);
+    const std::string lease_safe_state = j.value("lease_safe_state", std::string("stopAll"));
+    const auto safe_state = desired_state_from_action(lease_safe_state);
+    if (!safe_state) {
+        return tl::unexpected(std::string("Invalid 'lease_safe_state' (expected an action name such as \"stopAll\"): ") + lease_safe_state);
+    }
+    cfg.lease_safe_state = *safe_state;
+    cfg.telemetry_rate_hz = j.value("telemetry_rate_hz", cfg.telemetry_rate_hz);
+    if (cfg.telemetry_rate_hz < 0.0 || cfg.telemetry_rate_hz > 1000.0) {
+        return tl::unexpected(std::string("Invalid 'telemetry_rate_hz' (expected 0 to 1000): ") + std::to_string(cfg.telemetry_rate_hz));
+    }
+    cfg.telemetry_max_subscribers = j.value("telemetry_max_subscribers", cfg.telemetry_max_subscribers);
+    if (cfg.telemetry_max_subscribers == 0) {
+        return tl::unexpected(std::string("Invalid 'telemetry_max_subscribers' (expected a positive integer)"));
+    }
+
+    // 电机调用故障处理策略
+    MotorFaultPolicy& fault = cfg.motor_fault_policy;
+    fault.call_timeout = std::chrono::milliseconds(j.value("motor_call_timeout_ms", static_cast<int64_t>(fault.call_timeout.count())));
+    fault.max_backoff = std::chrono::milliseconds(j.value("motor_max_backoff_ms", static_cast<int64_t>(fault.max_backoff.count())));
+    fault.reinit_after_failures = j.value("motor_reinit_after_failures", fault.reinit_after_failures);
+    fault.degraded_after_failures = j.value("motor_degraded_after_failures", fault.degraded_after_failures);
+    fault.max_cpu_share = j.value("motor_fault_cpu_share", fault.max_cpu_share);
+    if (fault.call_timeout.count() <= 0 || fault.max_backoff < fault.initial_backoff) {
+        return tl::unexpected(std::string("Invalid 'motor_call_timeout_ms' or 'motor_max_backoff_ms' (expected positive values, max backoff >= ") +
+                              std::to_string(fault.initial_backoff.count()) + " ms)");
+    }
+    if (fault.degraded_after_failures == 0) {
+        return tl::unexpected(std::string("Invalid 'motor_degraded_after_failures' (expected a positive integer)"));
+    }
+    if (!(fault.max_cpu_share > 0.0 && fault.max_cpu_share <= 1.0)) {
+        return tl::unexpected(std::string("Invalid 'motor_fault_cpu_share' (expected a value in (0, 1]): ") + std::to_string(fault.max_cpu_share));
+    }
+
+    // 闭环轮速控制
+    WheelSpeedConfig& speed = cfg.wheel_speed;
+    speed.enabled = j.value("closed_loop_enabled", speed.enabled);
+    speed.rate_hz = j.value("closed_loop_rate_hz", speed.rate_hz);
+    speed.max_speed_eps = j.value("closed_loop_max_speed_eps", speed.max_speed_eps);
+    speed.kp = j.value("closed_loop_kp", speed.kp);
+    speed.ki = j.value("closed_loop_ki", speed.ki);
+    speed.feedforward = j.value("closed_loop_feedforward", speed.feedforward);
+    if (!(speed.rate_hz > 0.0 && speed.rate_hz <= 1000.0)) {
+        return tl::unexpected(std::string("Invalid 'closed_loop_rate_hz' (expected a value in (0, 1000]): ") + std::to_string(speed.rate_hz));
+    }
+    if (speed.max_speed_eps < 1.0 || speed.kp < 0.0 || speed.ki < 0.0 || speed.feedforward < 0.0 || speed.feedforward > 1.0) {
+        return tl::unexpected(std::string("Invalid closed loop parameters (expected closed_loop_max_speed_eps >= 1, "
+                                          "closed_loop_kp/closed_loop_ki >= 0 and closed_loop_feedforward in [0, 1])"));
+    }
+    cfg.encoder_gpio_chip = j.value("encoder_gpio_chip", cfg.encoder_gpio_chip);
+    if (j.contains("encoder_gpio_lines")) {
+        const auto& lines = j["encoder_gpio_lines"];
+        if (!lines.is_array() || lines.size() != WHEEL_COUNT) {
+            return tl::unexpected(std::string("Invalid 'encoder_gpio_lines' (expected an array of 4 line offsets: FL, FR, BL, BR)"));
+        }
+        for (size_t i = 0; i < WHEEL_COUNT; ++i) {
+            if (!lines[i].is_number_unsigned()) {
+                return tl::unexpected(std::string("Invalid 'encoder_gpio_lines' (expected non-negative integers)"));
+            }
+            cfg.encoder_gpio_lines[i] = lines[i].get<uint32_t>();
+        }
+    }
+
     // 解析PCA9685地址（可以是整数或十六进制字符串）
     if (j.contains("pca9685_address")) {
         if (j["pca9685_address"].is_number()) {
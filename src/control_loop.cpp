@@ -1,29 +1,94 @@
 #include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/trace.hpp"
+#include "fpvcar_device_control/flight_recorder.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream> // 用于打印状态和错误
+#include <sys/prctl.h>
 
 namespace fpvcar::device_control {
 
-ControlLoop::ControlLoop(DesiredStateManager& desired_state_manager, control::FpvCarController& car)
+ControlLoop::ControlLoop(DesiredStateManager& desired_state_manager, MotorBackend& car,
+                         DesiredState lease_safe_state, const MotorFaultPolicy& fault_policy, Clock& clock)
     : m_desired_state_manager(desired_state_manager),
       m_car(car),
+      m_clock(clock),
       m_old_desired_state(DesiredState::STOPPING), // <--- 正确初始化
+      m_lease_safe_state(lease_safe_state),
       m_is_running(false), // <--- 构造时为 false
-      m_watchdog(std::chrono::milliseconds(5000), car, desired_state_manager)
+      m_watchdog(WATCHDOG_TIMEOUT, car, m_actuation_mutex, desired_state_manager, clock),
+      m_fault_guard(car, clock, fault_policy)
 {}
 
 ControlLoop::~ControlLoop() {
     stop(); // 确保在对象销毁时，线程被正确停止和 join
 }
 
+void ControlLoop::set_wheel_speed_control(WheelFeedback& feedback, const WheelSpeedConfig& config) {
+    const double rate_hz = std::clamp(config.rate_hz, 1.0, 1000.0);
+    m_target_interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate_hz));
+    m_feedback = &feedback;
+    m_speed_controller = std::make_unique<WheelSpeedController>(config);
+    std::cout << "Closed-loop wheel speed control at " << rate_hz << " Hz" << std::endl;
+}
+
+TickTimingStats ControlLoop::tick_timing() const {
+    TickTimingStats stats;
+    stats.intervals = m_intervals.load(std::memory_order_relaxed);
+    stats.target_interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(m_target_interval).count();
+    stats.mean_interval_ns = stats.intervals > 0
+        ? m_interval_sum_ns.load(std::memory_order_relaxed) / static_cast<int64_t>(stats.intervals) : 0;
+    stats.max_jitter_ns = m_max_jitter_ns.load(std::memory_order_relaxed);
+    stats.overruns = m_overruns.load(std::memory_order_relaxed);
+
+    // 由直方图计算分位数（取桶的上界）
+    std::array<uint64_t, JITTER_BUCKETS> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < JITTER_BUCKETS; ++i) {
+        counts[i] = m_jitter_histogram[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    const int64_t bucket_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(JITTER_BUCKET).count();
+    auto percentile = [&](double p) -> int64_t {
+        if (total == 0) return 0;
+        const uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < JITTER_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return i + 1 < JITTER_BUCKETS ? static_cast<int64_t>(i + 1) * bucket_ns : stats.max_jitter_ns;
+        }
+        return stats.max_jitter_ns;
+    };
+    stats.jitter_p50_ns = percentile(50.0);
+    stats.jitter_p99_ns = percentile(99.0);
+    stats.jitter_p999_ns = percentile(99.9);
+    return stats;
+}
+
 void ControlLoop::start() {
     // 使用 exchange 来原子性地检查并设置 m_is_running
     // 防止重复调用 start
     if (m_is_running.exchange(true)) {
         return; // 如果已经是 true, 说明已启动, 直接返回
     }
+    m_has_last_tick = false;
     // 启动看门狗
     m_watchdog.start();
-    // 启动新线程
+    // 启动新线程（先在时钟上登记，虚拟时钟据此等待本线程休眠后再推进时间）
+    m_clock.register_thread();
+    m_loop_thread = std::thread(&ControlLoop::run_loop, this);
+}
+
+void ControlLoop::start(const ControlLoopResumeState& resume) {
+    if (m_is_running.exchange(true)) {
+        return;
+    }
+    // 电机仍保持旧进程执行的状态；第一次循环无条件重新下发，保证硬件与期望状态一致
+    m_old_desired_state = resume.applied_state;
+    m_reapply = true;
+    m_has_last_tick = false;
+    m_watchdog.start(resume.watchdog);
+    m_clock.register_thread();
     m_loop_thread = std::thread(&ControlLoop::run_loop, this);
 }
 
@@ -33,9 +98,16 @@ void ControlLoop::stop() {
         return; // 如果已经是 false, 说明已停止, 直接返回
     }
     m_watchdog.stop();
+    // 打断循环线程的休眠，使其立即看到停止标志
+    m_clock.wake_all();
 
     // [安全措施] 立即停止车辆，而不是等待循环下一次迭代
-    m_car.stopAll();
+    try {
+        std::lock_guard<PiMutex> lock(m_actuation_mutex);
+        m_car.stopAll();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Failed to stop motors: " << e.what() << std::endl;
+    }
 
     // 等待循环线程结束
     if (m_loop_thread.joinable()) {
@@ -44,78 +116,303 @@ void ControlLoop::stop() {
     std::cout << "Control loop stopped." << std::endl;
 }
 
+ControlLoopResumeState ControlLoop::detach() {
+    if (m_is_running.exchange(false)) {
+        // 与 stop() 相同，但不调用 stopAll：电机保持当前输出，由新进程继续控制
+        m_watchdog.stop();
+        m_clock.wake_all();
+        if (m_loop_thread.joinable()) {
+            m_loop_thread.join();
+        }
+        std::cout << "Control loop detached." << std::endl;
+    }
+    ControlLoopResumeState state;
+    state.applied_state = m_old_desired_state;
+    state.watchdog = m_watchdog.state();
+    return state;
+}
+
+bool ControlLoop::emergency_stop() {
+    std::lock_guard<PiMutex> lock(m_actuation_mutex);
+    m_desired_state_manager.set_desired_state(DesiredState::STOPPING);
+    m_estops.fetch_add(1, std::memory_order_relaxed);
+    try {
+        m_car.stopAll();
+    } catch (const std::exception& e) {
+        recorder::record(recorder::EventType::ESTOP, 0, 1);
+        std::cerr << "Error: Emergency stop failed to stop motors: " << e.what() << std::endl;
+        return false;
+    }
+    recorder::record(recorder::EventType::ESTOP);
+    return true;
+}
+
 void ControlLoop::feed_watchdog() {
     m_watchdog.feed();
 }
 
 void ControlLoop::run_loop() {
+    // 控制线程的定时器余量从默认的 50us 降到 10us，减小高频闭环时的唤醒抖动
+    ::prctl(PR_SET_TIMERSLACK, 10000UL, 0UL, 0UL, 0UL);
     // 重置循环的起始时间
-    m_next_loop_start_time = std::chrono::steady_clock::now();
+    m_next_loop_start_time = m_clock.now();
+
+    // 电机调用经故障处理层执行；实际发起的调用连同耗时写入飞行记录
+    auto motor_call = [this](DesiredState state, auto&& call) {
+        const bool record = recorder::is_enabled() && m_clock.now() >= m_fault_guard.next_attempt();
+        const uint64_t start = record ? recorder::now_ns() : 0;
+        const bool ok = m_fault_guard.run(call);
+        if (record) {
+            recorder::record_motor_call(state, ok ? recorder::MotorCallResult::OK : recorder::MotorCallResult::FAILED,
+                                        recorder::now_ns() - start);
+        }
+        return ok;
+    };
 
     while (m_is_running.load(std::memory_order_relaxed)) {
+        Clock::time_point wake_time;
         try {
+            auto now = m_clock.now();
+            // 因租约到期提前醒来时不算一个周期
+            const bool tick = now >= m_next_loop_start_time;
+            if (tick) record_tick(now);
+
+            // 执行锁：从读取期望状态到电机调用完成，emergency_stop() 不能插入其间
+            std::unique_lock<PiMutex> actuation(m_actuation_mutex);
+
+            // --- 0. 检查指令租约 ---
+            // 租约到期且期间没有新指令时切换到安全状态；expire_lease 在锁内比较到期时间，不会覆盖刚到达的新指令
+            LeaseTimePoint lease_deadline = m_desired_state_manager.get_lease_deadline();
+            if (lease_deadline != NO_LEASE && now >= lease_deadline) {
+                if (m_desired_state_manager.expire_lease(lease_deadline, m_lease_safe_state)) {
+                    ++m_lease_expiries;
+                    recorder::record(recorder::EventType::LEASE_EXPIRY, static_cast<uint8_t>(m_lease_safe_state));
+                    std::cerr << "Warning: Command lease expired, falling back to safe state" << std::endl;
+                }
+            }
+
             // --- 1. 获取状态 (安全地) ---
             DesiredState desired_state = m_desired_state_manager.get_desired_state();
+            // 降级模式下不执行运动指令，只保持停车
+            const DesiredState target_state = m_fault_guard.degraded() ? DesiredState::STOPPING : desired_state;
 
             // --- 2. 检查状态变更 ---
-            if (desired_state != m_old_desired_state) {
-                m_old_desired_state = desired_state;
-                switch (desired_state) {
-                    case DesiredState::MOVING_FORWARD:
-                        std::cout << "Moving forward" << std::endl;
-                        m_car.moveForward();
-                        break;
-                    case DesiredState::MOVING_BACKWARD:
-                        std::cout << "Moving backward" << std::endl;
-                        m_car.moveBackward();
-                        break;
-                    case DesiredState::TURNING_LEFT:
-                        std::cout << "Turning left" << std::endl;
-                        m_car.turnLeft();
-                        break;
-                    case DesiredState::TURNING_RIGHT:
-                        std::cout << "Turning right" << std::endl;
-                        m_car.turnRight();
-                        break;
-                    case DesiredState::MOVING_FORWARD_AND_TURN_LEFT:
-                        std::cout << "Moving forward and turning left" << std::endl;
-                        m_car.moveForwardAndTurnLeft();
-                        break;
-                    case DesiredState::MOVING_FORWARD_AND_TURN_RIGHT:
-                        std::cout << "Moving forward and turning right" << std::endl;
-                        m_car.moveForwardAndTurnRight();
-                        break;
-                    case DesiredState::MOVING_BACKWARD_AND_TURN_LEFT:
-                        std::cout << "Moving backward and turning left" << std::endl;
-                        m_car.moveBackwardAndTurnLeft();
-                        break;
-                    case DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT:
-                        std::cout << "Moving backward and turning right" << std::endl;
-                        m_car.moveBackwardAndTurnRight();
-                        break;
-                    case DesiredState::STOPPING:
-                        std::cout << "Stopping" << std::endl;
-                        m_car.stopAll();
-                        break;
+            // 只有调用成功后才更新 m_old_desired_state，失败的指令会在退避期结束后重试
+            // 降级模式下即使上次执行的已是停车，也按退避间隔重复停车调用：只有调用成功才能退出降级
+            const bool retry_stop = m_fault_guard.degraded();
+            bool state_changed = false;
+            const DesiredState previous_state = m_old_desired_state;
+            if (m_speed_controller && target_state != DesiredState::STOPPING) {
+                // 闭环：运动状态下每个周期都按编码器反馈更新占空比；状态变更时立即更新，不等下一个周期
+                if (tick || target_state != m_old_desired_state || m_reapply) {
+                    if (motor_call(target_state, [this, target_state]() { apply_wheel_speed(target_state); })) {
+                        state_changed = target_state != m_old_desired_state;
+                        if (state_changed) std::cout << "Closed-loop " << desired_state_to_action(target_state) << std::endl;
+                        m_old_desired_state = target_state;
+                        m_reapply = false;
+                    }
+                }
+            } else if (target_state != m_old_desired_state || m_reapply || retry_stop) {
+                // 追踪：把本次状态变更关联到最近一次写入期望状态的请求
+                const uint64_t request_id = trace::is_enabled() ? m_desired_state_manager.get_request_id() : 0;
+                if (motor_call(target_state, [this, target_state, request_id]() { apply_state(target_state, request_id); })) {
+                    state_changed = target_state != m_old_desired_state;
+                    m_old_desired_state = target_state;
+                    m_reapply = false;
+                    // 停车后闭环控制器从零开始（积分器与速度历史不再有效）
+                    if (m_speed_controller) {
+                        m_speed_controller->reset();
+                        m_duty.fill(0);
+                    }
                 }
             }
+
+            actuation.unlock();
+            if (state_changed) recorder::record_state(target_state, previous_state, m_ticks);
+
+            // 刚进入降级模式：清除期望状态，总线恢复后需要新的指令才会再次运动
+            const bool degraded = m_fault_guard.degraded();
+            if (degraded && !m_was_degraded) {
+                m_desired_state_manager.set_desired_state(DesiredState::STOPPING);
+            }
+            const bool degraded_changed = degraded != m_was_degraded;
+            if (degraded_changed) recorder::record(recorder::EventType::FAULT, 0, degraded ? 1 : 0);
+            m_was_degraded = degraded;
+
+            // --- 2.5 发布遥测快照：状态变更、看门狗停车或降级状态变化时通知订阅推送线程 ---
+            const uint64_t watchdog_trips = m_watchdog.trips();
+            publish_telemetry(desired_state, state_changed || degraded_changed || watchdog_trips != m_last_watchdog_trips);
+            m_last_watchdog_trips = watchdog_trips;
+
             // --- 3. 固定周期休眠 ---
-            m_next_loop_start_time += m_target_interval;
-
-            // "掉帧"检测
-            auto now = std::chrono::steady_clock::now();
-            if (now > m_next_loop_start_time) {
-                std::cerr << "Warning: Control loop is overloaded (missed interval)!" << std::endl;
-                // 如果工作时间超过了间隔, 立即开始下一次循环
-                // 并且把下次启动时间重置为 "当前时间 + 间隔"
-                m_next_loop_start_time = now + m_target_interval;
+            // 因租约到期提前醒来时不推进周期
+            if (tick) {
+                ++m_ticks;
+                m_next_loop_start_time += m_target_interval;
+
+                // "掉帧"检测
+                now = m_clock.now();
+                if (now > m_next_loop_start_time) {
+                    const uint64_t overruns = m_overruns.fetch_add(1, std::memory_order_relaxed) + 1;
+                    recorder::record_overrun(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_next_loop_start_time).count(), m_ticks);
+                    // 高频闭环时掉帧可能连续发生，告警每秒最多打印一次
+                    if (now >= m_next_overrun_report) {
+                        std::cerr << "Warning: Control loop is overloaded (missed " << (overruns - m_reported_overruns)
+                                  << " interval(s))!" << std::endl;
+                        m_reported_overruns = overruns;
+                        m_next_overrun_report = now + std::chrono::seconds(1);
+                    }
+                    // 如果工作时间超过了间隔, 立即开始下一次循环
+                    // 并且把下次启动时间重置为 "当前时间 + 间隔"
+                    m_next_loop_start_time = now + m_target_interval;
+                }
             }
 
-            std::this_thread::sleep_until(m_next_loop_start_time);
+            // 租约在下一个周期之前到期时，在到期时刻醒来
+            lease_deadline = m_desired_state_manager.get_lease_deadline();
+            wake_time = std::min(m_next_loop_start_time, lease_deadline);
         } catch (const std::exception& e) {
             std::cerr << "Error in control loop: " << e.what() << std::endl;
+            // 出错时同样按周期休眠，避免空转占满 CPU
+            m_next_loop_start_time = m_clock.now() + m_target_interval;
+            wake_time = m_next_loop_start_time;
+        }
+        m_clock.sleep_until(wake_time);
+    }
+    m_clock.unregister_thread();
+}
+
+void ControlLoop::record_tick(Clock::time_point now) {
+    if (m_has_last_tick) {
+        const int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last_tick_start).count();
+        const int64_t target = std::chrono::duration_cast<std::chrono::nanoseconds>(m_target_interval).count();
+        const int64_t jitter = interval > target ? interval - target : target - interval;
+        m_interval_ewma_ns += (interval - m_interval_ewma_ns) / 16;
+        m_jitter_ewma_ns += (jitter - m_jitter_ewma_ns) / 16;
+        // 统计只由本线程写入，读取方只需要看到最终值
+        const size_t bucket = std::min<size_t>(static_cast<size_t>(jitter / std::chrono::duration_cast<std::chrono::nanoseconds>(JITTER_BUCKET).count()),
+                                               JITTER_BUCKETS - 1);
+        m_jitter_histogram[bucket].store(m_jitter_histogram[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_intervals.store(m_intervals.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_interval_sum_ns.store(m_interval_sum_ns.load(std::memory_order_relaxed) + interval, std::memory_order_relaxed);
+        if (jitter > m_max_jitter_ns.load(std::memory_order_relaxed)) m_max_jitter_ns.store(jitter, std::memory_order_relaxed);
+    } else {
+        m_interval_ewma_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(m_target_interval).count();
+    }
+    m_last_tick_start = now;
+    m_has_last_tick = true;
+}
+
+void ControlLoop::apply_wheel_speed(DesiredState target_state) {
+    // 编码器读取失败时按前馈开环输出，不让车辆因为反馈中断而停在原地或失控
+    if (m_feedback->sample(m_encoder_sample)) {
+        m_speed_controller->update(target_state, m_encoder_sample, m_duty);
+    } else {
+        ++m_feedback_failures;
+        m_speed_controller->reset();
+        m_speed_controller->feedforward(target_state, m_duty);
+    }
+    m_car.set_wheel_duty(m_duty);
+}
+
+void ControlLoop::publish_telemetry(DesiredState desired_state, bool notify) {
+    TelemetrySnapshot snapshot;
+    snapshot.timestamp_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        m_clock.now().time_since_epoch()).count());
+    snapshot.applied_state = m_old_desired_state;
+    snapshot.desired_state = desired_state;
+    snapshot.ticks = m_ticks;
+    snapshot.overruns = m_overruns.load(std::memory_order_relaxed);
+    snapshot.watchdog_trips = m_watchdog.trips();
+    snapshot.lease_expiries = m_lease_expiries;
+    const MotorFaultStats faults = m_fault_guard.stats();
+    snapshot.motor_calls = faults.calls;
+    snapshot.motor_failures = faults.failures;
+    snapshot.motor_timeouts = faults.timeouts;
+    snapshot.motor_reinits = faults.reinits;
+    snapshot.motor_degraded = faults.degraded ? 1 : 0;
+    snapshot.estops = m_estops.load(std::memory_order_relaxed);
+    snapshot.tick_interval_ns = static_cast<uint64_t>(std::max<int64_t>(0, m_interval_ewma_ns));
+    snapshot.tick_jitter_ns = static_cast<uint64_t>(std::max<int64_t>(0, m_jitter_ewma_ns));
+    snapshot.tick_max_jitter_ns = static_cast<uint64_t>(m_max_jitter_ns.load(std::memory_order_relaxed));
+    if (m_speed_controller) {
+        snapshot.closed_loop = 1;
+        const auto speeds = m_speed_controller->measured_eps();
+        for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+            snapshot.wheel_speed_eps[w] = speeds[w];
+            snapshot.wheel_duty[w] = m_duty[w];
         }
     }
+    m_telemetry.publish(snapshot, notify);
+}
+
+void ControlLoop::apply_state(DesiredState desired_state, uint64_t request_id) {
+    trace::Span apply_span("ControlLoop::apply_state", request_id);
+    switch (desired_state) {
+        case DesiredState::MOVING_FORWARD:
+            std::cout << "Moving forward" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::moveForward", request_id);
+                m_car.moveForward();
+            }
+            break;
+        case DesiredState::MOVING_BACKWARD:
+            std::cout << "Moving backward" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::moveBackward", request_id);
+                m_car.moveBackward();
+            }
+            break;
+        case DesiredState::TURNING_LEFT:
+            std::cout << "Turning left" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::turnLeft", request_id);
+                m_car.turnLeft();
+            }
+            break;
+        case DesiredState::TURNING_RIGHT:
+            std::cout << "Turning right" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::turnRight", request_id);
+                m_car.turnRight();
+            }
+            break;
+        case DesiredState::MOVING_FORWARD_AND_TURN_LEFT:
+            std::cout << "Moving forward and turning left" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::moveForwardAndTurnLeft", request_id);
+                m_car.moveForwardAndTurnLeft();
+            }
+            break;
+        case DesiredState::MOVING_FORWARD_AND_TURN_RIGHT:
+            std::cout << "Moving forward and turning right" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::moveForwardAndTurnRight", request_id);
+                m_car.moveForwardAndTurnRight();
+            }
+            break;
+        case DesiredState::MOVING_BACKWARD_AND_TURN_LEFT:
+            std::cout << "Moving backward and turning left" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::moveBackwardAndTurnLeft", request_id);
+                m_car.moveBackwardAndTurnLeft();
+            }
+            break;
+        case DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT:
+            std::cout << "Moving backward and turning right" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::moveBackwardAndTurnRight", request_id);
+                m_car.moveBackwardAndTurnRight();
+            }
+            break;
+        case DesiredState::STOPPING:
+            std::cout << "Stopping" << std::endl;
+            {
+                trace::Span call_span("FpvCarController::stopAll", request_id);
+                m_car.stopAll();
+            }
+            break;
+    }
 }
 
 }// namespace fpvcar::device_control
\ No newline at end of file
@@ -1,8 +1,39 @@
 #include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/trace.hpp"
+#include <algorithm>
 
 
 namespace fpvcar::device_control {
-DesiredStateManager::DesiredStateManager() {
+
+std::optional<DesiredState> desired_state_from_action(std::string_view action) {
+    if (action == "moveForward") return DesiredState::MOVING_FORWARD;
+    if (action == "moveBackward") return DesiredState::MOVING_BACKWARD;
+    if (action == "turnLeft") return DesiredState::TURNING_LEFT;
+    if (action == "turnRight") return DesiredState::TURNING_RIGHT;
+    if (action == "moveForwardAndTurnLeft") return DesiredState::MOVING_FORWARD_AND_TURN_LEFT;
+    if (action == "moveForwardAndTurnRight") return DesiredState::MOVING_FORWARD_AND_TURN_RIGHT;
+    if (action == "moveBackwardAndTurnLeft") return DesiredState::MOVING_BACKWARD_AND_TURN_LEFT;
+    if (action == "moveBackwardAndTurnRight") return DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT;
+    if (action == "stopAll") return DesiredState::STOPPING;
+    return std::nullopt;
+}
+
+const char* desired_state_to_action(DesiredState state) {
+    switch (state) {
+        case DesiredState::MOVING_FORWARD: return "moveForward";
+        case DesiredState::MOVING_BACKWARD: return "moveBackward";
+        case DesiredState::TURNING_LEFT: return "turnLeft";
+        case DesiredState::TURNING_RIGHT: return "turnRight";
+        case DesiredState::MOVING_FORWARD_AND_TURN_LEFT: return "moveForwardAndTurnLeft";
+        case DesiredState::MOVING_FORWARD_AND_TURN_RIGHT: return "moveForwardAndTurnRight";
+        case DesiredState::MOVING_BACKWARD_AND_TURN_LEFT: return "moveBackwardAndTurnLeft";
+        case DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT: return "moveBackwardAndTurnRight";
+        case DesiredState::STOPPING: return "stopAll";
+    }
+    return "stopAll";
+}
+
+DesiredStateManager::DesiredStateManager(Clock& clock) : m_clock(clock) {
     m_desired_state = DesiredState::STOPPING;
 }
 
@@ -10,13 +41,49 @@ DesiredStateManager::~DesiredStateManager() {
 }
 
 void DesiredStateManager::set_desired_state(const DesiredState& desired_state) {
-    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    set_desired_state(desired_state, std::chrono::milliseconds(0));
+}
+
+void DesiredStateManager::set_desired_state(const DesiredState& desired_state, std::chrono::milliseconds ttl) {
+    trace::Span span("DesiredStateManager::set_desired_state");
+    // 在加锁前计算到期时间，缩短临界区
+    const LeaseTimePoint deadline = ttl.count() > 0
+        ? m_clock.now() + std::min(ttl, std::chrono::milliseconds(MAX_LEASE_TTL_MS))
+        : NO_LEASE;
+    std::lock_guard<PiMutex> lock(m_mutex);
+    m_desired_state = desired_state;
+    m_lease_deadline = deadline;
+    m_request_id.store(trace::is_enabled() ? trace::current_request_id() : 0, std::memory_order_relaxed);
+}
+
+void DesiredStateManager::restore_desired_state(const DesiredState& desired_state, LeaseTimePoint lease_deadline) {
+    std::lock_guard<PiMutex> lock(m_mutex);
     m_desired_state = desired_state;
+    m_lease_deadline = lease_deadline;
 }
 
 DesiredState DesiredStateManager::get_desired_state() {
-    std::shared_lock<std::shared_mutex> shared_lock(m_mutex);
+    std::lock_guard<PiMutex> lock(m_mutex);
     return m_desired_state;
 }
 
+uint64_t DesiredStateManager::get_request_id() const {
+    return m_request_id.load(std::memory_order_relaxed);
+}
+
+LeaseTimePoint DesiredStateManager::get_lease_deadline() {
+    std::lock_guard<PiMutex> lock(m_mutex);
+    return m_lease_deadline;
+}
+
+bool DesiredStateManager::expire_lease(LeaseTimePoint deadline, DesiredState safe_state) {
+    std::lock_guard<PiMutex> lock(m_mutex);
+    if (m_lease_deadline != deadline) {
+        return false; // 租约已被续期或替换
+    }
+    m_desired_state = safe_state;
+    m_lease_deadline = NO_LEASE;
+    return true;
+}
+
 }
\ No newline at end of file
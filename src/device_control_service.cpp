@@ -1,35 +1,121 @@
 #include "fpvcar_device_control/device_control_service.hpp"
+#include "fpvcar_device_control/flight_recorder.hpp"
+#include "fpvcar_device_control/gpio_encoder.hpp"
+#include "fpvcar_device_control/pca9685.hpp"
+#ifdef FPVCAR_STATIC_CHANNEL_LAYOUT
+#include "fpvcar_device_control/static_channel_layout.hpp"
+#endif
+#include "fpvcar_device_control/trace.hpp"
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <exception>
+#include <stdexcept>
+#include <unistd.h>
 
 namespace fpvcar::device_control {
 
+namespace {
+    /**
+     * @brief 是否使用 Pca9685MotorBackend：配置为 "pca9685" 驱动，或 I2C 设备为仿真器
+     */
+    bool uses_pca9685_driver(const config::AppConfig& config) {
+        return config.motor_driver == "pca9685" || config.i2c_device_path.rfind(I2C_EMULATOR_PREFIX, 0) == 0;
+    }
+
+    /**
+     * @brief 打开 Pca9685MotorBackend 使用的 I2C 传输层（fpvcar-motor 驱动自己打开设备，返回空）
+     * @note 失败时抛出异常，由 create() 转换为错误返回
+     */
+    std::unique_ptr<I2cTransport> open_motor_transport(const config::AppConfig& config) {
+        if (!uses_pca9685_driver(config)) return nullptr;
+        auto transport = open_i2c_transport(config.i2c_device_path, config.i2c_bus_speed_hz, config.pca9685_address);
+        if (!transport) throw std::runtime_error(transport.error());
+        return std::move(*transport);
+    }
+
+#ifdef FPVCAR_STATIC_CHANNEL_LAYOUT
+    /**
+     * @brief 配置的通道、PWM 频率与地址是否与构建时的通道布局一致
+     * @note PWM 频率按芯片实际使用的 PRESCALE 比较
+     */
+    bool matches_configured_layout(const config::AppConfig& config) {
+        const auto configured = pca9685::wheel_channels(config.channels);
+        for (size_t i = 0; i < WHEEL_COUNT; ++i) {
+            const pca9685::WheelChannels& expected = ConfiguredPca9685Backend::WHEELS[i];
+            if (configured[i].speed != expected.speed || configured[i].in1 != expected.in1 || configured[i].in2 != expected.in2) {
+                return false;
+            }
+        }
+        return pca9685::prescale_for(config.pwm_frequency) == ConfiguredPca9685Backend::PRESCALE &&
+               config.pca9685_address == ConfiguredPca9685Backend::ADDRESS;
+    }
+#endif
+
+    std::unique_ptr<MotorBackend> create_motor_backend(const config::AppConfig& config, I2cTransport* transport) {
+        if (transport) {
+#ifdef FPVCAR_STATIC_CHANNEL_LAYOUT
+            if (matches_configured_layout(config)) {
+                std::cout << "Motor backend: PCA9685 with the static channel layout (compile-time register tables)" << std::endl;
+                return std::make_unique<ConfiguredPca9685Backend>(*transport);
+            }
+            std::cerr << "Warning: channels/pwm_frequency/pca9685_address differ from the static channel layout "
+                         "this build was configured with, using the runtime-configured PCA9685 backend" << std::endl;
+#endif
+            return std::make_unique<Pca9685MotorBackend>(*transport, config.channels, config.pwm_frequency, config.pca9685_address);
+        }
+        return std::make_unique<FpvCarMotorBackend>(config.i2c_device_path, config.channels, config.pwm_frequency, config.pca9685_address);
+    }
+}
+
 DeviceControlService::DeviceControlService(const config::AppConfig& config)
     : m_config(config),
-      // 初始化 I2C/PCA9685 控制器，传入 I2C 设备路径、通道配置、PWM 频率和 I2C 地址
-        m_controller(
-            m_config.i2c_device_path,
-            m_config.channels,
-            m_config.pwm_frequency,
-            m_config.pca9685_address
-        ),
         m_desired_state_manager(),
-        m_control_loop(m_desired_state_manager, m_controller),
-        // 初始化请求处理器，传入期望状态管理器引用
-        m_handler(m_desired_state_manager),
+        // 初始化 I2C/PCA9685 控制器，传入 I2C 设备路径、通道配置、PWM 频率和 I2C 地址
+        m_i2c(open_motor_transport(m_config)),
+        m_controller(create_motor_backend(m_config, m_i2c.get())),
+        m_control_loop(m_desired_state_manager, *m_controller, m_config.lease_safe_state, m_config.motor_fault_policy),
+        // 紧急停车通道直接调用控制循环的停车路径
+        m_estop(m_config.estop_socket_path, [this]() { return m_control_loop.emergency_stop(); }),
+        // 初始化请求处理器，传入期望状态管理器引用与导出目录
+        m_handler(m_desired_state_manager, m_config.diagnostics_dir),
+        // 订阅推送器读取控制循环发布的遥测快照
+        m_telemetry(
+            m_control_loop.telemetry(),
+            std::chrono::milliseconds(m_config.telemetry_rate_hz > 0.0
+                ? std::max<int64_t>(1, static_cast<int64_t>(1000.0 / m_config.telemetry_rate_hz))
+                : 0),
+            m_config.telemetry_max_subscribers
+        ),
         // 初始化 IPC 服务器，使用 lambda 捕获 this 并将请求转发给处理器
         // 当接收到新指令时，处理请求并喂看门狗
         m_server(
             m_config.ipc_socket_path,
-            [this](const std::string& req) {
-                std::string response = m_handler.handle_request(req);
-                // 只有在成功处理请求后才喂看门狗（即使请求格式错误，也算收到了指令）
-                m_control_loop.feed_watchdog();
-                return response;
-            }
-        )
+            [this](std::string_view req, std::string& response) { return handle_command(req, response); },
+            m_config.ipc_backend == "io_uring" ? IpcBackend::IO_URING : IpcBackend::BLOCKING
+        ),
+        // UDP 控制通道：只有通过序号与过期检查的数据报才会到达 handle_command（喂看门狗）
+        m_udp(
+            m_config.udp_bind_address,
+            m_config.udp_port,
+            [this](std::string_view req, std::string& response) { return handle_command(req, response); },
+            UdpPolicy{std::chrono::milliseconds(m_config.udp_max_delay_ms), std::chrono::milliseconds(1000)}
+        ),
+        // 接管套接字：新实例连接后在监听线程中执行移交
+        m_takeover(m_config.takeover_socket_path, [this](int fd) { return hand_over(fd); })
 {
+    trace::set_enabled(m_config.trace_enabled);
+    // 飞行记录器：看门狗停车与致命信号时自动导出
+    recorder::set_enabled(m_config.flight_recorder_enabled);
+    recorder::set_dump_path(m_config.flight_recorder_enabled ? m_config.flight_recorder_path : std::string());
+    if (m_config.flight_recorder_enabled && !m_config.flight_recorder_path.empty()) {
+        recorder::install_crash_handler();
+    }
+    m_server.set_handoff([this](int fd, std::string response) {
+        m_telemetry.add_subscriber(fd, std::move(response));
+    });
+    m_server.set_rate_limit({m_config.ipc_rate_limit_hz, m_config.ipc_rate_limit_burst});
+    enable_wheel_speed_control();
     std::cout << "DeviceControlService initialized." << std::endl;
 }
 
@@ -37,6 +123,41 @@ DeviceControlService::~DeviceControlService() {
     stop();
 }
 
+IpcDisposition DeviceControlService::handle_command(std::string_view request, std::string& response) {
+    const RequestOutcome outcome = m_handler.handle_request(request, response);
+    // 只有在成功处理请求后才喂看门狗（即使请求格式错误，也算收到了指令）
+    m_control_loop.feed_watchdog();
+    // 订阅请求：连接转为推送流
+    return outcome == RequestOutcome::SUBSCRIBE ? IpcDisposition::HAND_OFF : IpcDisposition::KEEP;
+}
+
+void DeviceControlService::enable_wheel_speed_control() {
+    if (!m_config.wheel_speed.enabled) return;
+    // 闭环需要按车轮设置占空比与编码器反馈，任一缺失时按开环运行（只告警，不影响启动）
+    if (!m_controller->supports_wheel_duty()) {
+        std::cerr << "Warning: Closed-loop wheel speed control disabled: motor backend does not support per-wheel duty" << std::endl;
+        return;
+    }
+    auto encoder = open_gpio_encoder(m_config.encoder_gpio_chip, m_config.encoder_gpio_lines);
+    if (!encoder) {
+        std::cerr << "Warning: Closed-loop wheel speed control disabled: " << encoder.error() << std::endl;
+        return;
+    }
+    m_encoder = std::move(*encoder);
+    m_control_loop.set_wheel_speed_control(*m_encoder, m_config.wheel_speed);
+}
+
+void DeviceControlService::start_udp() {
+    if (m_config.udp_port == 0) return;
+    auto udp = m_udp.start();
+    if (!udp) std::cerr << "Warning: " << udp.error() << std::endl;
+}
+
+void DeviceControlService::start_estop() {
+    auto estop = m_estop.start();
+    if (!estop) std::cerr << "Warning: " << estop.error() << std::endl;
+}
+
 tl::expected<std::unique_ptr<DeviceControlService>, std::string> DeviceControlService::create(const config::AppConfig& config) {
     try {
         // 使用 new 创建对象，因为 unique_ptr 需要在构造后设置
@@ -49,8 +170,18 @@ tl::expected<std::unique_ptr<DeviceControlService>, std::string> DeviceControlSe
 }
 
 tl::expected<void, std::string> DeviceControlService::start() {
-    // 先启动控制循环
+    // 配置电机驱动芯片（构造时不访问芯片，见 start_takeover）
+    try {
+        m_controller->initialize();
+    } catch (const std::exception& e) {
+        return tl::unexpected(std::string("Failed to initialize motor driver: ") + e.what());
+    }
+    // 先启动控制循环和紧急停车通道
     m_control_loop.start();
+    start_estop();
+    // 启动订阅推送线程
+    auto telemetry = m_telemetry.start();
+    if (!telemetry) return tl::unexpected(telemetry.error());
     // 再启动 IPC 服务器
     // 准备 IPC 服务器：创建并绑定套接字
     auto prep = m_server.prepare();
@@ -58,19 +189,204 @@ tl::expected<void, std::string> DeviceControlService::start() {
     
     // 在独立线程中运行服务器，避免阻塞调用者
     m_server_thread = std::thread([this]() { m_server.run(); });
+    start_udp();
+
+    // 最后开放接管套接字，供后续的新实例接管
+    if (!m_config.takeover_socket_path.empty()) {
+        auto takeover = m_takeover.start();
+        if (!takeover) std::cerr << "Warning: " << takeover.error() << std::endl;
+    }
     return {};
 }
 
+tl::expected<void, std::string> DeviceControlService::start_takeover() {
+    if (m_config.takeover_socket_path.empty()) {
+        return tl::unexpected(std::string("Takeover is disabled ('takeover_socket_path' is empty)"));
+    }
+    auto fd = takeover::request_takeover(m_config.takeover_socket_path);
+    if (!fd) {
+        std::cout << fd.error() << ", starting normally" << std::endl;
+        return start();
+    }
+
+    // 1. 接收状态和套接字；旧实例此时已冻结，这之后的每一步都计入接管间隙
+    auto received = takeover::receive_state(*fd);
+    if (!received) {
+        ::close(*fd);
+        return tl::unexpected(std::string("Takeover failed: ") + received.error());
+    }
+    takeover::TakeoverState state = received->first;
+    IpcSockets sockets = std::move(received->second);
+    const size_t clients = sockets.client_fds.size();
+
+    // 2. 确认可以接管，等待旧实例提交；旧实例提交之前任何失败都由旧实例恢复服务
+    auto res = m_telemetry.start();
+    if (res) res = takeover::send_control(*fd, "ready");
+    if (res) res = takeover::expect_control(*fd, "commit");
+    if (!res) {
+        takeover::close_sockets(sockets);
+        ::close(*fd);
+        return tl::unexpected(std::string("Takeover aborted: ") + res.error());
+    }
+
+    // 3. 已提交：恢复期望状态，接管套接字后启动控制循环和服务器（电机保持旧实例的输出）
+    // 芯片在这之前一直由旧实例驱动：不复位，读回寄存器作为写入基准
+    m_desired_state_manager.restore_desired_state(state.desired_state, state.lease_deadline);
+    try {
+        m_controller->adopt_outputs();
+    } catch (const std::exception& e) {
+        // 没有发送 started 就关闭连接，旧实例据此恢复服务
+        takeover::close_sockets(sockets);
+        ::close(*fd);
+        return tl::unexpected(std::string("Takeover failed after commit: ") + e.what());
+    }
+    auto adopted = m_server.adopt(std::move(sockets));
+    if (!adopted) {
+        // 没有发送 started 就关闭连接，旧实例据此恢复服务
+        ::close(*fd);
+        return tl::unexpected(std::string("Takeover failed after commit: ") + adopted.error());
+    }
+    m_control_loop.start(state.control_loop);
+    start_estop();
+    m_server_thread = std::thread([this]() { m_server.run(); });
+    // UDP 端口在旧实例冻结时已释放，这里重新绑定（期间到达的数据报丢失，由发送端重发）
+    start_udp();
+
+    const auto gap = std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::instance().now() - state.freeze_time);
+    auto started = takeover::send_control(*fd, "started", gap.count());
+    if (!started) std::cerr << "Warning: " << started.error() << std::endl;
+    ::close(*fd);
+    std::cout << "Took over running instance: desired=" << desired_state_to_action(state.desired_state)
+              << ", applied=" << desired_state_to_action(state.control_loop.applied_state)
+              << ", " << clients << " client connection(s), gap " << gap.count() << " us" << std::endl;
+
+    // 4. 开放接管套接字（替换旧实例的套接字文件）
+    auto listener = m_takeover.start();
+    if (!listener) std::cerr << "Warning: " << listener.error() << std::endl;
+    return {};
+}
+
+bool DeviceControlService::hand_over(int fd) {
+    auto request = takeover::accept_request(fd);
+    if (!request) {
+        std::cerr << "Error: " << request.error() << std::endl;
+        return false;
+    }
+
+    // 1. 冻结：先停止 IPC 服务（保留套接字），再停止控制循环和看门狗（不停车）
+    // 紧急停车通道同时停止，套接字文件由新实例重新绑定（接管间隙内紧急停车不可用）
+    takeover::TakeoverState state;
+    state.freeze_time = SteadyClock::instance().now();
+    m_estop.stop(false);
+    m_udp.stop();
+    m_server.detach();
+    if (m_server_thread.joinable()) {
+        m_server_thread.join();
+    }
+    IpcSockets sockets = m_server.take_detached();
+    state.control_loop = m_control_loop.detach();
+    state.desired_state = m_desired_state_manager.get_desired_state();
+    state.lease_deadline = m_desired_state_manager.get_lease_deadline();
+    while (sockets.client_fds.size() > takeover::MAX_CLIENT_FDS) {
+        ::close(sockets.client_fds.back());
+        sockets.client_fds.pop_back();
+    }
+
+    // 2. 发送状态和套接字，等待新实例就绪后提交
+    auto res = takeover::send_state(fd, state, sockets);
+    if (res) res = takeover::expect_control(fd, "ready");
+    if (res) res = takeover::send_control(fd, "commit");
+    if (!res) {
+        std::cerr << "Takeover aborted (" << res.error() << "), resuming service" << std::endl;
+        resume_after_failed_handover(state, std::move(sockets));
+        return false;
+    }
+
+    // 3. 已提交：只有新实例在启动前退出（连接被关闭）时才恢复服务
+    int64_t gap_us = -1;
+    bool peer_closed = false;
+    auto started = takeover::expect_control(fd, "started", &gap_us, &peer_closed);
+    if (!started && peer_closed) {
+        std::cerr << "New instance exited before starting, resuming service" << std::endl;
+        resume_after_failed_handover(state, std::move(sockets));
+        return false;
+    }
+    takeover::close_sockets(sockets);
+    m_handed_over.store(true);
+    if (started) {
+        std::cout << "Handed over to new instance, gap " << gap_us << " us" << std::endl;
+    } else {
+        std::cerr << "Warning: handed over but the new instance did not confirm (" << started.error() << ")" << std::endl;
+    }
+    return true;
+}
+
+void DeviceControlService::resume_after_failed_handover(const takeover::TakeoverState& state, IpcSockets sockets) {
+    // 新实例提交后可能已经写过芯片，寄存器副本不再可信
+    try {
+        m_controller->adopt_outputs();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: failed to read back motor driver state: " << e.what() << std::endl;
+    }
+    m_control_loop.start(state.control_loop);
+    start_estop();
+    auto adopted = m_server.adopt(std::move(sockets));
+    if (!adopted) {
+        std::cerr << "Error: failed to resume IPC server: " << adopted.error() << std::endl;
+        return;
+    }
+    m_server_thread = std::thread([this]() { m_server.run(); });
+    start_udp();
+}
+
 void DeviceControlService::stop() {
-    // 关闭控制循环
+    // 先停止接管监听（等待正在进行的移交结束），之后服务状态不会再被监听线程修改
+    m_takeover.stop();
+    // 先停止紧急停车通道（它直接调用控制循环），已移交时套接字文件属于新实例，不删除
+    m_estop.stop(!m_handed_over.load());
+    // 关闭控制循环（已移交时控制循环已经 detach，不会停车）
     m_control_loop.stop();
-    // 停止服务器，这会中断 accept 循环
+    // 停止 UDP 通道与 IPC 服务器，这会中断 accept 循环
+    m_udp.stop();
     m_server.stop();
     
     // 等待服务器线程结束，确保资源完全清理
     if (m_server_thread.joinable()) {
         m_server_thread.join();
     }
+    // 服务器不再移交连接后停止推送，关闭所有订阅连接
+    m_telemetry.stop();
+
+    // 紧急停车与 UDP 通道统计只在第一次停止时打印
+    const EstopStats estop = m_estop.stats();
+    if (estop.triggers > 0 && !m_estop_reported.exchange(true)) {
+        std::cout << "Emergency stop: triggered " << estop.triggers << " (socket " << estop.socket_triggers << ", SIGUSR1 "
+                  << estop.signal_triggers << "), failed " << estop.failures << ", latency mean "
+                  << estop.total_latency_ns / static_cast<int64_t>(estop.triggers) / 1000 << " us, max "
+                  << estop.max_latency_ns / 1000 << " us" << std::endl;
+    }
+    if (m_i2c && !m_i2c_reported.exchange(true)) {
+        const I2cStats i2c = m_i2c->stats();
+        std::cout << "I2C bus (" << m_i2c->bus_speed_hz() / 1000 << " kHz): " << i2c.transactions << " transactions, "
+                  << i2c.write_bytes + i2c.read_bytes << " bytes, bus time " << i2c.bus_time_ns / 1000 << " us (max "
+                  << i2c.max_bus_time_ns / 1000 << " us per transaction), errors " << i2c.errors << std::endl;
+        if (const auto* emulator = dynamic_cast<const Pca9685Emulator*>(m_i2c.get())) {
+            const Pca9685EmulatorStats pca = emulator->device_stats();
+            std::cout << "PCA9685 emulator: register writes " << pca.register_writes << ", redundant " << pca.redundant_writes
+                      << ", ignored " << pca.ignored_writes << ", PWM " << static_cast<int64_t>(emulator->pwm_frequency()) << " Hz" << std::endl;
+        }
+    }
+    const UdpServerStats udp = m_udp.stats();
+    if (udp.received > 0 && !m_udp_reported.exchange(true)) {
+        std::cout << "UDP control: received " << udp.received << ", accepted " << udp.accepted << ", stale " << udp.stale
+                  << ", out of order " << udp.reordered << ", malformed " << udp.malformed << ", rejected " << udp.rejected
+                  << ", handler errors " << udp.errors << std::endl;
+        for (const UdpSenderStats& s : udp.senders) {
+            std::cout << "  " << s.address << ": accepted " << s.accepted << ", stale " << s.stale << ", out of order "
+                      << s.reordered << ", jitter " << static_cast<int64_t>(s.jitter_us) << " us (max "
+                      << static_cast<int64_t>(s.max_jitter_us) << " us)" << std::endl;
+        }
+    }
 }
 
 } // namespace fpvcar::device_control
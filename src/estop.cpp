@@ -0,0 +1,238 @@
+#include "fpvcar_device_control/estop.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace fpvcar::device_control {
+
+namespace {
+    // SIGUSR1 的接收方：信号处理函数只能使用无锁原子量与异步信号安全的系统调用
+    std::atomic<int> g_signal_fd{-1};
+    std::atomic<uint64_t> g_signal_pending{0};
+    std::atomic<int64_t> g_signal_time_ns{0}; // 本批信号中第一个信号的到达时间
+
+    int64_t monotonic_ns() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    void on_sigusr1(int) {
+        const int saved_errno = errno;
+        if (g_signal_pending.fetch_add(1, std::memory_order_relaxed) == 0) {
+            g_signal_time_ns.store(monotonic_ns(), std::memory_order_relaxed);
+        }
+        const int fd = g_signal_fd.load(std::memory_order_relaxed);
+        if (fd >= 0) {
+            uint64_t one = 1;
+            ssize_t n = ::write(fd, &one, sizeof(one));
+            (void)n;
+        }
+        errno = saved_errno;
+    }
+
+    void install_signal_handler() {
+        struct sigaction sa{};
+        sa.sa_handler = on_sigusr1;
+        sigemptyset(&sa.sa_mask);
+        // 其它线程被中断的阻塞调用自动重启（poll 等不会重启的调用各自处理 EINTR）
+        sa.sa_flags = SA_RESTART;
+        ::sigaction(SIGUSR1, &sa, nullptr);
+    }
+}
+
+EmergencyStop::EmergencyStop(std::string socket_path, StopAction action)
+    : m_socket_path(std::move(socket_path)), m_action(std::move(action)) {}
+
+EmergencyStop::~EmergencyStop() {
+    stop();
+}
+
+tl::expected<void, std::string> EmergencyStop::start() {
+    if (m_running.load()) return {};
+
+    if (!m_socket_path.empty()) {
+        // 删除已存在的套接字文件（如果存在）
+        ::unlink(m_socket_path.c_str());
+        m_listen_fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (m_listen_fd < 0) {
+            return tl::unexpected(std::string("Failed to create emergency stop socket: ") + std::strerror(errno));
+        }
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", m_socket_path.c_str());
+        if (::bind(m_listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(m_listen_fd, static_cast<int>(MAX_CLIENTS)) < 0) {
+            int err = errno;
+            ::close(m_listen_fd);
+            m_listen_fd = -1;
+            ::unlink(m_socket_path.c_str());
+            return tl::unexpected("Failed to listen on emergency stop socket " + m_socket_path + ": " + std::strerror(err));
+        }
+    }
+
+    m_wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wake_fd < 0) {
+        int err = errno;
+        if (m_listen_fd >= 0) {
+            ::close(m_listen_fd);
+            m_listen_fd = -1;
+            ::unlink(m_socket_path.c_str());
+        }
+        return tl::unexpected(std::string("Failed to create eventfd: ") + std::strerror(err));
+    }
+
+    // 丢弃启动之前到达的信号，再开始接收
+    g_signal_pending.store(0, std::memory_order_relaxed);
+    g_signal_fd.store(m_wake_fd, std::memory_order_relaxed);
+    install_signal_handler();
+
+    m_running.store(true);
+    m_thread = std::thread([this]() { run(); });
+    sched_param param{};
+    param.sched_priority = THREAD_PRIORITY;
+    if (int err = ::pthread_setschedparam(m_thread.native_handle(), SCHED_FIFO, &param); err != 0) {
+        std::cout << "Emergency stop thread running at normal priority (SCHED_FIFO: " << std::strerror(err) << ")" << std::endl;
+    }
+    if (m_listen_fd >= 0) {
+        std::cout << "Emergency stop listening on " << m_socket_path << " and SIGUSR1" << std::endl;
+    } else {
+        std::cout << "Emergency stop listening on SIGUSR1" << std::endl;
+    }
+    return {};
+}
+
+void EmergencyStop::stop(bool remove_socket) {
+    if (!m_running.exchange(false)) return;
+    // 停止接收信号（只在仍指向本实例时清除）
+    int expected = m_wake_fd;
+    g_signal_fd.compare_exchange_strong(expected, -1);
+    uint64_t one = 1;
+    ssize_t n = ::write(m_wake_fd, &one, sizeof(one));
+    (void)n;
+    if (m_thread.joinable()) m_thread.join();
+
+    for (int fd : m_clients) ::close(fd);
+    m_clients.clear();
+    if (m_listen_fd >= 0) {
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+        if (remove_socket) ::unlink(m_socket_path.c_str());
+    }
+    ::close(m_wake_fd);
+    m_wake_fd = -1;
+}
+
+EstopStats EmergencyStop::stats() const {
+    EstopStats stats;
+    stats.triggers = m_triggers.load(std::memory_order_relaxed);
+    stats.socket_triggers = m_socket_triggers.load(std::memory_order_relaxed);
+    stats.signal_triggers = m_signal_triggers.load(std::memory_order_relaxed);
+    stats.failures = m_failures.load(std::memory_order_relaxed);
+    stats.invalid_frames = m_invalid_frames.load(std::memory_order_relaxed);
+    stats.last_latency_ns = m_last_latency_ns.load(std::memory_order_relaxed);
+    stats.max_latency_ns = m_max_latency_ns.load(std::memory_order_relaxed);
+    stats.total_latency_ns = m_total_latency_ns.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool EmergencyStop::trigger(bool from_signal, int64_t received_ns) {
+    const bool ok = m_action();
+    const int64_t latency = monotonic_ns() - received_ns;
+
+    m_triggers.fetch_add(1, std::memory_order_relaxed);
+    (from_signal ? m_signal_triggers : m_socket_triggers).fetch_add(1, std::memory_order_relaxed);
+    if (!ok) m_failures.fetch_add(1, std::memory_order_relaxed);
+    m_last_latency_ns.store(latency, std::memory_order_relaxed);
+    m_total_latency_ns.fetch_add(latency, std::memory_order_relaxed);
+    if (latency > m_max_latency_ns.load(std::memory_order_relaxed)) m_max_latency_ns.store(latency, std::memory_order_relaxed);
+    if (!ok) std::cerr << "Error: Emergency stop " << (from_signal ? "(SIGUSR1)" : "(socket)") << " failed" << std::endl;
+    return ok;
+}
+
+void EmergencyStop::run() {
+    // 只有本线程修改 m_clients；poll 集合为 [eventfd, 监听套接字, 各连接]
+    pollfd fds[2 + MAX_CLIENTS];
+    while (m_running.load(std::memory_order_relaxed)) {
+        fds[0] = {m_wake_fd, POLLIN, 0};
+        fds[1] = {m_listen_fd, POLLIN, 0}; // fd 为 -1 时 poll 忽略该项
+        for (size_t i = 0; i < m_clients.size(); ++i) fds[2 + i] = {m_clients[i], POLLIN, 0};
+        const nfds_t count = static_cast<nfds_t>(2 + m_clients.size());
+        if (::poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: Emergency stop poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        // 1. SIGUSR1 或 stop()
+        if (fds[0].revents & POLLIN) {
+            uint64_t value = 0;
+            ssize_t n = ::read(m_wake_fd, &value, sizeof(value));
+            (void)n;
+            if (!m_running.load(std::memory_order_relaxed)) break;
+            if (g_signal_pending.exchange(0, std::memory_order_relaxed) > 0) {
+                trigger(true, g_signal_time_ns.load(std::memory_order_relaxed));
+            }
+        }
+
+        // 2. 连接上的消息：每条一个字节，读空再回到 poll
+        for (size_t i = 0; i < m_clients.size(); ++i) {
+            if (!(fds[2 + i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            const int fd = m_clients[i];
+            bool closed = false;
+            while (true) {
+                char frame[16];
+                ssize_t n = ::recv(fd, frame, sizeof(frame), MSG_DONTWAIT);
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                if (n <= 0) {
+                    closed = true;
+                    break;
+                }
+                const int64_t received_ns = monotonic_ns();
+                char ack = ESTOP_ACK_INVALID;
+                if (n == 1 && frame[0] == ESTOP_FRAME) {
+                    ack = trigger(false, received_ns) ? ESTOP_ACK_OK : ESTOP_ACK_FAILED;
+                } else {
+                    m_invalid_frames.fetch_add(1, std::memory_order_relaxed);
+                }
+                // 回复失败（对端不读）不影响停车
+                if (::send(fd, &ack, 1, MSG_DONTWAIT | MSG_NOSIGNAL) < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                    closed = true;
+                    break;
+                }
+            }
+            if (closed) {
+                ::close(fd);
+                m_clients[i] = -1;
+            }
+        }
+        m_clients.erase(std::remove(m_clients.begin(), m_clients.end(), -1), m_clients.end());
+
+        // 3. 新连接
+        if (m_listen_fd >= 0 && (fds[1].revents & POLLIN)) {
+            int fd = ::accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd >= 0) {
+                if (m_clients.size() < MAX_CLIENTS) {
+                    m_clients.push_back(fd);
+                } else {
+                    std::cerr << "Warning: Emergency stop connection limit (" << MAX_CLIENTS << ") reached, closing new connection" << std::endl;
+                    ::close(fd);
+                }
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,197 @@
+#include "fpvcar_device_control/fast_request_parser.hpp"
+
+// 字符串扫描的 SIMD 实现：x86 使用 SSE2，AArch64 使用 NEON，其它平台使用标量实现
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FPVCAR_PARSER_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FPVCAR_PARSER_NEON 1
+#endif
+
+namespace fpvcar::device_control {
+
+namespace {
+    // JSON 规定的空白字符
+    bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    /**
+     * @brief 字符串中需要特殊处理的字节：结束引号、转义、控制字符或非 ASCII
+     */
+    bool is_string_special(unsigned char c) {
+        return c == '"' || c == '\\' || c < 0x20 || c >= 0x80;
+    }
+
+    /**
+     * @brief 标量扫描：返回 [p, end) 中第一个特殊字节的位置，没有则返回 end
+     */
+    const char* scan_string_scalar(const char* p, const char* end) {
+        while (p < end && !is_string_special(static_cast<unsigned char>(*p))) ++p;
+        return p;
+    }
+
+    /**
+     * @brief SIMD 扫描：每次比较 16 字节，不足 16 字节的尾部交给标量实现（不会越界读取）
+     */
+    const char* scan_string_simd(const char* p, const char* end) {
+#if defined(FPVCAR_PARSER_SSE2)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i space = _mm_set1_epi8(0x20);
+        while (end - p >= 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            // 有符号比较：< 0x20 的控制字符和 >= 0x80 的字节（视为负数）同时命中
+            const __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                _mm_cmplt_epi8(v, space));
+            const int mask = _mm_movemask_epi8(special);
+            if (mask != 0) return p + __builtin_ctz(static_cast<unsigned>(mask));
+            p += 16;
+        }
+#elif defined(FPVCAR_PARSER_NEON)
+        const uint8x16_t quote = vdupq_n_u8('"');
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        const int8x16_t space = vdupq_n_s8(0x20);
+        while (end - p >= 16) {
+            const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+            // 有符号比较：< 0x20 的控制字符和 >= 0x80 的字节（视为负数）同时命中
+            const uint8x16_t special = vorrq_u8(
+                vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                vcltq_s8(vreinterpretq_s8_u8(v), space));
+            if (vmaxvq_u8(special) != 0) {
+                // 每个字节压缩为 4 位，第一个非零半字节即第一个命中的位置
+                const uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(
+                    vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+                return p + (__builtin_ctzll(nibbles) >> 2);
+            }
+            p += 16;
+        }
+#endif
+        return scan_string_scalar(p, end);
+    }
+
+    using ScanFn = const char* (*)(const char*, const char*);
+
+    /**
+     * @brief 输入上的只读游标
+     * @tparam Scan 字符串扫描实现
+     */
+    template <ScanFn Scan>
+    struct Cursor {
+        const char* p;
+        const char* end;
+
+        void skip_space() {
+            while (p < end && is_space(*p)) ++p;
+        }
+
+        bool consume(char c) {
+            skip_space();
+            if (p >= end || *p != c) return false;
+            ++p;
+            return true;
+        }
+
+        /**
+         * @brief 读取一个不含转义的字符串（起始引号之后开始）
+         * @note 遇到转义、控制字符或非 ASCII 字节时返回 false，由 DOM 路径负责校验与反转义
+         */
+        bool read_plain_string(std::string_view& out) {
+            const char* start = p;
+            p = Scan(p, end);
+            if (p >= end || *p != '"') return false; // 字符串未结束，或遇到转义/控制字符/非 ASCII
+            out = std::string_view(start, static_cast<size_t>(p - start));
+            ++p;
+            return true;
+        }
+
+        /**
+         * @brief 读取一个非负整数
+         * @note 负数、小数、指数形式、前导零和超过 18 位的数字返回 false
+         */
+        bool read_unsigned(int64_t& out) {
+            const char* start = p;
+            int64_t value = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                value = value * 10 + (*p - '0');
+                ++p;
+            }
+            const size_t digits = static_cast<size_t>(p - start);
+            if (digits == 0 || digits > 18) return false;
+            if (digits > 1 && *start == '0') return false; // JSON 不允许前导零
+            out = value;
+            return true;
+        }
+    };
+
+    /**
+     * @brief 解析实现，字符串扫描方式由模板参数决定
+     */
+    template <ScanFn Scan>
+    bool parse_fast_request_with(std::string_view json_request, FastRequest& out) {
+        Cursor<Scan> cur{json_request.data(), json_request.data() + json_request.size()};
+        out = FastRequest{};
+        bool has_action = false;
+
+        if (!cur.consume('{')) return false;
+        while (true) {
+            if (!cur.consume('"')) return false;
+            std::string_view key;
+            if (!cur.read_plain_string(key)) return false;
+            if (!cur.consume(':')) return false;
+            cur.skip_space();
+
+            if (key == "action" && !has_action) {
+                if (!cur.consume('"')) return false; // 非字符串的 action 交给 DOM 路径报错
+                if (!cur.read_plain_string(out.action)) return false;
+                has_action = true;
+            } else if (key == "ttl_ms" && !out.has_ttl) {
+                if (!cur.read_unsigned(out.ttl_ms)) return false;
+                out.has_ttl = true;
+            } else if (key == "seq" && !out.has_seq) {
+                if (!cur.read_unsigned(out.seq)) return false;
+                out.has_seq = true;
+            } else if (key == "ts_us" && !out.has_ts) {
+                if (!cur.read_unsigned(out.ts_us)) return false;
+                out.has_ts = true;
+            } else {
+                return false; // 其它字段或重复字段
+            }
+
+            cur.skip_space();
+            if (cur.p >= cur.end) return false;
+            if (*cur.p == ',') {
+                ++cur.p;
+                continue;
+            }
+            if (*cur.p != '}') return false;
+            ++cur.p;
+            break;
+        }
+
+        cur.skip_space();
+        return has_action && cur.p == cur.end;
+    }
+}
+
+bool parse_fast_request(std::string_view json_request, FastRequest& out) {
+    return parse_fast_request_with<scan_string_simd>(json_request, out);
+}
+
+bool parse_fast_request_scalar(std::string_view json_request, FastRequest& out) {
+    return parse_fast_request_with<scan_string_scalar>(json_request, out);
+}
+
+const char* fast_request_scanner() {
+#if defined(FPVCAR_PARSER_SSE2)
+    return "sse2";
+#elif defined(FPVCAR_PARSER_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+}
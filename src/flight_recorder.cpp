@@ -0,0 +1,257 @@
+#include "fpvcar_device_control/flight_recorder.hpp"
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace fpvcar::device_control::recorder {
+
+std::atomic<bool> g_recorder_enabled{true};
+
+namespace {
+    constexpr uint64_t MASK = CAPACITY - 1;
+    static_assert((CAPACITY & MASK) == 0, "CAPACITY must be a power of two");
+
+    /**
+     * @brief 环形缓冲区的一个槽位（顺序锁）
+     * @note 写入者先把 seq 置为 2 * index + 1（写入中），写完后置为 2 * index + 2；
+     *       读取方只接受读取前后 seq 都等于 2 * index + 2 的槽位，被并发覆盖的槽位直接跳过
+     *       所有字段都是原子量，读写之间没有数据竞争
+     */
+    struct alignas(32) Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> ts_ns{0};
+        std::atomic<uint64_t> packed{0}; // type | a << 8 | b << 16 | c << 32
+        std::atomic<uint64_t> d{0};
+    };
+
+    /**
+     * @brief 文件中的一条事件
+     */
+    struct PackedRecord {
+        uint64_t ts_ns;
+        uint8_t type;
+        uint8_t a;
+        uint16_t b;
+        uint32_t c;
+        uint64_t d;
+    };
+    static_assert(sizeof(PackedRecord) == 24, "record layout must stay 24 bytes");
+
+    constexpr char MAGIC[8] = {'F', 'P', 'V', 'F', 'R', 'E', 'C', '\0'};
+    constexpr uint32_t VERSION = 1;
+
+    std::array<Slot, CAPACITY> g_slots;
+    std::atomic<uint64_t> g_head{0}; // 已分配的事件总数
+
+    // 自动导出路径：信号处理函数中读取，只在启动时设置
+    char g_dump_path[256] = {};
+    std::atomic<bool> g_crash_dumping{false};
+
+    int64_t clock_ns(clockid_t id) {
+        timespec ts{};
+        ::clock_gettime(id, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    bool write_all(int fd, const void* data, size_t size) {
+        const char* ptr = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = ::write(fd, ptr, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            ptr += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 把环形缓冲区写入已打开的文件（异步信号安全：只使用栈上的缓冲区与 write/lseek）
+     * @return 成功返回写入的事件数，失败返回 -1（errno 保留）
+     */
+    int64_t dump_to_fd(int fd, DumpReason reason, int signal) {
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.record_size = sizeof(PackedRecord);
+        header.reason = static_cast<uint32_t>(reason);
+        header.signal = static_cast<uint32_t>(signal);
+        header.dump_steady_ns = clock_ns(CLOCK_MONOTONIC);
+        header.dump_realtime_ns = clock_ns(CLOCK_REALTIME);
+
+        // 先占位写文件头，事件写完后回填数量
+        if (!write_all(fd, &header, sizeof(header))) return -1;
+
+        const uint64_t head = g_head.load(std::memory_order_acquire);
+        const uint64_t begin = head > CAPACITY ? head - CAPACITY : 0;
+        PackedRecord chunk[128];
+        size_t used = 0;
+        uint64_t count = 0;
+        for (uint64_t index = begin; index < head; ++index) {
+            const Slot& slot = g_slots[index & MASK];
+            const uint64_t expected = 2 * index + 2;
+            if (slot.seq.load(std::memory_order_acquire) != expected) continue; // 写入中或已被覆盖
+            const uint64_t ts = slot.ts_ns.load(std::memory_order_relaxed);
+            const uint64_t packed = slot.packed.load(std::memory_order_relaxed);
+            const uint64_t d = slot.d.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != expected) continue;
+
+            PackedRecord& record = chunk[used++];
+            record.ts_ns = ts;
+            record.type = static_cast<uint8_t>(packed & 0xff);
+            record.a = static_cast<uint8_t>((packed >> 8) & 0xff);
+            record.b = static_cast<uint16_t>((packed >> 16) & 0xffff);
+            record.c = static_cast<uint32_t>(packed >> 32);
+            record.d = d;
+            ++count;
+            if (used == sizeof(chunk) / sizeof(chunk[0])) {
+                if (!write_all(fd, chunk, sizeof(PackedRecord) * used)) return -1;
+                used = 0;
+            }
+        }
+        if (used > 0 && !write_all(fd, chunk, sizeof(PackedRecord) * used)) return -1;
+
+        header.count = count;
+        header.recorded = head;
+        if (::lseek(fd, 0, SEEK_SET) < 0 || !write_all(fd, &header, sizeof(header))) return -1;
+        return static_cast<int64_t>(count);
+    }
+
+    void on_fatal_signal(int signal) {
+        // 多个线程同时崩溃时只导出一次
+        if (!g_crash_dumping.exchange(true) && g_dump_path[0] != '\0') {
+            int fd = ::open(g_dump_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd >= 0) {
+                const bool ok = dump_to_fd(fd, DumpReason::CRASH, signal) >= 0;
+                ::close(fd);
+                static const char done[] = "Fatal signal: flight recorder dumped\n";
+                static const char failed[] = "Fatal signal: flight recorder dump failed\n";
+                ssize_t n = ok ? ::write(STDERR_FILENO, done, sizeof(done) - 1) : ::write(STDERR_FILENO, failed, sizeof(failed) - 1);
+                (void)n;
+            }
+        }
+        // SA_RESETHAND 已恢复默认处理，再次发送信号按默认行为终止（生成 core dump）
+        ::raise(signal);
+    }
+}
+
+void set_enabled(bool enabled) {
+    g_recorder_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(EventType type, uint8_t a, uint16_t b, uint32_t c, uint64_t d) {
+    if (!is_enabled()) return;
+    const uint64_t ts = now_ns();
+    const uint64_t index = g_head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = g_slots[index & MASK];
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.ts_ns.store(ts, std::memory_order_relaxed);
+    slot.packed.store(static_cast<uint64_t>(type) | (static_cast<uint64_t>(a) << 8) | (static_cast<uint64_t>(b) << 16) |
+                      (static_cast<uint64_t>(c) << 32), std::memory_order_relaxed);
+    slot.d.store(d, std::memory_order_relaxed);
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+}
+
+tl::expected<void, std::string> dump(const std::string& file_path, DumpReason reason) {
+    int fd = ::open(file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return tl::unexpected("Failed to open " + file_path + ": " + std::strerror(errno));
+    }
+    const int64_t count = dump_to_fd(fd, reason, 0);
+    const int err = errno;
+    ::close(fd);
+    if (count < 0) {
+        return tl::unexpected("Failed to write " + file_path + ": " + std::strerror(err));
+    }
+    return {};
+}
+
+void set_dump_path(const std::string& file_path) {
+    std::snprintf(g_dump_path, sizeof(g_dump_path), "%s", file_path.c_str());
+}
+
+std::string dump_path() {
+    return g_dump_path;
+}
+
+bool dump_automatic(DumpReason reason) {
+    if (g_dump_path[0] == '\0') return false;
+    auto res = dump(g_dump_path, reason);
+    if (!res) {
+        std::cerr << "Error: Flight recorder dump failed: " << res.error() << std::endl;
+        return false;
+    }
+    std::cerr << "Flight recorder dumped to " << g_dump_path << std::endl;
+    return true;
+}
+
+void install_crash_handler() {
+    struct sigaction sa{};
+    sa.sa_handler = on_fatal_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESETHAND;
+    for (int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) {
+        ::sigaction(signal, &sa, nullptr);
+    }
+}
+
+tl::expected<std::vector<Event>, std::string> load_dump(const std::string& file_path, FileHeader& header) {
+    std::ifstream in(file_path, std::ios::binary);
+    if (!in) {
+        return tl::unexpected("Failed to open " + file_path);
+    }
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return tl::unexpected(file_path + ": truncated header");
+    }
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return tl::unexpected(file_path + ": not a flight recorder dump");
+    }
+    if (header.version != VERSION || header.record_size != sizeof(PackedRecord)) {
+        return tl::unexpected(file_path + ": unsupported version " + std::to_string(header.version));
+    }
+    if (header.count > CAPACITY) {
+        return tl::unexpected(file_path + ": invalid event count " + std::to_string(header.count));
+    }
+
+    std::vector<Event> events;
+    events.reserve(header.count);
+    PackedRecord record;
+    for (uint64_t i = 0; i < header.count; ++i) {
+        if (!in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            return tl::unexpected(file_path + ": truncated after " + std::to_string(i) + " events");
+        }
+        Event event;
+        event.ts_ns = record.ts_ns;
+        event.type = static_cast<EventType>(record.type);
+        event.a = record.a;
+        event.b = record.b;
+        event.c = record.c;
+        event.d = record.d;
+        events.push_back(event);
+    }
+    return events;
+}
+
+void clear() {
+    for (Slot& slot : g_slots) slot.seq.store(0, std::memory_order_relaxed);
+    g_head.store(0, std::memory_order_release);
+}
+
+}
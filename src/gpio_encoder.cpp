@@ -0,0 +1,94 @@
+#include "fpvcar_device_control/gpio_encoder.hpp"
+
+#ifdef FPVCAR_GPIO_ENCODER
+#include <linux/gpio.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstdio>
+#include <cstring>
+#endif
+
+namespace fpvcar::device_control {
+
+#ifdef FPVCAR_GPIO_ENCODER
+
+namespace {
+    constexpr uint32_t EVENT_BUFFER_SIZE = 1024; // 内核事件缓冲区（建议值）
+    constexpr size_t READ_BATCH = 64;            // 每次 read 读取的事件数
+
+    class GpioEncoder : public WheelFeedback {
+    public:
+        GpioEncoder(int fd, const std::array<uint32_t, WHEEL_COUNT>& lines) : m_fd(fd), m_lines(lines) {}
+
+        ~GpioEncoder() override {
+            ::close(m_fd);
+        }
+
+        bool sample(EncoderSample& out) override {
+            // 读空事件缓冲区，记录每条线最新的事件序号
+            for (;;) {
+                const ssize_t n = ::read(m_fd, m_events, sizeof(m_events));
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN) return false;
+                    break;
+                }
+                const size_t count = static_cast<size_t>(n) / sizeof(gpio_v2_line_event);
+                for (size_t i = 0; i < count; ++i) {
+                    for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+                        if (m_events[i].offset == m_lines[w]) m_edges[w] = m_events[i].line_seqno;
+                    }
+                }
+                if (count < READ_BATCH) break;
+            }
+            out.time = SteadyClock::instance().now();
+            out.edges = m_edges;
+            return true;
+        }
+
+    private:
+        const int m_fd;
+        const std::array<uint32_t, WHEEL_COUNT> m_lines;
+        std::array<uint64_t, WHEEL_COUNT> m_edges{};
+        gpio_v2_line_event m_events[READ_BATCH];
+    };
+}
+
+tl::expected<std::unique_ptr<WheelFeedback>, std::string> open_gpio_encoder(
+    const std::string& chip_path, const std::array<uint32_t, WHEEL_COUNT>& lines) {
+    const int chip = ::open(chip_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (chip < 0) {
+        return tl::unexpected("Failed to open GPIO chip " + chip_path + ": " + std::strerror(errno));
+    }
+
+    gpio_v2_line_request request{};
+    for (size_t w = 0; w < WHEEL_COUNT; ++w) request.offsets[w] = lines[w];
+    request.num_lines = WHEEL_COUNT;
+    std::snprintf(request.consumer, sizeof(request.consumer), "%s", "fpvcar-encoder");
+    request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    request.event_buffer_size = EVENT_BUFFER_SIZE;
+    const int res = ::ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &request);
+    const int err = errno;
+    ::close(chip);
+    if (res < 0) {
+        return tl::unexpected("Failed to request encoder lines on " + chip_path + ": " + std::strerror(err));
+    }
+
+    // 行请求的文件描述符设为非阻塞：sample() 只读取已经到达的事件
+    const int flags = ::fcntl(request.fd, F_GETFL);
+    ::fcntl(request.fd, F_SETFL, flags | O_NONBLOCK);
+    return std::unique_ptr<WheelFeedback>(new GpioEncoder(request.fd, lines));
+}
+
+#else
+
+tl::expected<std::unique_ptr<WheelFeedback>, std::string> open_gpio_encoder(
+    const std::string&, const std::array<uint32_t, WHEEL_COUNT>&) {
+    return tl::unexpected(std::string("GPIO encoder support is disabled (built with FPVCAR_GPIO_ENCODER=OFF)"));
+}
+
+#endif
+
+}
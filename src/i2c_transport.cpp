@@ -0,0 +1,141 @@
+#include "fpvcar_device_control/i2c_transport.hpp"
+#include "fpvcar_device_control/pca9685.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace fpvcar::device_control {
+
+namespace {
+    /**
+     * @brief Linux i2c-dev 传输层：每个事务一次 I2C_RDWR ioctl（写后读使用重复起始条件，中间不释放总线）
+     */
+    class LinuxI2cTransport : public I2cTransport {
+    public:
+        LinuxI2cTransport(std::string path, uint32_t bus_speed_hz) : I2cTransport(bus_speed_hz), m_path(std::move(path)) {
+            open_device();
+        }
+
+        ~LinuxI2cTransport() override {
+            if (m_fd >= 0) ::close(m_fd);
+        }
+
+        void write(uint8_t address, const uint8_t* data, size_t size) override {
+            i2c_msg msg{};
+            msg.addr = address;
+            msg.flags = 0;
+            msg.len = static_cast<uint16_t>(size);
+            msg.buf = const_cast<uint8_t*>(data);
+            transfer(&msg, 1, size, 0);
+        }
+
+        void write_read(uint8_t address, const uint8_t* out, size_t out_size, uint8_t* in, size_t in_size) override {
+            i2c_msg msgs[2]{};
+            msgs[0].addr = address;
+            msgs[0].flags = 0;
+            msgs[0].len = static_cast<uint16_t>(out_size);
+            msgs[0].buf = const_cast<uint8_t*>(out);
+            msgs[1].addr = address;
+            msgs[1].flags = I2C_M_RD;
+            msgs[1].len = static_cast<uint16_t>(in_size);
+            msgs[1].buf = in;
+            transfer(msgs, 2, out_size, in_size);
+        }
+
+        void reopen() override {
+            if (m_fd >= 0) ::close(m_fd);
+            m_fd = -1;
+            open_device();
+        }
+
+    private:
+        void open_device() {
+            m_fd = ::open(m_path.c_str(), O_RDWR | O_CLOEXEC);
+            if (m_fd < 0) {
+                throw std::runtime_error("Failed to open I2C device " + m_path + ": " + std::strerror(errno));
+            }
+        }
+
+        void transfer(i2c_msg* msgs, uint32_t count, size_t write_bytes, size_t read_bytes) {
+            if (m_fd < 0) {
+                throw std::runtime_error("I2C device " + m_path + " is not open");
+            }
+            i2c_rdwr_ioctl_data data{msgs, count};
+            const auto start = std::chrono::steady_clock::now();
+            const int rc = ::ioctl(m_fd, I2C_RDWR, &data);
+            const int err = errno;
+            I2cTransaction transaction;
+            transaction.address = static_cast<uint8_t>(msgs[0].addr);
+            transaction.write_bytes = static_cast<uint32_t>(write_bytes);
+            transaction.read_bytes = static_cast<uint32_t>(read_bytes);
+            transaction.bus_time_ns = i2c_bus_time_ns(write_bytes, read_bytes, m_bus_speed_hz);
+            transaction.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            account(transaction, rc >= 0);
+            if (rc < 0) {
+                throw std::runtime_error("I2C transfer to 0x" + to_hex(msgs[0].addr) + " failed: " + std::strerror(err));
+            }
+        }
+
+        static std::string to_hex(uint16_t value) {
+            static const char digits[] = "0123456789abcdef";
+            return {digits[(value >> 4) & 0xf], digits[value & 0xf]};
+        }
+
+        const std::string m_path;
+        int m_fd = -1;
+    };
+}
+
+int64_t i2c_bus_time_ns(size_t write_bytes, size_t read_bytes, uint32_t bus_speed_hz) {
+    // 起始 + 地址 + 写入数据 [+ 重复起始 + 地址 + 读取数据] + 停止
+    uint64_t clocks = 1 + 9 * (1 + static_cast<uint64_t>(write_bytes)) + 1;
+    if (read_bytes > 0) clocks += 1 + 9 * (1 + static_cast<uint64_t>(read_bytes));
+    return static_cast<int64_t>(clocks * 1000000000ULL / std::max<uint32_t>(1, bus_speed_hz));
+}
+
+I2cStats I2cTransport::stats() const {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    return m_stats;
+}
+
+void I2cTransport::set_observer(TransactionObserver observer) {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    m_observer = std::move(observer);
+}
+
+void I2cTransport::account(const I2cTransaction& transaction, bool ok) {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    if (!ok) {
+        ++m_stats.errors;
+        return;
+    }
+    ++m_stats.transactions;
+    m_stats.write_bytes += transaction.write_bytes;
+    m_stats.read_bytes += transaction.read_bytes;
+    m_stats.bus_time_ns += transaction.bus_time_ns;
+    m_stats.duration_ns += transaction.duration_ns;
+    m_stats.max_bus_time_ns = std::max(m_stats.max_bus_time_ns, transaction.bus_time_ns);
+    m_stats.max_duration_ns = std::max(m_stats.max_duration_ns, transaction.duration_ns);
+    if (m_observer) m_observer(transaction);
+}
+
+tl::expected<std::unique_ptr<I2cTransport>, std::string> open_i2c_transport(
+    const std::string& device_path, uint32_t bus_speed_hz, uint8_t pca9685_address) {
+    if (device_path.rfind(I2C_EMULATOR_PREFIX, 0) == 0) {
+        return std::unique_ptr<I2cTransport>(std::make_unique<Pca9685Emulator>(pca9685_address, bus_speed_hz));
+    }
+    try {
+        return std::unique_ptr<I2cTransport>(std::make_unique<LinuxI2cTransport>(device_path, bus_speed_hz));
+    } catch (const std::exception& e) {
+        return tl::unexpected(std::string(e.what()));
+    }
+}
+
+}
@@ -0,0 +1,191 @@
+#include "fpvcar_device_control/ipc_admission.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/fast_request_parser.hpp"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <iostream>
+
+namespace fpvcar::device_control::ipc {
+
+namespace {
+    // 与 RequestHandler::create_error_response 的输出格式一致（nlohmann 按键名排序输出）
+    constexpr std::string_view RATE_LIMITED_RESPONSE =
+        "{\"error_code\":\"RATE_LIMITED\",\"message\":\"Too many requests, command dropped\",\"status\":\"error\"}";
+}
+
+BatchDispatcher::BatchDispatcher(Dispatch dispatch) : m_dispatch(std::move(dispatch)) {}
+
+AdmissionStats BatchDispatcher::stats() const {
+    AdmissionStats stats;
+    stats.rate_limited = m_rate_limited.load(std::memory_order_relaxed);
+    stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    stats.superseded = m_superseded.load(std::memory_order_relaxed);
+    stats.priority_stops = m_priority_stops.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool BatchDispatcher::take_token(TokenBucket& bucket, AdmissionClock::time_point now) const {
+    if (m_limit.rate_hz <= 0.0) return true;
+    const double burst = std::max(1.0, m_limit.burst);
+    if (!bucket.primed) {
+        bucket.tokens = burst;
+        bucket.last_refill = now;
+        bucket.primed = true;
+    } else if (now > bucket.last_refill) {
+        const double elapsed_s = std::chrono::duration<double>(now - bucket.last_refill).count();
+        bucket.tokens = std::min(burst, bucket.tokens + elapsed_s * m_limit.rate_hz);
+        bucket.last_refill = now;
+    }
+    if (bucket.tokens < 1.0) return false;
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+void BatchDispatcher::append_frame(std::string& out, std::string_view response) const {
+    const uint32_t length_net = htonl(static_cast<uint32_t>(response.size()));
+    out.append(reinterpret_cast<const char*>(&length_net), sizeof(length_net));
+    out.append(response);
+}
+
+bool BatchDispatcher::dispatch(TokenBucket& bucket, const std::vector<std::string_view>& frames,
+                               std::string& out, std::string& handoff_response) {
+    const size_t n = frames.size();
+    if (n == 0) return false;
+    if (m_entries.size() < n) m_entries.resize(n);
+    const auto now = AdmissionClock::now();
+
+    // 1. 用快速路径识别运动指令与停止指令，找到批内最后一条 stopAll
+    //    快速路径无法确定的请求（含非法请求）一律按普通请求顺序处理
+    //    令牌桶在步骤 2 才检查：停止指令不受限速，必须先知道每条请求是不是 stopAll；
+    //    这一步只做快速扫描，被限速的请求不会再被 DOM 解析或交给请求处理
+    size_t last_stop = n;
+    for (size_t i = 0; i < n; ++i) {
+        Entry& e = m_entries[i];
+        e = Entry();
+        FastRequest fast;
+        if (!parse_fast_request(frames[i], fast)) continue;
+        const std::optional<DesiredState> state = desired_state_from_action(fast.action);
+        // 与 RequestHandler 快速路径的接受条件一致，非法 ttl_ms 由 DOM 路径生成错误响应
+        if (!state || (fast.has_ttl && !lease_ttl_valid(fast.ttl_ms))) continue;
+        if (*state == DesiredState::STOPPING) {
+            e.stop = true;
+            last_stop = i;
+        } else {
+            e.motion = true;
+            e.action = fast.action;
+            e.ttl_ms = fast.has_ttl ? fast.ttl_ms : -1;
+        }
+    }
+
+    // 2. 决定每条请求的处理方式：停止指令插队且不消耗令牌，被取代的运动指令也不消耗令牌
+    uint64_t rate_limited = 0;
+    uint64_t coalesced = 0;
+    uint64_t superseded = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Entry& e = m_entries[i];
+        if (i == last_stop) {
+            e.plan = Plan::PRIORITY;
+        } else if (e.stop) {
+            // 前面的 stopAll 与最后一条合并
+            e.plan = Plan::COPY;
+            e.ref = last_stop;
+            ++coalesced;
+        } else if (i < last_stop && last_stop < n && e.motion) {
+            e.plan = Plan::SUPERSEDED;
+            ++superseded;
+        } else if (!take_token(bucket, now)) {
+            e.plan = Plan::LIMITED;
+            ++rate_limited;
+        }
+    }
+    // 3. 从后往前合并连续的相同运动指令（跳过被限速的请求），只有每组的最后一条写入期望状态
+    size_t next = n; // 后面最近的、没有被限速的请求
+    for (size_t i = n; i-- > 0;) {
+        Entry& e = m_entries[i];
+        if (e.plan == Plan::LIMITED) continue;
+        if (e.plan == Plan::RUN && e.motion && next < n) {
+            const Entry& f = m_entries[next];
+            if (f.motion && (f.plan == Plan::RUN || f.plan == Plan::COPY) && f.action == e.action && f.ttl_ms == e.ttl_ms) {
+                e.plan = Plan::COPY;
+                e.ref = f.plan == Plan::COPY ? f.ref : next;
+                ++coalesced;
+            }
+        }
+        next = i;
+    }
+
+    // 4. 执行：插队的 stopAll 最先执行，其余按到达顺序
+    size_t slots = 0;
+    for (size_t i = 0; i < n; ++i) {
+        Entry& e = m_entries[i];
+        if (e.plan == Plan::RUN || e.plan == Plan::PRIORITY) e.slot = slots++;
+    }
+    if (m_responses.size() < slots) m_responses.resize(slots);
+
+    if (last_stop < n) {
+        m_dispatch(frames[last_stop], m_responses[m_entries[last_stop].slot]);
+    }
+    size_t handoff_index = n;
+    bool ran_before_stop = false; // stopAll 之前是否有快速路径无法识别的请求在它之后执行
+    for (size_t i = 0; i < n; ++i) {
+        Entry& e = m_entries[i];
+        if (e.plan == Plan::RUN) {
+            if (i < last_stop && last_stop < n) ran_before_stop = true;
+            if (m_dispatch(frames[i], m_responses[e.slot])) {
+                handoff_index = i;
+                break;
+            }
+        } else if (i == last_stop && ran_before_stop) {
+            // 这些请求可能改变了期望状态（例如 DOM 路径的运动指令），按到达顺序再执行一次 stopAll
+            m_dispatch(frames[i], m_responses[e.slot]);
+        }
+    }
+
+    // 5. 按请求顺序写回响应
+    for (size_t i = 0; i < n && i <= handoff_index; ++i) {
+        const Entry& e = m_entries[i];
+        if (i == handoff_index) {
+            handoff_response = m_responses[e.slot];
+            break;
+        }
+        switch (e.plan) {
+            case Plan::RUN:
+            case Plan::PRIORITY:
+                append_frame(out, m_responses[e.slot]);
+                break;
+            case Plan::COPY:
+                append_frame(out, m_responses[m_entries[e.ref].slot]);
+                break;
+            case Plan::SUPERSEDED:
+                // 与成功响应格式一致：指令已被接受，只是被随后的 stopAll 取代
+                m_scratch.clear();
+                m_scratch.append("{\"message\":\"").append(e.action).append(" superseded by stopAll\",\"status\":\"ok\"}");
+                append_frame(out, m_scratch);
+                break;
+            case Plan::LIMITED:
+                append_frame(out, RATE_LIMITED_RESPONSE);
+                break;
+        }
+    }
+
+    if (last_stop < n) m_priority_stops.fetch_add(1, std::memory_order_relaxed);
+    if (coalesced > 0) m_coalesced.fetch_add(coalesced, std::memory_order_relaxed);
+    if (superseded > 0) m_superseded.fetch_add(superseded, std::memory_order_relaxed);
+    if (rate_limited > 0) {
+        m_rate_limited.fetch_add(rate_limited, std::memory_order_relaxed);
+        report(now);
+    }
+    return handoff_index < n;
+}
+
+void BatchDispatcher::report(AdmissionClock::time_point now) {
+    if (now < m_next_report) return;
+    const uint64_t total = m_rate_limited.load(std::memory_order_relaxed);
+    std::cerr << "Warning: IPC overload, shed " << (total - m_reported_rate_limited)
+              << " request(s) over the per-connection rate limit (" << m_limit.rate_hz << "/s, burst "
+              << std::max(1.0, m_limit.burst) << "); stop commands are still accepted" << std::endl;
+    m_reported_rate_limited = total;
+    m_next_report = now + std::chrono::seconds(1);
+}
+
+}
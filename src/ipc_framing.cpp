@@ -0,0 +1,126 @@
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+namespace fpvcar::device_control::ipc {
+
+namespace {
+    thread_local uint64_t t_syscall_count = 0;
+}
+
+ssize_t read_exact(int fd, void* buffer, size_t size) {
+    char* ptr = static_cast<char*>(buffer);
+    size_t left = size;
+    while (left > 0) {
+        ++t_syscall_count;
+        ssize_t n = ::read(fd, ptr, left);
+        if (n < 0) {
+            if (errno == EINTR) continue; // 被信号中断，重试
+            return -1; // 读取错误
+        }
+        if (n == 0) return 0; // 连接关闭
+        ptr += n;
+        left -= static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(size);
+}
+
+ssize_t write_exact(int fd, const void* buffer, size_t size) {
+    const char* ptr = static_cast<const char*>(buffer);
+    size_t left = size;
+    while (left > 0) {
+        // MSG_NOSIGNAL：对端已关闭时返回 EPIPE 而不是触发 SIGPIPE 终止进程
+        ++t_syscall_count;
+        ssize_t n = ::send(fd, ptr, left, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue; // 被信号中断，重试
+            return -1; // 写入错误
+        }
+        ptr += n;
+        left -= static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(size);
+}
+
+std::string read_message(int fd) {
+    std::string message;
+    if (!read_message(fd, message)) {
+        return ""; // 读取失败或连接关闭
+    }
+    return message;
+}
+
+bool read_message(int fd, std::string& message) {
+    // 先读取4字节长度前缀（网络字节序）
+    uint32_t length_net;
+    ssize_t n = read_exact(fd, &length_net, sizeof(length_net));
+    if (n != sizeof(length_net)) {
+        return false; // 读取失败或连接关闭
+    }
+    
+    // 转换为主机字节序
+    uint32_t length = ntohl(length_net);
+    
+    // 检查长度是否合理（防止恶意请求）
+    if (length == 0 || length > MAX_MESSAGE_SIZE) { // 空帧或超过最大长度
+        return false; // 非法长度，拒绝
+    }
+    
+    // 直接读入复用的缓冲区（resize 在容量足够时不分配内存）
+    message.resize(length);
+    n = read_exact(fd, message.data(), length);
+    if (n != static_cast<ssize_t>(length)) {
+        message.clear();
+        return false; // 读取失败或连接关闭
+    }
+    return true;
+}
+
+bool write_message(int fd, std::string_view message) {
+    // 将长度转换为网络字节序
+    uint32_t length = static_cast<uint32_t>(message.size());
+    uint32_t length_net = htonl(length);
+    
+    // 先写入长度前缀
+    if (write_exact(fd, &length_net, sizeof(length_net)) != sizeof(length_net)) {
+        return false;
+    }
+    
+    // 再写入消息内容
+    if (write_exact(fd, message.data(), message.size()) != static_cast<ssize_t>(message.size())) {
+        return false;
+    }
+    
+    return true;
+}
+
+void append_frame(std::string& buffer, std::string_view message) {
+    const uint32_t length_net = htonl(static_cast<uint32_t>(message.size()));
+    buffer.append(reinterpret_cast<const char*>(&length_net), sizeof(length_net));
+    buffer.append(message.data(), message.size());
+}
+
+bool split_frames(std::string_view buffer, size_t& offset, std::vector<std::string_view>& frames) {
+    while (buffer.size() - offset >= sizeof(uint32_t)) {
+        uint32_t length_net;
+        std::memcpy(&length_net, buffer.data() + offset, sizeof(length_net));
+        const uint32_t length = ntohl(length_net);
+        // 与 read_message 一致：空帧或超长帧视为非法
+        if (length == 0 || length > MAX_MESSAGE_SIZE) {
+            return false;
+        }
+        if (buffer.size() - offset - sizeof(uint32_t) < length) break; // 帧尚未接收完整
+        frames.push_back(buffer.substr(offset + sizeof(uint32_t), length));
+        offset += sizeof(uint32_t) + length;
+    }
+    return true;
+}
+
+uint64_t syscall_count() {
+    return t_syscall_count;
+}
+
+}
@@ -1,125 +1,91 @@
 #include "fpvcar_device_control/ipc_server.hpp"
+#include "fpvcar_device_control/trace.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include "fpvcar_device_control/ipc_uring.hpp"
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <errno.h>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
-#include <vector>
+#include <ctime>
 
 namespace fpvcar::device_control {
 
 namespace {
     /**
-     * @brief 从套接字读取指定长度的数据
-     * @param fd 文件描述符
-     * @param buffer 缓冲区
-     * @param size 要读取的字节数
-     * @return 成功返回读取的字节数，失败返回-1，连接关闭返回0
+     * @brief 获取当前线程消耗的 CPU 时间（纳秒）
      */
-    ssize_t read_exact(int fd, void* buffer, size_t size) {
-        char* ptr = static_cast<char*>(buffer);
-        size_t left = size;
-        while (left > 0) {
-            ssize_t n = ::read(fd, ptr, left);
-            if (n < 0) {
-                if (errno == EINTR) continue; // 被信号中断，重试
-                return -1; // 读取错误
-            }
-            if (n == 0) return 0; // 连接关闭
-            ptr += n;
-            left -= static_cast<size_t>(n);
-        }
-        return static_cast<ssize_t>(size);
+    uint64_t thread_cpu_ns() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
     }
 
-    /**
-     * @brief 向套接字写入指定长度的数据
-     * @param fd 文件描述符
-     * @param buffer 缓冲区
-     * @param size 要写入的字节数
-     * @return 成功返回写入的字节数，失败返回-1
-     */
-    ssize_t write_exact(int fd, const void* buffer, size_t size) {
-        const char* ptr = static_cast<const char*>(buffer);
-        size_t left = size;
-        while (left > 0) {
-            ssize_t n = ::write(fd, ptr, left);
-            if (n < 0) {
-                if (errno == EINTR) continue; // 被信号中断，重试
-                return -1; // 写入错误
-            }
-            ptr += n;
-            left -= static_cast<size_t>(n);
-        }
-        return static_cast<ssize_t>(size);
-    }
+    constexpr size_t RECV_CHUNK = 4096;    // 阻塞后端每轮从一个连接读取的最大字节数，即一批请求的上限
 
     /**
-     * @brief 读取一条带长度前缀的消息
-     * @param fd 文件描述符
-     * @return 成功返回消息内容，失败返回空字符串
+     * @brief 阻塞后端的一个客户端连接
+     * @note 响应以非阻塞 send 写出，写不完的部分留在 output 中等待 POLLOUT；有未发完的响应时不再读取该连接，
+     *       不读取响应的客户端因此只会停住自己（一批请求的响应有上限），不会拖住其它连接
      */
-    std::string read_message(int fd) {
-        // 先读取4字节长度前缀（网络字节序）
-        uint32_t length_net;
-        ssize_t n = read_exact(fd, &length_net, sizeof(length_net));
-        if (n != sizeof(length_net)) {
-            return ""; // 读取失败或连接关闭
-        }
-        
-        // 转换为主机字节序
-        uint32_t length = ntohl(length_net);
-        
-        // 检查长度是否合理（防止恶意请求）
-        if (length > 1024 * 1024) { // 最大1MB
-            return ""; // 长度过大，拒绝
-        }
-        
-        // 读取消息内容
-        std::vector<char> buffer(length);
-        n = read_exact(fd, buffer.data(), length);
-        if (n != static_cast<ssize_t>(length)) {
-            return ""; // 读取失败或连接关闭
-        }
-        
-        return std::string(buffer.data(), length);
+    struct BlockingConnection {
+        int fd = -1;
+        std::string input;        // 已接收但尚未解析的数据（可能以半个请求结尾）
+        size_t input_offset = 0;  // input 中已解析部分的长度
+        std::string output;       // 尚未发完的响应（带长度前缀）
+        size_t output_offset = 0; // output 中已发送部分的长度
+        bool handing_off = false;      // 已收到需要移交连接的请求，等待之前的响应发送完毕
+        bool close_after_send = false; // 收到非法帧，等之前的响应发送完毕后关闭
+        std::string handoff_response;  // 随连接一起移交的响应
+        ipc::TokenBucket bucket;  // 每连接限速
+    };
+
+    BlockingConnection make_connection(int fd) {
+        BlockingConnection conn;
+        conn.fd = fd;
+        return conn;
     }
 
-    /**
-     * @brief 写入一条带长度前缀的消息
-     * @param fd 文件描述符
-     * @param message 消息内容
-     * @return 成功返回true，失败返回false
-     */
-    bool write_message(int fd, const std::string& message) {
-        // 将长度转换为网络字节序
-        uint32_t length = static_cast<uint32_t>(message.size());
-        uint32_t length_net = htonl(length);
-        
-        // 先写入长度前缀
-        if (write_exact(fd, &length_net, sizeof(length_net)) != sizeof(length_net)) {
-            return false;
-        }
-        
-        // 再写入消息内容
-        if (write_exact(fd, message.data(), message.size()) != static_cast<ssize_t>(message.size())) {
-            return false;
-        }
-        
-        return true;
+    void close_connection(BlockingConnection& conn) {
+        ::shutdown(conn.fd, SHUT_RDWR);
+        ::close(conn.fd);
+        conn.fd = -1;
     }
 }
 
-IpcServer::IpcServer(const std::string& socket_path, IpcCallback callback)
-    : m_socket_path(socket_path), m_callback(std::move(callback)), m_listen_fd(-1), m_running(false) {}
+IpcServer::IpcServer(const std::string& socket_path, IpcCallback callback, IpcBackend backend)
+    : m_socket_path(socket_path), m_callback(std::move(callback)),
+      m_batch([this](std::string_view request, std::string& response) {
+          return dispatch(request, response) == IpcDisposition::HAND_OFF;
+      }),
+      m_listen_fd(-1), m_running(false), m_backend(backend) {}
 
 IpcServer::~IpcServer() {
     stop();
+    // prepare()/adopt() 之后没有运行过 run()：套接字仍由本对象持有
+    close_sockets();
+    if (m_wake_fd >= 0) {
+        ::close(m_wake_fd);
+        m_wake_fd = -1;
+    }
+}
+
+void IpcServer::set_handoff(IpcHandoff handoff) {
+    m_handoff = std::move(handoff);
+}
+
+void IpcServer::set_rate_limit(ipc::RateLimit limit) {
+    m_batch.set_rate_limit(limit);
 }
 
 tl::expected<void, std::string> IpcServer::prepare() {
+    // 上一次准备好但没有运行就被停止时留下的套接字
+    close_sockets();
     // 删除已存在的套接字文件（如果存在）
     ::unlink(m_socket_path.c_str());
 
@@ -153,81 +119,310 @@ tl::expected<void, std::string> IpcServer::prepare() {
         return tl::unexpected(std::string("Failed to listen on socket: ") + std::strerror(err));
     }
 
+    // 创建用于唤醒事件循环的 eventfd
+    auto wake = init_wake_fd();
+    if (!wake) {
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+        ::unlink(m_socket_path.c_str());
+        return wake;
+    }
+
     // 标记服务器已准备就绪并开始运行
+    m_detaching.store(false);
     m_running.store(true);
     m_prepared = true;
     std::cout << "IPC server listening on " << m_socket_path << std::endl;
     return {};
 }
 
+tl::expected<void, std::string> IpcServer::adopt(IpcSockets sockets) {
+    close_sockets();
+    auto wake = init_wake_fd();
+    if (!wake) {
+        if (sockets.listen_fd >= 0) ::close(sockets.listen_fd);
+        for (int fd : sockets.client_fds) ::close(fd);
+        return wake;
+    }
+
+    // 直接使用移交过来的监听套接字：套接字文件保持不变，监听队列中的连接也一并接管
+    m_listen_fd = sockets.listen_fd;
+    m_adopted_clients = std::move(sockets.client_fds);
+    m_detaching.store(false);
+    m_running.store(true);
+    m_prepared = true;
+    std::cout << "IPC server adopted " << m_socket_path << " with " << m_adopted_clients.size()
+              << " client connection(s)" << std::endl;
+    return {};
+}
+
+tl::expected<void, std::string> IpcServer::init_wake_fd() {
+    if (m_wake_fd >= 0) {
+        // 清空上一次 stop()/detach() 留下的计数
+        uint64_t value;
+        ssize_t n = ::read(m_wake_fd, &value, sizeof(value));
+        (void)n;
+        return {};
+    }
+    m_wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wake_fd < 0) {
+        return tl::unexpected(std::string("Failed to create eventfd: ") + std::strerror(errno));
+    }
+    return {};
+}
+
 void IpcServer::run() {
     // 检查服务器是否已准备就绪
     if (!m_prepared) return;
 
-    // 主循环：持续接受客户端连接
-    while (m_running.load()) {
-        // 接受新的客户端连接（阻塞调用）
-        int client_fd = ::accept(m_listen_fd, nullptr, nullptr);
-        if (client_fd < 0) {
-            // 如果服务器已停止，退出循环
-            if (!m_running.load()) break; // 如果是stop() 触发的关闭，则退出循环
-            // 如果是被信号中断的错误，则继续下一次 accept
-            continue;
+    const uint64_t cpu_start = thread_cpu_ns();
+    bool served = false;
+    if (m_backend == IpcBackend::IO_URING) {
+        auto res = run_uring();
+        if (res) {
+            served = true;
+        } else if (m_running.load()) {
+            // 内核不支持 io_uring 或运行出错：回退到阻塞读写路径
+            std::cerr << "io_uring backend unavailable (" << res.error() << "), falling back to blocking I/O" << std::endl;
         }
+    }
+    if (!served) {
+        run_blocking();
+    }
+    m_cpu_ns.store(thread_cpu_ns() - cpu_start);
+
+    if (m_detaching.load()) {
+        // detach()：保留监听套接字和套接字文件，交给接管的进程
+        m_detached.listen_fd = m_listen_fd;
+        m_listen_fd = -1;
+        m_detached.client_fds.insert(m_detached.client_fds.end(), m_adopted_clients.begin(), m_adopted_clients.end());
+        m_adopted_clients.clear();
+        return;
+    }
+
+    // 清理：关闭监听套接字并删除套接字文件
+    close_sockets();
+    ::unlink(m_socket_path.c_str());
+}
+
+void IpcServer::close_sockets() {
+    for (int fd : m_adopted_clients) ::close(fd);
+    m_adopted_clients.clear();
+    if (m_listen_fd >= 0) {
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+    }
+}
+
+tl::expected<void, std::string> IpcServer::run_uring() {
+    auto loop = ipc::UringLoop::create(m_listen_fd, m_wake_fd);
+    if (!loop) return tl::unexpected(loop.error());
+    std::cout << "IPC server using io_uring backend" << std::endl;
+
+    (*loop)->adopt(std::move(m_adopted_clients));
+    m_adopted_clients.clear();
+    auto res = (*loop)->run(m_running, m_detaching, m_batch,
+        [this](int fd, std::string response) { m_handoff(fd, std::move(response)); });
+    m_commands.fetch_add((*loop)->commands());
+    m_syscalls.fetch_add((*loop)->syscalls());
+    for (int fd : (*loop)->take_detached()) m_detached.client_fds.push_back(fd);
+    // 回退到阻塞后端时，尚未交给事件循环的接管连接由阻塞后端继续服务
+    for (int fd : (*loop)->take_adopted()) m_adopted_clients.push_back(fd);
+    return res;
+}
 
-        // 在单个连接上循环处理多个请求（保持长连接）
-        while (m_running.load()) {
-            // 读取带长度前缀的请求消息
-            std::string request = read_message(client_fd);
-            if (request.empty()) {
-                // 读取失败或连接关闭，退出内层循环
-                break;
+void IpcServer::run_blocking() {
+    // 所有缓冲区在轮次间复用，容量增长到稳态后不再分配
+    std::vector<BlockingConnection> conns;
+    for (int fd : m_adopted_clients) conns.push_back(make_connection(fd));
+    m_adopted_clients.clear();
+    std::vector<pollfd> fds;
+    std::vector<std::string_view> frames;
+    char chunk[RECV_CHUNK];
+
+    // 尽量写出连接上排队的响应（不阻塞），返回 false 表示连接已失效
+    auto flush = [this](BlockingConnection& conn) {
+        if (conn.output.empty()) return true;
+        trace::Span write_span("IpcServer::write_message", trace::current_request_id());
+        while (conn.output_offset < conn.output.size()) {
+            m_syscalls.fetch_add(1, std::memory_order_relaxed);
+            const ssize_t n = ::send(conn.fd, conn.output.data() + conn.output_offset,
+                                     conn.output.size() - conn.output_offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
             }
+            conn.output_offset += static_cast<size_t>(n);
+        }
+        conn.output.clear();
+        conn.output_offset = 0;
+        return true;
+    };
+
+    while (m_running.load()) {
+        // fds[0] 为唤醒 eventfd（stop()/detach()），fds[1] 为监听套接字，之后依次为各连接：
+        // 有未发完的响应的连接只等待可写，其余等待可读
+        fds.clear();
+        fds.push_back({m_wake_fd, POLLIN, 0});
+        fds.push_back({m_listen_fd, POLLIN, 0});
+        for (const auto& conn : conns) {
+            const bool sending = conn.output_offset < conn.output.size();
+            fds.push_back({conn.fd, static_cast<short>(sending ? POLLOUT : POLLIN), 0});
+        }
+        m_syscalls.fetch_add(1, std::memory_order_relaxed);
+        if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        // 唤醒优先：每轮都在帧边界结束，未读取的数据留在内核缓冲区中
+        if (fds[0].revents != 0) break;
+
+        // 每个可读连接每轮只读取一次（最多 RECV_CHUNK 字节）：洪泛的连接不会饿死其它连接，
+        // 读不完的数据留在内核缓冲区中，使对端受到发送背压
+        for (size_t i = 0; i < conns.size(); ++i) {
+            if (fds[i + 2].revents == 0) continue;
+            BlockingConnection& conn = conns[i];
+
+            if (fds[i + 2].events == POLLOUT) {
+                // 继续写出排队的响应；对端关闭或出错时 send 失败
+                if (!flush(conn)) {
+                    close_connection(conn);
+                    continue;
+                }
+            } else {
+                m_syscalls.fetch_add(1, std::memory_order_relaxed);
+                const ssize_t n = ::recv(conn.fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    if (n < 0 && errno == EINTR) continue;
+                    close_connection(conn);
+                    continue;
+                }
+                conn.input.append(chunk, static_cast<size_t>(n));
+
+                // 请求直接引用输入缓冲区，处理完这一批之前不修改它
+                frames.clear();
+                const bool valid = ipc::split_frames(conn.input, conn.input_offset, frames);
+                conn.handing_off = m_batch.dispatch(conn.bucket, frames, conn.output, conn.handoff_response);
+                m_commands.fetch_add(frames.size(), std::memory_order_relaxed);
+                conn.close_after_send = !valid && !conn.handing_off;
+
+                // 写出这一批的全部响应（通常一次 send 即可写完）；写入失败时连接可能已关闭，断开它
+                if (!flush(conn)) {
+                    close_connection(conn);
+                    continue;
+                }
 
-            // 调用回调函数处理请求，捕获所有异常
-            std::string response;
-            try {
-                response = m_callback ? m_callback(request) : std::string("{\"status\":\"error\",\"error_code\":\"NO_HANDLER\",\"message\":\"No handler set\"}");
-            } catch (const std::exception& e) {
-                // 如果回调函数抛出异常，返回服务器错误响应
-                response = std::string("{\"status\":\"error\",\"error_code\":\"SERVER_ERROR\",\"message\":\"") + e.what() + "\"}";
+                // 已解析的数据过多时压缩缓冲区
+                if (conn.input_offset == conn.input.size()) {
+                    conn.input.clear();
+                    conn.input_offset = 0;
+                } else if (conn.input_offset * 2 >= conn.input.size()) {
+                    conn.input.erase(0, conn.input_offset);
+                    conn.input_offset = 0;
+                }
             }
+            if (conn.output_offset < conn.output.size()) continue; // 等待可写
 
-            // 写入带长度前缀的响应消息
-            if (!write_message(client_fd, response)) {
-                // 写入失败，连接可能已关闭，退出内层循环
-                break;
+            if (conn.handing_off) {
+                // 移交连接：之前的响应都已写完，响应由接收方发送，本线程不再读写该连接
+                m_handoff(conn.fd, std::move(conn.handoff_response));
+                conn.handoff_response = std::string();
+                conn.fd = -1;
+            } else if (conn.close_after_send) {
+                // 收到非法帧：之前合法请求的响应已写完，断开连接
+                close_connection(conn);
             }
         }
+        conns.erase(std::remove_if(conns.begin(), conns.end(),
+                                   [](const BlockingConnection& conn) { return conn.fd < 0; }),
+                    conns.end());
 
-        // 关闭客户端连接（双向关闭，确保数据发送完成）
-        ::shutdown(client_fd, SHUT_RDWR);
-        ::close(client_fd);
+        // 接受新的客户端连接
+        if (fds[1].revents != 0) {
+            m_syscalls.fetch_add(1, std::memory_order_relaxed);
+            const int client_fd = ::accept(m_listen_fd, nullptr, nullptr);
+            // 失败（被信号中断、连接已被对端放弃等）时等待下一轮
+            if (client_fd >= 0) conns.push_back(make_connection(client_fd));
+        }
     }
 
-    // 清理：关闭监听套接字并删除套接字文件
-    if (m_listen_fd >= 0) {
-        ::close(m_listen_fd);
-        m_listen_fd = -1;
+    for (auto& conn : conns) {
+        if (m_detaching.load() && conn.input_offset == conn.input.size() && conn.output.empty() &&
+            !conn.handing_off && !conn.close_after_send) {
+            // detach()：连接停在帧边界且响应都已发完，连同监听套接字一起移交
+            m_detached.client_fds.push_back(conn.fd);
+            continue;
+        }
+        // 关闭客户端连接（双向关闭，确保数据发送完成）；读了一半请求或响应没有发完的连接无法移交，只能关闭
+        close_connection(conn);
     }
-    ::unlink(m_socket_path.c_str());
+}
+
+IpcDisposition IpcServer::dispatch(std::string_view request, std::string& response) {
+    // 追踪：为每条消息分配请求 ID，后续各阶段的追踪片段都会关联到它
+    const uint64_t request_id = trace::is_enabled() ? trace::next_request_id() : 0;
+    trace::set_current_request_id(request_id);
+    trace::Span run_span("IpcServer::run", request_id);
+
+    // 调用回调函数处理请求，捕获所有异常
+    try {
+        if (m_callback) {
+            const IpcDisposition disposition = m_callback(request, response);
+            return m_handoff ? disposition : IpcDisposition::KEEP;
+        } else {
+            response = "{\"status\":\"error\",\"error_code\":\"NO_HANDLER\",\"message\":\"No handler set\"}";
+        }
+    } catch (const std::exception& e) {
+        // 如果回调函数抛出异常，返回服务器错误响应
+        response = std::string("{\"status\":\"error\",\"error_code\":\"SERVER_ERROR\",\"message\":\"") + e.what() + "\"}";
+    }
+    return IpcDisposition::KEEP;
 }
 
 void IpcServer::stop() {
     // 原子地设置运行标志为 false，如果已经是 false 则直接返回（避免重复停止）
     if (!m_running.exchange(false)) return;
-    
-    if (m_listen_fd >= 0) {
-        // 关闭监听套接字，这会中断正在阻塞的 accept 调用
-        // 触发 accept 返回错误，从而退出 run() 中的循环
-        ::shutdown(m_listen_fd, SHUT_RDWR);
-        ::close(m_listen_fd);
-        m_listen_fd = -1;
+
+    // 唤醒事件循环（io_uring 后端，以及阻塞后端的 poll）
+    if (m_wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = ::write(m_wake_fd, &one, sizeof(one));
+        (void)n;
     }
-    // 删除套接字文件，清理文件系统资源
+
+    // 监听套接字由 run() 退出时在服务器线程关闭（未运行时由析构函数关闭）：
+    // 在这里关闭会与正在 poll/accept 它的服务器线程竞争，fd 编号还可能已被复用
+    // 删除套接字文件，新的客户端立即连接失败
     ::unlink(m_socket_path.c_str());
 }
 
+void IpcServer::detach() {
+    // 先标记再清除运行标志，保证 run() 退出时看到 detach
+    m_detaching.store(true);
+    if (!m_running.exchange(false)) {
+        m_detaching.store(false); // 已经停止，没有可移交的套接字
+        return;
+    }
+    if (m_wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = ::write(m_wake_fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+IpcSockets IpcServer::take_detached() {
+    IpcSockets sockets = std::move(m_detached);
+    m_detached = IpcSockets();
+    return sockets;
 }
 
+IpcServerStats IpcServer::stats() const {
+    IpcServerStats stats;
+    stats.commands = m_commands.load();
+    stats.syscalls = m_syscalls.load();
+    stats.cpu_ns = m_cpu_ns.load();
+    stats.admission = m_batch.stats();
+    return stats;
+}
 
+}
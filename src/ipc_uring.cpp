@@ -0,0 +1,657 @@
+#include "fpvcar_device_control/ipc_uring.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include <sys/mman.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+// 内核头文件过旧（缺少多发 recv / 缓冲区环）时只编译回退实现，运行时由 IpcServer 使用阻塞路径
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT) && defined(__NR_io_uring_setup)
+#define FPVCAR_HAVE_IO_URING 1
+#endif
+
+namespace fpvcar::device_control::ipc {
+
+#ifdef FPVCAR_HAVE_IO_URING
+
+namespace {
+    constexpr unsigned RING_ENTRIES = 256;     // 提交队列长度
+    constexpr unsigned BUF_COUNT = 64;         // 缓冲区环中的缓冲区数量（必须是 2 的幂）
+    constexpr unsigned BUF_SIZE = 2048;        // 单个接收缓冲区大小
+    constexpr uint16_t BUF_GROUP_ID = 0;       // 缓冲区组 ID
+    // 每个连接排队未发送的响应上限：超过后暂停接收该连接（取消 recv），未读取的请求留在内核缓冲区中，
+    // 洪泛的客户端受到发送背压，也不会占满缓冲区环而饿死其它连接；排队量降到一半以下时恢复接收
+    constexpr size_t MAX_QUEUED_OUTPUT = 64 * 1024;
+
+    // user_data 编码：高 16 位为操作类型，低 48 位为连接 ID
+    enum class Op : uint64_t { ACCEPT = 1, RECV = 2, SEND = 3, WAKE = 4, CANCEL = 5 };
+
+    uint64_t encode(Op op, uint64_t conn_id) {
+        return (static_cast<uint64_t>(op) << 48) | (conn_id & ((1ull << 48) - 1));
+    }
+    Op decode_op(uint64_t user_data) {
+        return static_cast<Op>(user_data >> 48);
+    }
+    uint64_t decode_conn(uint64_t user_data) {
+        return user_data & ((1ull << 48) - 1);
+    }
+
+    template <typename T>
+    T load_acquire(const T* p) {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+    template <typename T>
+    void store_release(T* p, T v) {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * @brief 一个客户端连接的状态
+     * @note 连接关闭后要等所有已提交的操作完成（ops == 0）才能释放
+     */
+    struct Connection {
+        int fd = -1;
+        std::string input;        // 已接收但尚未解析的数据
+        size_t input_offset = 0;  // input 中已解析部分的长度
+        std::string inflight;     // 正在发送的响应数据（send 完成前必须保持不变）
+        size_t inflight_offset = 0;
+        std::string pending;      // 等待下一次 send 的响应数据
+        bool send_inflight = false;
+        bool recv_armed = false;
+        bool closing = false;
+        bool handing_off = false;  // 已收到需要移交连接的请求，等待之前的响应发送完毕
+        bool close_after_send = false; // 收到非法帧，不再接收，等之前的响应发送完毕后关闭
+        bool detaching = false;    // 服务移交给其它进程：不再接收新数据，等在途操作完成后保留连接
+        bool throttled = false;    // 排队的响应超过 MAX_QUEUED_OUTPUT，暂停接收
+        bool single_shot = false;  // 曾经被暂停接收的连接改用单次 recv：每轮事件循环最多取一个缓冲区
+        std::string handoff_response; // 随连接一起移交的响应
+        TokenBucket bucket;       // 每连接限速
+        int ops = 0;              // 已提交未完成的操作数
+    };
+}
+
+struct UringLoop::Impl {
+    int ring_fd = -1;
+    int listen_fd = -1;
+    int wake_fd = -1; // stop() 写入的 eventfd，用于唤醒阻塞在 io_uring_enter 中的循环
+
+    // 提交队列 / 完成队列映射
+    void* sq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    void* cq_ptr = MAP_FAILED;
+    size_t cq_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_entries = 0;
+    unsigned sq_local_tail = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // 提供缓冲区环
+    void* buf_ring = MAP_FAILED;
+    size_t buf_ring_size = 0;
+    uint16_t* buf_ring_tail = nullptr;
+    uint16_t buf_local_tail = 0;
+    std::vector<char> buffers;
+
+    bool multishot_recv = true; // 内核不支持多发 recv 时退化为单次 recv
+    bool accept_armed = false;
+    bool accepted = false;       // 是否已经接收过连接（多发 accept 可用）
+    bool accept_failed = false;  // 多发 accept 失败且无法回退：不再重新提交
+    bool wake_armed = false;
+    uint64_t next_conn_id = 1;
+    std::unordered_map<uint64_t, Connection> conns;
+    std::vector<int> adopted;    // run() 开始时加入的已建立连接
+    std::vector<int> detached;   // detach 模式下保留的连接
+    std::vector<uint64_t> dirty; // 本批次产生了响应、需要发送的连接
+    std::vector<std::string_view> frames; // 一个连接上本次解析出的完整请求（复用）
+
+    ~Impl() {
+        if (ring_fd >= 0) ::close(ring_fd);
+        if (sqes != MAP_FAILED) ::munmap(sqes, sqes_size);
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) ::munmap(cq_ptr, cq_size);
+        if (sq_ptr != MAP_FAILED) ::munmap(sq_ptr, sq_size);
+        if (buf_ring != MAP_FAILED) ::munmap(buf_ring, buf_ring_size);
+    }
+
+    io_uring_sqe* get_sqe() {
+        unsigned head = load_acquire(sq_head);
+        if (sq_local_tail - head >= sq_entries) return nullptr;
+        unsigned index = sq_local_tail & sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        ++sq_local_tail;
+        return sqe;
+    }
+
+    /**
+     * @brief 提交所有待提交的 SQE，并等待至少 min_complete 个完成事件
+     * @return io_uring_enter 的返回值，失败时为 -errno
+     */
+    int enter(unsigned min_complete, uint64_t& syscalls) {
+        store_release(sq_tail, sq_local_tail);
+        unsigned to_submit = sq_local_tail - load_acquire(sq_head);
+        unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        ++syscalls;
+        int ret = static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+        return ret < 0 ? -errno : ret;
+    }
+
+    /**
+     * @brief 完成队列中是否有 accept 以 -EINVAL 完成（内核不支持多发 accept），不消费完成事件
+     */
+    bool accept_rejected() const {
+        const unsigned tail = load_acquire(cq_tail);
+        for (unsigned head = *cq_head; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes[head & cq_mask];
+            if (decode_op(cqe.user_data) == Op::ACCEPT && cqe.res == -EINVAL) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 获取一个 SQE，提交队列已满时先提交一次
+     */
+    io_uring_sqe* acquire_sqe(uint64_t& syscalls) {
+        io_uring_sqe* sqe = get_sqe();
+        while (sqe == nullptr) {
+            enter(0, syscalls);
+            sqe = get_sqe();
+        }
+        return sqe;
+    }
+
+    void add_buffer(uint16_t bid) {
+        auto* bufs = static_cast<io_uring_buf*>(buf_ring);
+        io_uring_buf& buf = bufs[buf_local_tail & (BUF_COUNT - 1)];
+        buf.addr = reinterpret_cast<uint64_t>(buffers.data() + static_cast<size_t>(bid) * BUF_SIZE);
+        buf.len = BUF_SIZE;
+        buf.bid = bid;
+        ++buf_local_tail;
+    }
+
+    void publish_buffers() {
+        store_release(buf_ring_tail, buf_local_tail);
+    }
+
+    void arm_accept(uint64_t& syscalls) {
+        io_uring_sqe* sqe = acquire_sqe(syscalls);
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listen_fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->user_data = encode(Op::ACCEPT, 0);
+        accept_armed = true;
+    }
+
+    void arm_wake(uint64_t& syscalls) {
+        io_uring_sqe* sqe = acquire_sqe(syscalls);
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = wake_fd;
+        sqe->poll32_events = POLLIN;
+        sqe->user_data = encode(Op::WAKE, 0);
+        wake_armed = true;
+    }
+
+    void arm_recv(uint64_t id, Connection& conn, uint64_t& syscalls) {
+        io_uring_sqe* sqe = acquire_sqe(syscalls);
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = conn.fd;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUF_GROUP_ID;
+        sqe->ioprio = multishot_recv && !conn.single_shot ? IORING_RECV_MULTISHOT : 0;
+        sqe->user_data = encode(Op::RECV, id);
+        conn.recv_armed = true;
+        ++conn.ops;
+    }
+
+    void arm_send(uint64_t id, Connection& conn, uint64_t& syscalls) {
+        io_uring_sqe* sqe = acquire_sqe(syscalls);
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = conn.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(conn.inflight.data() + conn.inflight_offset);
+        sqe->len = static_cast<uint32_t>(conn.inflight.size() - conn.inflight_offset);
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = encode(Op::SEND, id);
+        conn.send_inflight = true;
+        ++conn.ops;
+    }
+
+    /**
+     * @brief 取消连接上挂起的多发 recv（移交连接时使用，不能 shutdown 套接字）
+     */
+    void cancel_recv(uint64_t id, uint64_t& syscalls) {
+        io_uring_sqe* sqe = acquire_sqe(syscalls);
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = encode(Op::RECV, id);
+        sqe->user_data = encode(Op::CANCEL, id);
+    }
+
+    /**
+     * @brief 取消挂起的多发 accept（detach 时使用，监听套接字要原样交给接管的进程）
+     */
+    void cancel_accept(uint64_t& syscalls) {
+        io_uring_sqe* sqe = acquire_sqe(syscalls);
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = encode(Op::ACCEPT, 0);
+        sqe->user_data = encode(Op::CANCEL, 0);
+    }
+
+    /**
+     * @brief 开始保留连接：取消 recv，之后不再重新提交
+     */
+    void begin_detach(uint64_t id, Connection& conn, uint64_t& syscalls) {
+        if (conn.closing || conn.detaching) return;
+        conn.detaching = true;
+        if (conn.recv_armed) cancel_recv(id, syscalls);
+    }
+
+    /**
+     * @brief 移交连接：把 fd 的副本和响应交给 handoff，然后停止本循环对该连接的读写
+     * @note 只在该连接没有在途 send、也没有待发送响应时调用，保证响应顺序
+     */
+    void hand_off(uint64_t id, Connection& conn, const Handoff& handoff, uint64_t& syscalls) {
+        conn.handing_off = false;
+        conn.closing = true;
+        int fd = ::dup(conn.fd);
+        if (fd >= 0) {
+            handoff(fd, std::move(conn.handoff_response));
+        } else {
+            ::shutdown(conn.fd, SHUT_RDWR);
+        }
+        if (conn.recv_armed) cancel_recv(id, syscalls);
+    }
+
+    void close_conn(Connection& conn) {
+        if (conn.closing) return;
+        conn.closing = true;
+        // shutdown 会让挂起的 recv/send 尽快完成，之后再真正关闭 fd
+        ::shutdown(conn.fd, SHUT_RDWR);
+    }
+
+    /**
+     * @brief 连接上排队（在途与等待发送）的响应字节数
+     */
+    static size_t queued_output(const Connection& conn) {
+        return conn.inflight.size() - conn.inflight_offset + conn.pending.size();
+    }
+
+    /**
+     * @brief 解析连接输入缓冲区中的完整帧，作为一批交给 dispatcher 并生成响应
+     * @return 处理的帧数
+     */
+    uint64_t process_frames(uint64_t id, Connection& conn, BatchDispatcher& dispatcher, uint64_t& syscalls) {
+        if (conn.closing || conn.handing_off || conn.close_after_send) return 0;
+        // 请求直接引用输入缓冲区，dispatcher 返回前输入缓冲区不会被修改
+        frames.clear();
+        const bool valid = split_frames(conn.input, conn.input_offset, frames);
+        if (!frames.empty()) {
+            const bool was_empty = conn.pending.empty();
+            if (dispatcher.dispatch(conn.bucket, frames, conn.pending, conn.handoff_response)) {
+                // 移交连接：移交请求的响应不经本循环发送，等之前的响应发完后再移交
+                conn.handing_off = true;
+            }
+            if (was_empty && !conn.pending.empty()) dirty.push_back(id);
+        }
+        // 与阻塞路径一致：空帧或超长帧断开连接，但先发出此前合法请求的响应
+        if (!valid) {
+            if (queued_output(conn) == 0) {
+                close_conn(conn);
+            } else {
+                conn.close_after_send = true;
+                if (conn.recv_armed) cancel_recv(id, syscalls);
+            }
+        }
+        if (!conn.throttled && !conn.closing && !conn.close_after_send && queued_output(conn) > MAX_QUEUED_OUTPUT) {
+            conn.throttled = true;
+            conn.single_shot = true;
+            if (conn.recv_armed) cancel_recv(id, syscalls);
+        }
+        // 已解析的数据过多时压缩缓冲区
+        if (conn.input_offset > 0 && conn.input_offset * 2 >= conn.input.size()) {
+            conn.input.erase(0, conn.input_offset);
+            conn.input_offset = 0;
+        }
+        return frames.size();
+    }
+
+    /**
+     * @brief 为本批次产生响应的连接提交 send（每个连接最多一个在途 send）
+     */
+    void flush_sends(uint64_t& syscalls) {
+        for (uint64_t id : dirty) {
+            auto it = conns.find(id);
+            if (it == conns.end()) continue;
+            Connection& conn = it->second;
+            if (conn.closing || conn.send_inflight || conn.pending.empty()) continue;
+            conn.inflight.swap(conn.pending);
+            conn.pending.clear();
+            conn.inflight_offset = 0;
+            arm_send(id, conn, syscalls);
+        }
+        dirty.clear();
+    }
+};
+
+UringLoop::UringLoop(std::unique_ptr<Impl> impl) : m_impl(std::move(impl)) {}
+
+UringLoop::~UringLoop() = default;
+
+tl::expected<std::unique_ptr<UringLoop>, std::string> UringLoop::create(int listen_fd, int wake_fd) {
+    auto impl = std::make_unique<Impl>();
+    impl->listen_fd = listen_fd;
+    impl->wake_fd = wake_fd;
+
+    io_uring_params params{};
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+    if (fd < 0) {
+        return tl::unexpected(std::string("io_uring_setup failed: ") + std::strerror(errno));
+    }
+    impl->ring_fd = fd;
+
+    // 映射提交队列、完成队列和 SQE 数组
+    impl->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    impl->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        impl->sq_size = impl->cq_size = std::max(impl->sq_size, impl->cq_size);
+    }
+    impl->sq_ptr = ::mmap(nullptr, impl->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (impl->sq_ptr == MAP_FAILED) {
+        return tl::unexpected(std::string("Failed to map io_uring SQ ring: ") + std::strerror(errno));
+    }
+    if (single_mmap) {
+        impl->cq_ptr = impl->sq_ptr;
+    } else {
+        impl->cq_ptr = ::mmap(nullptr, impl->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (impl->cq_ptr == MAP_FAILED) {
+            return tl::unexpected(std::string("Failed to map io_uring CQ ring: ") + std::strerror(errno));
+        }
+    }
+    impl->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    impl->sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, impl->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (impl->sqes == MAP_FAILED) {
+        return tl::unexpected(std::string("Failed to map io_uring SQEs: ") + std::strerror(errno));
+    }
+
+    char* sq = static_cast<char*>(impl->sq_ptr);
+    impl->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    impl->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    impl->sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    impl->sq_entries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    impl->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    impl->sq_local_tail = *impl->sq_tail;
+    char* cq = static_cast<char*>(impl->cq_ptr);
+    impl->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    impl->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    impl->cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    impl->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // 注册提供缓冲区环（内核 5.19+）；失败说明内核不支持所需特性
+    impl->buf_ring_size = BUF_COUNT * sizeof(io_uring_buf);
+    impl->buf_ring = ::mmap(nullptr, impl->buf_ring_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (impl->buf_ring == MAP_FAILED) {
+        return tl::unexpected(std::string("Failed to allocate buffer ring: ") + std::strerror(errno));
+    }
+    // 环尾指针与第一个 io_uring_buf 的 resv 字段重叠
+    impl->buf_ring_tail = reinterpret_cast<uint16_t*>(static_cast<char*>(impl->buf_ring) + offsetof(io_uring_buf, resv));
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(impl->buf_ring);
+    reg.ring_entries = BUF_COUNT;
+    reg.bgid = BUF_GROUP_ID;
+    if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        return tl::unexpected(std::string("Failed to register io_uring buffer ring: ") + std::strerror(errno));
+    }
+    impl->buffers.resize(static_cast<size_t>(BUF_COUNT) * BUF_SIZE);
+    for (uint16_t bid = 0; bid < BUF_COUNT; ++bid) {
+        impl->add_buffer(bid);
+    }
+    impl->publish_buffers();
+
+    return std::unique_ptr<UringLoop>(new UringLoop(std::move(impl)));
+}
+
+void UringLoop::adopt(std::vector<int> client_fds) {
+    m_impl->adopted.insert(m_impl->adopted.end(), client_fds.begin(), client_fds.end());
+}
+
+std::vector<int> UringLoop::take_adopted() {
+    std::vector<int> fds;
+    fds.swap(m_impl->adopted);
+    return fds;
+}
+
+std::vector<int> UringLoop::take_detached() {
+    std::vector<int> fds;
+    fds.swap(m_impl->detached);
+    return fds;
+}
+
+tl::expected<void, std::string> UringLoop::run(const std::atomic<bool>& running, const std::atomic<bool>& detach,
+                                               BatchDispatcher& dispatcher, const Handoff& handoff) {
+    Impl& r = *m_impl;
+    r.arm_accept(m_syscalls);
+    r.arm_wake(m_syscalls);
+    // 先单独提交 accept：内核不支持多发 accept 时它在提交时即以 -EINVAL 完成，
+    // 此时接管的连接还没有提交 recv、没有被读取过，回退到阻塞后端时原样交还（见 take_adopted()）
+    r.enter(0, m_syscalls);
+    if (r.accept_rejected()) return tl::unexpected(std::string("multishot accept not supported"));
+    for (int fd : r.adopted) {
+        uint64_t conn_id = r.next_conn_id++;
+        Connection& conn = r.conns[conn_id];
+        conn.fd = fd;
+        r.arm_recv(conn_id, conn, m_syscalls);
+    }
+    r.adopted.clear();
+
+    bool shutting_down = false;
+    bool detaching = false;
+    while (true) {
+        // 停止：关闭所有客户端连接，等待在途操作完成后退出
+        // detach：取消 accept 和 recv，等在途操作完成，保留停在帧边界的连接
+        if (!running.load() && !shutting_down) {
+            shutting_down = true;
+            detaching = detach.load();
+            if (detaching) {
+                if (r.accept_armed) r.cancel_accept(m_syscalls);
+                for (auto& [id, conn] : r.conns) r.begin_detach(id, conn, m_syscalls);
+            } else {
+                for (auto& [id, conn] : r.conns) r.close_conn(conn);
+            }
+        }
+        if (shutting_down && r.conns.empty() && !(detaching && r.accept_armed)) break;
+
+        int ret = r.enter(1, m_syscalls);
+        if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+            for (auto& [id, conn] : r.conns) ::close(conn.fd);
+            r.conns.clear();
+            return tl::unexpected(std::string("io_uring_enter failed: ") + std::strerror(-ret));
+        }
+
+        // 收割本批次所有完成事件
+        unsigned head = *r.cq_head;
+        const unsigned tail = load_acquire(r.cq_tail);
+        bool buffers_returned = false;
+        for (; head != tail; ++head) {
+            const io_uring_cqe cqe = r.cqes[head & r.cq_mask];
+            const bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+            const uint64_t id = decode_conn(cqe.user_data);
+
+            switch (decode_op(cqe.user_data)) {
+                case Op::ACCEPT: {
+                    if (!more) r.accept_armed = false;
+                    if (cqe.res >= 0) {
+                        r.accepted = true;
+                        if (detaching) {
+                            // 取消 accept 之前刚接收的连接：还没有读过数据，直接保留
+                            uint64_t conn_id = r.next_conn_id++;
+                            Connection& conn = r.conns[conn_id];
+                            conn.fd = cqe.res;
+                            conn.detaching = true;
+                        } else if (shutting_down) {
+                            ::close(cqe.res);
+                        } else {
+                            uint64_t conn_id = r.next_conn_id++;
+                            Connection& conn = r.conns[conn_id];
+                            conn.fd = cqe.res;
+                            r.arm_recv(conn_id, conn, m_syscalls);
+                        }
+                    } else if (cqe.res == -EINVAL && !r.accepted && r.conns.empty() && running.load()) {
+                        // 内核不支持多发 accept，尚未接收或接管任何连接，可以安全回退
+                        *r.cq_head = head + 1;
+                        return tl::unexpected(std::string("multishot accept not supported"));
+                    } else if (cqe.res == -EINVAL && !r.accept_failed) {
+                        // 已有连接在本循环中读写，不能回退：继续服务这些连接，但不再接收新连接
+                        r.accept_failed = true;
+                        std::cerr << "Error: io_uring accept failed (" << std::strerror(-cqe.res)
+                                  << "), no new IPC connections will be accepted" << std::endl;
+                    }
+                    if (!r.accept_armed && !r.accept_failed && running.load()) r.arm_accept(m_syscalls);
+                    break;
+                }
+                case Op::CANCEL:
+                    break; // 被取消的 recv 会以 -ECANCELED 单独完成
+                case Op::WAKE: {
+                    // stop() 已清除运行标志，下一轮循环开始关闭连接
+                    r.wake_armed = false;
+                    if (running.load()) r.arm_wake(m_syscalls);
+                    break;
+                }
+                case Op::RECV: {
+                    auto it = r.conns.find(id);
+                    if (it == r.conns.end()) break;
+                    Connection& conn = it->second;
+                    if (!more) {
+                        conn.recv_armed = false;
+                        --conn.ops;
+                    }
+                    if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+                        const uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                        conn.input.append(r.buffers.data() + static_cast<size_t>(bid) * BUF_SIZE, static_cast<size_t>(cqe.res));
+                        r.add_buffer(bid);
+                        buffers_returned = true;
+                        m_commands += r.process_frames(id, conn, dispatcher, m_syscalls);
+                    } else if (cqe.res == 0) {
+                        r.close_conn(conn); // 对端关闭
+                    } else if (cqe.res == -EINVAL && r.multishot_recv) {
+                        r.multishot_recv = false; // 内核不支持多发 recv，退化为单次 recv
+                    } else if (cqe.res == -ECANCELED && (conn.detaching || conn.throttled || conn.close_after_send)) {
+                        // detach、暂停接收或等待关闭取消的 recv：连接保留，未读取的数据留在内核缓冲区中
+                    } else if (cqe.res < 0 && cqe.res != -ENOBUFS) {
+                        r.close_conn(conn);
+                    }
+                    // 多发 recv 终止（或单次 recv 完成）后重新提交
+                    if (!conn.recv_armed && !conn.closing && !conn.detaching && !conn.throttled && !conn.close_after_send) {
+                        r.arm_recv(id, conn, m_syscalls);
+                    }
+                    break;
+                }
+                case Op::SEND: {
+                    auto it = r.conns.find(id);
+                    if (it == r.conns.end()) break;
+                    Connection& conn = it->second;
+                    --conn.ops;
+                    conn.send_inflight = false;
+                    if (cqe.res < 0) {
+                        r.close_conn(conn);
+                        break;
+                    }
+                    conn.inflight_offset += static_cast<size_t>(cqe.res);
+                    if (conn.closing) break;
+                    if (conn.inflight_offset < conn.inflight.size()) {
+                        r.arm_send(id, conn, m_syscalls); // 部分发送，继续发送剩余部分
+                    } else if (!conn.pending.empty()) {
+                        r.dirty.push_back(id);
+                    }
+                    // 排队的响应已基本发出：恢复接收
+                    if (conn.throttled && Impl::queued_output(conn) < MAX_QUEUED_OUTPUT / 2) {
+                        conn.throttled = false;
+                        if (!conn.recv_armed && !conn.detaching && !conn.handing_off && !conn.close_after_send) r.arm_recv(id, conn, m_syscalls);
+                    }
+                    break;
+                }
+            }
+        }
+        store_release(r.cq_head, head);
+
+        if (buffers_returned) r.publish_buffers();
+        r.flush_sends(m_syscalls);
+
+        // 移交响应已全部发出的连接，释放已关闭且没有在途操作的连接
+        for (auto it = r.conns.begin(); it != r.conns.end();) {
+            Connection& conn = it->second;
+            if (conn.handing_off && !conn.closing && !conn.send_inflight && conn.pending.empty()) {
+                r.hand_off(it->first, conn, handoff, m_syscalls);
+            }
+            if (conn.close_after_send && !conn.closing && !conn.send_inflight && conn.pending.empty()) {
+                r.close_conn(conn); // 非法帧之前的响应已全部发出
+            }
+            if (conn.detaching && !conn.closing && !conn.handing_off && conn.ops == 0 && conn.pending.empty()) {
+                // recv 已取消、响应已发完：停在帧边界的连接保留下来，读了一半请求的连接只能关闭
+                if (conn.input.size() == conn.input_offset) {
+                    r.detached.push_back(conn.fd);
+                    it = r.conns.erase(it);
+                    continue;
+                }
+                r.close_conn(conn);
+            }
+            if (it->second.closing && it->second.ops == 0) {
+                ::close(it->second.fd);
+                it = r.conns.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return {};
+}
+
+#else // FPVCAR_HAVE_IO_URING
+
+struct UringLoop::Impl {};
+
+UringLoop::UringLoop(std::unique_ptr<Impl> impl) : m_impl(std::move(impl)) {}
+
+UringLoop::~UringLoop() = default;
+
+tl::expected<std::unique_ptr<UringLoop>, std::string> UringLoop::create(int, int) {
+    return tl::unexpected(std::string("io_uring not supported by kernel headers"));
+}
+
+void UringLoop::adopt(std::vector<int>) {}
+
+std::vector<int> UringLoop::take_adopted() {
+    return {};
+}
+
+std::vector<int> UringLoop::take_detached() {
+    return {};
+}
+
+tl::expected<void, std::string> UringLoop::run(const std::atomic<bool>&, const std::atomic<bool>&, BatchDispatcher&, const Handoff&) {
+    return tl::unexpected(std::string("io_uring not supported by kernel headers"));
+}
+
+#endif // FPVCAR_HAVE_IO_URING
+
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <signal.h>
 #include <atomic>
+#include <string>
 #include <thread>
 
 // 全局关闭标志，用于优雅地处理信号中断
@@ -23,16 +24,25 @@ void signal_handler(int) {
  * @return 成功返回 0，失败返回 1
  * 
  * 程序流程：
+ * 0. 解析命令行：--takeover 表示接管正在运行的实例
  * 1. 注册信号处理器（SIGINT 和 SIGTERM）以支持优雅关闭
  * 2. 从配置文件加载应用配置
  * 3. 创建并初始化设备控制服务
- * 4. 启动服务（在后台线程中运行 IPC 服务器）
- * 5. 进入主循环，等待关闭信号
+ * 4. 启动服务（在后台线程中运行 IPC 服务器），或接管正在运行的实例
+ * 5. 进入主循环，等待关闭信号或服务被新实例接管
  * 6. 收到信号后优雅地停止服务并退出
  */
 int main(int argc, char** argv) {
-    (void)argc;
-    (void)argv;
+    // --takeover：接管正在运行的实例（不停车升级），没有正在运行的实例时正常启动
+    bool takeover = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--takeover") {
+            takeover = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--takeover]" << std::endl;
+            return 1;
+        }
+    }
 
     // 注册信号处理器：捕获 Ctrl+C (SIGINT) 和终止信号 (SIGTERM)
     // 当收到 SIGINT 或 SIGTERM 信号时，调用 signal_handler 函数
@@ -54,20 +64,20 @@ int main(int argc, char** argv) {
     }
 
     // 启动服务：准备 IPC 服务器并在后台线程中运行
-    auto start_res = (*svc_res)->start();
+    auto start_res = takeover ? (*svc_res)->start_takeover() : (*svc_res)->start();
     if (!start_res) {
         std::cerr << "FATAL ERROR: " << start_res.error() << std::endl;
         return 1;
     }
     std::cout << "fpvcar-devicecontrol service started. Press Ctrl+C to stop." << std::endl;
 
-    // 主循环：等待关闭信号，每隔 100ms 检查一次标志
-    while (!g_shutdown_request.load()) {
+    // 主循环：等待关闭信号或服务被新实例接管，每隔 100ms 检查一次标志
+    while (!g_shutdown_request.load() && !(*svc_res)->handed_over()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
-    // 收到关闭信号后，优雅地停止服务
-    std::cout << "Shutting down service..." << std::endl;
+    // 收到关闭信号后，优雅地停止服务；已被接管时 stop() 不停车、不删除套接字文件
+    std::cout << ((*svc_res)->handed_over() ? "Service handed over, exiting..." : "Shutting down service...") << std::endl;
     (*svc_res)->stop();
     std::cout << "Service stopped." << std::endl;
 
@@ -0,0 +1,48 @@
+#include "fpvcar_device_control/motor_backend.hpp"
+#include <stdexcept>
+
+namespace fpvcar::device_control {
+
+void MotorBackend::set_wheel_duty(const WheelDuty&) {
+    throw std::logic_error("Motor backend does not support per-wheel duty control");
+}
+
+FpvCarMotorBackend::FpvCarMotorBackend(const std::string& i2c_device_path,
+                                       const motorconfig::FpvCarChannelConfig& channels,
+                                       float pwm_frequency,
+                                       uint8_t pca9685_address)
+    : m_i2c_device_path(i2c_device_path),
+      m_channels(channels),
+      m_pwm_frequency(pwm_frequency),
+      m_pca9685_address(pca9685_address)
+{
+    m_car.emplace(m_i2c_device_path, m_channels, m_pwm_frequency, m_pca9685_address);
+}
+
+template <typename F>
+void FpvCarMotorBackend::call(F&& f) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_car) {
+        throw std::runtime_error("Motor controller is not initialized");
+    }
+    f(*m_car);
+}
+
+void FpvCarMotorBackend::moveForward() { call([](control::FpvCarController& car) { car.moveForward(); }); }
+void FpvCarMotorBackend::moveBackward() { call([](control::FpvCarController& car) { car.moveBackward(); }); }
+void FpvCarMotorBackend::turnLeft() { call([](control::FpvCarController& car) { car.turnLeft(); }); }
+void FpvCarMotorBackend::turnRight() { call([](control::FpvCarController& car) { car.turnRight(); }); }
+void FpvCarMotorBackend::moveForwardAndTurnLeft() { call([](control::FpvCarController& car) { car.moveForwardAndTurnLeft(); }); }
+void FpvCarMotorBackend::moveForwardAndTurnRight() { call([](control::FpvCarController& car) { car.moveForwardAndTurnRight(); }); }
+void FpvCarMotorBackend::moveBackwardAndTurnLeft() { call([](control::FpvCarController& car) { car.moveBackwardAndTurnLeft(); }); }
+void FpvCarMotorBackend::moveBackwardAndTurnRight() { call([](control::FpvCarController& car) { car.moveBackwardAndTurnRight(); }); }
+void FpvCarMotorBackend::stopAll() { call([](control::FpvCarController& car) { car.stopAll(); }); }
+
+void FpvCarMotorBackend::reinitialize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 先销毁旧控制器（关闭 I2C 设备），再重新打开并配置 PCA9685
+    m_car.reset();
+    m_car.emplace(m_i2c_device_path, m_channels, m_pwm_frequency, m_pca9685_address);
+}
+
+}
@@ -0,0 +1,86 @@
+#include "fpvcar_device_control/motor_fault.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace fpvcar::device_control {
+
+MotorFaultGuard::MotorFaultGuard(MotorBackend& backend, Clock& clock, MotorFaultPolicy policy)
+    : m_backend(backend), m_clock(clock), m_policy(policy) {}
+
+MotorFaultStats MotorFaultGuard::stats() const {
+    MotorFaultStats stats;
+    stats.calls = m_calls.load(std::memory_order_relaxed);
+    stats.failures = m_failures.load(std::memory_order_relaxed);
+    stats.timeouts = m_timeouts.load(std::memory_order_relaxed);
+    stats.reinits = m_reinits.load(std::memory_order_relaxed);
+    stats.reinit_failures = m_reinit_failures.load(std::memory_order_relaxed);
+    stats.degraded_entries = m_degraded_entries.load(std::memory_order_relaxed);
+    stats.degraded = m_degraded.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MotorFaultGuard::on_success(Clock::time_point start) {
+    const auto elapsed = m_clock.now() - start;
+    if (elapsed > m_policy.call_timeout) {
+        // 调用已完成，结果有效，但总线响应过慢：按故障计入，连续出现时同样触发重新初始化和降级
+        m_timeouts.fetch_add(1, std::memory_order_relaxed);
+        if (m_consecutive_faults == 0) {
+            std::cerr << "Warning: Motor call took "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms (timeout "
+                      << m_policy.call_timeout.count() << " ms)" << std::endl;
+        }
+        record_fault(start);
+        return;
+    }
+
+    if (m_consecutive_faults > 0) {
+        std::cerr << "Motor bus recovered after " << m_consecutive_faults << " consecutive faults" << std::endl;
+    }
+    m_consecutive_faults = 0;
+    m_backoff = std::chrono::milliseconds(0);
+    if (m_degraded.exchange(false, std::memory_order_relaxed)) {
+        std::cerr << "Leaving degraded mode (hold safe stop)" << std::endl;
+    }
+}
+
+void MotorFaultGuard::on_failure(Clock::time_point start, const char* what) {
+    m_failures.fetch_add(1, std::memory_order_relaxed);
+    // 只记录一轮连续故障中的第一次，避免故障期间刷屏
+    if (m_consecutive_faults == 0) {
+        std::cerr << "Error: Motor call failed: " << what << std::endl;
+    }
+    record_fault(start);
+}
+
+void MotorFaultGuard::record_fault(Clock::time_point start) {
+    ++m_consecutive_faults;
+
+    // 1. 连续失败若干次：重新初始化后端（重新打开总线、重新配置驱动芯片）
+    if (m_policy.reinit_after_failures > 0 && m_consecutive_faults % m_policy.reinit_after_failures == 0) {
+        m_reinits.fetch_add(1, std::memory_order_relaxed);
+        try {
+            m_backend.reinitialize();
+            std::cerr << "Motor backend reinitialized after " << m_consecutive_faults << " consecutive faults" << std::endl;
+        } catch (const std::exception& e) {
+            m_reinit_failures.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "Error: Motor backend reinitialization failed: " << e.what() << std::endl;
+        }
+    }
+
+    // 2. 指数退避；同时保证失败调用（含重新初始化）耗时 / (耗时 + 等待) 不超过 max_cpu_share
+    const auto end = m_clock.now();
+    m_backoff = m_backoff.count() == 0 ? m_policy.initial_backoff : std::min(m_backoff * 2, m_policy.max_backoff);
+    const double share = std::clamp(m_policy.max_cpu_share, 0.01, 1.0);
+    const auto cpu_wait = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(end - start) * ((1.0 - share) / share));
+    m_next_attempt = end + std::max<Clock::duration>(m_backoff, cpu_wait);
+
+    // 3. 连续失败过多：进入降级模式
+    if (m_consecutive_faults >= m_policy.degraded_after_failures && !m_degraded.exchange(true, std::memory_order_relaxed)) {
+        m_degraded_entries.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "!!! Motor bus unhealthy after " << m_consecutive_faults
+                  << " consecutive faults, entering degraded mode (hold safe stop) !!!" << std::endl;
+    }
+}
+
+}
@@ -0,0 +1,319 @@
+#include "fpvcar_device_control/pca9685.hpp"
+#include "fpvcar_device_control/wheel_speed.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace fpvcar::device_control {
+
+namespace {
+    // 退出 SLEEP 后振荡器稳定所需的时间
+    constexpr std::chrono::microseconds OSCILLATOR_STARTUP{500};
+
+    /**
+     * @brief 等待到 deadline：较长的等待先休眠，最后 100us 忙等，避免休眠的唤醒延迟使限速偏慢
+     */
+    void wait_until(std::chrono::steady_clock::time_point deadline) {
+        constexpr auto SPIN = std::chrono::microseconds(100);
+        auto now = std::chrono::steady_clock::now();
+        if (deadline - now > SPIN) std::this_thread::sleep_for(deadline - now - SPIN);
+        while (std::chrono::steady_clock::now() < deadline) {}
+    }
+}
+
+namespace pca9685 {
+
+void write_registers(I2cTransport& transport, uint8_t address, uint8_t first, const uint8_t* values, size_t count) {
+    uint8_t buffer[1 + sizeof(LedImage)];
+    buffer[0] = first;
+    std::copy(values, values + count, buffer + 1);
+    transport.write(address, buffer, 1 + count);
+}
+
+void configure_chip(I2cTransport& transport, uint8_t address, uint8_t prescale) {
+    // 1. 进入 SLEEP（只有 SLEEP 状态下才能写 PRESCALE），同时打开自动递增
+    const uint8_t sleep = MODE1_SLEEP | MODE1_AI | MODE1_ALLCALL;
+    write_registers(transport, address, MODE1, &sleep, 1);
+    write_registers(transport, address, PRESCALE, &prescale, 1);
+    const uint8_t mode2 = MODE2_OUTDRV;
+    write_registers(transport, address, MODE2, &mode2, 1);
+    // 2. 所有通道全关（ALL_LED 一个事务），然后唤醒并等待振荡器稳定
+    const uint8_t all_off[4] = {0, 0, 0, LED_FULL};
+    write_registers(transport, address, ALL_LED_ON_L, all_off, sizeof(all_off));
+    const uint8_t awake = MODE1_AI | MODE1_ALLCALL;
+    write_registers(transport, address, MODE1, &awake, 1);
+    std::this_thread::sleep_for(OSCILLATOR_STARTUP);
+}
+
+bool read_running_image(I2cTransport& transport, uint8_t address, uint8_t prescale, LedImage& image) {
+    uint8_t reg = MODE1;
+    uint8_t mode1 = 0;
+    transport.write_read(address, &reg, 1, &mode1, 1);
+    reg = PRESCALE;
+    uint8_t current_prescale = 0;
+    transport.write_read(address, &reg, 1, &current_prescale, 1);
+    if ((mode1 & MODE1_SLEEP) || !(mode1 & MODE1_AI) || current_prescale != prescale) return false;
+    reg = LED0_ON_L;
+    transport.write_read(address, &reg, 1, image.data(), image.size());
+    return true;
+}
+
+}
+
+// ---------------- Pca9685Emulator ----------------
+
+Pca9685Emulator::Pca9685Emulator(uint8_t address, uint32_t bus_speed_hz, bool enforce_bus_timing)
+    : I2cTransport(bus_speed_hz), m_address(address), m_enforce_bus_timing(enforce_bus_timing) {
+    reset();
+}
+
+void Pca9685Emulator::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 上电默认值（数据手册 7.3 节）：SLEEP、ALLCALL，所有通道全关，PRESCALE 为 200Hz
+    m_registers.fill(0);
+    m_registers[pca9685::MODE1] = pca9685::MODE1_SLEEP | pca9685::MODE1_ALLCALL;
+    m_registers[pca9685::MODE2] = pca9685::MODE2_OUTDRV;
+    m_registers[pca9685::SUBADR1] = 0xE2;
+    m_registers[pca9685::SUBADR2] = 0xE4;
+    m_registers[pca9685::SUBADR3] = 0xE8;
+    m_registers[pca9685::ALLCALLADR] = 0xE0;
+    for (size_t ch = 0; ch < pca9685::CHANNELS; ++ch) {
+        m_registers[pca9685::LED0_ON_L + 4 * ch + 3] = pca9685::LED_FULL;
+    }
+    m_registers[pca9685::PRESCALE] = 0x1E;
+    m_pointer = 0;
+}
+
+bool Pca9685Emulator::acknowledges(uint8_t address) const {
+    return address == m_address ||
+           (address == pca9685::ALLCALL_ADDRESS && (m_registers[pca9685::MODE1] & pca9685::MODE1_ALLCALL));
+}
+
+uint8_t Pca9685Emulator::next_pointer(uint8_t reg) const {
+    if (!(m_registers[pca9685::MODE1] & pca9685::MODE1_AI)) return reg;
+    if (reg == pca9685::LED15_OFF_H || reg == pca9685::TESTMODE) return pca9685::MODE1;
+    return static_cast<uint8_t>(reg + 1);
+}
+
+void Pca9685Emulator::write_register(uint8_t reg, uint8_t value) {
+    ++m_stats.register_writes;
+    if (reg > pca9685::LED15_OFF_H && reg < pca9685::ALL_LED_ON_L) {
+        ++m_stats.ignored_writes; // 保留寄存器
+        return;
+    }
+    if (reg >= pca9685::ALL_LED_ON_L && reg <= pca9685::ALL_LED_OFF_H) {
+        // ALL_LED：写入所有通道的对应寄存器，本身读出为 0
+        const size_t offset = reg - pca9685::ALL_LED_ON_L;
+        bool changed = false;
+        for (size_t ch = 0; ch < pca9685::CHANNELS; ++ch) {
+            uint8_t& target = m_registers[pca9685::LED0_ON_L + 4 * ch + offset];
+            changed = changed || target != value;
+            target = value;
+        }
+        if (!changed) ++m_stats.redundant_writes;
+        return;
+    }
+    if (reg == pca9685::PRESCALE) {
+        if (!(m_registers[pca9685::MODE1] & pca9685::MODE1_SLEEP)) {
+            ++m_stats.ignored_writes; // 振荡器运行时 PRESCALE 写保护
+            return;
+        }
+        value = std::max(value, pca9685::PRESCALE_MIN);
+    }
+    if (reg == pca9685::MODE1) {
+        // RESTART 写 1 清除重启标志（本仿真器不保存 PWM 暂停状态，读出恒为 0）
+        value = static_cast<uint8_t>(value & ~pca9685::MODE1_RESTART);
+    }
+    if (m_registers[reg] == value) ++m_stats.redundant_writes;
+    m_registers[reg] = value;
+}
+
+void Pca9685Emulator::finish(uint8_t address, size_t write_bytes, size_t read_bytes,
+                             std::chrono::steady_clock::time_point start, bool ok) {
+    I2cTransaction transaction;
+    transaction.address = address;
+    transaction.write_bytes = static_cast<uint32_t>(write_bytes);
+    transaction.read_bytes = static_cast<uint32_t>(read_bytes);
+    // 未应答的事务在地址字节后即停止
+    transaction.bus_time_ns = ok ? i2c_bus_time_ns(write_bytes, read_bytes, m_bus_speed_hz)
+                                 : i2c_bus_time_ns(0, 0, m_bus_speed_hz);
+    if (m_enforce_bus_timing) wait_until(start + std::chrono::nanoseconds(transaction.bus_time_ns));
+    transaction.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    account(transaction, ok);
+}
+
+void Pca9685Emulator::write(uint8_t address, const uint8_t* data, size_t size) {
+    const auto start = std::chrono::steady_clock::now();
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ok = acknowledges(address);
+        if (ok && size > 0) {
+            m_pointer = data[0];
+            for (size_t i = 1; i < size; ++i) {
+                write_register(m_pointer, data[i]);
+                m_pointer = next_pointer(m_pointer);
+            }
+        } else if (!ok) {
+            ++m_stats.nacks;
+        }
+    }
+    finish(address, size, 0, start, ok);
+    if (!ok) throw std::runtime_error("I2C transfer failed: no acknowledge from emulated PCA9685");
+}
+
+void Pca9685Emulator::write_read(uint8_t address, const uint8_t* out, size_t out_size, uint8_t* in, size_t in_size) {
+    const auto start = std::chrono::steady_clock::now();
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ok = acknowledges(address);
+        if (ok) {
+            if (out_size > 0) m_pointer = out[0];
+            for (size_t i = 1; i < out_size; ++i) {
+                write_register(m_pointer, out[i]);
+                m_pointer = next_pointer(m_pointer);
+            }
+            for (size_t i = 0; i < in_size; ++i) {
+                const bool write_only = m_pointer >= pca9685::ALL_LED_ON_L && m_pointer <= pca9685::ALL_LED_OFF_H;
+                in[i] = write_only ? 0 : m_registers[m_pointer];
+                m_pointer = next_pointer(m_pointer);
+            }
+            m_stats.register_reads += in_size;
+        } else {
+            ++m_stats.nacks;
+        }
+    }
+    finish(address, out_size, in_size, start, ok);
+    if (!ok) throw std::runtime_error("I2C transfer failed: no acknowledge from emulated PCA9685");
+}
+
+uint8_t Pca9685Emulator::register_value(uint8_t reg) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_registers[reg];
+}
+
+uint16_t Pca9685Emulator::channel_counts(uint8_t channel) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (channel >= pca9685::CHANNELS || (m_registers[pca9685::MODE1] & pca9685::MODE1_SLEEP)) return 0;
+    const uint8_t* led = &m_registers[pca9685::LED0_ON_L + 4 * static_cast<size_t>(channel)];
+    if (led[3] & pca9685::LED_FULL) return 0;
+    if (led[1] & pca9685::LED_FULL) return pca9685::PWM_COUNTS;
+    const uint16_t on = static_cast<uint16_t>(((led[1] & 0x0f) << 8) | led[0]);
+    const uint16_t off = static_cast<uint16_t>(((led[3] & 0x0f) << 8) | led[2]);
+    return static_cast<uint16_t>((off - on) & (pca9685::PWM_COUNTS - 1));
+}
+
+double Pca9685Emulator::pwm_frequency() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return pca9685::frequency_for(m_registers[pca9685::PRESCALE]);
+}
+
+Pca9685EmulatorStats Pca9685Emulator::device_stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+// ---------------- Pca9685MotorBackend ----------------
+
+namespace {
+    std::array<pca9685::WheelChannels, WHEEL_COUNT> checked_channels(const motorconfig::FpvCarChannelConfig& channels) {
+        const auto wheels = pca9685::wheel_channels(channels);
+        for (const pca9685::WheelChannels& wheel : wheels) {
+            for (uint8_t ch : {wheel.speed, wheel.in1, wheel.in2}) {
+                if (ch >= pca9685::CHANNELS) {
+                    throw std::invalid_argument("PCA9685 channel out of range: " + std::to_string(ch));
+                }
+            }
+        }
+        return wheels;
+    }
+}
+
+Pca9685MotorBackend::Pca9685MotorBackend(I2cTransport& transport,
+                                         const motorconfig::FpvCarChannelConfig& channels,
+                                         float pwm_frequency,
+                                         uint8_t address,
+                                         Pca9685WritePolicy policy)
+    : m_transport(transport),
+      m_channels(checked_channels(channels)),
+      m_address(address),
+      m_prescale(pca9685::prescale_for(pwm_frequency)),
+      m_policy(policy),
+      m_used(pca9685::used_channels(m_channels))
+{
+    if (std::abs(pca9685::frequency_for(m_prescale) - pwm_frequency) > 0.05 * pwm_frequency) {
+        std::cerr << "Warning: PWM frequency " << pwm_frequency << " Hz is outside the PCA9685 range, running at "
+                  << pca9685::frequency_for(m_prescale) << " Hz" << std::endl;
+    }
+}
+
+void Pca9685MotorBackend::initialize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    configure();
+}
+
+void Pca9685MotorBackend::adopt_outputs() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shadow_valid = false;
+    pca9685::LedImage image{};
+    if (!pca9685::read_running_image(m_transport, m_address, m_prescale, image)) {
+        std::cerr << "Warning: PCA9685 is not running with the configured PWM frequency, reconfiguring (outputs off)" << std::endl;
+        configure();
+        return;
+    }
+    m_shadow = image;
+    m_shadow_valid = true;
+}
+
+void Pca9685MotorBackend::configure() {
+    m_shadow_valid = false;
+    pca9685::configure_chip(m_transport, m_address, m_prescale);
+    m_shadow = pca9685::state_image(m_channels, DesiredState::STOPPING);
+    m_shadow_valid = true;
+}
+
+void Pca9685MotorBackend::reinitialize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shadow_valid = false;
+    m_transport.reopen();
+    configure();
+}
+
+void Pca9685MotorBackend::command(DesiredState state) {
+    const std::array<int32_t, WHEEL_COUNT> setpoints = wheel_setpoints(state, pca9685::TURN_INNER_DUTY);
+    set_wheel_duty(setpoints);
+}
+
+void Pca9685MotorBackend::set_wheel_duty(const WheelDuty& duty) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    pca9685::LedImage image = m_shadow;
+    pca9685::set_wheel_duty(image, m_channels, duty);
+    write_image(image);
+}
+
+void Pca9685MotorBackend::write_image(const pca9685::LedImage& image) {
+    try {
+        if (m_policy == Pca9685WritePolicy::PER_CHANNEL) {
+            for (size_t ch = 0; ch < pca9685::CHANNELS; ++ch) {
+                if (!m_used[ch]) continue;
+                pca9685::write_registers(m_transport, m_address, static_cast<uint8_t>(pca9685::LED0_ON_L + 4 * ch), &image[4 * ch], 4);
+            }
+        } else {
+            pca9685::for_each_run(m_shadow, image, m_used, m_shadow_valid, [&](size_t offset, size_t count) {
+                pca9685::write_registers(m_transport, m_address, static_cast<uint8_t>(pca9685::LED0_ON_L + offset), &image[offset], count);
+            });
+        }
+    } catch (...) {
+        // 不知道失败的事务写入了多少字节，下一次重写所有使用中的通道
+        m_shadow_valid = false;
+        throw;
+    }
+    m_shadow = image;
+    m_shadow_valid = true;
+}
+
+}
@@ -1,51 +1,190 @@
 #include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/trace.hpp"
+#include "fpvcar_device_control/flight_recorder.hpp"
+#include "fpvcar_device_control/fast_request_parser.hpp"
 #include <nlohmann/json.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <functional>
+#include <chrono>
+#include <optional>
+#include <ctime>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using nlohmann::json;
 
 namespace fpvcar::device_control {
 
-RequestHandler::RequestHandler(DesiredStateManager& desired_state_manager)
-    :   m_desired_state_manager(desired_state_manager){}
+namespace {
+    // 进程内导出序号，保证同一秒内的多次导出文件名不同
+    std::atomic<uint64_t> g_export_sequence{0};
+
+    /**
+     * @brief 准备导出目录并生成导出文件路径：<dir>/<prefix>-<UTC 时间>-<序号><extension>
+     * @return 成功返回文件路径，目录无法创建或不安全时返回错误信息字符串
+     * @note 目录必须是本进程用户所有、组和其他用户不可写的真实目录，其他本机用户无法在其中预先放置符号链接
+     */
+    tl::expected<std::string, std::string> export_file_path(const std::string& dir, const char* prefix, const char* extension) {
+        if (dir.empty()) {
+            return tl::unexpected(std::string("exports are disabled (diagnostics_dir is empty)"));
+        }
+        if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+            return tl::unexpected("Failed to create " + dir + ": " + std::strerror(errno));
+        }
+        struct stat st{};
+        if (::lstat(dir.c_str(), &st) != 0) {
+            return tl::unexpected("Failed to stat " + dir + ": " + std::strerror(errno));
+        }
+        if (!S_ISDIR(st.st_mode) || st.st_uid != ::geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+            return tl::unexpected(dir + " must be a directory owned by the service user and not writable by others");
+        }
+
+        const std::time_t now = std::time(nullptr);
+        std::tm utc{};
+        ::gmtime_r(&now, &utc);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &utc);
+        const uint64_t sequence = g_export_sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+        return dir + "/" + prefix + "-" + stamp + "-" + std::to_string(sequence) + extension;
+    }
+}
+
+RequestHandler::RequestHandler(DesiredStateManager& desired_state_manager, std::string diagnostics_dir)
+    :   m_desired_state_manager(desired_state_manager),
+        m_diagnostics_dir(std::move(diagnostics_dir)){}
 
 std::string RequestHandler::handle_request(const std::string& json_request) {
+    std::string response;
+    handle_request(std::string_view(json_request), response);
+    return response;
+}
+
+RequestOutcome RequestHandler::handle_request(std::string_view json_request, std::string& response) {
+    trace::Span span("RequestHandler::handle_request");
+
+    // 快速路径：运动指令直接扫描输入，不构建 DOM，响应写入复用的缓冲区
+    FastRequest fast;
+    if (parse_fast_request(json_request, fast)) {
+        const std::optional<DesiredState> desired_state = desired_state_from_action(fast.action);
+        // 未知 action、非法 ttl_ms 交给 DOM 路径生成错误响应
+        if (desired_state && (!fast.has_ttl || lease_ttl_valid(fast.ttl_ms))) {
+            std::chrono::milliseconds ttl(0);
+            if (fast.has_ttl && *desired_state != DesiredState::STOPPING) {
+                ttl = std::chrono::milliseconds(fast.ttl_ms);
+            }
+            m_desired_state_manager.set_desired_state(*desired_state, ttl);
+            recorder::record_command(*desired_state, false, ttl.count());
+            // 与 create_success_response 的输出逐字节一致（nlohmann 按键名排序输出）
+            response.clear();
+            response.append("{\"message\":\"").append(fast.action).append(" executed\",\"status\":\"ok\"}");
+            return RequestOutcome::REPLY;
+        }
+    }
+
+    RequestOutcome outcome = RequestOutcome::REPLY;
+    response = handle_request_dom(json_request, outcome);
+    return outcome;
+}
+
+std::string RequestHandler::handle_request_dom(std::string_view json_request, RequestOutcome& outcome) {
     // 解析 JSON 请求，禁用异常机制，通过 is_discarded 判断解析失败
     auto data = json::parse(json_request, nullptr, /*allow_exceptions=*/false);
     if (data.is_discarded()) {
         return create_error_response("INVALID_JSON", "Failed to parse JSON");
     }
+    // 以下只用 find 与类型检查读取字段：value() 在字段类型不符时抛出 type_error
+    if (!data.is_object()) {
+        return create_error_response("INVALID_JSON", "Request must be a JSON object");
+    }
 
-    // 提取 action 字段，如果不存在则使用空字符串
-    const std::string action = data.value("action", "");
-    if (action.empty()) {
+    // 提取 action 字段
+    const auto action_field = data.find("action");
+    if (action_field == data.end() || (action_field->is_string() && action_field->get_ref<const std::string&>().empty())) {
         return create_error_response("INVALID_JSON", "Missing 'action' field");
     }
+    if (!action_field->is_string()) {
+        return create_error_response("INVALID_JSON", "'action' must be a string");
+    }
+    const std::string action = action_field->get<std::string>();
 
-    if (action == "moveForward") {
-        m_desired_state_manager.set_desired_state(DesiredState::MOVING_FORWARD);
-    } else if (action == "moveBackward") {
-        m_desired_state_manager.set_desired_state(DesiredState::MOVING_BACKWARD);
-    } else if (action == "turnLeft") {
-        m_desired_state_manager.set_desired_state(DesiredState::TURNING_LEFT);
-    } else if (action == "turnRight") {
-        m_desired_state_manager.set_desired_state(DesiredState::TURNING_RIGHT);
-    } else if (action == "moveForwardAndTurnLeft") {
-        m_desired_state_manager.set_desired_state(DesiredState::MOVING_FORWARD_AND_TURN_LEFT);
-    } else if (action == "moveForwardAndTurnRight") {
-        m_desired_state_manager.set_desired_state(DesiredState::MOVING_FORWARD_AND_TURN_RIGHT);
-    } else if (action == "moveBackwardAndTurnLeft") {
-        m_desired_state_manager.set_desired_state(DesiredState::MOVING_BACKWARD_AND_TURN_LEFT);
-    } else if (action == "moveBackwardAndTurnRight") {
-        m_desired_state_manager.set_desired_state(DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT);
-    } else if (action == "stopAll") {
-        m_desired_state_manager.set_desired_state(DesiredState::STOPPING);
-    } else {
+    // 旧版本 traceExport、recorderDump 的 "path" 字段，现在一律拒绝（见下）
+    const auto path_field = data.find("path");
+
+    // 追踪控制指令：不改变期望状态
+    if (action == "traceStart") {
+        trace::set_enabled(true);
+        return create_success_response("tracing enabled");
+    } else if (action == "traceStop") {
+        trace::set_enabled(false);
+        return create_success_response("tracing disabled");
+    } else if (action == "traceExport") {
+        // 文件只写入配置的导出目录，客户端不能指定路径（否则任何能连上套接字的本机进程都能覆盖服务可写的文件）
+        if (path_field != data.end()) {
+            return create_error_response("INVALID_JSON", "'path' is not accepted: traces are written to the diagnostics directory");
+        }
+        const auto path = export_file_path(m_diagnostics_dir, "trace", ".json");
+        if (!path) {
+            return create_error_response("TRACE_ERROR", path.error());
+        }
+        auto res = trace::export_chrome_trace(*path);
+        if (!res) {
+            return create_error_response("TRACE_ERROR", res.error());
+        }
+        return create_success_response("trace exported to " + *path);
+    }
+
+    // 飞行记录器导出：不改变期望状态
+    if (action == "recorderDump") {
+        // 与 traceExport 相同：只写入配置的导出目录，不接受客户端指定的路径
+        if (path_field != data.end()) {
+            return create_error_response("INVALID_JSON", "'path' is not accepted: dumps are written to the diagnostics directory");
+        }
+        const auto path = export_file_path(m_diagnostics_dir, "flight", ".bin");
+        if (!path) {
+            return create_error_response("RECORDER_ERROR", path.error());
+        }
+        auto res = recorder::dump(*path, recorder::DumpReason::REQUEST);
+        if (!res) {
+            return create_error_response("RECORDER_ERROR", res.error());
+        }
+        return create_success_response("flight recorder dumped to " + *path);
+    }
+
+    // 订阅状态与遥测推送：不改变期望状态，由调用方移交连接
+    if (action == "subscribe") {
+        outcome = RequestOutcome::SUBSCRIBE;
+        return create_success_response("subscribed");
+    }
+
+    const std::optional<DesiredState> desired_state = desired_state_from_action(action);
+    if (!desired_state) {
         m_desired_state_manager.set_desired_state(DesiredState::STOPPING);
+        recorder::record_command(DesiredState::STOPPING, true, 0);
         std::cerr << "Unknown action: " + action << std::endl;
         return create_error_response("INVALID_ACTION", "Unknown action: " + action);
     }
 
+    // 可选的指令租约：ttl_ms 毫秒内没有新的指令则由 control_loop 切换到安全状态
+    // 停止指令本身就是安全状态，忽略 ttl_ms
+    std::chrono::milliseconds ttl(0);
+    if (data.contains("ttl_ms")) {
+        const auto& ttl_value = data["ttl_ms"];
+        // 无符号大整数转为 int64_t 后为负数，同样被拒绝
+        if (!ttl_value.is_number_integer() || !lease_ttl_valid(ttl_value.get<int64_t>())) {
+            m_desired_state_manager.set_desired_state(DesiredState::STOPPING);
+            recorder::record_command(DesiredState::STOPPING, true, 0);
+            return create_error_response("INVALID_TTL", "'ttl_ms' must be a positive integer no greater than " +
+                                         std::to_string(MAX_LEASE_TTL_MS));
+        }
+        if (*desired_state != DesiredState::STOPPING) {
+            ttl = std::chrono::milliseconds(ttl_value.get<int64_t>());
+        }
+    }
+    m_desired_state_manager.set_desired_state(*desired_state, ttl);
+    recorder::record_command(*desired_state, false, ttl.count());
+
     std::string success_message = action + " executed"; 
     return create_success_response(success_message);
 }
@@ -0,0 +1,179 @@
+#include "fpvcar_device_control/simulated_motor_backend.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace fpvcar::device_control {
+
+namespace {
+    // 运动学积分步长
+    constexpr std::chrono::milliseconds SIM_STEP(1);
+
+    /**
+     * @brief 期望状态对应的左右轮速度（满速的比例）
+     * @note 原地转向为左右轮反向；前进/后退并转向时内侧轮按 inner 比例减速
+     */
+    void wheel_targets(DesiredState state, double inner, double& left, double& right) {
+        switch (state) {
+            case DesiredState::MOVING_FORWARD: left = 1.0; right = 1.0; return;
+            case DesiredState::MOVING_BACKWARD: left = -1.0; right = -1.0; return;
+            case DesiredState::TURNING_LEFT: left = -1.0; right = 1.0; return;
+            case DesiredState::TURNING_RIGHT: left = 1.0; right = -1.0; return;
+            case DesiredState::MOVING_FORWARD_AND_TURN_LEFT: left = inner; right = 1.0; return;
+            case DesiredState::MOVING_FORWARD_AND_TURN_RIGHT: left = 1.0; right = inner; return;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_LEFT: left = -inner; right = -1.0; return;
+            case DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT: left = -1.0; right = -inner; return;
+            case DesiredState::STOPPING: left = 0.0; right = 0.0; return;
+        }
+        left = 0.0;
+        right = 0.0;
+    }
+
+    /**
+     * @brief 轮速向目标靠近，单步变化量不超过 max_delta
+     */
+    double ramp(double current, double target, double max_delta) {
+        if (std::abs(target - current) <= max_delta) return target; // 精确到达目标，之后走匀速分支
+        return current + std::clamp(target - current, -max_delta, max_delta);
+    }
+}
+
+SimulatedMotorBackend::SimulatedMotorBackend(Clock& clock, SimulatedMotorParams params)
+    : m_clock(clock), m_params(params), m_last_update(clock.now()) {}
+
+void SimulatedMotorBackend::set_observer(CommandObserver observer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_observer = std::move(observer);
+}
+
+SimulatedVehicleState SimulatedMotorBackend::state() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    integrate_to(m_clock.now());
+    return m_state;
+}
+
+void SimulatedMotorBackend::reinitialize() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_state.reinits;
+}
+
+void SimulatedMotorBackend::inject_faults(uint32_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending_faults = count;
+}
+
+void SimulatedMotorBackend::check_fault() {
+    if (m_pending_faults > 0) {
+        --m_pending_faults;
+        ++m_state.failed_commands;
+        throw std::runtime_error("simulated I2C bus fault");
+    }
+}
+
+void SimulatedMotorBackend::set_targets(double left_mps, double right_mps) {
+    const double left = left_mps * m_params.drive_efficiency;
+    const double right = right_mps * m_params.drive_efficiency;
+
+    // 高速时直接反向：对电机和驱动芯片冲击最大，单独计数
+    // 只在目标方向改变时计数（闭环每个周期都会重新下发同一方向的目标）
+    const double half_speed = 0.5 * m_params.max_wheel_speed_mps;
+    const bool left_reversal = (m_state.left_mps > half_speed && left < 0.0 && m_target_left >= 0.0) ||
+                               (m_state.left_mps < -half_speed && left > 0.0 && m_target_left <= 0.0);
+    const bool right_reversal = (m_state.right_mps > half_speed && right < 0.0 && m_target_right >= 0.0) ||
+                                (m_state.right_mps < -half_speed && right > 0.0 && m_target_right <= 0.0);
+    if (left_reversal || right_reversal) ++m_state.abrupt_reversals;
+    m_target_left = left;
+    m_target_right = right;
+}
+
+void SimulatedMotorBackend::command(DesiredState state) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto now = m_clock.now();
+    integrate_to(now);
+    check_fault();
+
+    double left = 0.0;
+    double right = 0.0;
+    wheel_targets(state, m_params.turn_inner_ratio, left, right);
+    set_targets(left * m_params.max_wheel_speed_mps, right * m_params.max_wheel_speed_mps);
+    ++m_state.commands;
+    if (m_observer) m_observer(now, state);
+}
+
+void SimulatedMotorBackend::set_wheel_duty(const WheelDuty& duty) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    integrate_to(m_clock.now());
+    check_fault();
+
+    const auto side = [this](int32_t front, int32_t back) {
+        return 0.5 * (static_cast<double>(front) + back) / DUTY_FULL * m_params.max_wheel_speed_mps;
+    };
+    set_targets(side(duty[static_cast<size_t>(Wheel::FRONT_LEFT)], duty[static_cast<size_t>(Wheel::BACK_LEFT)]),
+                side(duty[static_cast<size_t>(Wheel::FRONT_RIGHT)], duty[static_cast<size_t>(Wheel::BACK_RIGHT)]));
+    ++m_state.wheel_duty_commands;
+}
+
+void SimulatedMotorBackend::integrate_to(Clock::time_point now) {
+    while (m_last_update < now) {
+        // 两侧轮速都已到达目标：剩余时间按匀速圆弧一次积分完
+        if (m_state.left_mps == m_target_left && m_state.right_mps == m_target_right) {
+            const double dt = std::chrono::duration<double>(now - m_last_update).count();
+            const double v = 0.5 * (m_state.left_mps + m_state.right_mps);
+            const double w = (m_state.right_mps - m_state.left_mps) / m_params.wheel_base_m;
+            if (std::abs(w) < 1e-12) {
+                m_state.x_m += v * std::cos(m_state.heading_rad) * dt;
+                m_state.y_m += v * std::sin(m_state.heading_rad) * dt;
+            } else {
+                const double heading = m_state.heading_rad + w * dt;
+                m_state.x_m += v / w * (std::sin(heading) - std::sin(m_state.heading_rad));
+                m_state.y_m -= v / w * (std::cos(heading) - std::cos(m_state.heading_rad));
+                m_state.heading_rad = heading;
+            }
+            m_state.distance_m += std::abs(v) * dt;
+            m_state.left_travel_m += std::abs(m_state.left_mps) * dt;
+            m_state.right_travel_m += std::abs(m_state.right_mps) * dt;
+            m_last_update = now;
+            break;
+        }
+
+        const auto step = std::min<Clock::duration>(SIM_STEP, now - m_last_update);
+        const double dt = std::chrono::duration<double>(step).count();
+        const double max_delta = m_params.max_wheel_accel_mps2 * dt;
+        const double left = ramp(m_state.left_mps, m_target_left, max_delta);
+        const double right = ramp(m_state.right_mps, m_target_right, max_delta);
+        const double accel = std::max(std::abs(left - m_state.left_mps), std::abs(right - m_state.right_mps)) / dt;
+        m_state.max_accel_mps2 = std::max(m_state.max_accel_mps2, accel);
+        m_state.left_mps = left;
+        m_state.right_mps = right;
+
+        // 单步内按欧拉法积分位姿
+        const double v = 0.5 * (left + right);
+        const double w = (right - left) / m_params.wheel_base_m;
+        m_state.x_m += v * std::cos(m_state.heading_rad) * dt;
+        m_state.y_m += v * std::sin(m_state.heading_rad) * dt;
+        m_state.heading_rad += w * dt;
+        m_state.distance_m += std::abs(v) * dt;
+        m_state.left_travel_m += std::abs(left) * dt;
+        m_state.right_travel_m += std::abs(right) * dt;
+        m_last_update += step;
+    }
+}
+
+// ---------------- SimulatedEncoder ----------------
+
+SimulatedEncoder::SimulatedEncoder(SimulatedMotorBackend& backend, Clock& clock, double edges_per_meter)
+    : m_backend(backend), m_clock(clock), m_edges_per_meter(edges_per_meter) {}
+
+bool SimulatedEncoder::sample(EncoderSample& out) {
+    const SimulatedVehicleState state = m_backend.state();
+    const auto left = static_cast<uint64_t>(state.left_travel_m * m_edges_per_meter);
+    const auto right = static_cast<uint64_t>(state.right_travel_m * m_edges_per_meter);
+    out.time = m_clock.now();
+    out.edges[static_cast<size_t>(Wheel::FRONT_LEFT)] = left;
+    out.edges[static_cast<size_t>(Wheel::BACK_LEFT)] = left;
+    out.edges[static_cast<size_t>(Wheel::FRONT_RIGHT)] = right;
+    out.edges[static_cast<size_t>(Wheel::BACK_RIGHT)] = right;
+    return true;
+}
+
+}
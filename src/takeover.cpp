@@ -0,0 +1,378 @@
+#include "fpvcar_device_control/takeover.hpp"
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include <nlohmann/json.hpp>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using nlohmann::json;
+
+namespace fpvcar::device_control::takeover {
+
+namespace {
+    /**
+     * @brief 设置收发超时，使接管过程中的每一步读写都受 STEP_TIMEOUT 限制
+     */
+    void set_timeouts(int fd) {
+        timeval tv{};
+        tv.tv_sec = STEP_TIMEOUT.count() / 1000;
+        tv.tv_usec = static_cast<suseconds_t>((STEP_TIMEOUT.count() % 1000) * 1000);
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+
+    int64_t to_ns(Clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    Clock::time_point from_ns(int64_t ns) {
+        return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    /**
+     * @brief 读取一帧并解析为 JSON
+     * @param peer_closed 非空时写入失败原因是否为对端关闭
+     */
+    tl::expected<json, std::string> read_frame(int fd, bool* peer_closed = nullptr) {
+        uint32_t length_net;
+        ssize_t n = ipc::read_exact(fd, &length_net, sizeof(length_net));
+        if (peer_closed) *peer_closed = n == 0;
+        if (n != sizeof(length_net)) {
+            if (n == 0) return tl::unexpected(std::string("peer closed the takeover connection"));
+            return tl::unexpected(std::string("Failed to read takeover frame: ") +
+                                  (errno == EAGAIN || errno == EWOULDBLOCK ? "timed out" : std::strerror(errno)));
+        }
+        const uint32_t length = ntohl(length_net);
+        if (length == 0 || length > ipc::MAX_MESSAGE_SIZE) {
+            return tl::unexpected(std::string("Invalid takeover frame length"));
+        }
+        std::string body(length, '\0');
+        n = ipc::read_exact(fd, body.data(), length);
+        if (n != static_cast<ssize_t>(length)) {
+            if (peer_closed) *peer_closed = n == 0;
+            return tl::unexpected(std::string("Truncated takeover frame"));
+        }
+        json j = json::parse(body, nullptr, /*allow_exceptions=*/false);
+        if (j.is_discarded() || !j.is_object()) {
+            return tl::unexpected(std::string("Invalid takeover frame: ") + body);
+        }
+        return j;
+    }
+
+    tl::expected<void, std::string> write_frame(int fd, const json& j) {
+        if (!ipc::write_message(fd, j.dump())) {
+            return tl::unexpected(std::string("Failed to write takeover frame: ") + std::strerror(errno));
+        }
+        return {};
+    }
+
+    // 以下只用 find 与类型检查读取帧字段：value() 在字段类型不符时抛出 type_error，在监听线程中会终止进程
+
+    /**
+     * @brief 读取字符串字段，缺失或不是字符串时返回空字符串
+     */
+    std::string string_field(const json& j, const char* key) {
+        const auto it = j.find(key);
+        return it != j.end() && it->is_string() ? it->get<std::string>() : std::string();
+    }
+
+    /**
+     * @brief 读取整数字段，缺失或不是整数时返回 fallback
+     */
+    int64_t integer_field(const json& j, const char* key, int64_t fallback) {
+        const auto it = j.find(key);
+        return it != j.end() && it->is_number_integer() ? it->get<int64_t>() : fallback;
+    }
+
+    /**
+     * @brief 拒绝接管请求：回复 {"type":"error","message":...}（尽力发送）并返回错误
+     */
+    tl::unexpected<std::string> refuse(int fd, std::string message) {
+        (void)write_frame(fd, json{{"type", "error"}, {"message", message}});
+        return tl::unexpected(std::move(message));
+    }
+}
+
+TakeoverListener::TakeoverListener(const std::string& socket_path, Handler handler)
+    : m_socket_path(socket_path), m_handler(std::move(handler)) {}
+
+TakeoverListener::~TakeoverListener() {
+    stop();
+}
+
+tl::expected<void, std::string> TakeoverListener::start() {
+    // 删除已存在的套接字文件（如果存在）
+    ::unlink(m_socket_path.c_str());
+
+    m_listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listen_fd < 0) {
+        return tl::unexpected(std::string("Failed to create takeover socket: ") + std::strerror(errno));
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", m_socket_path.c_str());
+    if (::bind(m_listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(m_listen_fd, 1) < 0) {
+        int err = errno;
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+        ::unlink(m_socket_path.c_str());
+        return tl::unexpected(std::string("Failed to listen on takeover socket: ") + std::strerror(err));
+    }
+    // 接管意味着取得电机控制权：只允许本用户访问（对端身份在 accept_request 中再次检查）
+    ::chmod(m_socket_path.c_str(), S_IRUSR | S_IWUSR);
+
+    m_running.store(true);
+    m_handed_over.store(false);
+    m_thread = std::thread(&TakeoverListener::run, this);
+    std::cout << "Takeover socket listening on " << m_socket_path << std::endl;
+    return {};
+}
+
+void TakeoverListener::stop() {
+    if (!m_running.exchange(false)) return;
+    // 关闭监听套接字，中断阻塞的 accept（与阻塞 IPC 后端相同的做法）
+    if (m_listen_fd >= 0) {
+        ::shutdown(m_listen_fd, SHUT_RDWR);
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_listen_fd >= 0) {
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+    }
+    // 已移交时套接字文件属于新进程
+    if (!m_handed_over.load()) {
+        ::unlink(m_socket_path.c_str());
+    }
+}
+
+void TakeoverListener::run() {
+    while (m_running.load()) {
+        int fd = ::accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (!m_running.load()) break;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "Error: takeover accept failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        set_timeouts(fd);
+        const bool handed_over = m_handler(fd);
+        ::close(fd);
+        if (handed_over) {
+            m_handed_over.store(true);
+            break;
+        }
+    }
+}
+
+tl::expected<int, std::string> request_takeover(const std::string& socket_path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return tl::unexpected(std::string("Failed to create takeover socket: ") + std::strerror(errno));
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path.c_str());
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        int err = errno;
+        ::close(fd);
+        return tl::unexpected(std::string("No running instance to take over (") + socket_path + ": " + std::strerror(err) + ")");
+    }
+    set_timeouts(fd);
+    auto sent = write_frame(fd, json{{"type", "takeover"}, {"version", PROTOCOL_VERSION}});
+    if (!sent) {
+        ::close(fd);
+        return tl::unexpected(sent.error());
+    }
+    return fd;
+}
+
+tl::expected<void, std::string> accept_request(int fd) {
+    // 对端必须是同一用户或 root
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        return tl::unexpected(std::string("Failed to read takeover peer credentials: ") + std::strerror(errno));
+    }
+    if (cred.uid != ::geteuid() && cred.uid != 0) {
+        return tl::unexpected(std::string("Takeover refused: peer uid ") + std::to_string(cred.uid) + " is not allowed");
+    }
+
+    auto request = read_frame(fd);
+    if (!request) return tl::unexpected(request.error());
+    if (string_field(*request, "type") != "takeover") {
+        return refuse(fd, std::string("Unexpected takeover request: ") + request->dump());
+    }
+    if (integer_field(*request, "version", 0) != PROTOCOL_VERSION) {
+        return refuse(fd, std::string("Takeover protocol version mismatch: ") + request->dump());
+    }
+    return {};
+}
+
+tl::expected<void, std::string> send_state(int fd, const TakeoverState& state, const IpcSockets& sockets) {
+    json j;
+    j["type"] = "state";
+    j["desired"] = desired_state_to_action(state.desired_state);
+    j["applied"] = desired_state_to_action(state.control_loop.applied_state);
+    j["lease_deadline_ns"] = state.lease_deadline == NO_LEASE ? json(nullptr) : json(to_ns(state.lease_deadline));
+    j["watchdog_period_end_ns"] = to_ns(state.control_loop.watchdog.period_end);
+    j["watchdog_kicked"] = state.control_loop.watchdog.kicked;
+    j["freeze_ns"] = to_ns(state.freeze_time);
+    j["client_fds"] = sockets.client_fds.size();
+    const std::string body = j.dump();
+
+    // 监听套接字在前，随后是客户端连接
+    std::vector<int> fds;
+    fds.push_back(sockets.listen_fd);
+    fds.insert(fds.end(), sockets.client_fds.begin(), sockets.client_fds.end());
+
+    // 长度前缀和状态 JSON 用一次 sendmsg 发出，文件描述符附着在第一个字节上
+    std::string frame(sizeof(uint32_t), '\0');
+    const uint32_t length_net = htonl(static_cast<uint32_t>(body.size()));
+    std::memcpy(frame.data(), &length_net, sizeof(length_net));
+    frame += body;
+
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()), 0);
+    iovec iov{frame.data(), frame.size()};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return tl::unexpected(std::string("Failed to send takeover state: ") + std::strerror(errno));
+    }
+    // 剩余部分（通常没有）按普通数据发送
+    if (static_cast<size_t>(n) < frame.size() &&
+        ipc::write_exact(fd, frame.data() + n, frame.size() - static_cast<size_t>(n)) < 0) {
+        return tl::unexpected(std::string("Failed to send takeover state: ") + std::strerror(errno));
+    }
+    return {};
+}
+
+tl::expected<std::pair<TakeoverState, IpcSockets>, std::string> receive_state(int fd) {
+    // 先用 recvmsg 读取长度前缀，同时取出附着的文件描述符
+    uint32_t length_net = 0;
+    iovec iov{&length_net, sizeof(length_net)};
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * (MAX_CLIENT_FDS + 1)), 0);
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    ssize_t n;
+    do {
+        n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        return tl::unexpected(std::string("Failed to receive takeover state: ") +
+                              (n == 0 ? "peer closed the connection" : std::strerror(errno)));
+    }
+
+    IpcSockets sockets;
+    std::vector<int> fds;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const size_t offset = fds.size();
+            fds.resize(offset + count);
+            std::memcpy(fds.data() + offset, CMSG_DATA(cmsg), sizeof(int) * count);
+        }
+    }
+    auto fail = [&fds](std::string error) -> tl::expected<std::pair<TakeoverState, IpcSockets>, std::string> {
+        for (int f : fds) ::close(f);
+        return tl::unexpected(std::move(error));
+    };
+    if (msg.msg_flags & MSG_CTRUNC) {
+        return fail("Takeover state carried too many file descriptors");
+    }
+    // 读取长度前缀的剩余部分和状态 JSON
+    if (static_cast<size_t>(n) < sizeof(length_net) &&
+        ipc::read_exact(fd, reinterpret_cast<char*>(&length_net) + n, sizeof(length_net) - static_cast<size_t>(n)) <= 0) {
+        return fail("Truncated takeover state");
+    }
+    const uint32_t length = ntohl(length_net);
+    if (length == 0 || length > ipc::MAX_MESSAGE_SIZE) {
+        return fail("Invalid takeover state length");
+    }
+    std::string body(length, '\0');
+    if (ipc::read_exact(fd, body.data(), length) != static_cast<ssize_t>(length)) {
+        return fail("Truncated takeover state");
+    }
+    const json j = json::parse(body, nullptr, /*allow_exceptions=*/false);
+    if (!j.is_discarded() && j.is_object() && string_field(j, "type") == "error") {
+        return fail("Takeover refused by the running instance: " + string_field(j, "message"));
+    }
+    if (j.is_discarded() || !j.is_object() || string_field(j, "type") != "state") {
+        return fail("Invalid takeover state: " + body);
+    }
+    if (fds.empty()) {
+        return fail("Takeover state carried no listening socket");
+    }
+
+    TakeoverState state;
+    try {
+        const auto desired = desired_state_from_action(j.at("desired").get<std::string>());
+        const auto applied = desired_state_from_action(j.at("applied").get<std::string>());
+        if (!desired || !applied) return fail("Invalid state in takeover frame: " + body);
+        state.desired_state = *desired;
+        state.control_loop.applied_state = *applied;
+        const json& lease = j.at("lease_deadline_ns");
+        state.lease_deadline = lease.is_null() ? NO_LEASE : from_ns(lease.get<int64_t>());
+        state.control_loop.watchdog.period_end = from_ns(j.at("watchdog_period_end_ns").get<int64_t>());
+        state.control_loop.watchdog.kicked = j.at("watchdog_kicked").get<bool>();
+        state.freeze_time = from_ns(j.at("freeze_ns").get<int64_t>());
+        if (j.at("client_fds").get<size_t>() + 1 != fds.size()) {
+            return fail("Takeover state file descriptor count mismatch");
+        }
+    } catch (const json::exception& e) {
+        return fail(std::string("Invalid takeover state: ") + e.what());
+    }
+
+    sockets.listen_fd = fds.front();
+    sockets.client_fds.assign(fds.begin() + 1, fds.end());
+    return std::make_pair(state, std::move(sockets));
+}
+
+tl::expected<void, std::string> send_control(int fd, const char* type, int64_t gap_us) {
+    json j{{"type", type}};
+    if (gap_us >= 0) j["gap_us"] = gap_us;
+    return write_frame(fd, j);
+}
+
+tl::expected<void, std::string> expect_control(int fd, const char* type, int64_t* gap_us, bool* peer_closed) {
+    auto frame = read_frame(fd, peer_closed);
+    if (!frame) return tl::unexpected(frame.error());
+    if (string_field(*frame, "type") != type) {
+        return tl::unexpected(std::string("Expected takeover '") + type + "' frame, got: " + frame->dump());
+    }
+    if (gap_us) *gap_us = integer_field(*frame, "gap_us", -1);
+    return {};
+}
+
+void close_sockets(IpcSockets& sockets) {
+    if (sockets.listen_fd >= 0) ::close(sockets.listen_fd);
+    for (int fd : sockets.client_fds) ::close(fd);
+    sockets.listen_fd = -1;
+    sockets.client_fds.clear();
+}
+
+}
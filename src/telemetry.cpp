@@ -0,0 +1,330 @@
+#include "fpvcar_device_control/telemetry.hpp"
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace fpvcar::device_control {
+
+namespace {
+    // 订阅者有待发送数据却持续这么久没有任何进展时断开
+    constexpr std::chrono::milliseconds SUBSCRIBER_STALL_TIMEOUT(2000);
+
+    void signal_eventfd(int fd) {
+        if (fd < 0) return;
+        uint64_t one = 1;
+        ssize_t n = ::write(fd, &one, sizeof(one));
+        (void)n;
+    }
+
+    void drain_eventfd(int fd) {
+        if (fd < 0) return;
+        uint64_t value;
+        ssize_t n = ::read(fd, &value, sizeof(value));
+        (void)n;
+    }
+
+    /**
+     * @brief 为消息加上 4 字节长度前缀（网络字节序），与 IPC 请求/响应帧格式一致
+     */
+    std::string make_frame(const char* data, size_t size) {
+        std::string frame;
+        frame.reserve(sizeof(uint32_t) + size);
+        uint32_t length_net = htonl(static_cast<uint32_t>(size));
+        frame.append(reinterpret_cast<const char*>(&length_net), sizeof(length_net));
+        frame.append(data, size);
+        return frame;
+    }
+
+    std::string format_update(const TelemetrySnapshot& s, const char* event) {
+        char buffer[768];
+        int n = std::snprintf(buffer, sizeof(buffer),
+            "{\"type\":\"telemetry\",\"event\":\"%s\",\"ts_us\":%llu,\"state\":\"%s\",\"desired\":\"%s\","
+            "\"ticks\":%llu,\"overruns\":%llu,\"watchdog_trips\":%llu,\"lease_expiries\":%llu,"
+            "\"motor_calls\":%llu,\"motor_failures\":%llu,\"motor_timeouts\":%llu,\"motor_reinits\":%llu,\"degraded\":%s,\"estops\":%llu,"
+            "\"interval_us\":%.1f,\"jitter_us\":%.1f,\"max_jitter_us\":%.1f",
+            event,
+            static_cast<unsigned long long>(s.timestamp_us),
+            desired_state_to_action(s.applied_state),
+            desired_state_to_action(s.desired_state),
+            static_cast<unsigned long long>(s.ticks),
+            static_cast<unsigned long long>(s.overruns),
+            static_cast<unsigned long long>(s.watchdog_trips),
+            static_cast<unsigned long long>(s.lease_expiries),
+            static_cast<unsigned long long>(s.motor_calls),
+            static_cast<unsigned long long>(s.motor_failures),
+            static_cast<unsigned long long>(s.motor_timeouts),
+            static_cast<unsigned long long>(s.motor_reinits),
+            s.motor_degraded ? "true" : "false",
+            static_cast<unsigned long long>(s.estops),
+            static_cast<double>(s.tick_interval_ns) / 1000.0,
+            static_cast<double>(s.tick_jitter_ns) / 1000.0,
+            static_cast<double>(s.tick_max_jitter_ns) / 1000.0);
+        n = std::clamp(n, 0, static_cast<int>(sizeof(buffer) - 1));
+        // 闭环时附带各轮速度与占空比（百分比）
+        if (s.closed_loop) {
+            n += std::snprintf(buffer + n, sizeof(buffer) - static_cast<size_t>(n),
+                ",\"wheel_speed_eps\":[%lld,%lld,%lld,%lld],\"wheel_duty_pct\":[%.1f,%.1f,%.1f,%.1f]",
+                static_cast<long long>(s.wheel_speed_eps[0]), static_cast<long long>(s.wheel_speed_eps[1]),
+                static_cast<long long>(s.wheel_speed_eps[2]), static_cast<long long>(s.wheel_speed_eps[3]),
+                static_cast<double>(s.wheel_duty[0]) * 100.0 / 32767.0, static_cast<double>(s.wheel_duty[1]) * 100.0 / 32767.0,
+                static_cast<double>(s.wheel_duty[2]) * 100.0 / 32767.0, static_cast<double>(s.wheel_duty[3]) * 100.0 / 32767.0);
+            n = std::clamp(n, 0, static_cast<int>(sizeof(buffer) - 2));
+        }
+        buffer[n++] = '}';
+        return make_frame(buffer, static_cast<size_t>(n));
+    }
+}
+
+// ---------------- TelemetryChannel ----------------
+
+TelemetryChannel::TelemetryChannel() {
+    m_event_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+TelemetryChannel::~TelemetryChannel() {
+    if (m_event_fd >= 0) ::close(m_event_fd);
+}
+
+void TelemetryChannel::publish(const TelemetrySnapshot& snapshot, bool notify) {
+    uint64_t words[WORDS];
+    std::memcpy(words, &snapshot, sizeof(snapshot));
+
+    // seqlock 写入：序号先变为奇数，写完全部字后再变为偶数
+    const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; ++i) {
+        m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+    m_sequence.store(sequence + 2, std::memory_order_release);
+
+    if (notify) signal_eventfd(m_event_fd);
+}
+
+TelemetrySnapshot TelemetryChannel::read() const {
+    uint64_t words[WORDS];
+    while (true) {
+        const uint64_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield(); // 生产者正在写入
+            continue;
+        }
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) == before) break; // 读取期间没有新的写入
+    }
+    TelemetrySnapshot snapshot;
+    std::memcpy(&snapshot, words, sizeof(snapshot));
+    return snapshot;
+}
+
+// ---------------- TelemetryPublisher ----------------
+
+TelemetryPublisher::TelemetryPublisher(const TelemetryChannel& channel, std::chrono::milliseconds period, size_t max_subscribers)
+    : m_channel(channel), m_period(period), m_max_subscribers(max_subscribers) {}
+
+TelemetryPublisher::~TelemetryPublisher() {
+    stop();
+    // 未被推送线程接管的订阅连接
+    for (auto& [fd, response] : m_incoming) ::close(fd);
+    m_incoming.clear();
+    if (m_wake_fd >= 0) ::close(m_wake_fd);
+}
+
+tl::expected<void, std::string> TelemetryPublisher::start() {
+    if (m_running.exchange(true)) return {};
+    if (m_wake_fd < 0) {
+        m_wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_wake_fd < 0) {
+            m_running.store(false);
+            return tl::unexpected(std::string("Failed to create telemetry eventfd: ") + std::strerror(errno));
+        }
+    }
+    m_thread = std::thread(&TelemetryPublisher::run, this);
+    return {};
+}
+
+void TelemetryPublisher::stop() {
+    if (!m_running.exchange(false)) return;
+    signal_eventfd(m_wake_fd);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void TelemetryPublisher::add_subscriber(int fd, std::string response) {
+    {
+        std::lock_guard<std::mutex> lock(m_incoming_mutex);
+        m_incoming.emplace_back(fd, std::move(response));
+    }
+    signal_eventfd(m_wake_fd);
+}
+
+TelemetryPublisherStats TelemetryPublisher::stats() const {
+    TelemetryPublisherStats stats;
+    stats.subscribers = m_subscriber_count.load();
+    stats.updates_sent = m_updates_sent.load();
+    stats.updates_coalesced = m_updates_coalesced.load();
+    stats.subscribers_dropped = m_subscribers_dropped.load();
+    return stats;
+}
+
+void TelemetryPublisher::enqueue(Subscriber& sub, const std::string& frame) {
+    if (sub.out.empty()) {
+        sub.out = frame;
+        sub.out_offset = 0;
+        sub.last_progress = std::chrono::steady_clock::now(); // 从有数据待发送时开始计算停滞时间
+        return;
+    }
+    // 上一帧还没发完：只保留最新的一帧，旧的待发送帧被合并掉
+    if (!sub.latest.empty()) m_updates_coalesced.fetch_add(1, std::memory_order_relaxed);
+    sub.latest = frame;
+}
+
+void TelemetryPublisher::flush(Subscriber& sub, std::chrono::steady_clock::time_point now) {
+    while (!sub.out.empty()) {
+        ssize_t n = ::send(sub.fd, sub.out.data() + sub.out_offset, sub.out.size() - sub.out_offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) sub.dead = true;
+            break;
+        }
+        sub.last_progress = now;
+        sub.out_offset += static_cast<size_t>(n);
+        if (sub.out_offset == sub.out.size()) {
+            m_updates_sent.fetch_add(1, std::memory_order_relaxed);
+            sub.out.swap(sub.latest);
+            sub.latest.clear();
+            sub.out_offset = 0;
+        }
+    }
+    if (!sub.out.empty() && now - sub.last_progress > SUBSCRIBER_STALL_TIMEOUT) {
+        sub.dead = true; // 订阅者长时间不读取，断开以释放名额
+    }
+}
+
+void TelemetryPublisher::run() {
+    using Clock = std::chrono::steady_clock;
+    auto next_periodic = Clock::now() + m_period;
+    TelemetrySnapshot last = m_channel.read();
+    std::vector<pollfd> fds;
+    std::vector<std::pair<int, std::string>> incoming;
+    char discard[256];
+
+    while (m_running.load()) {
+        fds.clear();
+        fds.push_back({m_wake_fd, POLLIN, 0});
+        fds.push_back({m_channel.event_fd(), POLLIN, 0}); // fd 为 -1 时 poll 忽略该项
+        for (const auto& sub : m_subscribers) {
+            fds.push_back({sub.fd, static_cast<short>(POLLIN | (sub.out.empty() ? 0 : POLLOUT)), 0});
+        }
+
+        int timeout_ms = -1;
+        bool has_output = false;
+        for (auto& fd : fds) has_output = has_output || (fd.events & POLLOUT);
+        if (m_period.count() > 0) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_periodic - Clock::now());
+            timeout_ms = static_cast<int>(std::max<int64_t>(0, wait.count() + 1));
+        }
+        if (has_output) {
+            // 有订阅者积压时定期醒来检查停滞
+            timeout_ms = timeout_ms < 0 ? 100 : std::min(timeout_ms, 100);
+        }
+        if (::poll(fds.data(), fds.size(), timeout_ms) < 0 && errno != EINTR) {
+            std::cerr << "Telemetry publisher poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        drain_eventfd(m_wake_fd);
+        drain_eventfd(m_channel.event_fd());
+
+        // 订阅连接只推送不接收：丢弃收到的数据，检测对端关闭
+        for (size_t i = 0; i < m_subscribers.size(); ++i) {
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) {
+                ssize_t n = ::recv(m_subscribers[i].fd, discard, sizeof(discard), MSG_DONTWAIT);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    m_subscribers[i].dead = true;
+                }
+            }
+        }
+
+        const auto now = Clock::now();
+        const TelemetrySnapshot snapshot = m_channel.read();
+
+        // 选择本轮推送的原因：紧急停车 > 看门狗停车 > 故障降级变化 > 执行状态变更 > 周期推送
+        const char* event = nullptr;
+        if (snapshot.estops != last.estops) {
+            event = "estop";
+        } else if (snapshot.watchdog_trips != last.watchdog_trips) {
+            event = "watchdog";
+        } else if (snapshot.motor_degraded != last.motor_degraded) {
+            event = "fault";
+        } else if (snapshot.applied_state != last.applied_state) {
+            event = "state";
+        }
+        if (m_period.count() > 0 && now >= next_periodic) {
+            if (!event) event = "periodic";
+            next_periodic += m_period;
+            if (next_periodic <= now) next_periodic = now + m_period;
+        }
+        last = snapshot;
+        if (event) {
+            const std::string frame = format_update(snapshot, event);
+            for (auto& sub : m_subscribers) enqueue(sub, frame);
+        }
+
+        // 接管新的订阅：先发送订阅响应，再发送当前快照
+        {
+            std::lock_guard<std::mutex> lock(m_incoming_mutex);
+            incoming.swap(m_incoming);
+        }
+        for (auto& [fd, response] : incoming) {
+            if (m_subscribers.size() >= m_max_subscribers) {
+                static const char* rejected = "{\"error_code\":\"TOO_MANY_SUBSCRIBERS\",\"message\":\"Subscriber limit reached\",\"status\":\"error\"}";
+                const std::string frame = make_frame(rejected, std::strlen(rejected));
+                ssize_t n = ::send(fd, frame.data(), frame.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+                (void)n;
+                ::close(fd);
+                continue;
+            }
+            Subscriber sub;
+            sub.fd = fd;
+            sub.last_progress = now;
+            enqueue(sub, make_frame(response.data(), response.size()));
+            enqueue(sub, format_update(snapshot, "subscribe"));
+            m_subscribers.push_back(std::move(sub));
+        }
+        incoming.clear();
+
+        for (auto& sub : m_subscribers) {
+            if (!sub.dead) flush(sub, now);
+        }
+
+        // 移除已断开的订阅者
+        auto dead_begin = std::remove_if(m_subscribers.begin(), m_subscribers.end(), [this](const Subscriber& sub) {
+            if (!sub.dead) return false;
+            ::close(sub.fd);
+            m_subscribers_dropped.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
+        m_subscribers.erase(dead_begin, m_subscribers.end());
+        m_subscriber_count.store(m_subscribers.size(), std::memory_order_relaxed);
+    }
+
+    for (auto& sub : m_subscribers) {
+        ::shutdown(sub.fd, SHUT_RDWR);
+        ::close(sub.fd);
+    }
+    m_subscribers.clear();
+    m_subscriber_count.store(0);
+}
+
+}
@@ -0,0 +1,195 @@
+#include "fpvcar_device_control/trace.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using nlohmann::json;
+
+namespace fpvcar::device_control::trace {
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace {
+    /**
+     * @brief 环形缓冲区的一个槽位（顺序锁）
+     * @note 写入者先把 seq 置为 2 * index + 1（写入中），写完后置为 2 * index + 2；
+     *       导出线程只接受读取前后 seq 都等于 2 * index + 2 的槽位，正在被覆盖的槽位直接跳过
+     *       所有字段都是原子量，导出与写入之间没有数据竞争
+     */
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> request_id{0};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> duration_ns{0};
+    };
+
+    /**
+     * @brief 单个线程的环形缓冲区
+     * @note 只有所属线程写入，head 使用 release 发布，导出线程使用 acquire 读取
+     */
+    struct ThreadBuffer {
+        uint32_t tid = 0;
+        std::atomic<uint64_t> head{0}; // 已写入事件总数
+        std::array<Slot, THREAD_BUFFER_CAPACITY> slots{};
+    };
+
+    /**
+     * @brief 读取一个槽位中序号为 index 的事件
+     * @return 槽位完整且仍是该事件时返回 true；写入中或已被覆盖时返回 false
+     */
+    bool read_slot(const Slot& slot, uint64_t index, TraceEvent& event) {
+        const uint64_t expected = 2 * index + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected) return false;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.request_id = slot.request_id.load(std::memory_order_relaxed);
+        event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+        event.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == expected;
+    }
+
+    // 所有线程缓冲区的注册表，线程退出后缓冲区仍保留，便于导出
+    std::mutex g_registry_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> g_registry;
+
+    std::atomic<uint64_t> g_next_request_id{1};
+    thread_local uint64_t t_current_request_id = 0;
+    thread_local ThreadBuffer* t_buffer = nullptr;
+
+    ThreadBuffer* thread_buffer() {
+        if (t_buffer == nullptr) {
+            auto buffer = std::make_shared<ThreadBuffer>();
+            buffer->tid = static_cast<uint32_t>(::syscall(SYS_gettid));
+            std::lock_guard<std::mutex> lock(g_registry_mutex);
+            g_registry.push_back(buffer);
+            t_buffer = buffer.get();
+        }
+        return t_buffer;
+    }
+
+    double to_us(uint64_t ns) {
+        return static_cast<double>(ns) / 1000.0;
+    }
+}
+
+void set_enabled(bool enabled) {
+    g_trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t next_request_id() {
+    return g_next_request_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+void set_current_request_id(uint64_t request_id) {
+    t_current_request_id = request_id;
+}
+
+uint64_t current_request_id() {
+    return t_current_request_id;
+}
+
+void record(const char* name, uint64_t request_id, uint64_t start_ns, uint64_t end_ns) {
+    ThreadBuffer* buffer = thread_buffer();
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    Slot& slot = buffer->slots[head % THREAD_BUFFER_CAPACITY];
+    slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.request_id.store(request_id, std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.duration_ns.store(end_ns > start_ns ? end_ns - start_ns : 0, std::memory_order_relaxed);
+    slot.seq.store(2 * head + 2, std::memory_order_release);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void clear() {
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+    for (auto& buffer : g_registry) {
+        for (Slot& slot : buffer->slots) slot.seq.store(0, std::memory_order_relaxed);
+        buffer->head.store(0, std::memory_order_release);
+    }
+}
+
+tl::expected<void, std::string> export_chrome_trace(const std::string& file_path) {
+    // 先复制一份注册表快照，避免在写文件时持有锁
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(g_registry_mutex);
+        buffers = g_registry;
+    }
+
+    const int pid = static_cast<int>(::getpid());
+    json events = json::array();
+    // 按请求 ID 收集事件位置（时间戳、线程），用于生成 flow 事件
+    std::map<uint64_t, std::vector<std::pair<uint64_t, uint32_t>>> flows;
+
+    for (const auto& buffer : buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t count = head < THREAD_BUFFER_CAPACITY ? head : THREAD_BUFFER_CAPACITY;
+
+        events.push_back({
+            {"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", buffer->tid},
+            {"args", {{"name", "tid " + std::to_string(buffer->tid)}}}
+        });
+
+        for (uint64_t i = head - count; i < head; ++i) {
+            TraceEvent event{};
+            if (!read_slot(buffer->slots[i % THREAD_BUFFER_CAPACITY], i, event) || event.name == nullptr) continue;
+            json e = {
+                {"name", event.name}, {"cat", "fpvcar"}, {"ph", "X"},
+                {"ts", to_us(event.start_ns)}, {"dur", to_us(event.duration_ns)},
+                {"pid", pid}, {"tid", buffer->tid}
+            };
+            if (event.request_id != 0) {
+                e["args"] = {{"request_id", event.request_id}};
+                flows[event.request_id].emplace_back(event.start_ns, buffer->tid);
+            }
+            events.push_back(std::move(e));
+        }
+    }
+
+    // 为每个请求生成 flow 事件（s -> t ... -> f），把不同线程上的片段连接起来
+    for (auto& [request_id, points] : flows) {
+        if (points.size() < 2) continue;
+        std::sort(points.begin(), points.end());
+        for (size_t i = 0; i < points.size(); ++i) {
+            const char* phase = (i == 0) ? "s" : (i + 1 == points.size() ? "f" : "t");
+            json e = {
+                {"name", "request"}, {"cat", "fpvcar"}, {"ph", phase},
+                {"id", request_id}, {"ts", to_us(points[i].first)},
+                {"pid", pid}, {"tid", points[i].second}
+            };
+            if (i + 1 == points.size()) e["bp"] = "e";
+            events.push_back(std::move(e));
+        }
+    }
+
+    std::ofstream ofs(file_path);
+    if (!ofs.is_open()) {
+        return tl::unexpected(std::string("Failed to open trace file: ") + file_path);
+    }
+    json root;
+    root["traceEvents"] = std::move(events);
+    root["displayTimeUnit"] = "ns";
+    ofs << root.dump();
+    if (!ofs) {
+        return tl::unexpected(std::string("Failed to write trace file: ") + file_path);
+    }
+    return {};
+}
+
+}
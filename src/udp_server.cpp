@@ -0,0 +1,342 @@
+#include "fpvcar_device_control/udp_server.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/fast_request_parser.hpp"
+#include <nlohmann/json.hpp>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace fpvcar::device_control {
+
+namespace {
+    constexpr size_t BATCH = 32;              // 每次 recvmmsg/sendmmsg 最多收发的数据报数
+    constexpr size_t MAX_DATAGRAM = 2048;     // 接收缓冲区大小，超过的数据报按格式错误处理
+    constexpr int64_t REORDER_WINDOW = 1024;  // 序号回退超过这么多时认为发送端已重启，而不是乱序
+    constexpr int64_t BASELINE_DRIFT_DIV = 10000; // 延迟基线每经过 1 秒最多上漂 100 微秒（100 ppm），跟随两端时钟的相对漂移
+
+    int64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t sender_key(const sockaddr_in& addr) {
+        return (static_cast<uint64_t>(ntohl(addr.sin_addr.s_addr)) << 16) | ntohs(addr.sin_port);
+    }
+
+    std::string format_address(const sockaddr_in& addr) {
+        char ip[INET_ADDRSTRLEN] = {0};
+        ::inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+    }
+
+    // 与 RequestHandler::create_error_response 的输出格式一致（nlohmann 按键名排序输出），另加 seq
+    void error_reply(std::string& reply, const char* code, const char* message, int64_t seq) {
+        reply.clear();
+        reply.append("{\"error_code\":\"").append(code).append("\",\"message\":\"").append(message).append("\"");
+        if (seq >= 0) reply.append(",\"seq\":").append(std::to_string(seq));
+        reply.append(",\"status\":\"error\"}");
+    }
+
+    /**
+     * @brief 读取数据报中的 seq、ts_us 与 action：先走快速路径，无法确定时用 DOM 解析
+     * @param motion action 是运动或停止指令时为对应的期望状态，否则（缺少、不是字符串、其它 action）为空
+     * @return seq 与 ts_us 都存在且为非负整数时返回 true；JSON 非法时 seq 保持 -1
+     */
+    bool read_sequencing(std::string_view datagram, int64_t& seq, int64_t& ts_us, std::optional<DesiredState>& motion) {
+        seq = -1;
+        motion.reset();
+        FastRequest fast;
+        if (parse_fast_request(datagram, fast)) {
+            if (fast.has_seq) seq = fast.seq;
+            if (!fast.has_seq || !fast.has_ts) return false;
+            ts_us = fast.ts_us;
+            motion = desired_state_from_action(fast.action);
+            return true;
+        }
+        const nlohmann::json data = nlohmann::json::parse(datagram, nullptr, false);
+        if (data.is_discarded() || !data.is_object()) return false;
+        const auto a = data.find("action");
+        if (a != data.end() && a->is_string()) {
+            motion = desired_state_from_action(a->get_ref<const std::string&>());
+        }
+        const auto s = data.find("seq");
+        const auto t = data.find("ts_us");
+        if (s != data.end() && s->is_number_unsigned() && s->get<uint64_t>() <= INT64_MAX) {
+            seq = s->get<int64_t>();
+        }
+        if (seq < 0 || t == data.end() || !t->is_number_unsigned() || t->get<uint64_t>() > INT64_MAX) return false;
+        ts_us = t->get<int64_t>();
+        return true;
+    }
+}
+
+UdpServer::UdpServer(std::string bind_address, uint16_t port, IpcCallback callback, UdpPolicy policy)
+    : m_bind_address(std::move(bind_address)), m_port(port), m_callback(std::move(callback)), m_policy(policy) {}
+
+UdpServer::~UdpServer() {
+    stop();
+}
+
+tl::expected<void, std::string> UdpServer::start() {
+    if (m_running.load()) return {};
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_port);
+    if (::inet_pton(AF_INET, m_bind_address.c_str(), &addr.sin_addr) != 1) {
+        return tl::unexpected("Invalid UDP bind address: " + m_bind_address);
+    }
+
+    m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (m_fd < 0) {
+        return tl::unexpected(std::string("Failed to create UDP socket: ") + std::strerror(errno));
+    }
+    if (::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        int err = errno;
+        ::close(m_fd);
+        m_fd = -1;
+        return tl::unexpected("Failed to bind UDP socket to " + m_bind_address + ":" + std::to_string(m_port) +
+                              ": " + std::strerror(err));
+    }
+    sockaddr_in bound{};
+    socklen_t len = sizeof(bound);
+    ::getsockname(m_fd, reinterpret_cast<sockaddr*>(&bound), &len);
+    m_bound_port = ntohs(bound.sin_port);
+
+    m_wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wake_fd < 0) {
+        int err = errno;
+        ::close(m_fd);
+        m_fd = -1;
+        return tl::unexpected(std::string("Failed to create eventfd: ") + std::strerror(err));
+    }
+
+    m_running.store(true);
+    m_thread = std::thread([this]() { run(); });
+    std::cout << "UDP control listening on " << m_bind_address << ":" << m_bound_port << std::endl;
+    return {};
+}
+
+void UdpServer::stop() {
+    if (!m_running.exchange(false)) return;
+    uint64_t one = 1;
+    ssize_t n = ::write(m_wake_fd, &one, sizeof(one));
+    (void)n;
+    if (m_thread.joinable()) m_thread.join();
+    ::close(m_fd);
+    ::close(m_wake_fd);
+    m_fd = -1;
+    m_wake_fd = -1;
+}
+
+UdpServerStats UdpServer::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    UdpServerStats stats;
+    stats.received = m_received;
+    stats.accepted = m_accepted;
+    stats.stale = m_stale;
+    stats.reordered = m_reordered;
+    stats.malformed = m_malformed;
+    stats.rejected = m_rejected;
+    stats.errors = m_errors;
+    for (const Sender& s : m_senders) {
+        UdpSenderStats out;
+        out.address = s.address;
+        out.accepted = s.accepted;
+        out.stale = s.stale;
+        out.reordered = s.reordered;
+        out.last_seq = s.last_seq;
+        out.jitter_us = s.jitter_us;
+        out.max_jitter_us = s.max_jitter_us;
+        stats.senders.push_back(std::move(out));
+    }
+    return stats;
+}
+
+void UdpServer::run() {
+    // 收发缓冲区在线程启动时分配一次，之后循环中不再分配
+    std::vector<char> buffers(BATCH * MAX_DATAGRAM);
+    std::vector<std::string> replies(BATCH);
+    sockaddr_in from[BATCH];
+    iovec rx_iov[BATCH];
+    mmsghdr rx[BATCH];
+    iovec tx_iov[BATCH];
+    mmsghdr tx[BATCH];
+
+    pollfd fds[2] = {{m_wake_fd, POLLIN, 0}, {m_fd, POLLIN, 0}};
+    while (m_running.load()) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Error: UDP poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[0].revents & POLLIN) break;
+
+        // 一直读到套接字为空，每轮最多 BATCH 个数据报
+        for (;;) {
+            for (size_t i = 0; i < BATCH; ++i) {
+                rx_iov[i] = {buffers.data() + i * MAX_DATAGRAM, MAX_DATAGRAM};
+                rx[i] = {};
+                rx[i].msg_hdr.msg_name = &from[i];
+                rx[i].msg_hdr.msg_namelen = sizeof(from[i]);
+                rx[i].msg_hdr.msg_iov = &rx_iov[i];
+                rx[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int received = ::recvmmsg(m_fd, rx, BATCH, MSG_DONTWAIT, nullptr);
+            if (received <= 0) break;
+
+            // 同一批数据报使用同一个到达时间：批次只在数据报堆积时形成，此时它们的到达间隔远小于控制周期
+            const int64_t arrival = now_us();
+            size_t replies_out = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (int i = 0; i < received; ++i) {
+                    std::string& reply = replies[i];
+                    handle_datagram(from[i], std::string_view(buffers.data() + i * MAX_DATAGRAM, rx[i].msg_len),
+                                    (rx[i].msg_hdr.msg_flags & MSG_TRUNC) != 0, arrival, reply);
+                    if (reply.empty() || rx[i].msg_hdr.msg_namelen != sizeof(sockaddr_in)) continue;
+                    tx_iov[replies_out] = {reply.data(), reply.size()};
+                    tx[replies_out] = {};
+                    tx[replies_out].msg_hdr.msg_name = &from[i];
+                    tx[replies_out].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                    tx[replies_out].msg_hdr.msg_iov = &tx_iov[replies_out];
+                    tx[replies_out].msg_hdr.msg_iovlen = 1;
+                    ++replies_out;
+                }
+            }
+            // 回复尽力发送：发送缓冲区满时丢弃，发送端按超时重发
+            if (replies_out > 0) {
+                int sent = ::sendmmsg(m_fd, tx, static_cast<unsigned>(replies_out), MSG_DONTWAIT);
+                (void)sent;
+            }
+            if (static_cast<size_t>(received) < BATCH) break;
+        }
+    }
+}
+
+UdpServer::Sender& UdpServer::sender_for(const sockaddr_in& from, int64_t now_us) {
+    const uint64_t key = sender_key(from);
+    for (Sender& s : m_senders) {
+        if (s.key == key) return s;
+    }
+    Sender fresh;
+    fresh.key = key;
+    fresh.address = format_address(from);
+    fresh.last_seen_us = now_us;
+    std::cout << "UDP sender " << fresh.address << " connected" << std::endl;
+    if (m_senders.size() < MAX_SENDERS) {
+        m_senders.push_back(std::move(fresh));
+        return m_senders.back();
+    }
+    // 淘汰最久不活动的发送端
+    auto oldest = std::min_element(m_senders.begin(), m_senders.end(),
+        [](const Sender& a, const Sender& b) { return a.last_seen_us < b.last_seen_us; });
+    *oldest = std::move(fresh);
+    return *oldest;
+}
+
+void UdpServer::handle_datagram(const sockaddr_in& from, std::string_view datagram, bool truncated,
+                                int64_t arrival_us, std::string& reply) {
+    ++m_received;
+    int64_t seq = -1;
+    int64_t ts_us = 0;
+    if (truncated) {
+        ++m_malformed;
+        error_reply(reply, "INVALID_DATAGRAM", "Datagram too large", -1);
+        return;
+    }
+    std::optional<DesiredState> motion;
+    if (!read_sequencing(datagram, seq, ts_us, motion)) {
+        ++m_malformed;
+        error_reply(reply, "INVALID_DATAGRAM", "UDP requests require non-negative integer 'seq' and 'ts_us'", seq);
+        return;
+    }
+    if (!motion) {
+        // UDP 不做身份验证：只开放运动与停止指令，追踪/记录器导出（可写任意路径）、订阅等只能经本机 IPC 套接字使用
+        ++m_rejected;
+        error_reply(reply, "ACTION_NOT_ALLOWED", "Only motion and stop actions are accepted over UDP", seq);
+        return;
+    }
+
+    Sender& s = sender_for(from, arrival_us);
+    const bool idle = arrival_us - s.last_seen_us > std::chrono::duration_cast<std::chrono::microseconds>(
+        m_policy.sender_idle_reset).count();
+    const bool restarted = s.has_seq && seq <= s.last_seq && s.last_seq - seq > REORDER_WINDOW;
+    s.last_seen_us = arrival_us;
+    if (s.has_seq && (idle || restarted)) {
+        // 发送端沉默太久或序号大幅回退（发送端重启）：重新建立序号与延迟基线
+        if (restarted) {
+            std::cout << "UDP sender " << s.address << " restarted its sequence (" << s.last_seq << " -> " << seq << ")" << std::endl;
+        }
+        s.has_seq = false;
+    }
+
+    // 1. 乱序或重复
+    if (s.has_seq && seq <= s.last_seq) {
+        ++s.reordered;
+        ++m_reordered;
+        error_reply(reply, "OUT_OF_ORDER", "Sequence number not newer than the last accepted one, command dropped", seq);
+        return;
+    }
+
+    // 2. 过期：单向延迟（含两端时钟偏差）与延迟基线比较
+    const int64_t transit = arrival_us - ts_us;
+    if (!s.has_seq) {
+        s.baseline_us = transit;
+    } else {
+        const int64_t drifted = s.baseline_us + (arrival_us - s.baseline_at_us) / BASELINE_DRIFT_DIV;
+        s.baseline_us = std::min(transit, drifted);
+    }
+    s.baseline_at_us = arrival_us;
+    if (transit - s.baseline_us > m_policy.max_delay.count()) {
+        ++s.stale;
+        ++m_stale;
+        error_reply(reply, "STALE", "Datagram delayed beyond the freshness limit, command dropped", seq);
+        return;
+    }
+
+    // 3. 到达抖动（RFC 3550）：到达间隔与发送间隔之差
+    if (s.has_seq) {
+        const double d = std::fabs(static_cast<double>((arrival_us - s.last_arrival_us) - (ts_us - s.last_ts_us)));
+        s.jitter_us += (d - s.jitter_us) / 16.0;
+        s.max_jitter_us = std::max(s.max_jitter_us, d);
+    }
+    s.has_seq = true;
+    s.last_seq = seq;
+    s.last_arrival_us = arrival_us;
+    s.last_ts_us = ts_us;
+    ++s.accepted;
+    ++m_accepted;
+
+    // 4. 执行（回调负责喂看门狗），响应中插入 seq 以便发送端匹配
+    m_response.clear();
+    try {
+        if (m_callback(datagram, m_response) == IpcDisposition::HAND_OFF) {
+            error_reply(reply, "UNSUPPORTED", "Subscriptions are not available over UDP", seq);
+            return;
+        }
+    } catch (const std::exception& e) {
+        // 与 IpcServer::dispatch 一致：回调的异常不能结束接收线程（std::thread 中未捕获的异常会终止进程）
+        ++m_errors;
+        std::cerr << "Error: UDP request handler failed: " << e.what() << std::endl;
+        error_reply(reply, "SERVER_ERROR", "Request handler failed", seq);
+        return;
+    }
+    reply.clear();
+    if (m_response.size() >= 2 && m_response.front() == '{') {
+        reply.append("{\"seq\":").append(std::to_string(seq));
+        if (m_response[1] != '}') reply.push_back(',');
+        reply.append(m_response, 1, std::string::npos);
+    } else {
+        reply = m_response;
+    }
+}
+
+}
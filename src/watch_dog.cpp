@@ -3,7 +3,9 @@
 #include <chrono>
 #include <atomic>
 #include <functional> // 用于 std::function
+#include <mutex>
 #include "fpvcar_device_control/watch_dog.hpp"
+#include "fpvcar_device_control/flight_recorder.hpp"
 
 /**
  * @brief 一个简单的C++软件看门狗类
@@ -11,18 +13,28 @@
 namespace fpvcar::device_control {
 
 void SoftwareWatchdog::start() {
+    WatchdogState fresh;
+    fresh.period_end = m_clock.now() + m_timeout;
+    fresh.kicked = true; // 初始为true，防止启动时立即超时
+    start(fresh);
+}
+
+void SoftwareWatchdog::start(const WatchdogState& resume) {
     std::cout << "SoftwareWatchdog start" << std::endl;
     // 如果线程已经在运行，先停止它
     // 注意：这里直接设置 m_stop 并 join，不使用 stop() 避免可能的竞争
     if (m_thread.joinable()) {
         m_stop.store(true, std::memory_order_relaxed);
+        m_clock.wake_all();
         m_thread.join();
     }
     
     // 重置状态并启动新线程
     m_stop.store(false, std::memory_order_relaxed);
-    m_kicked.store(true, std::memory_order_relaxed); // 初始为true，防止启动时立即超时
-    m_thread = std::thread(&SoftwareWatchdog::watchLoop, this);
+    m_kicked.store(resume.kicked, std::memory_order_relaxed);
+    m_period_end.store(resume.period_end.time_since_epoch().count(), std::memory_order_relaxed);
+    m_clock.register_thread();
+    m_thread = std::thread(&SoftwareWatchdog::watchLoop, this, resume.period_end);
 }
 
 void SoftwareWatchdog::stop() {
@@ -33,7 +45,8 @@ void SoftwareWatchdog::stop() {
         return;
     }
     
-    // 等待线程结束
+    // 打断休眠并等待线程结束
+    m_clock.wake_all();
     if (m_thread.joinable()) {
         m_thread.join();
     }
@@ -41,13 +54,26 @@ void SoftwareWatchdog::stop() {
 
 void SoftwareWatchdog::feed() {
     m_kicked.store(true, std::memory_order_relaxed);
+    recorder::record(recorder::EventType::WATCHDOG_FEED);
 }
 
 
-void SoftwareWatchdog::watchLoop() {
+WatchdogState SoftwareWatchdog::state() const {
+    WatchdogState state;
+    state.period_end = Clock::time_point(Clock::duration(m_period_end.load(std::memory_order_relaxed)));
+    state.kicked = m_kicked.load(std::memory_order_relaxed);
+    return state;
+}
+
+void SoftwareWatchdog::watchLoop(Clock::time_point period_end) {
     while (!m_stop.load(std::memory_order_relaxed)) {
-        // 1. 等待一个超时周期
-        std::this_thread::sleep_for(m_timeout);
+        // 1. 等待到周期结束（提前唤醒时继续等待，stop() 时立即退出）
+        while (!m_stop.load(std::memory_order_relaxed) && m_clock.now() < period_end) {
+            m_clock.sleep_until(period_end);
+        }
+        if (m_stop.load(std::memory_order_relaxed)) {
+            break;
+        }
 
         // 2. 检查是否被 "喂" 过
         //    我们使用 exchange 来原子地检查并重置标志
@@ -56,12 +82,40 @@ void SoftwareWatchdog::watchLoop() {
         if (!wasKicked) {
             // 3. 超时！
             std::cerr << "!!! 软件看门狗超时 停止所有电机 !!!" << std::endl;
+            const DesiredState interrupted = m_desired_state_manager.get_desired_state();
             m_desired_state_manager.set_desired_state(DesiredState::STOPPING);
-            m_car.stopAll();
+            bool stopped = true;
+            std::unique_lock<PiMutex> actuation(m_actuation, std::defer_lock);
+            if (!actuation.try_lock_for(m_timeout)) {
+                // control_loop 卡在电机调用里：不并发调用后端，期望状态已是停止，调用返回后由 control_loop 停车
+                std::cerr << "Error: Watchdog failed to stop motors: motor call in progress for more than "
+                          << m_timeout.count() << "ms" << std::endl;
+                stopped = false;
+            } else {
+                try {
+                    m_car.stopAll();
+                } catch (const std::exception& e) {
+                    // 总线故障时由 control_loop 的故障处理层继续重试停车
+                    std::cerr << "Error: Watchdog failed to stop motors: " << e.what() << std::endl;
+                    stopped = false;
+                }
+                actuation.unlock();
+            }
+            m_trips.fetch_add(1, std::memory_order_relaxed);
+            recorder::record(recorder::EventType::WATCHDOG_TRIP, static_cast<uint8_t>(interrupted), stopped ? 0 : 1);
+            // 停下运动中的车辆时导出飞行记录（空闲时看门狗同样会周期性超时，此时不导出）
+            if (interrupted != DesiredState::STOPPING) {
+                recorder::dump_automatic(recorder::DumpReason::WATCHDOG);
+            }
 
             m_kicked.store(true, std::memory_order_relaxed); // 重置标志，防止立即再次超时
         }
+
+        // 4. 开始下一个周期
+        period_end = m_clock.now() + m_timeout;
+        m_period_end.store(period_end.time_since_epoch().count(), std::memory_order_relaxed);
     }
+    m_clock.unregister_thread();
 }
 
 } // namespace fpvcar::device_control
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "fpvcar_device_control/wheel_speed.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace fpvcar::device_control {
+
+namespace {
+    constexpr int64_t Q15 = 32768;
+    constexpr int64_t MAX_DT_US = 100000; // 周期间隔的上限：线程长时间没有运行时不让积分器一步跳满
+    // 积分分离：误差超过满量程的 20% 时（起步、换向，车轮正受加速度限制）只用前馈 + 比例，避免积分饱和后超调
+    constexpr int64_t INTEGRAL_BAND_Q15 = Q15 / 5;
+
+    int64_t to_q16(double gain) {
+        return static_cast<int64_t>(std::llround(gain * 65536.0));
+    }
+
+    int64_t elapsed_us(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+    }
+}
+
+// ---------------- WheelSpeedEstimator ----------------
+
+WheelSpeedEstimator::WheelSpeedEstimator(double max_speed_eps, std::chrono::milliseconds window)
+    : m_max_speed_eps(std::max<int64_t>(1, static_cast<int64_t>(std::llround(max_speed_eps)))),
+      m_window_us(std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::microseconds>(window).count())) {}
+
+void WheelSpeedEstimator::reset() {
+    m_count = 0;
+    m_head = 0;
+    m_speed_q15.fill(0);
+    m_speed_eps.fill(0);
+}
+
+void WheelSpeedEstimator::update(const EncoderSample& sample) {
+    // 计数倒退（编码器重新打开后从零计数）：之前的历史不再可比，从这个采样重新开始估计
+    if (m_count > 0) {
+        const EncoderSample& last = m_history[(m_head + HISTORY - 1) % HISTORY];
+        for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+            if (sample.edges[w] < last.edges[w]) {
+                reset();
+                break;
+            }
+        }
+    }
+    m_history[m_head] = sample;
+    m_head = (m_head + 1) % HISTORY;
+    if (m_count < HISTORY) ++m_count;
+    if (m_count < 2) return;
+
+    // 从上一个采样往前找窗口内最老的采样（至少取上一个采样）
+    size_t back = 1;
+    while (back + 1 < m_count) {
+        const EncoderSample& older = m_history[(m_head + HISTORY - 2 - back) % HISTORY];
+        if (elapsed_us(older.time, sample.time) > m_window_us) break;
+        ++back;
+    }
+    const EncoderSample& base = m_history[(m_head + HISTORY - 1 - back) % HISTORY];
+    const int64_t dt_us = elapsed_us(base.time, sample.time);
+    if (dt_us <= 0) return;
+
+    for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+        const int64_t edges = static_cast<int64_t>(sample.edges[w] - base.edges[w]);
+        m_speed_eps[w] = std::max<int64_t>(0, edges * 1000000 / dt_us);
+        // 限制在 [0, 2 倍满速] 以内：计数向前跳变不让控制器饱和，上面的倒退检查之外也不会出现负速度
+        m_speed_q15[w] = static_cast<int32_t>(std::clamp<int64_t>(edges * Q15 * 1000000 / (dt_us * m_max_speed_eps), 0, 2 * Q15));
+    }
+}
+
+// ---------------- FixedPointPi ----------------
+
+FixedPointPi::FixedPointPi(double kp, double ki, double feedforward)
+    : m_kp_q16(to_q16(kp)), m_ki_q16(to_q16(ki)), m_ff_q16(to_q16(feedforward)) {}
+
+int32_t FixedPointPi::update(int32_t setpoint_q15, int32_t measured_q15, int64_t dt_us) {
+    const int64_t error = static_cast<int64_t>(setpoint_q15) - measured_q15;
+    const int64_t limit_q31 = static_cast<int64_t>(DUTY_FULL) << 16;
+
+    // Q15 × Q16 = Q31
+    const int64_t unsaturated = m_ff_q16 * setpoint_q15 + m_kp_q16 * error + m_integral_q31;
+    const bool saturated_high = unsaturated >= limit_q31 && error > 0;
+    const bool saturated_low = unsaturated <= -limit_q31 && error < 0;
+    if (!saturated_high && !saturated_low && std::abs(error) <= INTEGRAL_BAND_Q15) {
+        const int64_t dt = std::clamp<int64_t>(dt_us, 0, MAX_DT_US);
+        m_integral_q31 = std::clamp(m_integral_q31 + m_ki_q16 * error * dt / 1000000, -limit_q31, limit_q31);
+    }
+    const int64_t output = (m_ff_q16 * setpoint_q15 + m_kp_q16 * error + m_integral_q31) >> 16;
+    return static_cast<int32_t>(std::clamp<int64_t>(output, -DUTY_FULL, DUTY_FULL));
+}
+
+// ---------------- WheelSpeedController ----------------
+
+WheelSpeedController::WheelSpeedController(const WheelSpeedConfig& config)
+    : m_config(config),
+      m_inner_q15(static_cast<int32_t>(std::clamp(config.turn_inner_ratio, 0.0, 1.0) * DUTY_FULL)),
+      m_estimator(config.max_speed_eps, config.speed_window),
+      m_pi{FixedPointPi(config.kp, config.ki, config.feedforward), FixedPointPi(config.kp, config.ki, config.feedforward),
+           FixedPointPi(config.kp, config.ki, config.feedforward), FixedPointPi(config.kp, config.ki, config.feedforward)} {}
+
+void WheelSpeedController::reset() {
+    m_estimator.reset();
+    for (auto& pi : m_pi) pi.reset();
+    m_setpoints.fill(0);
+    m_primed = false;
+}
+
+void WheelSpeedController::update(DesiredState target, const EncoderSample& sample, WheelDuty& duty) {
+    const int64_t dt_us = m_primed ? elapsed_us(m_last_time, sample.time) : 0;
+    m_last_time = sample.time;
+    m_primed = true;
+    m_estimator.update(sample);
+
+    const std::array<int32_t, WHEEL_COUNT> setpoints = wheel_setpoints(target, m_inner_q15);
+    for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+        const int32_t sp = setpoints[w];
+        // 换向（或从停止起步）时清除积分器：积分量属于另一个方向的负载
+        if ((sp > 0) != (m_setpoints[w] > 0) || (sp < 0) != (m_setpoints[w] < 0)) m_pi[w].reset();
+        m_setpoints[w] = sp;
+        if (sp == 0) {
+            duty[w] = 0;
+            continue;
+        }
+        // 单相编码器只给出转速大小，方向取目标方向
+        const int32_t measured = sp > 0 ? m_estimator.speed_q15(w) : -m_estimator.speed_q15(w);
+        duty[w] = m_pi[w].update(sp, measured, dt_us);
+    }
+}
+
+void WheelSpeedController::feedforward(DesiredState target, WheelDuty& duty) const {
+    const std::array<int32_t, WHEEL_COUNT> setpoints = wheel_setpoints(target, m_inner_q15);
+    const int64_t ff_q16 = to_q16(m_config.feedforward);
+    for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+        duty[w] = static_cast<int32_t>(std::clamp<int64_t>((ff_q16 * setpoints[w]) >> 16, -DUTY_FULL, DUTY_FULL));
+    }
+}
+
+std::array<int64_t, WHEEL_COUNT> WheelSpeedController::measured_eps() const {
+    std::array<int64_t, WHEEL_COUNT> out{};
+    for (size_t w = 0; w < WHEEL_COUNT; ++w) {
+        out[w] = m_setpoints[w] < 0 ? -m_estimator.speed_eps(w) : m_estimator.speed_eps(w);
+    }
+    return out;
+}
+
+}
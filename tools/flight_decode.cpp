@@ -0,0 +1,117 @@
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/flight_recorder.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+// fpvcar-flight-decode：飞行记录解码工具
+// 读取 recorderDump 指令、看门狗停车或致命信号导出的二进制文件，打印文件头和每条事件，
+// 时间为相对导出时刻的毫秒数（负数表示导出之前），状态以指令名称显示
+//
+// 用法: fpvcar-flight-decode [--last N] [FILE]   （FILE 默认为 /tmp/fpvcar_flight.bin）
+
+using namespace fpvcar::device_control;
+
+namespace {
+    const char* reason_to_string(uint32_t reason) {
+        switch (static_cast<recorder::DumpReason>(reason)) {
+            case recorder::DumpReason::REQUEST: return "request";
+            case recorder::DumpReason::WATCHDOG: return "watchdog";
+            case recorder::DumpReason::CRASH: return "crash";
+        }
+        return "unknown";
+    }
+
+    const char* state_name(uint32_t value) {
+        if (value > static_cast<uint32_t>(DesiredState::STOPPING)) return "?";
+        return desired_state_to_action(static_cast<DesiredState>(value));
+    }
+
+    /**
+     * @brief 把一条事件格式化为可读文本
+     */
+    void print_event(const recorder::Event& event, int64_t dump_steady_ns) {
+        const double rel_ms = static_cast<double>(static_cast<int64_t>(event.ts_ns) - dump_steady_ns) / 1e6;
+        std::printf("%12.3f ms  ", rel_ms);
+        switch (event.type) {
+            case recorder::EventType::COMMAND:
+                std::printf("command        %s%s", state_name(event.a), event.b ? " (invalid)" : "");
+                if (event.c > 0) std::printf(" ttl=%ums", event.c);
+                break;
+            case recorder::EventType::STATE:
+                std::printf("state          %s -> %s  tick=%llu", state_name(event.b), state_name(event.a),
+                    static_cast<unsigned long long>(event.d));
+                break;
+            case recorder::EventType::MOTOR_CALL:
+                std::printf("motor_call     %s %s  %.1fus", state_name(event.a),
+                    event.b == static_cast<uint16_t>(recorder::MotorCallResult::OK) ? "ok" : "FAILED",
+                    static_cast<double>(event.c) / 1e3);
+                break;
+            case recorder::EventType::OVERRUN:
+                std::printf("overrun        late=%uus  tick=%llu", event.c, static_cast<unsigned long long>(event.d));
+                break;
+            case recorder::EventType::WATCHDOG_FEED:
+                std::printf("watchdog_feed");
+                break;
+            case recorder::EventType::WATCHDOG_TRIP:
+                std::printf("watchdog_trip  interrupted=%s%s", state_name(event.a), event.b ? " stop FAILED" : "");
+                break;
+            case recorder::EventType::LEASE_EXPIRY:
+                std::printf("lease_expiry   -> %s", state_name(event.a));
+                break;
+            case recorder::EventType::ESTOP:
+                std::printf("estop%s", event.b ? "          stop FAILED" : "");
+                break;
+            case recorder::EventType::FAULT:
+                std::printf("fault          %s degraded mode", event.b ? "enter" : "exit");
+                break;
+            default:
+                std::printf("unknown(%u)    a=%u b=%u c=%u d=%llu", static_cast<unsigned>(event.type), event.a, event.b, event.c,
+                    static_cast<unsigned long long>(event.d));
+                break;
+        }
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string path = recorder::DEFAULT_DUMP_PATH;
+    size_t last = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--last") == 0 && i + 1 < argc) {
+            last = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            std::printf("usage: %s [--last N] [FILE]\n", argv[0]);
+            return 0;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    recorder::FileHeader header{};
+    auto events = recorder::load_dump(path, header);
+    if (!events) {
+        std::fprintf(stderr, "Error: %s\n", events.error().c_str());
+        return 1;
+    }
+
+    char when[64] = "?";
+    const time_t seconds = static_cast<time_t>(header.dump_realtime_ns / 1000000000);
+    tm local{};
+    if (::localtime_r(&seconds, &local)) std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+    std::printf("flight recorder dump: %s\n", path.c_str());
+    std::printf("  reason=%s", reason_to_string(header.reason));
+    if (header.signal != 0) std::printf(" signal=%u", header.signal);
+    std::printf("  dumped_at=%s  events=%llu  recorded=%llu  overwritten=%llu\n", when,
+        static_cast<unsigned long long>(header.count), static_cast<unsigned long long>(header.recorded),
+        static_cast<unsigned long long>(header.recorded > header.count ? header.recorded - header.count : 0));
+    if (!events->empty()) {
+        std::printf("  span=%.3f ms\n", static_cast<double>(events->back().ts_ns - events->front().ts_ns) / 1e6);
+    }
+
+    const size_t begin = (last > 0 && last < events->size()) ? events->size() - last : 0;
+    for (size_t i = begin; i < events->size(); ++i) print_event((*events)[i], header.dump_steady_ns);
+    return 0;
+}
@@ -0,0 +1,593 @@
+#include "fpvcar_device_control/ipc_framing.hpp"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// fpvcar-loadgen：多连接 IPC 压测工具
+// 打开 N 条长连接，按目标速率（或开环最大速率）发送真实的指令组合，
+// 并按比例注入非法 JSON 帧和超长帧，统计每条连接的吞吐、错误数和响应延迟分位数
+// 洪泛模式（--flood）另开 N 条连接，不等响应连续发送相同的前进指令，模拟失控的 gateway，
+// 用于检查服务端限速、合并与 stopAll 插队是否让正常连接保持低延迟
+// UDP 模式（--udp）下每条"连接"是一个 UDP 发送端，数据报带 seq/ts_us，并可按比例注入
+// 过期数据报（ts_us 提前 1 秒）和重放的旧序号，检查服务端是否把它们丢弃（STALE / OUT_OF_ORDER）
+//
+// 用法: fpvcar-loadgen [--socket PATH] [--connections N] [--duration SEC] [--rate MSG_PER_SEC]
+//                      [--malformed PERCENT] [--oversized PERCENT] [--timeout-ms MS] [--seed N]
+//                      [--flood N] [--flood-rate MSG_PER_SEC]
+//                      [--udp HOST:PORT] [--udp-stale PERCENT] [--udp-reorder PERCENT]
+//   --rate 0 表示开环：每条连接收到响应后立即发送下一条
+//   --flood-rate 0 表示洪泛连接尽可能快地发送（只受服务端背压限制）
+//   --udp 时 --oversized 不适用（被忽略），洪泛连接仍使用 Unix 套接字
+
+namespace ipc = fpvcar::device_control::ipc;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        std::string socket_path = "/tmp/fpvcar_control.sock";
+        int connections = 4;
+        double duration_s = 10.0;
+        double rate = 0.0;            // 所有连接合计的目标速率（条/秒），0 为开环
+        double malformed_pct = 0.0;   // 非法 JSON 帧占比（%）
+        double oversized_pct = 0.0;   // 超长帧占比（%）
+        int timeout_ms = 1000;        // 等待响应的超时时间
+        uint32_t seed = 1;
+        int flood_connections = 0;    // 洪泛连接数
+        double flood_rate = 0.0;      // 所有洪泛连接合计的发送速率（条/秒），0 为尽可能快
+        std::string udp_target;       // UDP 模式的目标 HOST:PORT，空表示使用 Unix 套接字
+        double udp_stale_pct = 0.0;   // 注入过期数据报的占比（%）
+        double udp_reorder_pct = 0.0; // 注入重放旧序号数据报的占比（%）
+    };
+
+    // 注入过期数据报时 ts_us 提前的时间，远大于服务端默认的 100ms 过期阈值
+    constexpr int64_t STALE_AGE_US = 1000000;
+    // UDP 发送端前若干个数据报不注入，先让服务端建立序号与延迟基线
+    constexpr int64_t UDP_WARMUP = 10;
+
+    // 洪泛连接每次写入的帧数
+    constexpr int FLOOD_BATCH = 64;
+
+    /**
+     * @brief 洪泛连接的统计结果
+     */
+    struct FloodStats {
+        uint64_t sent = 0;          // 发送的帧数
+        uint64_t responses = 0;     // 收到的响应数
+        uint64_t ok = 0;            // status 为 ok 的响应
+        uint64_t rate_limited = 0;  // 被服务端限速丢弃（RATE_LIMITED）
+        uint64_t other_errors = 0;  // 其它错误响应
+        uint64_t io_errors = 0;     // 连接/读写失败
+    };
+
+    /**
+     * @brief 单条连接的统计结果
+     */
+    struct ConnectionStats {
+        uint64_t sent = 0;                // 发送的帧数（含非法帧）
+        uint64_t ok = 0;                  // status 为 ok 的响应
+        uint64_t error_responses = 0;     // status 为 error 的响应
+        uint64_t unexpected_ok = 0;       // 非法帧却收到 ok 响应
+        uint64_t oversized_rejected = 0;  // 超长帧被服务端断开连接
+        uint64_t io_errors = 0;           // 连接/读写失败
+        uint64_t timeouts = 0;            // 等待响应超时
+        uint64_t reconnects = 0;          // 重连次数
+        uint64_t udp_dropped = 0;         // 注入的过期/乱序数据报被服务端正确丢弃
+        std::vector<uint32_t> latencies_us; // 每条正常响应的延迟（微秒）
+    };
+
+    // 真实指令组合：以前进与转向为主，夹杂停止（权重与 action 对应）
+    const std::vector<std::pair<const char*, int>> ACTION_MIX = {
+        {"moveForward", 30},
+        {"moveForwardAndTurnLeft", 12},
+        {"moveForwardAndTurnRight", 12},
+        {"turnLeft", 8},
+        {"turnRight", 8},
+        {"moveBackward", 8},
+        {"moveBackwardAndTurnLeft", 4},
+        {"moveBackwardAndTurnRight", 4},
+        {"stopAll", 14},
+    };
+
+    // 非法帧：服务端应返回错误响应而不是断开连接
+    const std::vector<std::string> MALFORMED_FRAMES = {
+        "{\"action\": \"moveForward\"",   // 截断的 JSON
+        "not json at all",
+        "{}",                              // 缺少 action
+        "{\"action\": 42}",                // action 类型错误
+        "{\"action\": \"\"}",              // 空 action
+        "{\"action\": \"flyToTheMoon\"}",  // 未知 action
+        "[1, 2, 3]",
+    };
+
+    void usage(const char* prog) {
+        std::fprintf(stderr,
+            "Usage: %s [--socket PATH] [--connections N] [--duration SEC] [--rate MSG_PER_SEC]\n"
+            "          [--malformed PERCENT] [--oversized PERCENT] [--timeout-ms MS] [--seed N]\n"
+            "          [--flood N] [--flood-rate MSG_PER_SEC]\n"
+            "          [--udp HOST:PORT] [--udp-stale PERCENT] [--udp-reorder PERCENT]\n", prog);
+    }
+
+    bool parse_args(int argc, char** argv, Options& opt) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                return false;
+            }
+            const char* value = argv[++i];
+            if (arg == "--socket") opt.socket_path = value;
+            else if (arg == "--connections") opt.connections = std::max(1, std::atoi(value));
+            else if (arg == "--duration") opt.duration_s = std::atof(value);
+            else if (arg == "--rate") opt.rate = std::atof(value);
+            else if (arg == "--malformed") opt.malformed_pct = std::atof(value);
+            else if (arg == "--oversized") opt.oversized_pct = std::atof(value);
+            else if (arg == "--timeout-ms") opt.timeout_ms = std::max(1, std::atoi(value));
+            else if (arg == "--seed") opt.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--flood") opt.flood_connections = std::max(0, std::atoi(value));
+            else if (arg == "--flood-rate") opt.flood_rate = std::atof(value);
+            else if (arg == "--udp") opt.udp_target = value;
+            else if (arg == "--udp-stale") opt.udp_stale_pct = std::atof(value);
+            else if (arg == "--udp-reorder") opt.udp_reorder_pct = std::atof(value);
+            else {
+                usage(argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int connect_socket(const Options& opt) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", opt.socket_path.c_str());
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+
+        // 设置接收超时，避免服务端繁忙时永久阻塞
+        timeval tv{};
+        tv.tv_sec = opt.timeout_ms / 1000;
+        tv.tv_usec = (opt.timeout_ms % 1000) * 1000;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        return fd;
+    }
+
+    /**
+     * @brief 创建连接到 --udp 目标的 UDP 套接字（connect 后只接收来自服务端的数据报）
+     */
+    int connect_udp(const Options& opt) {
+        const size_t colon = opt.udp_target.rfind(':');
+        if (colon == std::string::npos) return -1;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(std::atoi(opt.udp_target.c_str() + colon + 1)));
+        if (::inet_pton(AF_INET, opt.udp_target.substr(0, colon).c_str(), &addr.sin_addr) != 1) return -1;
+
+        int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) return -1;
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            return -1;
+        }
+        timeval tv{};
+        tv.tv_sec = opt.timeout_ms / 1000;
+        tv.tv_usec = (opt.timeout_ms % 1000) * 1000;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        return fd;
+    }
+
+    int64_t steady_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 读取响应中的 seq 字段，没有时返回 -1
+     */
+    int64_t reply_seq(const std::string& reply) {
+        const size_t pos = reply.find("\"seq\":");
+        if (pos == std::string::npos) return -1;
+        return std::strtoll(reply.c_str() + pos + 6, nullptr, 10);
+    }
+
+    enum class ReadResult { OK, CLOSED, TIMEOUT, ERROR };
+
+    /**
+     * @brief 读取一条响应帧
+     */
+    ReadResult read_response(int fd, std::string& response) {
+        uint32_t length_net = 0;
+        ssize_t n = ipc::read_exact(fd, &length_net, sizeof(length_net));
+        if (n == 0) return ReadResult::CLOSED;
+        if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? ReadResult::TIMEOUT : ReadResult::ERROR;
+
+        uint32_t length = ntohl(length_net);
+        if (length > ipc::MAX_MESSAGE_SIZE) return ReadResult::ERROR;
+        response.resize(length);
+        n = ipc::read_exact(fd, response.data(), length);
+        if (n == 0 && length > 0) return ReadResult::CLOSED;
+        if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? ReadResult::TIMEOUT : ReadResult::ERROR;
+        return ReadResult::OK;
+    }
+
+    /**
+     * @brief UDP 发送端：闭环发送带 seq/ts_us 的指令，按 seq 匹配回复
+     * @note 注入的过期/重放数据报应收到 STALE / OUT_OF_ORDER，被接受则计为 unexpected_ok
+     */
+    void run_udp_sender(const Options& opt, int index, Clock::time_point deadline, ConnectionStats& stats) {
+        std::mt19937 rng(opt.seed + static_cast<uint32_t>(index) * 7919u);
+        std::uniform_real_distribution<double> percent(0.0, 100.0);
+        std::vector<int> weights;
+        for (const auto& entry : ACTION_MIX) weights.push_back(entry.second);
+        std::discrete_distribution<size_t> pick_action(weights.begin(), weights.end());
+        std::uniform_int_distribution<size_t> pick_malformed(0, MALFORMED_FRAMES.size() - 1);
+
+        const auto interval = opt.rate > 0.0
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.connections / opt.rate))
+            : Clock::duration::zero();
+        auto next_send = Clock::now();
+
+        int fd = connect_udp(opt);
+        if (fd < 0) {
+            ++stats.io_errors;
+            return;
+        }
+
+        int64_t seq = 0;
+        int64_t accepted_seq = -1; // 服务端最近接受的序号，重放它应被判为乱序
+        char reply_buf[2048];
+        std::string request;
+        std::string reply;
+        while (Clock::now() < deadline) {
+            if (interval != Clock::duration::zero()) {
+                std::this_thread::sleep_until(next_send);
+            }
+            const auto start = interval != Clock::duration::zero() ? next_send : Clock::now();
+            next_send += interval;
+
+            // 选择数据报类型：非法、过期、重放旧序号或正常指令
+            const double roll = percent(rng);
+            const bool warm = seq >= UDP_WARMUP;
+            const bool malformed = roll < opt.malformed_pct;
+            const bool stale = !malformed && warm && roll < opt.malformed_pct + opt.udp_stale_pct;
+            const bool replay = !malformed && !stale && warm && accepted_seq >= 0 &&
+                roll < opt.malformed_pct + opt.udp_stale_pct + opt.udp_reorder_pct;
+            const int64_t request_seq = replay ? accepted_seq : ++seq;
+            if (malformed) {
+                request = MALFORMED_FRAMES[pick_malformed(rng)];
+            } else {
+                const int64_t ts = steady_us() - (stale ? STALE_AGE_US : 0);
+                request = std::string("{\"action\":\"") + ACTION_MIX[pick_action(rng)].first +
+                          "\",\"seq\":" + std::to_string(request_seq) + ",\"ts_us\":" + std::to_string(ts) + "}";
+            }
+
+            ++stats.sent;
+            if (::send(fd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size())) {
+                ++stats.io_errors;
+                continue;
+            }
+
+            // 等待匹配的回复：丢弃之前超时请求的迟到回复；非法数据报的回复可能不带 seq
+            bool matched = false;
+            while (!matched) {
+                const ssize_t n = ::recv(fd, reply_buf, sizeof(reply_buf), 0);
+                if (n < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) ++stats.timeouts;
+                    else ++stats.io_errors;
+                    break;
+                }
+                reply.assign(reply_buf, static_cast<size_t>(n));
+                const int64_t got = reply_seq(reply);
+                matched = got == request_seq || (malformed && got < 0);
+            }
+            if (!matched) continue;
+
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+            stats.latencies_us.push_back(static_cast<uint32_t>(std::min<int64_t>(latency, UINT32_MAX)));
+
+            if (reply.find("\"status\":\"ok\"") != std::string::npos) {
+                ++stats.ok;
+                if (malformed || stale || replay) ++stats.unexpected_ok;
+                else accepted_seq = request_seq;
+            } else {
+                ++stats.error_responses;
+                if ((stale && reply.find("\"STALE\"") != std::string::npos) ||
+                    (replay && reply.find("\"OUT_OF_ORDER\"") != std::string::npos)) {
+                    ++stats.udp_dropped;
+                }
+            }
+
+            if (interval != Clock::duration::zero() && next_send < Clock::now() - interval * 100) {
+                next_send = Clock::now();
+            }
+        }
+        ::close(fd);
+    }
+
+    void run_connection(const Options& opt, int index, Clock::time_point deadline, ConnectionStats& stats) {
+        if (!opt.udp_target.empty()) {
+            run_udp_sender(opt, index, deadline, stats);
+            return;
+        }
+
+        std::mt19937 rng(opt.seed + static_cast<uint32_t>(index) * 7919u);
+        std::uniform_real_distribution<double> percent(0.0, 100.0);
+
+        std::vector<int> weights;
+        for (const auto& entry : ACTION_MIX) weights.push_back(entry.second);
+        std::discrete_distribution<size_t> pick_action(weights.begin(), weights.end());
+        std::uniform_int_distribution<size_t> pick_malformed(0, MALFORMED_FRAMES.size() - 1);
+
+        // 每条连接分到的发送间隔；开环模式下为 0
+        const auto interval = opt.rate > 0.0
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.connections / opt.rate))
+            : Clock::duration::zero();
+        auto next_send = Clock::now();
+
+        int fd = connect_socket(opt);
+        if (fd < 0) ++stats.io_errors;
+
+        std::string request;
+        std::string response;
+        while (Clock::now() < deadline) {
+            if (fd < 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                fd = connect_socket(opt);
+                if (fd < 0) {
+                    ++stats.io_errors;
+                    continue;
+                }
+                ++stats.reconnects;
+            }
+
+            if (interval != Clock::duration::zero()) {
+                std::this_thread::sleep_until(next_send);
+            }
+            // 限速模式下延迟从计划发送时间算起，避免协调遗漏（coordinated omission）
+            const auto start = interval != Clock::duration::zero() ? next_send : Clock::now();
+            next_send += interval;
+
+            const double roll = percent(rng);
+            if (roll < opt.oversized_pct) {
+                // 超长帧：只发送一个超过上限的长度前缀，服务端应直接断开连接
+                uint32_t length_net = htonl(ipc::MAX_MESSAGE_SIZE + 1);
+                ++stats.sent;
+                if (ipc::write_exact(fd, &length_net, sizeof(length_net)) != sizeof(length_net)) {
+                    ++stats.io_errors;
+                } else if (read_response(fd, response) == ReadResult::CLOSED) {
+                    ++stats.oversized_rejected;
+                } else {
+                    ++stats.io_errors;
+                }
+                ::close(fd);
+                fd = -1;
+                continue;
+            }
+
+            const bool malformed = roll < opt.oversized_pct + opt.malformed_pct;
+            if (malformed) {
+                request = MALFORMED_FRAMES[pick_malformed(rng)];
+            } else {
+                request = std::string("{\"action\":\"") + ACTION_MIX[pick_action(rng)].first + "\"}";
+            }
+
+            ++stats.sent;
+            if (!ipc::write_message(fd, request)) {
+                ++stats.io_errors;
+                ::close(fd);
+                fd = -1;
+                continue;
+            }
+
+            ReadResult result = read_response(fd, response);
+            if (result != ReadResult::OK) {
+                if (result == ReadResult::TIMEOUT) ++stats.timeouts;
+                else ++stats.io_errors;
+                // 响应状态未知，关闭连接重新开始
+                ::close(fd);
+                fd = -1;
+                continue;
+            }
+
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+            stats.latencies_us.push_back(static_cast<uint32_t>(std::min<int64_t>(latency, UINT32_MAX)));
+
+            const bool is_ok = response.find("\"status\":\"ok\"") != std::string::npos;
+            if (is_ok) {
+                ++stats.ok;
+                if (malformed) ++stats.unexpected_ok;
+            } else {
+                ++stats.error_responses;
+            }
+
+            // 限速模式下严重落后时（例如刚重连）重置节拍，不做突发追赶
+            if (interval != Clock::duration::zero() && next_send < Clock::now() - interval * 100) {
+                next_send = Clock::now();
+            }
+        }
+
+        if (fd >= 0) ::close(fd);
+    }
+
+    /**
+     * @brief 洪泛连接：写线程不等响应连续发送相同的前进指令，读线程统计响应
+     */
+    void run_flood(const Options& opt, Clock::time_point deadline, FloodStats& stats) {
+        int fd = connect_socket(opt);
+        if (fd < 0) {
+            ++stats.io_errors;
+            return;
+        }
+
+        std::atomic<bool> writer_done{false};
+        std::thread reader([&]() {
+            std::string response;
+            while (true) {
+                const ReadResult result = read_response(fd, response);
+                if (result == ReadResult::TIMEOUT && !writer_done.load()) continue;
+                if (result != ReadResult::OK) {
+                    // 写完后服务端处理完剩余请求即关闭连接；其它情况计为 I/O 错误
+                    if (result == ReadResult::ERROR) ++stats.io_errors;
+                    break;
+                }
+                ++stats.responses;
+                if (response.find("\"status\":\"ok\"") != std::string::npos) ++stats.ok;
+                else if (response.find("\"RATE_LIMITED\"") != std::string::npos) ++stats.rate_limited;
+                else ++stats.other_errors;
+            }
+        });
+
+        std::string batch;
+        const std::string request = "{\"action\":\"moveForward\"}";
+        const uint32_t length_net = htonl(static_cast<uint32_t>(request.size()));
+        for (int i = 0; i < FLOOD_BATCH; ++i) {
+            batch.append(reinterpret_cast<const char*>(&length_net), sizeof(length_net));
+            batch.append(request);
+        }
+        const auto interval = opt.flood_rate > 0.0
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.flood_connections * FLOOD_BATCH / opt.flood_rate))
+            : Clock::duration::zero();
+        auto next_send = Clock::now();
+        while (Clock::now() < deadline) {
+            if (interval != Clock::duration::zero()) {
+                std::this_thread::sleep_until(next_send);
+                next_send += interval;
+            }
+            if (ipc::write_exact(fd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) {
+                ++stats.io_errors;
+                break;
+            }
+            stats.sent += FLOOD_BATCH;
+        }
+        // 半关闭：服务端读到 EOF 后关闭连接，读线程收完剩余响应后退出
+        writer_done.store(true);
+        ::shutdown(fd, SHUT_WR);
+        reader.join();
+        ::close(fd);
+    }
+
+    uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t idx = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+    void print_row(const char* label, ConnectionStats& stats, double elapsed_s) {
+        std::sort(stats.latencies_us.begin(), stats.latencies_us.end());
+        const auto& lat = stats.latencies_us;
+        std::printf("%-6s %9llu %9.0f %8llu %8llu %6llu %6llu %6llu %6llu %6llu %8u %8u %8u %8u %8u\n",
+            label,
+            static_cast<unsigned long long>(stats.sent),
+            static_cast<double>(stats.ok + stats.error_responses) / elapsed_s,
+            static_cast<unsigned long long>(stats.ok),
+            static_cast<unsigned long long>(stats.error_responses),
+            static_cast<unsigned long long>(stats.unexpected_ok),
+            static_cast<unsigned long long>(stats.oversized_rejected),
+            static_cast<unsigned long long>(stats.io_errors),
+            static_cast<unsigned long long>(stats.timeouts),
+            static_cast<unsigned long long>(stats.reconnects),
+            percentile(lat, 50), percentile(lat, 90), percentile(lat, 99), percentile(lat, 99.9),
+            lat.empty() ? 0u : lat.back());
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 1;
+
+    // 服务端断开连接时写入不应导致进程退出
+    signal(SIGPIPE, SIG_IGN);
+
+    char rate_text[32] = "open-loop";
+    if (opt.rate > 0.0) std::snprintf(rate_text, sizeof(rate_text), "%.0f/s", opt.rate);
+    std::printf("fpvcar-loadgen: socket=%s connections=%d duration=%.1fs rate=%s malformed=%.1f%% oversized=%.1f%%\n",
+        opt.socket_path.c_str(), opt.connections, opt.duration_s, rate_text,
+        opt.malformed_pct, opt.oversized_pct);
+    if (!opt.udp_target.empty()) {
+        std::printf("udp: target=%s stale=%.1f%% reorder=%.1f%%\n",
+            opt.udp_target.c_str(), opt.udp_stale_pct, opt.udp_reorder_pct);
+    }
+    if (opt.flood_connections > 0) {
+        char flood_text[32] = "unbounded";
+        if (opt.flood_rate > 0.0) std::snprintf(flood_text, sizeof(flood_text), "%.0f/s", opt.flood_rate);
+        std::printf("flood: connections=%d rate=%s\n", opt.flood_connections, flood_text);
+    }
+
+    std::vector<ConnectionStats> stats(static_cast<size_t>(opt.connections));
+    std::vector<std::thread> workers;
+    const auto begin = Clock::now();
+    const auto deadline = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.duration_s));
+    for (int i = 0; i < opt.connections; ++i) {
+        workers.emplace_back(run_connection, std::cref(opt), i, deadline, std::ref(stats[static_cast<size_t>(i)]));
+    }
+    std::vector<FloodStats> flood_stats(static_cast<size_t>(opt.flood_connections));
+    for (auto& fs : flood_stats) {
+        workers.emplace_back(run_flood, std::cref(opt), deadline, std::ref(fs));
+    }
+    for (auto& worker : workers) worker.join();
+    const double elapsed_s = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::printf("%-6s %9s %9s %8s %8s %6s %6s %6s %6s %6s %8s %8s %8s %8s %8s\n",
+        "conn", "sent", "resp/s", "ok", "err", "badok", "oversz", "ioerr", "tmout", "recon",
+        "p50us", "p90us", "p99us", "p999us", "maxus");
+
+    ConnectionStats total;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        auto& s = stats[i];
+        total.sent += s.sent;
+        total.ok += s.ok;
+        total.error_responses += s.error_responses;
+        total.unexpected_ok += s.unexpected_ok;
+        total.oversized_rejected += s.oversized_rejected;
+        total.io_errors += s.io_errors;
+        total.timeouts += s.timeouts;
+        total.reconnects += s.reconnects;
+        total.udp_dropped += s.udp_dropped;
+        total.latencies_us.insert(total.latencies_us.end(), s.latencies_us.begin(), s.latencies_us.end());
+        print_row(std::to_string(i).c_str(), s, elapsed_s);
+    }
+    print_row("total", total, elapsed_s);
+    if (!opt.udp_target.empty()) {
+        std::printf("udp    injected datagrams dropped by the server (STALE/OUT_OF_ORDER)=%llu\n",
+            static_cast<unsigned long long>(total.udp_dropped));
+    }
+
+    if (!flood_stats.empty()) {
+        FloodStats flood;
+        for (const auto& fs : flood_stats) {
+            flood.sent += fs.sent;
+            flood.responses += fs.responses;
+            flood.ok += fs.ok;
+            flood.rate_limited += fs.rate_limited;
+            flood.other_errors += fs.other_errors;
+            flood.io_errors += fs.io_errors;
+        }
+        std::printf("flood  sent=%llu (%.0f/s) responses=%llu ok=%llu rate_limited=%llu other_err=%llu ioerr=%llu\n",
+            static_cast<unsigned long long>(flood.sent), static_cast<double>(flood.sent) / elapsed_s,
+            static_cast<unsigned long long>(flood.responses),
+            static_cast<unsigned long long>(flood.ok),
+            static_cast<unsigned long long>(flood.rate_limited),
+            static_cast<unsigned long long>(flood.other_errors),
+            static_cast<unsigned long long>(flood.io_errors));
+    }
+
+    // 非法帧被当作成功处理属于回归，以非零退出码提示
+    return total.unexpected_ok == 0 ? 0 : 2;
+}
@@ -0,0 +1,351 @@
+#include "fpvcar_device_control/clock.hpp"
+#include "fpvcar_device_control/control_loop.hpp"
+#include "fpvcar_device_control/desired_state.hpp"
+#include "fpvcar_device_control/request_handler.hpp"
+#include "fpvcar_device_control/simulated_motor_backend.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// fpvcar-sim：虚拟时钟车辆仿真
+// 用 VirtualClock + SimulatedMotorBackend 运行完整的控制路径（RequestHandler → DesiredStateManager → ControlLoop/看门狗 → 电机），
+// 按随机种子生成可复现的驾驶脚本（驾驶片段 + 链路中断），在几秒内跑完一小时，并检查：
+//   - 租约：带 ttl_ms 的指令中断后，停车时刻恰好在 ttl 到期时（误差 ≤ 1ms）
+//   - 看门狗：不带 ttl 的指令中断后，停车延迟在 [超时, 2×超时] 之内，中断不足一个超时周期时不会误停车
+//   - 控制周期：周期数与虚拟时长一致，没有掉帧
+//   - 加速度限制：仿真轮速变化率不超过车辆参数的上限
+//   - 指令持续到达期间没有任何停车
+//   - 闭环（--closed-loop）：驾驶片段开始 0.5 秒后，各侧轮速在目标速度的 ±5% 以内（--efficiency 模拟电压跌落）
+//
+// 用法: fpvcar-sim [--duration SEC] [--rate HZ] [--ttl-ms MS] [--no-ttl PERCENT] [--gap PERCENT] [--seed N]
+//                  [--closed-loop] [--loop-rate HZ] [--efficiency RATIO]
+
+using namespace fpvcar::device_control;
+using namespace std::chrono_literals;
+
+namespace {
+    struct Options {
+        double duration_s = 3600.0;  // 虚拟时长
+        double rate_hz = 50.0;       // 驾驶期间网关发送指令的频率
+        int ttl_ms = 150;            // 指令租约
+        double no_ttl_pct = 30.0;    // 不带租约的驾驶片段占比（%），这些片段只靠看门狗停车
+        double gap_pct = 25.0;       // 链路中断片段占比（%）
+        uint32_t seed = 1;
+        bool closed_loop = false;
+        double loop_rate_hz = 1000.0; // 闭环控制频率
+        double efficiency = 1.0;      // 仿真车辆的驱动效率
+    };
+
+    // 闭环仿真参数：编码器每米边沿数、目标满速（低于满占空比时的 1 m/s，给效率下降留出余量）
+    constexpr double EDGES_PER_METER = 2000.0;
+    constexpr double CLOSED_LOOP_MAX_SPEED_MPS = 0.7;
+    constexpr double SETTLE_S = 0.5;
+    constexpr double SPEED_TOLERANCE = 0.05;
+
+    /**
+     * @brief 脚本片段：一段持续发送同一指令的驾驶，或一段没有任何指令的链路中断
+     */
+    struct Segment {
+        Clock::time_point begin;
+        Clock::time_point end;
+        bool gap = false;
+        DesiredState action = DesiredState::STOPPING;
+        int ttl_ms = 0;                     // 0 表示不带租约
+        Clock::time_point first_command{}; // 执行时记录
+        Clock::time_point last_command{};
+    };
+
+    /**
+     * @brief 丢弃所有输出的流缓冲区（控制循环的状态日志）
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+
+    const DesiredState ACTIONS[] = {
+        DesiredState::MOVING_FORWARD,
+        DesiredState::MOVING_BACKWARD,
+        DesiredState::TURNING_LEFT,
+        DesiredState::TURNING_RIGHT,
+        DesiredState::MOVING_FORWARD_AND_TURN_LEFT,
+        DesiredState::MOVING_FORWARD_AND_TURN_RIGHT,
+        DesiredState::MOVING_BACKWARD_AND_TURN_LEFT,
+        DesiredState::MOVING_BACKWARD_AND_TURN_RIGHT,
+        DesiredState::STOPPING,
+    };
+
+    void usage(const char* prog) {
+        std::fprintf(stderr,
+            "Usage: %s [--duration SEC] [--rate HZ] [--ttl-ms MS] [--no-ttl PERCENT] [--gap PERCENT] [--seed N]\n"
+            "          [--closed-loop] [--loop-rate HZ] [--efficiency RATIO]\n", prog);
+    }
+
+    bool parse_args(int argc, char** argv, Options& opt) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--closed-loop") {
+                opt.closed_loop = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                return false;
+            }
+            const char* value = argv[++i];
+            if (arg == "--duration") opt.duration_s = std::max(1.0, std::atof(value));
+            else if (arg == "--rate") opt.rate_hz = std::max(1.0, std::atof(value));
+            else if (arg == "--ttl-ms") opt.ttl_ms = std::max(1, std::atoi(value));
+            else if (arg == "--no-ttl") opt.no_ttl_pct = std::atof(value);
+            else if (arg == "--gap") opt.gap_pct = std::atof(value);
+            else if (arg == "--seed") opt.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (arg == "--loop-rate") opt.loop_rate_hz = std::clamp(std::atof(value), 1.0, 1000.0);
+            else if (arg == "--efficiency") opt.efficiency = std::clamp(std::atof(value), 0.1, 1.0);
+            else {
+                usage(argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Clock::duration seconds(double s) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+    }
+
+    double to_ms(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    /**
+     * @brief 生成驾驶脚本：驾驶片段 0.5~8 秒；中断片段一半短于看门狗超时、一半长于两倍超时
+     */
+    std::vector<Segment> make_script(const Options& opt, Clock::time_point start) {
+        std::mt19937 rng(opt.seed);
+        std::uniform_real_distribution<double> percent(0.0, 100.0);
+        std::uniform_real_distribution<double> drive_len(0.5, 8.0);
+        std::uniform_real_distribution<double> short_gap(0.05, 4.0);
+        std::uniform_real_distribution<double> long_gap(10.5, 15.0);
+        std::uniform_int_distribution<size_t> action(0, sizeof(ACTIONS) / sizeof(ACTIONS[0]) - 1);
+
+        std::vector<Segment> script;
+        const auto end = start + seconds(opt.duration_s);
+        auto t = start;
+        while (t < end) {
+            Segment seg;
+            seg.begin = t;
+            // 脚本以驾驶开始，不连续生成两段中断
+            seg.gap = !script.empty() && !script.back().gap && percent(rng) < opt.gap_pct;
+            if (seg.gap) {
+                seg.end = t + seconds(percent(rng) < 50.0 ? short_gap(rng) : long_gap(rng));
+            } else {
+                seg.action = ACTIONS[action(rng)];
+                seg.ttl_ms = percent(rng) < opt.no_ttl_pct ? 0 : opt.ttl_ms;
+                seg.end = t + seconds(drive_len(rng));
+            }
+            seg.end = std::min(seg.end, end);
+            t = seg.end;
+            script.push_back(seg);
+        }
+        return script;
+    }
+
+    /**
+     * @brief 单项检查的结果
+     */
+    struct Check {
+        const char* name;
+        uint64_t samples = 0;
+        uint64_t violations = 0;
+        double min_ms = 0.0;
+        double max_ms = 0.0;
+        std::string bound{};
+
+        void sample(double ms, bool ok) {
+            min_ms = samples == 0 ? ms : std::min(min_ms, ms);
+            max_ms = samples == 0 ? ms : std::max(max_ms, ms);
+            ++samples;
+            if (!ok) ++violations;
+        }
+    };
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) return 1;
+
+    // 控制循环的状态日志写入空缓冲区
+    NullBuffer null_buffer;
+    std::streambuf* saved_cout = std::cout.rdbuf(&null_buffer);
+    std::streambuf* saved_cerr = std::cerr.rdbuf(&null_buffer);
+
+    VirtualClock clock;
+    DesiredStateManager manager(clock);
+    SimulatedMotorParams params;
+    params.drive_efficiency = opt.efficiency;
+    SimulatedMotorBackend motor(clock, params);
+    SimulatedEncoder encoder(motor, clock, EDGES_PER_METER);
+    ControlLoop loop(manager, motor, DesiredState::STOPPING, MotorFaultPolicy(), clock);
+    RequestHandler handler(manager);
+    if (opt.closed_loop) {
+        WheelSpeedConfig speed;
+        speed.enabled = true;
+        speed.rate_hz = opt.loop_rate_hz;
+        speed.max_speed_eps = CLOSED_LOOP_MAX_SPEED_MPS * EDGES_PER_METER;
+        speed.feedforward = CLOSED_LOOP_MAX_SPEED_MPS / params.max_wheel_speed_mps;
+        speed.turn_inner_ratio = params.turn_inner_ratio;
+        loop.set_wheel_speed_control(encoder, speed);
+    }
+    // 各侧目标轮速（满速）：闭环为控制目标，开环为标称满占空比轮速
+    const double target_speed = opt.closed_loop ? CLOSED_LOOP_MAX_SPEED_MPS : params.max_wheel_speed_mps;
+    const int32_t inner_q15 = static_cast<int32_t>(params.turn_inner_ratio * DUTY_FULL);
+
+    // 记录所有停车指令的时刻（control_loop 与看门狗都会调用）
+    std::mutex stops_mutex;
+    std::vector<Clock::time_point> stops;
+    motor.set_observer([&stops_mutex, &stops](Clock::time_point t, DesiredState state) {
+        if (state != DesiredState::STOPPING) return;
+        std::lock_guard<std::mutex> lock(stops_mutex);
+        stops.push_back(t);
+    });
+
+    const auto start = clock.now();
+    std::vector<Segment> script = make_script(opt, start);
+    const auto period = seconds(1.0 / opt.rate_hz);
+    const auto wall_begin = std::chrono::steady_clock::now();
+
+    loop.start();
+    std::string request;
+    std::string response;
+    uint64_t requests = 0;
+    // 轮速跟踪：驾驶片段稳定后每条指令采样一次，误差为相对各侧目标速度的比例
+    Check tracking{"wheel_speed_tracking"};
+    tracking.bound = opt.closed_loop ? "+-5% (ratio)" : "open loop (ratio)";
+    const auto settle = seconds(SETTLE_S);
+    for (auto& seg : script) {
+        if (seg.gap) {
+            clock.advance_to(seg.end);
+            continue;
+        }
+        request = std::string("{\"action\":\"") + desired_state_to_action(seg.action) + "\"";
+        if (seg.ttl_ms > 0) request += ",\"ttl_ms\":" + std::to_string(seg.ttl_ms);
+        request += "}";
+        seg.first_command = seg.begin;
+        for (auto t = seg.begin; t < seg.end; t += period) {
+            clock.advance_to(t);
+            response.clear();
+            handler.handle_request(request, response);
+            loop.feed_watchdog();
+            seg.last_command = t;
+            ++requests;
+            if (seg.action == DesiredState::STOPPING || t - seg.begin < settle) continue;
+            const SimulatedVehicleState now = motor.state();
+            const auto setpoints = wheel_setpoints(seg.action, inner_q15);
+            const double left = target_speed * setpoints[static_cast<size_t>(Wheel::FRONT_LEFT)] / DUTY_FULL;
+            const double right = target_speed * setpoints[static_cast<size_t>(Wheel::FRONT_RIGHT)] / DUTY_FULL;
+            const double error = std::max(std::abs(now.left_mps - left) / std::abs(left), std::abs(now.right_mps - right) / std::abs(right));
+            tracking.sample(error, !opt.closed_loop || error <= SPEED_TOLERANCE);
+        }
+    }
+    const auto end = script.empty() ? start : script.back().end;
+    clock.advance_to(end);
+    const TelemetrySnapshot telemetry = loop.telemetry().read();
+    const SimulatedVehicleState vehicle = motor.state();
+    loop.stop();
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+
+    std::cout.rdbuf(saved_cout);
+    std::cerr.rdbuf(saved_cerr);
+
+    // --- 检查 ---
+    const auto timeout = std::chrono::duration_cast<Clock::duration>(ControlLoop::WATCHDOG_TIMEOUT);
+    const auto ttl = std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(opt.ttl_ms));
+    auto first_stop_after = [&stops](Clock::time_point t) {
+        return std::upper_bound(stops.begin(), stops.end(), t);
+    };
+
+    Check lease{"lease_stop_latency"};
+    lease.bound = "= ttl_ms (+1ms)";
+    Check watchdog{"watchdog_stop_latency"};
+    watchdog.bound = "[" + std::to_string(ControlLoop::WATCHDOG_TIMEOUT.count()) + ", " +
+                     std::to_string(2 * ControlLoop::WATCHDOG_TIMEOUT.count()) + "] ms";
+    Check false_stops{"stops_while_driving"};
+    false_stops.bound = "0";
+
+    for (size_t i = 0; i < script.size(); ++i) {
+        const Segment& seg = script[i];
+        if (seg.gap || seg.action == DesiredState::STOPPING) continue;
+
+        // 指令持续到达期间不应停车
+        auto it = first_stop_after(seg.first_command);
+        const bool stopped_while_driving = it != stops.end() && *it <= seg.last_command;
+        false_stops.sample(stopped_while_driving ? to_ms(*it - seg.first_command) : 0.0, !stopped_while_driving);
+
+        // 之后紧跟中断时检查停车延迟
+        if (i + 1 >= script.size() || !script[i + 1].gap) continue;
+        const Segment& gap = script[i + 1];
+        const auto gap_len = gap.end - seg.last_command;
+        it = first_stop_after(seg.last_command);
+        const bool stopped = it != stops.end() && *it < gap.end;
+        const auto latency = stopped ? *it - seg.last_command : Clock::duration::zero();
+        if (seg.ttl_ms > 0) {
+            if (gap_len <= ttl) continue;
+            lease.sample(to_ms(latency), stopped && latency >= ttl && latency <= ttl + 1ms);
+        } else if (stopped) {
+            watchdog.sample(to_ms(latency), latency >= timeout && latency <= 2 * timeout);
+        } else if (gap_len >= 2 * timeout) {
+            watchdog.sample(to_ms(gap_len), false); // 应当停车却没有停车
+        }
+    }
+
+    // 遥测在每个周期计数之前发布，读到的是此前已完成的周期数
+    const uint64_t expected_ticks = static_cast<uint64_t>((end - start) / loop.target_interval());
+    const uint64_t tick_error = telemetry.ticks > expected_ticks ? telemetry.ticks - expected_ticks : expected_ticks - telemetry.ticks;
+    const bool ticks_ok = tick_error <= 1 && telemetry.overruns == 0;
+    const double accel_limit = motor.params().max_wheel_accel_mps2;
+    const bool ramp_ok = vehicle.max_accel_mps2 <= accel_limit * (1.0 + 1e-9);
+
+    // --- 报告 ---
+    const double virtual_s = std::chrono::duration<double>(end - start).count();
+    std::printf("fpvcar-sim: seed=%u duration=%.0fs rate=%.0fHz ttl_ms=%d no_ttl=%.0f%% gap=%.0f%% %s efficiency=%.2f\n",
+        opt.seed, virtual_s, opt.rate_hz, opt.ttl_ms, opt.no_ttl_pct, opt.gap_pct,
+        opt.closed_loop ? ("closed_loop=" + std::to_string(static_cast<int>(opt.loop_rate_hz)) + "Hz").c_str() : "open_loop",
+        opt.efficiency);
+    std::printf("wall_time_s=%.3f speedup=%.0fx segments=%zu requests=%llu motor_commands=%llu wheel_duty_commands=%llu\n",
+        wall_s, wall_s > 0.0 ? virtual_s / wall_s : 0.0, script.size(),
+        static_cast<unsigned long long>(requests), static_cast<unsigned long long>(vehicle.commands),
+        static_cast<unsigned long long>(vehicle.wheel_duty_commands));
+    std::printf("ticks=%llu expected=%llu overruns=%llu lease_expiries=%llu watchdog_trips=%llu\n",
+        static_cast<unsigned long long>(telemetry.ticks), static_cast<unsigned long long>(expected_ticks),
+        static_cast<unsigned long long>(telemetry.overruns), static_cast<unsigned long long>(telemetry.lease_expiries),
+        static_cast<unsigned long long>(telemetry.watchdog_trips));
+    std::printf("distance_m=%.1f pose=(%.2f, %.2f) max_accel_mps2=%.3f abrupt_reversals=%llu\n",
+        vehicle.distance_m, vehicle.x_m, vehicle.y_m, vehicle.max_accel_mps2,
+        static_cast<unsigned long long>(vehicle.abrupt_reversals));
+
+    std::printf("%-24s %8s %10s %10s %10s  %-18s %s\n", "check", "samples", "violations", "min_ms", "max_ms", "bound", "result");
+    bool pass = true;
+    for (const Check* check : {&lease, &watchdog, &false_stops, &tracking}) {
+        const bool ok = check->violations == 0;
+        pass = pass && ok;
+        std::printf("%-24s %8llu %10llu %10.3f %10.3f  %-18s %s\n", check->name,
+            static_cast<unsigned long long>(check->samples), static_cast<unsigned long long>(check->violations),
+            check->min_ms, check->max_ms, check->bound.c_str(), ok ? "PASS" : "FAIL");
+    }
+    std::printf("%-24s %8llu %10llu %10s %10s  %-18s %s\n", "tick_cadence",
+        static_cast<unsigned long long>(telemetry.ticks), static_cast<unsigned long long>(ticks_ok ? 0 : 1),
+        "-", "-", "+-1 tick,0 overrun", ticks_ok ? "PASS" : "FAIL");
+    std::printf("%-24s %8s %10s %10s %10.3f  <= %-15.3f %s\n", "wheel_ramp_mps2", "-", ramp_ok ? "0" : "1",
+        "-", vehicle.max_accel_mps2, accel_limit, ramp_ok ? "PASS" : "FAIL");
+    pass = pass && ticks_ok && ramp_ok;
+    return pass ? 0 : 1;
+}